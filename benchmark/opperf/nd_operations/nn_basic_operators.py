@@ -25,6 +25,7 @@ from benchmark.opperf.rules.default_params import MX_OP_MODULE
 1. FullyConnected
 2. Dropout
 3. BatchNorm
+4. contrib.interleaved_selfatt
 
 """
 
@@ -81,6 +82,23 @@ def run_nn_basic_operators_benchmarks(ctx=mx.cpu(), dtype='float32', profiler='n
                                                             "moving_var": (3,)}],
                                                    warmup=warmup,
                                                    runs=runs)
+    # Fused self-attention benchmarks, BERT-base shapes. The operator only runs on CPU
+    selfatt_benchmark_res = []
+    if ctx == mx.cpu():
+        selfatt_benchmark_res = run_performance_test([getattr(mx.nd.contrib, "interleaved_selfatt")],
+                                                     run_backward=True,
+                                                     dtype=dtype,
+                                                     ctx=ctx,
+                                                     profiler=profiler,
+                                                     inputs=[{"queries_keys_values": (128, 32, 12 * 3 * 64),
+                                                              "heads": 12},
+                                                             {"queries_keys_values": (512, 8, 12 * 3 * 64),
+                                                              "mask": (8, 512, 512),
+                                                              "heads": 12,
+                                                              "use_mask": True}],
+                                                     warmup=warmup,
+                                                     runs=runs)
     # Prepare combined results
-    mx_basic_nn_results = merge_map_list(fc_benchmark_res + dropout_benchmark_res + batchnorm_benchmark_res)
+    mx_basic_nn_results = merge_map_list(fc_benchmark_res + dropout_benchmark_res + batchnorm_benchmark_res +
+                                         selfatt_benchmark_res)
     return mx_basic_nn_results
@@ -18,6 +18,7 @@
 """Performance benchmark tests for MXNet NDArray Reduction Operations.
 1. Operators are automatically fetched from MXNet operator registry.
 2. Default Inputs are generated. See rules/default_params.py. You can override the default values.
+3. sum, mean, max and norm are additionally run over inner, outer and strided axes.
 
 Below 10 reduction Operators are covered:
 
@@ -28,7 +29,8 @@ Below 10 reduction Operators are covered:
 import mxnet as mx
 
 from benchmark.opperf.utils.op_registry_utils import get_all_reduction_operators
-from benchmark.opperf.utils.benchmark_utils import run_op_benchmarks
+from benchmark.opperf.utils.benchmark_utils import run_op_benchmarks, run_performance_test
+from benchmark.opperf.rules.default_params import MX_OP_MODULE
 
 
 def run_mx_reduction_operators_benchmarks(ctx=mx.cpu(), dtype='float32', profiler='native', warmup=25, runs=100):
@@ -55,4 +57,18 @@ def run_mx_reduction_operators_benchmarks(ctx=mx.cpu(), dtype='float32', profile
     mx_reduction_broadcast_ops = get_all_reduction_operators()
     # Run benchmarks
     mx_reduction_op_results = run_op_benchmarks(mx_reduction_broadcast_ops, dtype, ctx, profiler, warmup, runs)
+    # Inner (contiguous trailing axes), outer (leading axes) and strided reductions
+    # take different code paths, cover each of them
+    for op in ["sum", "mean", "max", "norm"]:
+        axis_res = run_performance_test([getattr(MX_OP_MODULE, op)], run_backward=False,
+                                        dtype=dtype, ctx=ctx,
+                                        inputs=[{"data": (1024, 1024), "axis": 1},
+                                                {"data": (4, 262144), "axis": 1},
+                                                {"data": (1024, 1024), "axis": 0},
+                                                {"data": (262144, 4), "axis": 0},
+                                                {"data": (64, 128, 128), "axis": 1}],
+                                        warmup=warmup, runs=runs, profiler=profiler)
+        for res in axis_res:
+            for name, op_res in res.items():
+                mx_reduction_op_results.setdefault(name, []).extend(op_res)
     return mx_reduction_op_results
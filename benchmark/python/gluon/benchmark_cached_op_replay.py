@@ -0,0 +1,71 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Per-call latency of small-batch hybridized inference, with and without static_replay."""
+
+import argparse
+import logging
+import time
+
+import mxnet as mx
+from mxnet.gluon import nn
+
+logging.basicConfig(level=logging.INFO)
+parser = argparse.ArgumentParser(description='CachedOp static_replay call overhead benchmark')
+parser.add_argument('--batch-size', type=int, default=1,
+                    help='batch size of each call')
+parser.add_argument('--num-layers', type=int, default=8,
+                    help='number of Dense layers of the network')
+parser.add_argument('--hidden', type=int, default=64,
+                    help='number of units of each Dense layer')
+parser.add_argument('--num-calls', type=int, default=10000,
+                    help='number of timed calls')
+parser.add_argument('--gpu', action='store_true', default=False,
+                    help='run on gpu 0 instead of the cpu')
+opt = parser.parse_args()
+
+ctx = mx.gpu(0) if opt.gpu else mx.cpu()
+
+
+def get_net():
+    net = nn.HybridSequential(prefix='net_')
+    with net.name_scope():
+        for _ in range(opt.num_layers):
+            net.add(nn.Dense(opt.hidden, activation='relu'))
+    net.initialize(mx.init.Xavier(), ctx=ctx)
+    return net
+
+
+def benchmark(**kwargs):
+    net = get_net()
+    net.hybridize(**kwargs)
+    x = mx.nd.random.uniform(shape=(opt.batch_size, opt.hidden), ctx=ctx)
+    for _ in range(100):
+        net(x)
+    mx.nd.waitall()
+    tic = time.time()
+    for _ in range(opt.num_calls):
+        y = net(x)
+        y.wait_to_read()
+    return (time.time() - tic) / opt.num_calls * 1e6
+
+
+if __name__ == '__main__':
+    base = benchmark(static_alloc=True, static_shape=True)
+    replay = benchmark(static_alloc=True, static_shape=True, static_replay=True)
+    logging.info('static_shape:  %.1f us per call', base)
+    logging.info('static_replay: %.1f us per call (%.2fx)', replay, base / replay)
@@ -0,0 +1,108 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Reports bytes sent per batch and convergence of a small MLP for each
+type of gradient compression, using the 'device' kvstore on cpu contexts."""
+import argparse
+import logging
+import time
+import mxnet as mx
+import numpy as np
+
+parser = argparse.ArgumentParser(description='Benchmark gradient compression types')
+parser.add_argument('--types', type=str, default='none,2bit,1bit,topk,randomk,fp16,bf16',
+                    help='comma separated compression types to compare')
+parser.add_argument('--ratio', type=float, default=0.01, help='ratio for topk and randomk')
+parser.add_argument('--threshold', type=float, default=0.5, help='threshold for 2bit')
+parser.add_argument('--num-devices', type=int, default=2, help='number of cpu contexts')
+parser.add_argument('--num-epochs', type=int, default=10, help='number of epochs')
+parser.add_argument('--num-samples', type=int, default=8192, help='size of synthetic dataset')
+parser.add_argument('--batch-size', type=int, default=128, help='batch size')
+parser.add_argument('--num-hidden', type=int, default=512, help='hidden units of the MLP')
+parser.add_argument('--lr', type=float, default=0.1, help='learning rate')
+
+
+def compressed_size(num_elem, args, compr_type):
+    """Number of floats sent for a gradient of num_elem floats.
+    Mirrors GradientCompression::GetCompressedSize."""
+    if compr_type == 'none':
+        return num_elem
+    if compr_type in ('topk', 'randomk'):
+        k = min(max(int(round(2048 * args.ratio)), 1), 2048)
+        block, compr_block = 2048, 2 * k
+    else:
+        block, compr_block = {'2bit': (16, 1), '1bit': (1024, 33),
+                              'fp16': (2, 1), 'bf16': (2, 1)}[compr_type]
+    return (num_elem + block - 1) // block * compr_block
+
+
+def get_data(args):
+    rng = np.random.RandomState(0)
+    num_features, num_classes = 128, 10
+    centers = rng.randn(num_classes, num_features)
+    label = rng.randint(0, num_classes, args.num_samples)
+    data = centers[label] + rng.randn(args.num_samples, num_features) * 2
+    return mx.io.NDArrayIter(data.astype(np.float32), label.astype(np.float32),
+                             args.batch_size, shuffle=True)
+
+
+def get_symbol(args):
+    net = mx.sym.Variable('data')
+    net = mx.sym.FullyConnected(net, num_hidden=args.num_hidden, name='fc1')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=args.num_hidden, name='fc2')
+    net = mx.sym.Activation(net, act_type='relu')
+    net = mx.sym.FullyConnected(net, num_hidden=10, name='fc3')
+    return mx.sym.SoftmaxOutput(net, name='softmax')
+
+
+def run(args, compr_type):
+    mx.random.seed(0)
+    train_iter = get_data(args)
+    ctx = [mx.cpu(i) for i in range(args.num_devices)]
+    mod = mx.mod.Module(get_symbol(args), context=ctx)
+    kv = mx.kv.create('device')
+    if compr_type != 'none':
+        kv.set_gradient_compression({'type': compr_type, 'threshold': args.threshold,
+                                     'ratio': args.ratio})
+    metric = mx.metric.create(['acc', 'ce'])
+    tic = time.time()
+    mod.fit(train_iter, eval_metric=metric, kvstore=kv, optimizer='sgd',
+            optimizer_params={'learning_rate': args.lr, 'momentum': 0.9},
+            initializer=mx.init.Xavier(), num_epoch=args.num_epochs)
+    elapsed = time.time() - tic
+    arg_params, _ = mod.get_params()
+    # every device other than the one merging sends its gradients
+    num_bytes = sum(compressed_size(v.size, args, compr_type) * 4 * (args.num_devices - 1)
+                    for v in arg_params.values())
+    results = dict(metric.get_name_value())
+    return num_bytes, results['accuracy'], results['cross-entropy'], elapsed
+
+
+if __name__ == '__main__':
+    logging.basicConfig(level=logging.WARNING)
+    args = parser.parse_args()
+    print('%-8s %16s %10s %10s %10s %8s' %
+          ('type', 'bytes/batch', 'reduction', 'accuracy', 'loss', 'time(s)'))
+    dense_bytes = None
+    for compr_type in args.types.split(','):
+        num_bytes, acc, loss, elapsed = run(args, compr_type)
+        if compr_type == 'none':
+            dense_bytes = num_bytes
+        reduction = '%.1fx' % (float(dense_bytes) / num_bytes) if dense_bytes else '-'
+        print('%-8s %16d %10s %10.4f %10.4f %8.2f' %
+              (compr_type, num_bytes, reduction, acc, loss, elapsed))
@@ -0,0 +1,74 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Decode and augmentation throughput of ImageRecordIter, with and without fused_decode."""
+
+import argparse
+import logging
+import time
+
+import mxnet as mx
+
+logging.basicConfig(level=logging.INFO)
+parser = argparse.ArgumentParser(description='ImageRecordIter fused_decode throughput benchmark')
+parser.add_argument('--rec', type=str, required=True,
+                    help='RecordIO file of JPEG images, e.g. an ImageNet validation set')
+parser.add_argument('--data-shape', type=int, default=224,
+                    help='height and width of the cropped images')
+parser.add_argument('--resize', type=int, default=256,
+                    help='shorter edge the images are resized to before cropping')
+parser.add_argument('--batch-size', type=int, default=128,
+                    help='batch size')
+parser.add_argument('--threads', type=int, default=1,
+                    help='number of preprocess threads')
+parser.add_argument('--dtype', type=str, default='float32',
+                    help='data type of the batches, uint8 or float32')
+parser.add_argument('--num-batches', type=int, default=50,
+                    help='number of timed batches')
+opt = parser.parse_args()
+
+
+def benchmark(fused_decode):
+    data_iter = mx.io.ImageRecordIter(path_imgrec=opt.rec, batch_size=opt.batch_size,
+                                      data_shape=(3, opt.data_shape, opt.data_shape),
+                                      resize=opt.resize, rand_crop=True, rand_mirror=True,
+                                      mean_r=123.68, mean_g=116.779, mean_b=103.939,
+                                      std_r=58.4, std_g=57.1, std_b=57.4, dtype=opt.dtype,
+                                      preprocess_threads=opt.threads, prefetch_buffer=1,
+                                      fused_decode=fused_decode)
+    # warm up the decoders and the prefetcher
+    for _, batch in zip(range(2), data_iter):
+        batch.data[0].wait_to_read()
+    num_batches = 0
+    tic = time.time()
+    for batch in data_iter:
+        batch.data[0].wait_to_read()
+        num_batches += 1
+        if num_batches == opt.num_batches:
+            break
+    elapsed = time.time() - tic
+    return num_batches * opt.batch_size / elapsed
+
+
+if __name__ == '__main__':
+    # the iterator logs whether the fused path is used
+    regular = benchmark(False)
+    fused = benchmark(True)
+    logging.info('regular decode: %.1f images/sec, %.1f images/sec per thread',
+                 regular, regular / opt.threads)
+    logging.info('fused decode:   %.1f images/sec, %.1f images/sec per thread (%.2fx)',
+                 fused, fused / opt.threads, fused / regular)
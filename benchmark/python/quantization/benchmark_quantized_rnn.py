@@ -0,0 +1,82 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+import time
+import mxnet as mx
+
+
+def time_forward(fn, repeats):
+    fn().wait_to_read()
+    tic = time.time()
+    for _ in range(repeats):
+        out = fn()
+    out.wait_to_read()
+    return (time.time() - tic) * 1000 / repeats
+
+
+def benchmark_rnn(mode, seq_len, batch_size, input_size, state_size, num_layers=1,
+                  bidirectional=False, repeats=20):
+    ctx = mx.cpu()
+    directions = 2 if bidirectional else 1
+    data_shape = (seq_len, batch_size, input_size)
+    state_shape = (num_layers * directions, batch_size, state_size)
+    rnn = mx.sym.RNN(data=mx.sym.Variable('data'), state_size=state_size, num_layers=num_layers,
+                     bidirectional=bidirectional, mode=mode, name='rnn')
+    arg_shapes, _, _ = rnn.infer_shape(data=data_shape)
+    data = mx.nd.random.uniform(-1, 1, shape=data_shape, ctx=ctx)
+    params = mx.nd.random.uniform(-0.1, 0.1, shape=arg_shapes[1], ctx=ctx)
+    states = [mx.nd.zeros(state_shape, ctx=ctx)]
+    if mode == 'lstm':
+        states.append(mx.nd.zeros(state_shape, ctx=ctx))
+    kwargs = {'state_size': state_size, 'num_layers': num_layers,
+              'bidirectional': bidirectional, 'mode': mode}
+
+    output = mx.nd.RNN(data, params, *states, **kwargs)
+    out_range = float(mx.nd.max(mx.nd.abs(output)).asscalar())
+    qdata, min_data, max_data = mx.nd.contrib.quantize_v2(data, out_type='int8')
+
+    def fp32_forward():
+        return mx.nd.RNN(data, params, *states, **kwargs)
+
+    def int8_forward():
+        return mx.nd.contrib.quantized_rnn(qdata, params, *(states + [min_data, max_data]),
+                                           min_calib_range=-out_range, max_calib_range=out_range,
+                                           **kwargs)[0]
+
+    fp32_time = time_forward(fp32_forward, repeats)
+    int8_time = time_forward(int8_forward, repeats)
+    qoutput, min_output, max_output = mx.nd.contrib.quantized_rnn(
+        qdata, params, *(states + [min_data, max_data]),
+        min_calib_range=-out_range, max_calib_range=out_range, **kwargs)
+    error = mx.nd.abs(mx.nd.contrib.dequantize(qoutput, min_output, max_output) - output)
+
+    print('==================================================================================================')
+    print('mode=%s, data=%s, state_size=%s, num_layers=%s, bidirectional=%s, repeats=%s'
+          % (mode, data_shape, state_size, num_layers, bidirectional, repeats))
+    print('RNN-FP32,       ctx=%s, time=%.2f ms' % (ctx, fp32_time))
+    print('quantized_rnn,  ctx=%s, time=%.2f ms' % (ctx, int8_time))
+    print('quantization speedup:               %.1fX' % (fp32_time / int8_time))
+    print('max abs error: %.4f, mean abs error: %.4f'
+          % (mx.nd.max(error).asscalar(), mx.nd.mean(error).asscalar()))
+    print('\n')
+
+
+if __name__ == '__main__':
+    for mode in ['lstm', 'gru']:
+        for batch_size in [1, 32, 64]:
+            benchmark_rnn(mode, seq_len=50, batch_size=batch_size, input_size=512, state_size=512)
+            benchmark_rnn(mode, seq_len=50, batch_size=batch_size, input_size=1024, state_size=1024,
+                          num_layers=2, bidirectional=True)
@@ -0,0 +1,83 @@
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+"""Forward and backward time of chains of unary and binary elementwise operators,
+with and without the ELEMWISE_FUSION subgraph backend."""
+
+import argparse
+import logging
+import time
+
+import mxnet as mx
+
+logging.basicConfig(level=logging.INFO)
+parser = argparse.ArgumentParser(description='ELEMWISE_FUSION subgraph backend benchmark')
+parser.add_argument('--shape', type=str, default='1024,1024',
+                    help='shape of the inputs')
+parser.add_argument('--dtype', type=str, default='float32',
+                    help='data type of the inputs')
+parser.add_argument('--runs', type=int, default=50,
+                    help='number of timed runs')
+parser.add_argument('--warmup', type=int, default=5,
+                    help='number of runs before timing')
+opt = parser.parse_args()
+
+
+def unary_chain():
+    # same operators as the opperf unary suite, chained
+    x = mx.sym.var('a')
+    for op in [mx.sym.abs, mx.sym.sqrt, mx.sym.exp, mx.sym.log, mx.sym.square,
+               mx.sym.sigmoid, mx.sym.tanh, mx.sym.relu]:
+        x = op(x)
+    return x
+
+
+def binary_chain():
+    # same operators as the opperf binary suite, chained
+    a, b, c = mx.sym.var('a'), mx.sym.var('b'), mx.sym.var('c')
+    x = mx.sym.elemwise_add(mx.sym.elemwise_mul(a, b), c)
+    x = mx.sym.elemwise_div(mx.sym.elemwise_sub(x, a), mx.sym.abs(c) + 1.0)
+    return mx.sym.elemwise_mul(x * 2.0 - 1.0, b)
+
+
+def benchmark(sym, backward):
+    shape = tuple(int(s) for s in opt.shape.split(','))
+    args = {name: mx.nd.random.uniform(0.5, 1.5, shape=shape, dtype=opt.dtype)
+            for name in sym.list_arguments()}
+    grads = {name: mx.nd.zeros_like(arg) for name, arg in args.items()}
+    exe = sym.bind(mx.cpu(), args=args, args_grad=grads if backward else None)
+    out_grad = mx.nd.ones(shape, dtype=opt.dtype)
+    for i in range(opt.warmup + opt.runs):
+        if i == opt.warmup:
+            mx.nd.waitall()
+            tic = time.time()
+        exe.forward(is_train=backward)
+        if backward:
+            exe.backward([out_grad])
+    mx.nd.waitall()
+    return (time.time() - tic) / opt.runs * 1000
+
+
+if __name__ == '__main__':
+    for name, sym in [('unary', unary_chain()), ('binary', binary_chain())]:
+        fused_sym = sym.get_backend_symbol('ELEMWISE_FUSION')
+        for backward in [False, True]:
+            regular = benchmark(sym, backward)
+            fused = benchmark(fused_sym, backward)
+            logging.info('%s chain %s: %.3f ms unfused, %.3f ms fused (%.2fx)', name,
+                         'forward+backward' if backward else 'forward', regular, fused,
+                         regular / fused)
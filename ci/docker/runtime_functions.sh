@@ -1169,6 +1169,8 @@ integrationtest_ubuntu_cpu_dist_kvstore() {
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu
     ../../tools/launch.py -n 7 --launcher local python dist_sync_kvstore.py --type=compressed_cpu --no-multiprecision
     ../../tools/launch.py -n 3 --launcher local python test_server_profiling.py
+    ../../tools/launch.py -n 7 --launcher local python dist_sync_hierarchical_kvstore.py
+    ../../tools/launch.py -n 7 --launcher local python dist_sync_hierarchical_kvstore.py --num-nodes=1
     popd
 }
 
@@ -351,6 +351,22 @@ MXNET_DLL int MXAggregateProfileStatsPrint(const char **out_str, int reset);
 MXNET_DLL int MXAggregateProfileStatsPrintEx(const char **out_str, int reset, int format,
                                             int sort_by, int ascending);
 
+/*!
+ * \brief Start or stop the streaming profiler, which records operator latencies into
+ *        per-thread ring buffers independently of the profiler state
+ * \param state 1 to start recording, 0 to stop
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXSetStreamingProfilerState(int state);
+
+/*!
+ * \brief Print per-operator latency percentiles of the streaming profiler to a string
+ * \param out_str will receive a pointer to the output string
+ * \param reset clear the latency histograms after printing
+ * \return 0 when success, -1 when failure happens.
+ */
+MXNET_DLL int MXStreamingProfileStatsPrint(const char **out_str, int reset);
+
 /*!
  * \brief Pause profiler tuning collection
  * \param paused If nonzero, profiling pauses. Otherwise, profiling resumes/continues
@@ -655,6 +671,19 @@ MXNET_DLL int MXNDArraySave(const char* fname,
                             uint32_t num_args,
                             NDArrayHandle* args,
                             const char** keys);
+/*!
+ * \brief Save list of narray into the file with page aligned data. MXNDArrayLoad maps
+ *  such files into memory instead of copying them.
+ * \param fname name of the file.
+ * \param num_args number of arguments to save.
+ * \param args the array of NDArrayHandles to be saved.
+ * \param keys the name of the NDArray, optional, can be NULL
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXNDArraySaveAligned(const char* fname,
+                                   uint32_t num_args,
+                                   NDArrayHandle* args,
+                                   const char** keys);
 /*!
  * \brief Load list of narray from the file.
  * \param fname name of the file.
@@ -1186,6 +1215,16 @@ MXNET_DLL int MXIsNumpyShape(bool* curr);
  * \return 0 when success, -1 when failure happens
  */
 MXNET_DLL int MXSetIsNumpyShape(int is_np_shape, int* prev);
+/*!
+ * \brief get the statistics of the imperative dispatch cache, summed over all threads
+ * \param hits returns the number of operator calls that skipped shape, type and storage inference
+ * \param misses returns the number of cacheable operator calls that ran inference
+ * \param saved_ns returns the inference time skipped by the hits, in nanoseconds
+ * \param reset clear the statistics after reading them
+ * \return 0 when success, -1 when failure happens
+ */
+MXNET_DLL int MXImperativeDispatchCacheStats(uint64_t *hits, uint64_t *misses,
+                                             uint64_t *saved_ns, int reset);
 /*!
  * \brief mark NDArrays as variables to compute gradient for autograd
  * \param num_var number of variable NDArrays
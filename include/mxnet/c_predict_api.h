@@ -51,6 +51,10 @@ typedef void *PredictorHandle;
 typedef void *NDListHandle;
 /*! \brief handle to NDArray */
 typedef void *NDArrayHandle;
+/*! \brief handle to a batching predictor server */
+typedef void *PredBatcherHandle;
+/*! \brief handle to a shape-bucketed predictor cache */
+typedef void *PredBucketHandle;
 /*! \brief callback used for add monitoring to nodes in the graph */
 typedef void (*PredMonitorCallback)(const char*,
                                     NDArrayHandle,
@@ -217,6 +221,67 @@ MXNET_DLL int MXPredReshape(uint32_t num_input_nodes,
                   const uint32_t* input_shape_data,
                   PredictorHandle handle,
                   PredictorHandle* out);
+/*!
+ * \brief Create a cache of predictors for varying input shapes, e.g. for variable
+ *  length sequences. Predictors are bound on demand for each new set of input shapes
+ *  and kept in an LRU cache. They all share the parameters of the original predictor
+ *  and the memory of a predictor bound for the largest input shapes.
+ * \param handle The original predictor handle. It must outlive the cache.
+ * \param num_input_nodes Number of input nodes to the net.
+ * \param input_keys The name of input argument.
+ * \param max_shape_indptr Index pointer of the largest shapes of each input node.
+ * \param max_shape_data A flattened data of the largest shapes of each input node.
+ * \param cache_size Maximum number of predictors cached besides the largest one.
+ * \param out The created cache handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBucketCreate(PredictorHandle handle,
+                                 uint32_t num_input_nodes,
+                                 const char** input_keys,
+                                 const uint32_t* max_shape_indptr,
+                                 const uint32_t* max_shape_data,
+                                 uint32_t cache_size,
+                                 PredBucketHandle* out);
+/*!
+ * \brief Get the predictor for the given input shapes, binding it on a cache miss.
+ *  The returned predictor is owned by the cache and must not be freed. It stays valid
+ *  until it is evicted, which happens at the earliest after cache_size calls for
+ *  other input shapes. No dimension may exceed the maximum shape of its input.
+ *  This function is not thread-safe, calls on the same cache must be serialized.
+ * \param handle The cache handle.
+ * \param num_input_nodes Number of input nodes to the net.
+ * \param input_keys The name of input argument.
+ * \param input_shape_indptr Index pointer of shapes of each input node.
+ * \param input_shape_data A flattened data of shapes of each input node.
+ * \param out The predictor handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBucketGet(PredBucketHandle handle,
+                              uint32_t num_input_nodes,
+                              const char** input_keys,
+                              const uint32_t* input_shape_indptr,
+                              const uint32_t* input_shape_data,
+                              PredictorHandle* out);
+/*!
+ * \brief Get the statistics of a predictor cache.
+ * \param handle The cache handle.
+ * \param hits Number of MXPredBucketGet calls served from the cache.
+ * \param misses Number of MXPredBucketGet calls that bound a new predictor.
+ * \param evictions Number of predictors evicted from the cache.
+ * \param num_cached Number of predictors currently cached, including the largest one.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBucketGetStats(PredBucketHandle handle,
+                                   uint64_t* hits,
+                                   uint64_t* misses,
+                                   uint64_t* evictions,
+                                   uint32_t* num_cached);
+/*!
+ * \brief Free a predictor cache and all of its predictors.
+ * \param handle The cache handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBucketFree(PredBucketHandle handle);
 /*!
  * \brief Get the shape of output node.
  *  The returned shape_data and shape_ndim is only valid before next call to MXPred function.
@@ -296,6 +361,74 @@ MXNET_DLL int MXPredGetOutput(PredictorHandle handle,
  * \return 0 when success, -1 when failure.
  */
 MXNET_DLL int MXPredFree(PredictorHandle handle);
+/*!
+ * \brief Create a server that coalesces requests from many threads into dynamic batches.
+ *  The first dimension of every input and output of the predictor is treated as the
+ *  batch dimension. Requests are queued and run together on executors bound for power
+ *  of two batch sizes up to max_batch_size, padding the unused rows.
+ *  The predictor only provides the symbol and the parameters and must outlive the server.
+ * \param handle The predictor handle.
+ * \param num_input_nodes Number of inputs sent with each request.
+ * \param input_keys The name of each input.
+ * \param max_batch_size The maximum number of samples run in one forward pass.
+ * \param max_wait_us How long the oldest queued request may wait for more requests, in
+ *    microseconds, before a partial batch is run.
+ * \param num_workers The number of threads running batches, each with its own executors.
+ *    Their forward passes only run concurrently with MXNET_ENGINE_TYPE set to NaiveEngine,
+ *    the threaded engines run them one at a time.
+ * \param out The created server handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatcherCreate(PredictorHandle handle,
+                                  uint32_t num_input_nodes,
+                                  const char** input_keys,
+                                  uint32_t max_batch_size,
+                                  uint32_t max_wait_us,
+                                  uint32_t num_workers,
+                                  PredBatcherHandle* out);
+/*!
+ * \brief Run one request and block until its outputs are written. Thread safe.
+ * \param handle The server handle.
+ * \param batch_size The number of samples in this request, at most max_batch_size.
+ * \param input_data The data of each input, in the order of input_keys at creation,
+ *    holding batch_size samples each.
+ * \param num_outputs The number of outputs to fetch, the first num_outputs outputs
+ *    of the predictor are written.
+ * \param output_data User allocated buffers holding batch_size samples of each output.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatcherForward(PredBatcherHandle handle,
+                                   uint32_t batch_size,
+                                   const float** input_data,
+                                   uint32_t num_outputs,
+                                   float** output_data);
+/*!
+ * \brief Get the statistics of a server.
+ *  The returned batch_size_counts is only valid before the next call on this handle.
+ * \param handle The server handle.
+ * \param num_percentiles The number of latency percentiles to compute.
+ * \param percentiles The requested percentiles in [0, 100].
+ * \param latency_us The end to end request latency at each percentile in microseconds,
+ *    computed over the most recent requests.
+ * \param num_requests The number of completed requests.
+ * \param batch_size_counts The number of forward passes run with each number of real
+ *    samples, indexed by the number of samples.
+ * \param num_counts The length of batch_size_counts, max_batch_size + 1.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatcherGetStats(PredBatcherHandle handle,
+                                    uint32_t num_percentiles,
+                                    const float* percentiles,
+                                    float* latency_us,
+                                    uint64_t* num_requests,
+                                    const uint64_t** batch_size_counts,
+                                    uint32_t* num_counts);
+/*!
+ * \brief Stop a server after the queued requests are done and free it.
+ * \param handle The server handle.
+ * \return 0 when success, -1 when failure.
+ */
+MXNET_DLL int MXPredBatcherFree(PredBatcherHandle handle);
 /*!
  * \brief Create a NDArray List by loading from ndarray file.
  *     This can be used to load mean image file.
@@ -35,6 +35,10 @@
 #include "./ndarray.h"
 
 namespace mxnet {
+namespace imperative {
+struct DispatchInfo;
+}  // namespace imperative
+
 /*! \brief runtime functions for NDArray */
 class Imperative {
  public:
@@ -126,7 +130,8 @@ class Imperative {
                       const std::vector<NDArray*>& outputs,
                       const std::vector<OpReqType>& req,
                       const DispatchMode dispatch_mode,
-                      OpStatePtr state = OpStatePtr());
+                      OpStatePtr state = OpStatePtr(),
+                      const imperative::DispatchInfo* dispatch_info = nullptr);
   /*! \brief mark variables for computing gradients. */
   void MarkVariables(const std::vector<NDArray*>& variables,
                      const std::vector<uint32_t>& grad_reqs,
@@ -131,6 +131,10 @@
 #define MXNET_USE_TVM_OP 0
 #endif
 
+#ifndef MXNET_USE_LIBJPEG_TURBO
+#define MXNET_USE_LIBJPEG_TURBO 0
+#endif
+
 namespace mxnet {
 namespace features {
 // Check compile flags such as CMakeLists.txt
@@ -192,6 +196,9 @@ enum : unsigned {
   // TVM operator
   TVM_OP,
 
+  // JPEG decoding with libjpeg-turbo, enables fused_decode of ImageRecordIter
+  LIBJPEG_TURBO,
+
   // size indicator
   MAX_FEATURES
 };
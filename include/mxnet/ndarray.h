@@ -326,6 +326,10 @@ class NDArray {
   inline bool is_none() const {
     return ptr_.get() == nullptr;
   }
+  /*! \return whether no other ndarray shares the chunk of this one */
+  inline bool is_unique() const {
+    return ptr_.use_count() == 1;
+  }
   /*! \return updated grad state in entry_ */
   bool fresh_out_grad() const;
   /*! \return updated grad state in entry_ */
@@ -565,7 +569,7 @@ class NDArray {
     CHECK_EQ(storage_type(), kDefaultStorage)
              << "AsArray is intended only for kDefaultStorage.";
     CHECK_GE(ptr_->shandle.size,
-             shape.Size() * mshadow::mshadow_sizeof(dtype))
+             byte_offset_ + shape.Size() * mshadow::mshadow_sizeof(dtype))
         << "NDArray.AsArray: target memory size is bigger";
     // We can't reuse memory in a view.
     CHECK(!IsView());
@@ -576,6 +580,33 @@ class NDArray {
     return ret;
   }
 
+  /*!
+   * \brief Create a NDArray that shares memory with current one, starting at
+   *  the given byte offset. This is used to sub-allocate arrays out of one
+   *  buffer. Like AsArray, the result reuses the memory rather than being a
+   *  view, and it shares the engine variable of the current array.
+   * \param byte_offset offset in bytes from the start of the current array
+   * \param shape new shape
+   * \param dtype The data type.
+   * \return NDArray in new shape and type.
+   */
+  inline NDArray AsArrayWithOffset(size_t byte_offset, const mxnet::TShape &shape,
+                                   int dtype) const {
+    CHECK_EQ(storage_type(), kDefaultStorage)
+             << "AsArrayWithOffset is intended only for kDefaultStorage.";
+    CHECK_GE(ptr_->shandle.size,
+             byte_offset_ + byte_offset + shape.Size() * mshadow::mshadow_sizeof(dtype))
+        << "NDArray.AsArrayWithOffset: target memory range is out of bound";
+    // We can't reuse memory in a view.
+    CHECK(!IsView());
+    NDArray ret = *this;
+    ret.byte_offset_ += byte_offset;
+    ret.shape_ = shape;
+    ret.dtype_ = dtype;
+    ret.reuse_ = true;
+    return ret;
+  }
+
   /*!
    * \brief Create a reference view of NDArray that
    *  represents as DLManagedTensor.
@@ -810,6 +841,28 @@ class NDArray {
   static void Load(dmlc::Stream* fi,
                    std::vector<NDArray>* data,
                    std::vector<std::string>* keys);
+  /*!
+   * \brief Save list of ndarray into the Stream with a header index and page aligned
+   *  data, so the file can be loaded with LoadMapped. Load also reads this layout.
+   * \param fo The stream of output.
+   * \param data the NDArrays to be saved, only default storage is supported.
+   * \param names the name of the NDArray, optional, can be zero length.
+   */
+  static void SaveAligned(dmlc::Stream* fo,
+                          const std::vector<NDArray>& data,
+                          const std::vector<std::string>& names);
+  /*!
+   * \brief Load list of ndarray saved by SaveAligned by mapping the file into memory.
+   *  The returned cpu NDArrays are backed by private copy-on-write pages of the file,
+   *  so processes loading the same file share one page cache copy until they write.
+   * \param fname name of a local file.
+   * \param data the NDArrays to be loaded
+   * \param keys the name of the NDArray, if saved in the file.
+   * \return false if the file cannot be opened locally or is not in the aligned layout.
+   */
+  static bool LoadMapped(const std::string& fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys);
 
  private:
   friend class Imperative;
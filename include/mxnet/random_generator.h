@@ -25,8 +25,12 @@
 #ifndef MXNET_RANDOM_GENERATOR_H_
 #define MXNET_RANDOM_GENERATOR_H_
 
+#include <cmath>
+#include <cstdint>
+#include <limits>
 #include <random>
 #include <new>
+#include <type_traits>
 #include "./base.h"
 
 #if MXNET_USE_CUDA
@@ -41,6 +45,55 @@ namespace random {
 template<typename Device, typename DType MSHADOW_DEFAULT_DTYPE>
 class RandGenerator;
 
+/*!
+ * \brief Philox4x32-10 counter based random number generator, see Salmon et al.,
+ *  "Parallel Random Numbers: As Easy as 1, 2, 3". Each output only depends on the key and
+ *  the counter, so streams can be split and skipped without any sequential state.
+ */
+struct Philox4x32 {
+  /*! \brief number of 4-word blocks generated at once */
+  static const int kBatch = 4;
+  /*! \brief number of words generated at once */
+  static const int kBatchWords = 4 * kBatch;
+
+  /*!
+   * \brief generate the blocks of counters counter, ..., counter + kBatch - 1. The blocks
+   *  are computed side by side so that the rounds vectorize.
+   */
+  static inline void Generate(const uint32_t key[2], uint64_t counter,
+                              uint32_t out[kBatchWords]) {
+    const uint32_t kM0 = 0xD2511F53, kM1 = 0xCD9E8D57;
+    const uint32_t kW0 = 0x9E3779B9, kW1 = 0xBB67AE85;
+    uint32_t c0[kBatch], c1[kBatch], c2[kBatch], c3[kBatch];
+    for (int b = 0; b < kBatch; ++b) {
+      c0[b] = static_cast<uint32_t>(counter + b);
+      c1[b] = static_cast<uint32_t>((counter + b) >> 32);
+      c2[b] = 0;
+      c3[b] = 0;
+    }
+    uint32_t k0 = key[0], k1 = key[1];
+    for (int round = 0; round < 10; ++round) {
+      #pragma omp simd
+      for (int b = 0; b < kBatch; ++b) {
+        const uint64_t p0 = static_cast<uint64_t>(kM0) * c0[b];
+        const uint64_t p1 = static_cast<uint64_t>(kM1) * c2[b];
+        c0[b] = static_cast<uint32_t>(p1 >> 32) ^ c1[b] ^ k0;
+        c1[b] = static_cast<uint32_t>(p1);
+        c2[b] = static_cast<uint32_t>(p0 >> 32) ^ c3[b] ^ k1;
+        c3[b] = static_cast<uint32_t>(p0);
+      }
+      k0 += kW0;
+      k1 += kW1;
+    }
+    for (int b = 0; b < kBatch; ++b) {
+      out[4 * b] = c0[b];
+      out[4 * b + 1] = c1[b];
+      out[4 * b + 2] = c2[b];
+      out[4 * b + 3] = c3[b];
+    }
+  }
+};
+
 template<typename DType>
 class RandGenerator<cpu, DType> {
  public:
@@ -49,43 +102,99 @@ class RandGenerator<cpu, DType> {
   // store how many global random states for CPU.
   static const int kNumRandomStates;
 
+  // state of one random stream: a Philox key and the next block counter
+  struct State {
+    uint32_t key[2];
+    uint64_t counter;
+  };
+
   // implementation class for random number generator
   // TODO(alexzai): move impl class to separate file - tracked in MXNET-948
   class Impl {
    public:
     typedef typename std::conditional<std::is_floating_point<DType>::value,
                                       DType, double>::type FType;
+    // Copy state to local memory for efficiency.
     explicit Impl(RandGenerator<cpu, DType> *gen, int state_idx)
-        : engine_(gen->states_ + state_idx) {}
+        : global_state_(gen->states_ + state_idx), state_(*global_state_) {}
+
+    ~Impl() {
+      // store the advanced counter back, unused words of the last batch are skipped
+      *global_state_ = state_;
+    }
 
     Impl(const Impl &) = delete;
     Impl &operator=(const Impl &) = delete;
 
-    MSHADOW_XINLINE int rand() { return engine_->operator()(); }
+    MSHADOW_XINLINE int rand() { return static_cast<int>(next()); }
 
     MSHADOW_XINLINE int64_t rand_int64() {
-      return static_cast<int64_t>(engine_->operator()() << 31) + engine_->operator()();
+      const uint64_t hi = next();
+      const uint64_t lo = next();
+      return static_cast<int64_t>((hi << 31) + lo);
     }
 
     MSHADOW_XINLINE FType uniform() {
-      typedef typename std::conditional<std::is_integral<DType>::value,
-      std::uniform_int_distribution<DType>,
-      std::uniform_real_distribution<FType>>::type GType;
-      GType dist_uniform;
-      return dist_uniform(*engine_);
+      return uniform(std::is_integral<DType>());
     }
 
     MSHADOW_XINLINE FType normal() {
-      std::normal_distribution<FType> dist_normal;
-      return dist_normal(*engine_);
+      // Box-Muller, the second value is kept for the next call
+      if (has_normal_) {
+        has_normal_ = false;
+        return normal_;
+      }
+      const FType u1 = FType(1) - uniform_real(FType());
+      const FType u2 = uniform_real(FType());
+      const FType r = std::sqrt(FType(-2) * std::log(u1));
+      const FType theta = FType(6.283185307179586) * u2;
+      normal_ = r * std::sin(theta);
+      has_normal_ = true;
+      return r * std::cos(theta);
     }
 
    private:
-    std::mt19937 *engine_;
+    MSHADOW_XINLINE uint32_t next() {
+      if (pos_ == Philox4x32::kBatchWords) {
+        Philox4x32::Generate(state_.key, state_.counter, buffer_);
+        state_.counter += Philox4x32::kBatch;
+        pos_ = 0;
+      }
+      return buffer_[pos_++];
+    }
+
+    // integer in [0, max(DType)], as std::uniform_int_distribution<DType>
+    MSHADOW_XINLINE FType uniform(std::true_type) {
+      const uint64_t range = static_cast<uint64_t>(std::numeric_limits<DType>::max()) + 1;
+      const uint64_t bits = (static_cast<uint64_t>(next()) << 32) | next();
+      return FType(static_cast<DType>(bits % range));
+    }
+
+    MSHADOW_XINLINE FType uniform(std::false_type) {
+      return uniform_real(FType());
+    }
+
+    // real in [0, 1)
+    MSHADOW_XINLINE float uniform_real(float) {
+      return (next() >> 8) * (1.0f / 16777216.0f);
+    }
+
+    MSHADOW_XINLINE double uniform_real(double) {
+      const uint64_t hi = next() >> 5;
+      const uint64_t lo = next() >> 6;
+      return (hi * 67108864.0 + lo) * (1.0 / 9007199254740992.0);
+    }
+
+    State *global_state_;
+    State state_;
+    uint32_t buffer_[Philox4x32::kBatchWords];
+    int pos_ = Philox4x32::kBatchWords;
+    bool has_normal_ = false;
+    FType normal_;
   };  // class RandGenerator<cpu, DType>::Impl
 
   static void AllocState(RandGenerator<cpu, DType> *inst) {
-    inst->states_ = new std::mt19937[kNumRandomStates];
+    inst->states_ = new State[kNumRandomStates];
   }
 
   static void FreeState(RandGenerator<cpu, DType> *inst) {
@@ -93,11 +202,16 @@ class RandGenerator<cpu, DType> {
   }
 
   MSHADOW_XINLINE void Seed(mshadow::Stream<cpu> *, uint32_t seed) {
-    for (int i = 0; i < kNumRandomStates; ++i) (states_ + i)->seed(seed + i);
+    // one stream per state, all starting at counter 0
+    for (int i = 0; i < kNumRandomStates; ++i) {
+      states_[i].key[0] = seed;
+      states_[i].key[1] = static_cast<uint32_t>(i);
+      states_[i].counter = 0;
+    }
   }
 
  private:
-  std::mt19937 *states_;
+  State *states_;
 };  // class RandGenerator<cpu, DType>
 
 template<typename DType>
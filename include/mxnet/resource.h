@@ -219,6 +219,13 @@ class ResourceManager {
    *       still hold by the manager singleton.
    */
   virtual Resource Request(Context ctx, const ResourceRequest &req) = 0;
+  /*!
+   * \brief Hand back a resource once the operations using it have been pushed.
+   *  Pooled temp space is reused for other requests after these operations complete,
+   *  other resources are not affected.
+   * \param res the resource returned by Request.
+   */
+  virtual void Release(const Resource &res) {}
   /*!
    * \brief Seed all the allocated random number generators.
    * \param seed the seed to the random number generators on all devices.
@@ -155,6 +155,8 @@ FP16_FP32_FUNCS = [
     '_mod_scalar',
     '_mp_adamw_update',
     '_mul_scalar',
+    '_multi_adamw_update',
+    '_multi_mp_adamw_update',
     '_not_equal_scalar',
     '_onehot_encode',
     '_ones',
@@ -277,9 +279,15 @@ FP16_FP32_FUNCS = [
     'min_axis',
     'mp_sgd_mom_update',
     'mp_sgd_update',
+    'multi_adam_update',
     'multi_all_finite',
+    'multi_mp_adam_update',
+    'multi_mp_nag_mom_update',
+    'multi_mp_rmsprop_update',
     'multi_mp_sgd_mom_update',
     'multi_mp_sgd_update',
+    'multi_nag_mom_update',
+    'multi_rmsprop_update',
     'multi_sgd_mom_update',
     'multi_sgd_update',
     'negative',
@@ -548,6 +548,12 @@ class Block(object):
             Optimize for invariant input shapes between iterations. Must also
             set static_alloc to True. Change of input shapes is still allowed
             but slower.
+        static_replay : bool, default False
+            Replay inference calls as a single engine operation over the
+            static memory plan. Inputs are copied into and outputs copied out
+            of fixed buffers, which cuts the per-call overhead of small
+            batches. Output arrays released by the caller are reused by later
+            calls. Must also set static_shape to True.
         """
         for cld in self._children.values():
             cld.hybridize(active, **kwargs)
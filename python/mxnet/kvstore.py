@@ -90,7 +90,8 @@ def _get_kvstore_server_command_type(command):
                      'kStopServer': 2,
                      'kSyncMode': 3,
                      'kSetGradientCompression': 4,
-                     'kSetProfilerParams': 5}
+                     'kSetProfilerParams': 5,
+                     'kRegisterNodeLeader': 6}
     assert (command in command_types), "Unknown command type to send to server"
     return command_types[command]
 
@@ -429,13 +430,25 @@ class KVStore(object):
         a dictionary which includes `threshold` like:
         {'type': '2bit', 'threshold': 0.5}
 
+        The following types are also supported, currently on CPU only. Like 2bit, they
+        keep the compression error in the residual and add it to the next gradient.
+
+        - `1bit` sends the sign of each value, and one scale per block of 1024 values
+          which is the mean absolute value of the block.
+        - `topk` sends the `ratio` fraction of values with largest magnitude out of each
+          block of 2048 values, as (index, value) pairs. `ratio` defaults to 0.01.
+        - `randomk` is like `topk` but sends randomly chosen values.
+        - `fp16` and `bf16` cast gradients to 16bit floats.
+
+        For example: {'type': 'topk', 'ratio': 0.01}
+
         Parameters
         ----------
         compression_params : dict
             A dictionary specifying the type and parameters for gradient compression.
             The key `type` in this dictionary is a
             required string argument and specifies the type of gradient compression.
-            Currently `type` can be only `2bit`
+            `type` can be `2bit`, `1bit`, `topk`, `randomk`, `fp16` or `bf16`.
             Other keys in this dictionary are optional and specific to the type
             of gradient compression.
         """
@@ -658,9 +671,15 @@ def create(name='local'):
     No two updates happen on the same weight at the same time. However, the order is not
     guaranteed.
 
+    ``dist_sync_hierarchical``: Same results as ``dist_sync``, for several worker processes
+    per machine. Workers on a machine first sum their gradients through shared memory,
+    then only one of them talks to the servers and shares the pulled weights with the
+    others. Only dense arrays are supported.
+
     Parameters
     ----------
-    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_async'}
+    name : {'local', 'device', 'nccl', 'dist_sync', 'dist_device_sync', 'dist_async',
+            'dist_sync_hierarchical', 'dist_sync_device_hierarchical'}
         The type of KVStore.
     Returns
     -------
@@ -219,7 +219,7 @@ def load_frombuffer(buf):
             for i in range(out_size.value))
 
 
-def save(fname, data):
+def save(fname, data, aligned=False):
     """Saves a list of arrays or a dict of str->array to file.
 
     Examples of filenames:
@@ -236,6 +236,10 @@ def save(fname, data):
            or list of NDArray, RowSparseNDArray or CSRNDArray, \
            or dict of str to NDArray, RowSparseNDArray or CSRNDArray
         The data to save.
+    aligned : bool, default False
+        Whether to write the data page aligned behind a header index. ``load`` maps
+        such local files into memory instead of copying them, so the loaded arrays
+        share the page cache. Only supports default storage arrays.
 
     Examples
     --------
@@ -274,7 +278,8 @@ def save(fname, data):
     else:
         raise ValueError("data needs to either be a NDArray, dict of str, NDArray pairs "
                          "or a list of NDarrays.")
-    check_call(_LIB.MXNDArraySave(c_str(fname),
-                                  mx_uint(len(handles)),
-                                  handles,
-                                  keys))
+    save_fn = _LIB.MXNDArraySaveAligned if aligned else _LIB.MXNDArraySave
+    check_call(save_fn(c_str(fname),
+                       mx_uint(len(handles)),
+                       handles,
+                       keys))
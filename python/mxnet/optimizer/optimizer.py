@@ -31,7 +31,9 @@ from ..ndarray import (sgd_update, sgd_mom_update, adam_update, rmsprop_update,
                        mp_sgd_update, mp_sgd_mom_update, square, ftrl_update, ftml_update,
                        signsgd_update, signum_update, nag_mom_update, mp_nag_mom_update,
                        multi_sgd_update, multi_sgd_mom_update, multi_mp_sgd_update,
-                       multi_mp_sgd_mom_update)
+                       multi_mp_sgd_mom_update, multi_adam_update, multi_mp_adam_update,
+                       multi_rmsprop_update, multi_mp_rmsprop_update, multi_nag_mom_update,
+                       multi_mp_nag_mom_update)
 from ..ndarray import sparse
 from ..random import normal
 from ..util import is_np_array
@@ -45,6 +47,10 @@ __all__ = [
 def _flatten_list(nested_list):
     return [item for sublist in nested_list for item in sublist]
 
+def _multi_update_aggregate_num():
+    # the fused Adam, RMSProp and NAG updates take at most 45 weights per call
+    return min(int(os.getenv('MXNET_OPTIMIZER_AGGREGATION_SIZE', "4")), 45)
+
 class Optimizer(object):
     """The base class inherited by all optimizers.
 
@@ -1053,6 +1059,7 @@ class NAG(Optimizer):
     def __init__(self, momentum=0.0, **kwargs):
         super(NAG, self).__init__(**kwargs)
         self.momentum = momentum
+        self.aggregate_num = _multi_update_aggregate_num()
 
     def create_state_multi_precision(self, index, weight):
         weight_master_copy = None
@@ -1072,12 +1079,22 @@ class NAG(Optimizer):
             momentum = zeros(weight.shape, weight.context, dtype=weight.dtype)
         return momentum
 
-    def _update_impl(self, index, weight, grad, state, multi_precision=False):
-        assert(isinstance(weight, NDArray))
-        assert(isinstance(grad, NDArray))
-        self._update_count(index)
-        lr = self._get_lr(index)
-        wd = self._get_wd(index)
+    def _update_impl(self, indices, weights, grads, states, multi_precision=False):
+        aggregate = True
+        if not isinstance(indices, (tuple, list)):
+            indices = [indices]
+            weights = [weights]
+            grads = [grads]
+            states = [states]
+        for weight, grad in zip(weights, grads):
+            assert(isinstance(weight, NDArray))
+            assert(isinstance(grad, NDArray))
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
 
         kwargs = {'rescale_grad': self.rescale_grad}
         if self.momentum > 0:
@@ -1085,25 +1102,50 @@ class NAG(Optimizer):
         if self.clip_gradient:
             kwargs['clip_gradient'] = self.clip_gradient
 
-        if not multi_precision:
-            if state is not None:
-                nag_mom_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
+        if aggregate:
+            if not multi_precision:
+                if self.momentum > 0:
+                    multi_nag_mom_update(*_flatten_list(zip(weights, grads, states)),
+                                         out=weights, num_weights=len(weights),
+                                         lrs=lrs, wds=wds, **kwargs)
+                else:
+                    multi_sgd_update(*_flatten_list(zip(weights, grads)), out=weights,
+                                     num_weights=len(weights), lrs=lrs, wds=wds, **kwargs)
             else:
-                sgd_update(weight, grad, out=weight, lr=lr, wd=wd, **kwargs)
+                if self.momentum > 0:
+                    multi_mp_nag_mom_update(*_flatten_list(zip(weights, grads, *zip(*states))),
+                                            out=weights, num_weights=len(weights),
+                                            lrs=lrs, wds=wds, **kwargs)
+                else:
+                    multi_mp_sgd_update(*_flatten_list(zip(weights, grads,
+                                                           list(zip(*states))[1])),
+                                        out=weights, num_weights=len(weights),
+                                        lrs=lrs, wds=wds, **kwargs)
         else:
-            if state[0] is not None:
-                mp_nag_mom_update(weight, grad, state[0], state[1], out=weight,
-                                  lr=lr, wd=wd, **kwargs)
-            else:
-                mp_sgd_update(weight, grad, state[1], out=weight,
-                              lr=lr, wd=wd, **kwargs)
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                if not multi_precision:
+                    if state is not None:
+                        nag_mom_update(weight, grad, state, out=weight, lr=lr, wd=wd, **kwargs)
+                    else:
+                        sgd_update(weight, grad, out=weight, lr=lr, wd=wd, **kwargs)
+                else:
+                    if state[0] is not None:
+                        mp_nag_mom_update(weight, grad, state[0], state[1], out=weight,
+                                          lr=lr, wd=wd, **kwargs)
+                    else:
+                        mp_sgd_update(weight, grad, state[1], out=weight,
+                                      lr=lr, wd=wd, **kwargs)
 
     def update(self, index, weight, grad, state):
         self._update_impl(index, weight, grad, state, multi_precision=False)
 
     def update_multi_precision(self, index, weight, grad, state):
-        use_multi_precision = self.multi_precision and weight.dtype == numpy.float16 \
-                                and isinstance(state, (tuple, list))
+        if not isinstance(index, (tuple, list)):
+            use_multi_precision = self.multi_precision and weight.dtype == numpy.float16 \
+                                    and isinstance(state, (tuple, list))
+        else:
+            use_multi_precision = self.multi_precision and weight[0].dtype == numpy.float16 \
+                                    and isinstance(state[0], (tuple, list))
         self._update_impl(index, weight, grad, state,
                           multi_precision=use_multi_precision)
 
@@ -1200,6 +1242,7 @@ class Adam(Optimizer):
         self.beta2 = beta2
         self.epsilon = epsilon
         self.lazy_update = lazy_update
+        self.aggregate_num = _multi_update_aggregate_num()
 
     def create_state(self, index, weight):
         stype = weight.stype if self.lazy_update else 'default'
@@ -1208,26 +1251,66 @@ class Adam(Optimizer):
                 zeros(weight.shape, weight.context, dtype=weight.dtype,
                       stype=stype))  # variance
 
-    def update(self, index, weight, grad, state):
-        assert(isinstance(weight, NDArray))
-        assert(isinstance(grad, NDArray))
-        self._update_count(index)
-        lr = self._get_lr(index)
-        wd = self._get_wd(index)
-
-        t = self._index_update_count[index]
-        coef1 = 1. - self.beta1**t
-        coef2 = 1. - self.beta2**t
-        lr *= math.sqrt(coef2)/coef1
+    def _update_impl(self, indices, weights, grads, states, multi_precision=False):
+        aggregate = True
+        if not isinstance(indices, (tuple, list)):
+            indices = [indices]
+            weights = [weights]
+            grads = [grads]
+            states = [states]
+        for weight, grad in zip(weights, grads):
+            assert(isinstance(weight, NDArray))
+            assert(isinstance(grad, NDArray))
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
+        for i, index in enumerate(indices):
+            t = self._index_update_count[index]
+            coef1 = 1. - self.beta1**t
+            coef2 = 1. - self.beta2**t
+            lrs[i] *= math.sqrt(coef2)/coef1
 
         kwargs = {'beta1': self.beta1, 'beta2': self.beta2, 'epsilon': self.epsilon,
                   'rescale_grad': self.rescale_grad}
         if self.clip_gradient:
             kwargs['clip_gradient'] = self.clip_gradient
 
-        mean, var = state
-        adam_update(weight, grad, mean, var, out=weight,
-                    lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
+        if aggregate:
+            if not multi_precision:
+                multi_adam_update(*_flatten_list(zip(weights, grads, *zip(*states))),
+                                  out=weights, num_weights=len(weights),
+                                  lrs=lrs, wds=wds, **kwargs)
+            else:
+                weights32, moments = zip(*states)
+                multi_mp_adam_update(*_flatten_list(zip(weights, grads, *zip(*moments),
+                                                        weights32)),
+                                     out=weights, num_weights=len(weights),
+                                     lrs=lrs, wds=wds, **kwargs)
+        else:
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                if not multi_precision:
+                    mean, var = state
+                    adam_update(weight, grad, mean, var, out=weight,
+                                lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
+                else:
+                    weight32, (mean, var) = state
+                    adam_update(weight32, grad.astype(numpy.float32), mean, var, out=weight32,
+                                lazy_update=self.lazy_update, lr=lr, wd=wd, **kwargs)
+                    cast(weight32, dtype=weight.dtype, out=weight)
+
+    def update(self, index, weight, grad, state):
+        self._update_impl(index, weight, grad, state, multi_precision=False)
+
+    def update_multi_precision(self, index, weight, grad, state):
+        if not isinstance(index, (tuple, list)):
+            use_multi_precision = self.multi_precision and weight.dtype == numpy.float16
+        else:
+            use_multi_precision = self.multi_precision and weight[0].dtype == numpy.float16
+        self._update_impl(index, weight, grad, state,
+                          multi_precision=use_multi_precision)
 
 @register
 class AdaGrad(Optimizer):
@@ -1331,6 +1414,8 @@ class RMSProp(Optimizer):
         self.centered = centered
         self.epsilon = epsilon
         self.clip_weights = clip_weights
+        if not centered:
+            self.aggregate_num = _multi_update_aggregate_num()
 
     def create_state(self, index, weight):
         if self.centered:
@@ -1341,12 +1426,22 @@ class RMSProp(Optimizer):
         else:
             return (zeros(weight.shape, weight.context, stype=weight.stype),)  # n
 
-    def update(self, index, weight, grad, state):
-        assert(isinstance(weight, NDArray))
-        assert(isinstance(grad, NDArray))
-        self._update_count(index)
-        lr = self._get_lr(index)
-        wd = self._get_wd(index)
+    def _update_impl(self, indices, weights, grads, states, multi_precision=False):
+        aggregate = not self.centered
+        if not isinstance(indices, (tuple, list)):
+            indices = [indices]
+            weights = [weights]
+            grads = [grads]
+            states = [states]
+        for weight, grad in zip(weights, grads):
+            assert(isinstance(weight, NDArray))
+            assert(isinstance(grad, NDArray))
+            aggregate = (aggregate and
+                         weight.stype == 'default' and
+                         grad.stype == 'default')
+        self._update_count(indices)
+        lrs = self._get_lrs(indices)
+        wds = self._get_wds(indices)
 
         kwargs = {'gamma1': self.gamma1, 'epsilon': self.epsilon,
                   'rescale_grad': self.rescale_grad}
@@ -1357,6 +1452,28 @@ class RMSProp(Optimizer):
         if self.clip_weights:
             kwargs['clip_weights'] = self.clip_weights
 
+        if aggregate:
+            if not multi_precision:
+                multi_rmsprop_update(*_flatten_list(zip(weights, grads, *zip(*states))),
+                                     out=weights, num_weights=len(weights),
+                                     lrs=lrs, wds=wds, **kwargs)
+            else:
+                weights32, ns = zip(*states)
+                multi_mp_rmsprop_update(*_flatten_list(zip(weights, grads, *zip(*ns),
+                                                           weights32)),
+                                        out=weights, num_weights=len(weights),
+                                        lrs=lrs, wds=wds, **kwargs)
+        else:
+            for weight, grad, state, lr, wd in zip(weights, grads, states, lrs, wds):
+                if multi_precision:
+                    weight32, state = state
+                    self._update_single(weight32, grad.astype(numpy.float32), state,
+                                        lr, wd, kwargs)
+                    cast(weight32, dtype=weight.dtype, out=weight)
+                else:
+                    self._update_single(weight, grad, state, lr, wd, kwargs)
+
+    def _update_single(self, weight, grad, state, lr, wd, kwargs):
         if not self.centered:
             (n, ) = state
             rmsprop_update(
@@ -1366,6 +1483,17 @@ class RMSProp(Optimizer):
             rmspropalex_update(weight, grad, n, g, delta, out=weight,
                                lr=lr, wd=wd, **kwargs)
 
+    def update(self, index, weight, grad, state):
+        self._update_impl(index, weight, grad, state, multi_precision=False)
+
+    def update_multi_precision(self, index, weight, grad, state):
+        if not isinstance(index, (tuple, list)):
+            use_multi_precision = self.multi_precision and weight.dtype == numpy.float16
+        else:
+            use_multi_precision = self.multi_precision and weight[0].dtype == numpy.float16
+        self._update_impl(index, weight, grad, state,
+                          multi_precision=use_multi_precision)
+
 @register
 class AdaDelta(Optimizer):
     """The AdaDelta optimizer.
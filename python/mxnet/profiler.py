@@ -190,6 +190,67 @@ def dumps(reset=False, format='table', sort_by='total', ascending=False):
     return py_str(debug_str.value)
 
 
+def dispatch_cache_stats(reset=False):
+    """Return the statistics of the imperative dispatch cache, summed over all threads.
+
+    Repeated imperative operator calls with the same operator, attributes and input
+    signature skip shape, type and storage inference. The cache size is set by
+    MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE.
+
+    Parameters
+    ----------
+    reset: boolean
+        indicates whether to clear the statistics collected up to this point
+
+    Returns
+    -------
+    dict with the number of `hits` and `misses`, the `hit_rate`, and `saved_time_us`,
+    the inference time skipped by the hits in microseconds
+    """
+    hits = ctypes.c_uint64()
+    misses = ctypes.c_uint64()
+    saved_ns = ctypes.c_uint64()
+    check_call(_LIB.MXImperativeDispatchCacheStats(ctypes.byref(hits), ctypes.byref(misses),
+                                                   ctypes.byref(saved_ns), int(reset)))
+    total = hits.value + misses.value
+    return {'hits': hits.value,
+            'misses': misses.value,
+            'hit_rate': float(hits.value) / total if total else 0.0,
+            'saved_time_us': saved_ns.value / 1000.0}
+
+
+def set_streaming_state(state='stop'):
+    """Start or stop the streaming profiler.
+
+    The streaming profiler records operator latencies into per-thread ring buffers at
+    low overhead, independently of `set_state`. A background thread aggregates them into
+    latency histograms and, if MXNET_PROFILER_STREAM_FILENAME is set, writes them to a
+    rotating file.
+
+    Parameters
+    ----------
+    state : string, optional
+        Indicates whether to run the streaming profiler, can
+        be 'stop' or 'run'. Default is `stop`.
+    """
+    state2int = {'stop': 0, 'run': 1}
+    check_call(_LIB.MXSetStreamingProfilerState(ctypes.c_int(state2int[state])))
+
+
+def streaming_dumps(reset=False):
+    """Return a printable string of per-operator latency percentiles (p50, p99, p99.9)
+    collected by the streaming profiler.
+
+    Parameters
+    ----------
+    reset: boolean
+        indicates whether to clear the latency histograms collected up to this point
+    """
+    debug_str = ctypes.c_char_p()
+    check_call(_LIB.MXStreamingProfileStatsPrint(ctypes.byref(debug_str), int(reset)))
+    return py_str(debug_str.value)
+
+
 def pause(profile_process='worker'):
     """Pause profiling.
 
@@ -749,3 +749,21 @@ def mp_adamw_update(weight, grad, mean, var, weight32, rescale_grad, lr, eta, be
                                              beta1=beta1, beta2=beta2, epsilon=epsilon,
                                              wd=wd, clip_gradient=clip_gradient, out=out,
                                              name=name, **kwargs)
+
+def multi_adamw_update(weights, grads, mean, var, rescale_grad, lrs, wds, etas,
+                       out=None, name=None, **kwargs):
+    if not isinstance(rescale_grad, Symbol):
+        rescale_grad = symbol.full(shape=(1,), val=rescale_grad)
+    data = [x for group in zip(weights, grads, mean, var) for x in group]
+    return symbol._internal._multi_adamw_update(*(data + [rescale_grad]), out=out,
+                                                num_weights=len(weights), lrs=lrs, wds=wds,
+                                                etas=etas, name=name, **kwargs)
+
+def multi_mp_adamw_update(weights, grads, mean, var, weights32, rescale_grad, lrs, wds, etas,
+                          out=None, name=None, **kwargs):
+    if not isinstance(rescale_grad, Symbol):
+        rescale_grad = symbol.full(shape=(1,), val=rescale_grad)
+    data = [x for group in zip(weights, grads, mean, var, weights32) for x in group]
+    return symbol._internal._multi_mp_adamw_update(*(data + [rescale_grad]), out=out,
+                                                   num_weights=len(weights), lrs=lrs, wds=wds,
+                                                   etas=etas, name=name, **kwargs)
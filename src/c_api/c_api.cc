@@ -380,6 +380,29 @@ int MXNDArraySave(const char* fname,
   API_END();
 }
 
+int MXNDArraySaveAligned(const char* fname,
+                         uint32_t num_args,
+                         NDArrayHandle* args,
+                         const char** keys) {
+  API_BEGIN();
+  std::vector<NDArray> data(num_args);
+  std::vector<std::string> names;
+  for (uint32_t i = 0; i < num_args; ++i) {
+    data[i] = *static_cast<NDArray*>(args[i]);
+  }
+  if (keys != nullptr) {
+    names.resize(num_args);
+    for (uint32_t i = 0; i < num_args; ++i) {
+      names[i] = keys[i];
+    }
+  }
+  {
+    std::unique_ptr<dmlc::Stream> fo(dmlc::Stream::Create(fname, "w"));
+    mxnet::NDArray::SaveAligned(fo.get(), data, names);
+  }
+  API_END();
+}
+
 int MXNDArrayLoad(const char* fname,
                   uint32_t *out_size,
                   NDArrayHandle** out_arr,
@@ -390,7 +413,8 @@ int MXNDArrayLoad(const char* fname,
   API_BEGIN();
   std::vector<NDArray> data;
   std::vector<std::string> &names = ret->ret_vec_str;
-  {
+  const bool load_mapped = dmlc::GetEnv("MXNET_NDARRAY_LOAD_MMAP", true);
+  if (!load_mapped || !mxnet::NDArray::LoadMapped(fname, &data, &names)) {
     std::unique_ptr<dmlc::Stream> fi(dmlc::Stream::Create(fname, "r"));
     mxnet::NDArray::Load(fi.get(), &data, &names);
   }
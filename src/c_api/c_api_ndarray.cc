@@ -37,6 +37,7 @@
 #include "../common/exec_utils.h"
 #include "../imperative/imperative_utils.h"
 #include "../imperative/cached_op.h"
+#include "../imperative/dispatch_cache.h"
 
 using namespace mxnet;
 
@@ -288,6 +289,13 @@ int MXSetIsNumpyShape(int is_np_shape, int* prev) {
   API_END();
 }
 
+int MXImperativeDispatchCacheStats(uint64_t *hits, uint64_t *misses,
+                                   uint64_t *saved_ns, int reset) {
+  API_BEGIN();
+  imperative::DispatchCache::Stats(hits, misses, saved_ns, static_cast<bool>(reset));
+  API_END();
+}
+
 int MXAutogradMarkVariables(uint32_t num_var,
                             NDArrayHandle *var_handles,
                             uint32_t *reqs_array,
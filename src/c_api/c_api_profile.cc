@@ -33,6 +33,7 @@
 #include <stack>
 #include "./c_api_common.h"
 #include "../profiler/profiler.h"
+#include "../profiler/streaming_profiler.h"
 
 namespace mxnet {
 
@@ -337,6 +338,23 @@ int MXAggregateProfileStatsPrintEx(const char **out_str, int reset, int format,
   API_END();
 }
 
+int MXSetStreamingProfilerState(int state) {
+  API_BEGIN();
+    profiler::StreamingProfiler::Get()->SetEnabled(state != 0);
+  API_END();
+}
+
+int MXStreamingProfileStatsPrint(const char **out_str, int reset) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  API_BEGIN();
+    CHECK_NOTNULL(out_str);
+    std::ostringstream os;
+    profiler::StreamingProfiler::Get()->DumpTable(os, reset != 0);
+    ret->ret_str = os.str();
+    *out_str = (ret->ret_str).c_str();
+  API_END();
+}
+
 int MXDumpProfile(int finished) {
   return MXDumpProcessProfile(finished, static_cast<int>(ProfileProcess::kWorker), nullptr);
 }
@@ -28,7 +28,17 @@
 #include <mxnet/executor.h>
 #include <mxnet/ndarray.h>
 #include <nnvm/pass_functions.h>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <list>
+#include <map>
 #include <memory>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
 #include <unordered_set>
 #include <unordered_map>
 #include "./c_api_common.h"
@@ -434,53 +444,50 @@ int MXPredCreateMultiThread(const char* symbol_json_str,
       out);
 }
 
-int MXPredReshape(uint32_t num_input_nodes,
-                  const char** input_keys,
-                  const uint32_t* input_shape_indptr,
-                  const uint32_t* input_shape_data,
-                  PredictorHandle handle,
-                  PredictorHandle* out) {
-  _CreateExecutor(handle);
-  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
-  std::unique_ptr<MXAPIPredictor> ret(new MXAPIPredictor());
-
-  API_BEGIN();
-  // shape inference
-  std::unordered_map<std::string, mxnet::TShape> new_shape;
-  for (uint32_t i = 0; i < num_input_nodes; ++i) {
-    new_shape[std::string(input_keys[i])] =
-        mxnet::TShape(input_shape_data + input_shape_indptr[i],
-            input_shape_data + input_shape_indptr[i + 1]);
-  }
-  ret->sym = p->sym;
-  std::vector<std::string> arg_names = ret->sym.ListInputNames(Symbol::kReadOnlyArgs);
-  std::vector<std::string> aux_names = ret->sym.ListInputNames(Symbol::kAuxiliaryStates);
-  mxnet::ShapeVector out_shapes(ret->sym.ListOutputNames().size());
-  mxnet::ShapeVector aux_shapes(aux_names.size());
-  mxnet::ShapeVector arg_shapes;
-  ret->key2arg = p->key2arg;
-
+/*! \brief infer all shapes of sym given the new shapes of some of its inputs */
+static void _InferReshapedShapes(const nnvm::Symbol& sym,
+                                 const std::unordered_map<std::string, mxnet::TShape>& new_shape,
+                                 mxnet::ShapeVector* arg_shapes,
+                                 mxnet::ShapeVector* out_shapes,
+                                 mxnet::ShapeVector* aux_shapes) {
   try {
     mxnet::ShapeVector in_shapes;
-    in_shapes.reserve(arg_names.size());
-    for (std::string key : ret->sym.ListInputNames(Symbol::kAll)) {
-      if (new_shape.count(key) != 0) {
-        in_shapes.push_back(new_shape[key]);
+    for (const std::string& key : sym.ListInputNames(Symbol::kAll)) {
+      auto it = new_shape.find(key);
+      if (it != new_shape.end()) {
+        in_shapes.push_back(it->second);
       } else {
         in_shapes.emplace_back();
       }
     }
-    nnvm::Graph g; g.outputs = ret->sym.outputs;
+    nnvm::Graph g; g.outputs = sym.outputs;
     g = mxnet::exec::InferShape(std::move(g), std::move(in_shapes), "__shape__");
     bool infer_complete = (g.GetAttr<size_t>("shape_num_unknown_nodes") == 0);
     CHECK(infer_complete)
       << "The shape information of is not enough to get the shapes";
     CopyAttr(g.indexed_graph(),
              g.GetAttr<mxnet::ShapeVector>("shape"),
-             &arg_shapes, &out_shapes, &aux_shapes);
+             arg_shapes, out_shapes, aux_shapes);
   } catch (const mxnet::op::InferShapeError &err) {
     throw dmlc::Error(err.msg);
   }
+}
+
+/*!
+ * \brief bind a predictor of p's symbol for new input shapes, parameters and the input
+ *  storage are shared with p
+ */
+static MXAPIPredictor* _ReshapePredictor(MXAPIPredictor* p,
+                                         const std::unordered_map<std::string,
+                                                                  mxnet::TShape>& new_shape,
+                                         Executor* shared_exec) {
+  std::unique_ptr<MXAPIPredictor> ret(new MXAPIPredictor());
+  ret->sym = p->sym;
+  std::vector<std::string> arg_names = ret->sym.ListInputNames(Symbol::kReadOnlyArgs);
+  std::vector<std::string> aux_names = ret->sym.ListInputNames(Symbol::kAuxiliaryStates);
+  mxnet::ShapeVector out_shapes, aux_shapes, arg_shapes;
+  ret->key2arg = p->key2arg;
+  _InferReshapedShapes(ret->sym, new_shape, &arg_shapes, &out_shapes, &aux_shapes);
 
   ret->arg_arrays = p->arg_arrays;
   ret->ctx = p->ctx;
@@ -516,15 +523,169 @@ int MXPredReshape(uint32_t num_input_nodes,
                                    ret->arg_arrays,
                                    grad_store, grad_req,
                                    ret->aux_arrays,
-                                   p->exec.get()));
+                                   shared_exec));
     ret->out_shapes = out_shapes;
     ret->out_arrays = ret->exec->outputs();
     ret->out_dtypes = p->out_dtypes;
   }
+  return ret.release();
+}
+
+/*! \brief parse the C API shape arguments */
+static std::unordered_map<std::string, mxnet::TShape>
+_ParseInputShapes(uint32_t num_input_nodes,
+                  const char** input_keys,
+                  const uint32_t* input_shape_indptr,
+                  const uint32_t* input_shape_data) {
+  std::unordered_map<std::string, mxnet::TShape> new_shape;
+  for (uint32_t i = 0; i < num_input_nodes; ++i) {
+    new_shape[std::string(input_keys[i])] =
+        mxnet::TShape(input_shape_data + input_shape_indptr[i],
+            input_shape_data + input_shape_indptr[i + 1]);
+  }
+  return new_shape;
+}
+
+int MXPredReshape(uint32_t num_input_nodes,
+                  const char** input_keys,
+                  const uint32_t* input_shape_indptr,
+                  const uint32_t* input_shape_data,
+                  PredictorHandle handle,
+                  PredictorHandle* out) {
+  _CreateExecutor(handle);
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+
+  API_BEGIN();
+  std::unordered_map<std::string, mxnet::TShape> new_shape =
+      _ParseInputShapes(num_input_nodes, input_keys, input_shape_indptr, input_shape_data);
+  *out = _ReshapePredictor(p, new_shape, p->exec.get());
+  API_END();
+}
+
+/*!
+ * \brief LRU cache of predictors keyed by their input shapes. All predictors share the
+ *  parameters of the base predictor and the memory of the predictor bound for the
+ *  largest shapes, which is never evicted.
+ */
+struct MXAPIPredBucket {
+  /*! \brief predictor providing the symbol and the parameters, not owned */
+  MXAPIPredictor* base;
+  /*! \brief predictor bound for the largest shapes */
+  std::unique_ptr<MXAPIPredictor> largest;
+  std::unordered_map<std::string, mxnet::TShape> max_shape;
+  std::string largest_key;
+  /*! \brief maximum number of cached predictors besides the largest one */
+  uint32_t cache_size;
+  /*! \brief cached predictors, most recently used first */
+  std::list<std::pair<std::string, std::unique_ptr<MXAPIPredictor> > > lru;
+  std::unordered_map<std::string, decltype(lru)::iterator> index;
+  uint64_t hits = 0;
+  uint64_t misses = 0;
+  uint64_t evictions = 0;
+};
+
+/*! \brief cache key of a set of input shapes, independent of the input order */
+static std::string _BucketKey(const std::unordered_map<std::string, mxnet::TShape>& shapes) {
+  std::map<std::string, mxnet::TShape> sorted(shapes.begin(), shapes.end());
+  std::ostringstream os;
+  for (const auto& kv : sorted) {
+    os << kv.first << ':' << kv.second << ';';
+  }
+  return os.str();
+}
+
+int MXPredBucketCreate(PredictorHandle handle,
+                       uint32_t num_input_nodes,
+                       const char** input_keys,
+                       const uint32_t* max_shape_indptr,
+                       const uint32_t* max_shape_data,
+                       uint32_t cache_size,
+                       PredBucketHandle* out) {
+  _CreateExecutor(handle);
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  CHECK_GT(cache_size, 0U) << "cache_size must be positive";
+  std::unordered_map<std::string, mxnet::TShape> max_shape =
+      _ParseInputShapes(num_input_nodes, input_keys, max_shape_indptr, max_shape_data);
+  std::unique_ptr<MXAPIPredBucket> ret(new MXAPIPredBucket());
+  ret->base = p;
+  ret->cache_size = cache_size;
+  ret->largest_key = _BucketKey(max_shape);
+  ret->largest.reset(_ReshapePredictor(p, max_shape, p->exec.get()));
+  ret->max_shape = max_shape;
   *out = ret.release();
   API_END();
 }
 
+int MXPredBucketGet(PredBucketHandle handle,
+                    uint32_t num_input_nodes,
+                    const char** input_keys,
+                    const uint32_t* input_shape_indptr,
+                    const uint32_t* input_shape_data,
+                    PredictorHandle* out) {
+  MXAPIPredBucket* b = static_cast<MXAPIPredBucket*>(handle);
+  API_BEGIN();
+  std::unordered_map<std::string, mxnet::TShape> new_shape =
+      _ParseInputShapes(num_input_nodes, input_keys, input_shape_indptr, input_shape_data);
+  // predictors share the memory of the largest one, so no dimension may exceed it
+  for (const auto& kv : new_shape) {
+    auto it = b->max_shape.find(kv.first);
+    CHECK(it != b->max_shape.end())
+        << "input " << kv.first << " has no maximum shape in the predictor cache";
+    CHECK_EQ(kv.second.ndim(), it->second.ndim())
+        << "input " << kv.first << " has shape " << kv.second
+        << ", expected the number of dimensions of its maximum shape " << it->second;
+    for (int i = 0; i < kv.second.ndim(); ++i) {
+      CHECK_LE(kv.second[i], it->second[i])
+          << "input " << kv.first << " has shape " << kv.second
+          << ", which exceeds its maximum shape " << it->second;
+    }
+  }
+  const std::string key = _BucketKey(new_shape);
+  if (key == b->largest_key) {
+    ++b->hits;
+    *out = b->largest.get();
+  } else if (b->index.count(key) != 0) {
+    ++b->hits;
+    auto it = b->index.at(key);
+    b->lru.splice(b->lru.begin(), b->lru, it);
+    *out = it->second.get();
+  } else {
+    ++b->misses;
+    std::unique_ptr<MXAPIPredictor> pred(
+        _ReshapePredictor(b->base, new_shape, b->largest->exec.get()));
+    *out = pred.get();
+    while (b->lru.size() >= b->cache_size) {
+      b->index.erase(b->lru.back().first);
+      b->lru.pop_back();
+      ++b->evictions;
+    }
+    b->lru.emplace_front(key, std::move(pred));
+    b->index[key] = b->lru.begin();
+  }
+  API_END();
+}
+
+int MXPredBucketGetStats(PredBucketHandle handle,
+                         uint64_t* hits,
+                         uint64_t* misses,
+                         uint64_t* evictions,
+                         uint32_t* num_cached) {
+  MXAPIPredBucket* b = static_cast<MXAPIPredBucket*>(handle);
+  API_BEGIN();
+  *hits = b->hits;
+  *misses = b->misses;
+  *evictions = b->evictions;
+  *num_cached = static_cast<uint32_t>(b->index.size()) + 1;
+  API_END();
+}
+
+int MXPredBucketFree(PredBucketHandle handle) {
+  API_BEGIN();
+  delete static_cast<MXAPIPredBucket*>(handle);
+  API_END();
+}
+
 int MXPredGetOutputShape(PredictorHandle handle,
                          uint32_t out_index,
                          uint32_t** shape_data,
@@ -608,6 +769,350 @@ int MXPredFree(PredictorHandle handle) {
   API_END();
 }
 
+/*!
+ * \brief Batching server: requests from many threads are queued, coalesced into batches
+ *  and run by worker threads on executors bound for power of two batch sizes.
+ */
+class MXAPIPredBatcher {
+ public:
+  MXAPIPredBatcher(const MXAPIPredictor* base,
+                   const std::vector<std::string>& input_keys,
+                   uint32_t max_batch_size,
+                   uint32_t max_wait_us,
+                   uint32_t num_workers)
+      : base_(base), max_batch_size_(max_batch_size), max_wait_(max_wait_us),
+        batch_size_counts_(max_batch_size + 1, 0) {
+    CHECK_GT(max_batch_size, 0U);
+    CHECK_GT(num_workers, 0U);
+    for (const std::string& key : input_keys) {
+      auto it = base->key2arg.find(key);
+      CHECK(it != base->key2arg.end()) << "cannot find input key " << key;
+      const mxnet::TShape& shape = base->arg_arrays[it->second].shape();
+      CHECK_GE(shape.ndim(), 1) << "input " << key << " has no batch dimension";
+      input_keys_.push_back(key);
+      input_sample_sizes_.push_back(shape.Size() / shape[0]);
+    }
+    for (uint32_t b = 1; b < max_batch_size; b *= 2) {
+      bucket_sizes_.push_back(b);
+    }
+    bucket_sizes_.push_back(max_batch_size);
+    // as for MXPredCreateMultiThread, executors only run concurrently on NaiveEngine
+    const char *type = getenv("MXNET_ENGINE_TYPE");
+    serialize_exec_ = type == nullptr || std::string(type) != "NaiveEngine";
+    // bind the largest bucket up front so binding errors surface here, the smaller
+    // buckets of a worker share its memory
+    std::vector<std::unique_ptr<MXAPIPredictor> > largest;
+    for (uint32_t i = 0; i < num_workers; ++i) {
+      largest.emplace_back(Bind(max_batch_size, nullptr));
+    }
+    for (const mxnet::TShape& shape : largest[0]->out_shapes) {
+      CHECK_GE(shape.ndim(), 1);
+      CHECK_EQ(shape[0], max_batch_size)
+          << "outputs must have the batch size as their first dimension";
+      output_sample_sizes_.push_back(shape.Size() / shape[0]);
+    }
+    for (uint32_t i = 0; i < num_workers; ++i) {
+      MXAPIPredictor* pred = largest[i].release();
+      workers_.emplace_back([this, pred]() { WorkerLoop(pred); });
+    }
+  }
+
+  ~MXAPIPredBatcher() {
+    {
+      std::lock_guard<std::mutex> lock(mutex_);
+      shutdown_ = true;
+    }
+    queue_cv_.notify_all();
+    for (std::thread& t : workers_) t.join();
+    // callers woken by the last batches still need the mutex to return
+    std::unique_lock<std::mutex> lock(mutex_);
+    done_cv_.wait(lock, [this]() { return num_callers_ == 0; });
+  }
+
+  /*! \brief enqueue a request and wait for it */
+  void Forward(uint32_t batch_size, const float** input_data,
+               uint32_t num_outputs, float** output_data) {
+    CHECK_GT(batch_size, 0U);
+    CHECK_LE(batch_size, max_batch_size_)
+        << "request batch size exceeds max_batch_size " << max_batch_size_;
+    CHECK_LE(num_outputs, output_sample_sizes_.size()) << "Output index out of range";
+    Request req;
+    req.batch_size = batch_size;
+    req.inputs.assign(input_data, input_data + input_keys_.size());
+    req.outputs.assign(output_data, output_data + num_outputs);
+    req.enqueue_time = std::chrono::steady_clock::now();
+    {
+      std::unique_lock<std::mutex> lock(mutex_);
+      CHECK(!shutdown_);
+      queue_.push_back(&req);
+      queue_samples_ += batch_size;
+      ++num_callers_;
+      queue_cv_.notify_one();
+      done_cv_.wait(lock, [&req]() { return req.done; });
+      if (--num_callers_ == 0 && shutdown_) done_cv_.notify_all();
+    }
+    if (!req.error.empty()) throw dmlc::Error(req.error);
+  }
+
+  void GetStats(uint32_t num_percentiles, const float* percentiles, float* latency_us,
+                uint64_t* num_requests, const uint64_t** batch_size_counts,
+                uint32_t* num_counts) {
+    std::vector<float> latencies;
+    {
+      std::lock_guard<std::mutex> lock(stats_mutex_);
+      latencies = latencies_;
+      *num_requests = num_requests_;
+      stats_counts_ = batch_size_counts_;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    for (uint32_t i = 0; i < num_percentiles; ++i) {
+      if (latencies.empty()) {
+        latency_us[i] = 0.0f;
+        continue;
+      }
+      const float p = std::min(std::max(percentiles[i], 0.0f), 100.0f);
+      const size_t idx = static_cast<size_t>(p / 100.0f * (latencies.size() - 1) + 0.5f);
+      latency_us[i] = latencies[idx];
+    }
+    *batch_size_counts = stats_counts_.data();
+    *num_counts = static_cast<uint32_t>(stats_counts_.size());
+  }
+
+ private:
+  struct Request {
+    uint32_t batch_size;
+    std::vector<const float*> inputs;
+    std::vector<float*> outputs;
+    std::chrono::steady_clock::time_point enqueue_time;
+    bool done = false;
+    std::string error;
+  };
+
+  /*! \brief number of latencies kept for the percentiles */
+  static const size_t kLatencyWindow = 1 << 16;
+
+  /*! \brief bind an executor of the base symbol for the given batch size */
+  MXAPIPredictor* Bind(uint32_t batch_size, Executor* shared_exec) const {
+    std::unordered_map<std::string, mxnet::TShape> new_shape;
+    for (const std::string& key : input_keys_) {
+      mxnet::TShape shape = base_->arg_arrays[base_->key2arg.at(key)].shape();
+      shape[0] = batch_size;
+      new_shape[key] = shape;
+    }
+    std::unique_ptr<MXAPIPredictor> ret(new MXAPIPredictor());
+    ret->sym = base_->sym;
+    ret->ctx = base_->ctx;
+    ret->key2arg = base_->key2arg;
+    ret->out_dtypes = base_->out_dtypes;
+    mxnet::ShapeVector arg_shapes, aux_shapes;
+    _InferReshapedShapes(ret->sym, new_shape, &arg_shapes, &ret->out_shapes, &aux_shapes);
+    // parameters are shared, inputs get their own arrays
+    ret->arg_arrays = base_->arg_arrays;
+    for (const std::string& key : input_keys_) {
+      const size_t idx = base_->key2arg.at(key);
+      ret->arg_arrays[idx] = NDArray(arg_shapes[idx], ret->ctx, false,
+                                     base_->arg_arrays[idx].dtype());
+    }
+    for (size_t i = 0; i < arg_shapes.size(); ++i) {
+      CHECK_EQ(arg_shapes[i], ret->arg_arrays[i].shape())
+          << "only the shapes of the inputs may depend on the batch size";
+    }
+    ret->aux_arrays = base_->aux_arrays;
+    std::map<std::string, Context> ctx_map;
+    std::vector<NDArray> grad_store(ret->arg_arrays.size());
+    std::vector<OpReqType> grad_req(ret->arg_arrays.size(), kNullOp);
+    ret->exec.reset(Executor::Bind(ret->sym, ret->ctx, ctx_map,
+                                   ret->arg_arrays,
+                                   grad_store, grad_req,
+                                   ret->aux_arrays,
+                                   shared_exec));
+    ret->out_arrays = ret->exec->outputs();
+    return ret.release();
+  }
+
+  /*! \brief wait for requests and pop up to max_batch_size samples of them */
+  bool NextBatch(std::vector<Request*>* batch) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    queue_cv_.wait(lock, [this]() { return shutdown_ || !queue_.empty(); });
+    if (queue_.empty()) return false;
+    const auto deadline = queue_.front()->enqueue_time + max_wait_;
+    queue_cv_.wait_until(lock, deadline, [this]() {
+      return shutdown_ || queue_.empty() || queue_samples_ >= max_batch_size_;
+    });
+    // another worker may have taken the requests
+    if (queue_.empty()) return !shutdown_;
+    uint32_t samples = 0;
+    while (!queue_.empty() && samples + queue_.front()->batch_size <= max_batch_size_) {
+      samples += queue_.front()->batch_size;
+      queue_samples_ -= queue_.front()->batch_size;
+      batch->push_back(queue_.front());
+      queue_.pop_front();
+    }
+    return true;
+  }
+
+  void WorkerLoop(MXAPIPredictor* largest) {
+    std::map<uint32_t, std::unique_ptr<MXAPIPredictor> > buckets;
+    buckets[max_batch_size_].reset(largest);
+    std::vector<std::vector<float> > in_buffers(input_keys_.size());
+    std::vector<std::vector<float> > out_buffers(output_sample_sizes_.size());
+    std::vector<Request*> batch;
+    while (true) {
+      batch.clear();
+      if (!NextBatch(&batch)) break;
+      if (batch.empty()) continue;
+      uint32_t samples = 0;
+      for (Request* req : batch) samples += req->batch_size;
+      std::string error;
+      try {
+        const uint32_t bucket = *std::lower_bound(bucket_sizes_.begin(), bucket_sizes_.end(),
+                                                  samples);
+        std::unique_lock<std::mutex> exec_lock(exec_mutex_, std::defer_lock);
+        if (serialize_exec_) exec_lock.lock();
+        std::unique_ptr<MXAPIPredictor>& pred = buckets[bucket];
+        if (pred == nullptr) {
+          pred.reset(Bind(bucket, buckets[max_batch_size_]->exec.get()));
+        }
+        // gather, the padding rows are zero
+        for (size_t i = 0; i < input_keys_.size(); ++i) {
+          const size_t sample_size = input_sample_sizes_[i];
+          in_buffers[i].assign(bucket * sample_size, 0.0f);
+          float* dst = in_buffers[i].data();
+          for (Request* req : batch) {
+            std::copy(req->inputs[i], req->inputs[i] + req->batch_size * sample_size, dst);
+            dst += req->batch_size * sample_size;
+          }
+          pred->arg_arrays[pred->key2arg.at(input_keys_[i])].SyncCopyFromCPU(
+              in_buffers[i].data(), in_buffers[i].size());
+        }
+        pred->exec->Forward(false);
+        // scatter
+        for (size_t i = 0; i < out_buffers.size(); ++i) {
+          const size_t sample_size = output_sample_sizes_[i];
+          bool needed = false;
+          for (Request* req : batch) needed = needed || i < req->outputs.size();
+          if (!needed) continue;
+          out_buffers[i].resize(bucket * sample_size);
+          pred->out_arrays[i].SyncCopyToCPU(out_buffers[i].data(), out_buffers[i].size());
+          const float* src = out_buffers[i].data();
+          for (Request* req : batch) {
+            if (i < req->outputs.size()) {
+              std::copy(src, src + req->batch_size * sample_size, req->outputs[i]);
+            }
+            src += req->batch_size * sample_size;
+          }
+        }
+      } catch (const std::exception& e) {
+        // an exception leaving the worker thread would terminate the process
+        error = e.what();
+      } catch (...) {
+        error = "unknown error in batched forward";
+      }
+      const auto now = std::chrono::steady_clock::now();
+      {
+        std::lock_guard<std::mutex> lock(stats_mutex_);
+        ++batch_size_counts_[samples];
+        for (Request* req : batch) {
+          const float latency = std::chrono::duration<float, std::micro>(
+              now - req->enqueue_time).count();
+          if (latencies_.size() < kLatencyWindow) {
+            latencies_.push_back(latency);
+          } else {
+            latencies_[num_requests_ % kLatencyWindow] = latency;
+          }
+          ++num_requests_;
+        }
+      }
+      {
+        std::lock_guard<std::mutex> lock(mutex_);
+        for (Request* req : batch) {
+          req->error = error;
+          req->done = true;
+        }
+      }
+      done_cv_.notify_all();
+    }
+  }
+
+  /*! \brief predictor providing the symbol and the parameters */
+  const MXAPIPredictor* base_;
+  std::vector<std::string> input_keys_;
+  /*! \brief number of elements of one sample of each input and output */
+  std::vector<size_t> input_sample_sizes_;
+  std::vector<size_t> output_sample_sizes_;
+  /*! \brief batch sizes executors are bound for */
+  std::vector<uint32_t> bucket_sizes_;
+  const uint32_t max_batch_size_;
+  const std::chrono::microseconds max_wait_;
+  std::vector<std::thread> workers_;
+  /*! \brief whether the workers take turns binding and running executors */
+  bool serialize_exec_;
+  std::mutex exec_mutex_;
+
+  std::mutex mutex_;
+  std::condition_variable queue_cv_;
+  std::condition_variable done_cv_;
+  std::deque<Request*> queue_;
+  /*! \brief number of samples in queue_ */
+  uint32_t queue_samples_ = 0;
+  /*! \brief number of threads blocked in Forward */
+  uint32_t num_callers_ = 0;
+  bool shutdown_ = false;
+
+  std::mutex stats_mutex_;
+  uint64_t num_requests_ = 0;
+  /*! \brief ring of the latest request latencies in microseconds */
+  std::vector<float> latencies_;
+  std::vector<uint64_t> batch_size_counts_;
+  /*! \brief copy returned by GetStats */
+  std::vector<uint64_t> stats_counts_;
+};
+
+int MXPredBatcherCreate(PredictorHandle handle,
+                        uint32_t num_input_nodes,
+                        const char** input_keys,
+                        uint32_t max_batch_size,
+                        uint32_t max_wait_us,
+                        uint32_t num_workers,
+                        PredBatcherHandle* out) {
+  MXAPIPredictor* p = static_cast<MXAPIPredictor*>(handle);
+  API_BEGIN();
+  std::vector<std::string> keys(input_keys, input_keys + num_input_nodes);
+  *out = new MXAPIPredBatcher(p, keys, max_batch_size, max_wait_us, num_workers);
+  API_END();
+}
+
+int MXPredBatcherForward(PredBatcherHandle handle,
+                         uint32_t batch_size,
+                         const float** input_data,
+                         uint32_t num_outputs,
+                         float** output_data) {
+  MXAPIPredBatcher* b = static_cast<MXAPIPredBatcher*>(handle);
+  API_BEGIN();
+  b->Forward(batch_size, input_data, num_outputs, output_data);
+  API_END();
+}
+
+int MXPredBatcherGetStats(PredBatcherHandle handle,
+                          uint32_t num_percentiles,
+                          const float* percentiles,
+                          float* latency_us,
+                          uint64_t* num_requests,
+                          const uint64_t** batch_size_counts,
+                          uint32_t* num_counts) {
+  MXAPIPredBatcher* b = static_cast<MXAPIPredBatcher*>(handle);
+  API_BEGIN();
+  b->GetStats(num_percentiles, percentiles, latency_us, num_requests,
+              batch_size_counts, num_counts);
+  API_END();
+}
+
+int MXPredBatcherFree(PredBatcherHandle handle) {
+  API_BEGIN();
+  delete static_cast<MXAPIPredBatcher*>(handle);
+  API_END();
+}
+
 int MXNDListCreate(const char* nd_file_bytes,
                    int nd_file_size,
                    NDListHandle *out,
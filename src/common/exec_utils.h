@@ -313,6 +313,14 @@ inline void LogMemoryPlan(const nnvm::Graph& g) {
       }
     }
   }
+  if (g.attrs.count("storage_allocated_bytes")) {
+    LOG(INFO) << "Total " << (g.GetAttr<size_t>("storage_allocated_bytes") >> 10)
+              << " KB allocated";
+  }
+  if (g.attrs.count("storage_arena_bytes")) {
+    LOG(INFO) << "Total " << (g.GetAttr<size_t>("storage_arena_bytes") >> 10)
+              << " KB planned peak in arena";
+  }
 }
 
 /* log the static memory plan of the graph. Example:
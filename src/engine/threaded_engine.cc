@@ -49,29 +49,41 @@ ThreadedVar::ThreadedVar(VersionedVarBlock* head) : head_{head} {
 }
 
 inline void ThreadedVar::AppendReadDependency(OprBlock* opr_block) {
-  std::lock_guard<std::mutex> lock{mutex_};
-  if (pending_write_ == nullptr) {
-    // invariant: is_ready_to_read()
-    CHECK_GE(num_pending_reads_, 0);
-    // STATE CHANGE
-    ++num_pending_reads_;
-    // decrease wait counter
-    opr_block->decr_wait();
-  } else {
-    auto&& new_var_block = VersionedVarBlock::New();
-    assert(head_->next == nullptr);
-    assert(head_->trigger == nullptr);
-    assert(head_->write == false);
-    // append things to next.
-    head_->next = new_var_block;
-    head_->trigger = opr_block;
-    head_ = new_var_block;
+  // The block is only needed when the read has to wait. It is allocated
+  // outside of the lock, so the spin lock is never held across the allocator.
+  VersionedVarBlock* new_var_block = nullptr;
+  while (true) {
+    {
+      std::lock_guard<dmlc::Spinlock> lock{lock_};
+      if (pending_write_ == nullptr) {
+        // invariant: is_ready_to_read()
+        CHECK_GE(num_pending_reads_, 0);
+        // STATE CHANGE
+        ++num_pending_reads_;
+        // decrease wait counter
+        opr_block->decr_wait();
+        break;
+      } else if (new_var_block != nullptr) {
+        assert(head_->next == nullptr);
+        assert(head_->trigger == nullptr);
+        assert(head_->write == false);
+        // append things to next.
+        head_->next = new_var_block;
+        head_->trigger = opr_block;
+        head_ = new_var_block;
+        return;
+      }
+    }
+    new_var_block = VersionedVarBlock::New();
+  }
+  if (new_var_block != nullptr) {
+    VersionedVarBlock::Delete(new_var_block);
   }
 }
 
 inline void ThreadedVar::AppendWriteDependency(OprBlock* opr_block) {
   auto&& new_var_block = VersionedVarBlock::New();
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<dmlc::Spinlock> lock{lock_};
   // invariant.
   assert(head_->next == nullptr);
   assert(head_->trigger == nullptr);
@@ -102,7 +114,7 @@ inline void ThreadedVar::CompleteReadDependency(Dispatcher dispatcher) {
   OprBlock *trigger = nullptr;
   {
     // this is lock scope
-    std::lock_guard<std::mutex> lock{mutex_};
+    std::lock_guard<dmlc::Spinlock> lock{lock_};
     CHECK_GT(num_pending_reads_, 0);
 
     if (--num_pending_reads_ == 0) {
@@ -124,7 +136,7 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
   VersionedVarBlock *old_pending_write, *end_of_read_chain;
   OprBlock* trigger_write = nullptr;
   {
-    std::lock_guard<std::mutex> lock{mutex_};
+    std::lock_guard<dmlc::Spinlock> lock{lock_};
     // invariants
     assert(head_->next == nullptr);
     assert(pending_write_ != nullptr);
@@ -190,17 +202,17 @@ inline bool ThreadedVar::CompleteWriteDependency(Dispatcher dispatcher) {
 }
 
 inline void ThreadedVar::SetToDelete() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<dmlc::Spinlock> lock{lock_};
   to_delete_ = true;
 }
 
 inline bool ThreadedVar::ready_to_read() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<dmlc::Spinlock> lock{lock_};
   return this->is_ready_to_read();
 }
 
 inline size_t ThreadedVar::version() {
-  std::lock_guard<std::mutex> lock{mutex_};
+  std::lock_guard<dmlc::Spinlock> lock{lock_};
   return this->version_;
 }
 
@@ -519,6 +531,11 @@ void ThreadedEngine::OnCompleteStatic(Engine *engine, void *opr_block_,
     // record operator end timestamp
     opr_block->opr_profile->stop();
   }
+  if (opr_block->stream_start_us != 0) {
+    static_cast<ThreadedEngine*>(engine)->stream_profiler_->Record(
+        threaded_opr->opr_name, opr_block->ctx, opr_block->stream_start_us,
+        profiler::ProfileStat::NowInMicrosec());
+  }
   static_cast<ThreadedEngine*>(engine)->OnComplete(threaded_opr);
   OprBlock::Delete(opr_block);
 }
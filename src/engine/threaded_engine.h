@@ -28,6 +28,7 @@
 #define MXNET_ENGINE_THREADED_ENGINE_H_
 
 #include <dmlc/base.h>
+#include <dmlc/concurrency.h>
 #include <dmlc/logging.h>
 #include <dmlc/omp.h>
 #include <mxnet/storage.h>
@@ -44,6 +45,7 @@
 #include "./openmp.h"
 #include "../common/object_pool.h"
 #include "../profiler/custom_op_profiler.h"
+#include "../profiler/streaming_profiler.h"
 
 namespace mxnet {
 namespace engine {
@@ -83,6 +85,8 @@ struct OprBlock : public common::ObjectPoolAllocatable<OprBlock> {
   bool profiling{false};
   /*! \brief operator execution statistics */
   std::unique_ptr<profiler::ProfileOperator> opr_profile;
+  /*! \brief start time for the streaming profiler, 0 if not recorded */
+  uint64_t stream_start_us{0};
   // define possible debug information
   DEFINE_ENGINE_DEBUG_INFO(OprBlock);
   /*!
@@ -189,10 +193,12 @@ class ThreadedVar final
   ExceptionRef var_exception;
 
  private:
-  // TODO(hotpxl) change this to spinlock for faster runtime
   // TODO(hotpxl) consider rename head
-  /*! \brief internal mutex of the ThreadedVar */
-  std::mutex mutex_;
+  /*!
+   * \brief internal lock of the ThreadedVar, its critical sections only touch a few
+   *  pointers and counters, so spinning is cheaper than parking the thread
+   */
+  dmlc::Spinlock lock_;
   /*!
    * \brief number of pending reads operation in the variable.
    *  will be marked as -1 when there is a already triggered pending write.
@@ -324,6 +330,7 @@ class ThreadedEngine : public Engine {
 
     // Get a ref to the profiler so that it doesn't get killed before us
     profiler::Profiler::Get(&profiler_);
+    profiler::StreamingProfiler::Get(&stream_profiler_);
   }
   ~ThreadedEngine() {
     {
@@ -361,6 +368,9 @@ class ThreadedEngine : public Engine {
                                                                  attrs.release()));
       opr_block->opr_profile->startForDevice(ctx.dev_type, ctx.dev_id);
     }
+    if (threaded_opr->opr_name && stream_profiler_->IsEnabled()) {
+      opr_block->stream_start_us = profiler::ProfileStat::NowInMicrosec();
+    }
     CallbackOnComplete callback =
         this->CreateCallback(ThreadedEngine::OnCompleteStatic, opr_block);
     const bool debug_info = (engine_info_ && debug_push_opr_ == opr_block);
@@ -595,6 +605,8 @@ class ThreadedEngine : public Engine {
 
   /*! \brief Hold a ref count ot the profiler */
   std::shared_ptr<profiler::Profiler> profiler_;
+  /*! \brief Hold a ref count to the streaming profiler */
+  std::shared_ptr<profiler::StreamingProfiler> stream_profiler_;
 
   /*!
    * \brief Disallow copy construction and assignment.
@@ -28,6 +28,11 @@
 #include <dmlc/parameter.h>
 #include <dmlc/concurrency.h>
 #include <dmlc/thread_group.h>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <vector>
 #include "../initialize.h"
 #include "./threaded_engine.h"
 #include "./thread_pool.h"
@@ -43,6 +48,8 @@ namespace engine {
  *  - Use fixed amount of threads for each device.
  *  - Use special threads for copy operations.
  *  - Each stream is allocated and bound to each of the thread.
+ *  - Optionally, CPU workers own a task deque each and steal from their
+ *    peers when idle, instead of sharing a single task queue.
  */
 class ThreadedEnginePerDevice : public ThreadedEngine {
  public:
@@ -52,7 +59,13 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   static auto constexpr kPriorityQueue = kPriority;
   static auto constexpr kWorkerQueue = kFIFO;
 
-  ThreadedEnginePerDevice() noexcept(false) {
+  /*!
+   * \brief Constructor.
+   * \param work_stealing whether normal CPU tasks are scheduled on per-worker
+   *        deques with work stealing instead of a single shared queue.
+   */
+  explicit ThreadedEnginePerDevice(bool work_stealing = false) noexcept(false)
+      : work_stealing_(work_stealing) {
     this->Start();
   }
   ~ThreadedEnginePerDevice() noexcept(false) {
@@ -65,6 +78,7 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     gpu_priority_workers_.Clear();
     gpu_copy_workers_.Clear();
     cpu_normal_workers_.Clear();
+    cpu_stealing_workers_.Clear();
     cpu_priority_worker_.reset(nullptr);
   }
 
@@ -107,6 +121,21 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
         // CPU execution.
         if (opr_block->opr->prop == FnProperty::kCPUPrioritized) {
           cpu_priority_worker_->task_queue.Push(opr_block, opr_block->priority);
+        } else if (work_stealing_) {
+          int dev_id = ctx.dev_id;
+          int nthread = cpu_worker_nthreads_;
+          auto ptr =
+          cpu_stealing_workers_.Get(dev_id, [this, ctx, nthread]() {
+              auto blk = new WorkStealingBlock(nthread);
+              blk->pool.reset(new ThreadPool(nthread,
+                  [this, ctx, blk](std::shared_ptr<dmlc::ManualEvent> ready_event) {
+                    this->CPUStealingWorker(ctx, blk, ready_event);
+                  }, true));
+            return blk;
+          });
+          if (ptr) {
+            ptr->Push(opr_block, opr_block->opr->prop == FnProperty::kDeleteVar);
+          }
         } else {
           int dev_id = ctx.dev_id;
           int nthread = cpu_worker_nthreads_;
@@ -214,8 +243,104 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     ~ThreadWorkerBlock() noexcept(false) {}
   };
 
+  /*!
+   * \brief Task queues of a group of CPU workers that steal work from each other.
+   *
+   * Every worker owns a deque, guarded by its own lock, which it pops from the
+   * front. Tasks pushed by a worker of the group (typically operators whose
+   * dependencies were just completed by that worker) go to that worker's own
+   * deque, other pushes are spread round-robin. An idle worker steals from the
+   * back of its peers' deques before going to sleep.
+   */
+  struct WorkStealingBlock {
+    // one deque per worker
+    struct TaskDeque {
+      std::mutex mutex;
+      std::deque<OprBlock*> tasks;
+    };
+    explicit WorkStealingBlock(size_t nthread) : queues(nthread) {
+      for (auto& q : queues) q.reset(new TaskDeque());
+    }
+    // push a task, at the front of the deque if it should run next
+    void Push(OprBlock* opr_block, bool front) {
+      size_t qid = (worker_block_ == this) ? worker_index_
+                                           : next_queue++ % queues.size();
+      {
+        TaskDeque* q = queues[qid].get();
+        std::lock_guard<std::mutex> lock(q->mutex);
+        if (front) {
+          q->tasks.push_front(opr_block);
+        } else {
+          q->tasks.push_back(opr_block);
+        }
+      }
+      num_pending.fetch_add(1);
+      if (num_idle.load() > 0) {
+        std::lock_guard<std::mutex> lock(idle_mutex);
+        idle_cv.notify_one();
+      }
+    }
+    // pop a task for the worker qid, blocks until a task is available or killed
+    bool Pop(size_t qid, OprBlock** opr_block) {
+      while (true) {
+        if (TryPop(qid, opr_block)) return true;
+        std::unique_lock<std::mutex> lock(idle_mutex);
+        num_idle.fetch_add(1);
+        idle_cv.wait(lock, [this]() { return num_pending.load() > 0 || kill; });
+        num_idle.fetch_sub(1);
+        if (kill && num_pending.load() == 0) return false;
+      }
+    }
+    // try the own deque first, then steal from the peers
+    bool TryPop(size_t qid, OprBlock** opr_block) {
+      const size_t n = queues.size();
+      for (size_t k = 0; k < n; ++k) {
+        TaskDeque* q = queues[(qid + k) % n].get();
+        std::lock_guard<std::mutex> lock(q->mutex);
+        if (q->tasks.empty()) continue;
+        if (k == 0) {
+          *opr_block = q->tasks.front();
+          q->tasks.pop_front();
+        } else {
+          *opr_block = q->tasks.back();
+          q->tasks.pop_back();
+        }
+        num_pending.fetch_sub(1);
+        return true;
+      }
+      return false;
+    }
+    void SignalForKill() {
+      std::lock_guard<std::mutex> lock(idle_mutex);
+      kill = true;
+      idle_cv.notify_all();
+    }
+    // per worker task deques
+    std::vector<std::unique_ptr<TaskDeque>> queues;
+    // round robin cursor for pushes from outside of the group
+    std::atomic<size_t> next_queue{0};
+    // index handed to the next worker that starts
+    std::atomic<size_t> next_worker{0};
+    // number of tasks pushed but not popped yet
+    std::atomic<int> num_pending{0};
+    // number of workers waiting on idle_cv
+    std::atomic<int> num_idle{0};
+    // protects kill and the sleep of idle workers
+    std::mutex idle_mutex;
+    std::condition_variable idle_cv;
+    bool kill{false};
+    // thread pool that works on this task
+    std::unique_ptr<ThreadPool> pool;
+  };
+
   /*! \brief whether this is a worker thread. */
   static MX_THREAD_LOCAL bool is_worker_;
+  /*! \brief work stealing block the current thread works for, if any. */
+  static MX_THREAD_LOCAL WorkStealingBlock* worker_block_;
+  /*! \brief index of the current thread in worker_block_. */
+  static MX_THREAD_LOCAL size_t worker_index_;
+  /*! \brief whether normal CPU tasks use work stealing */
+  const bool work_stealing_;
   /*! \brief number of concurrent thread cpu worker uses */
   size_t cpu_worker_nthreads_;
   /*! \brief number of concurrent thread each gpu worker uses */
@@ -224,6 +349,8 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
   size_t gpu_copy_nthreads_;
   // cpu worker
   common::LazyAllocArray<ThreadWorkerBlock<kWorkerQueue> > cpu_normal_workers_;
+  // cpu workers with work stealing
+  common::LazyAllocArray<WorkStealingBlock> cpu_stealing_workers_;
   // cpu priority worker
   std::unique_ptr<ThreadWorkerBlock<kPriorityQueue> > cpu_priority_worker_;
   // workers doing normal works on GPU
@@ -303,6 +430,32 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     }
   }
 
+  /*!
+   * \brief CPU worker that performs operations on CPU with work stealing.
+   * \param block The work stealing block of the worker.
+   */
+  inline void CPUStealingWorker(Context ctx,
+                                WorkStealingBlock *block,
+                                const std::shared_ptr<dmlc::ManualEvent>& ready_event) {
+    this->is_worker_ = true;
+    const size_t qid = block->next_worker++;
+    worker_block_ = block;
+    worker_index_ = qid;
+    RunContext run_ctx{ctx, nullptr, nullptr, false};
+
+    // execute task
+    OprBlock* opr_block;
+    ready_event->signal();
+
+    // Set default number of threads for OMP parallel regions initiated by this thread
+    OpenMP::Get()->on_start_worker_thread(true);
+
+    while (block->Pop(qid, &opr_block)) {
+      this->ExecuteOprBlock(run_ctx, opr_block);
+    }
+    worker_block_ = nullptr;
+  }
+
   /*!
    * \brief Get number of cores this engine should reserve for its own use
    * \param using_gpu Whether there is GPU usage
@@ -338,6 +491,9 @@ class ThreadedEnginePerDevice : public ThreadedEngine {
     SignalQueueForKill(&gpu_normal_workers_);
     SignalQueueForKill(&gpu_copy_workers_);
     SignalQueueForKill(&cpu_normal_workers_);
+    cpu_stealing_workers_.ForEach([](size_t i, WorkStealingBlock *block) {
+      block->SignalForKill();
+    });
     if (cpu_priority_worker_) {
       cpu_priority_worker_->task_queue.SignalForKill();
     }
@@ -348,7 +504,14 @@ Engine *CreateThreadedEnginePerDevice() {
   return new ThreadedEnginePerDevice();
 }
 
+Engine *CreateThreadedEngineWorkStealing() {
+  return new ThreadedEnginePerDevice(true);
+}
+
 MX_THREAD_LOCAL bool ThreadedEnginePerDevice::is_worker_ = false;
+MX_THREAD_LOCAL ThreadedEnginePerDevice::WorkStealingBlock*
+ThreadedEnginePerDevice::worker_block_ = nullptr;
+MX_THREAD_LOCAL size_t ThreadedEnginePerDevice::worker_index_ = 0;
 
 }  // namespace engine
 }  // namespace mxnet
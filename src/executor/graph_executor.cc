@@ -27,6 +27,7 @@
 #include <nnvm/pass_functions.h>
 #include <vector>
 #include <algorithm>
+#include <map>
 
 #include "./exec_pass.h"
 #include "./graph_executor.h"
@@ -169,6 +170,10 @@ void GraphExecutor::Print(std::ostream &os) const {  // NOLINT(*)
   // message to be backward compatible with the memonger
   size_t total_bytes = graph_.GetAttr<size_t>("storage_allocated_bytes");
   os << "Total " << (total_bytes >> 20UL) <<" MB allocated\n";
+  if (graph_.attrs.count("storage_arena_bytes")) {
+    size_t arena_bytes = graph_.GetAttr<size_t>("storage_arena_bytes");
+    os << "Total " << (arena_bytes >> 20UL) << " MB planned peak in arena\n";
+  }
   os << "Total " << 11 << " TempSpace resource requested\n";
 }
 
@@ -1107,6 +1112,46 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   data_pool_.clear();
   data_pool_.resize(pool_info.size());
 
+  if (graph_.attrs.count("storage_offset")) {
+    // the memory planner packed the storage into one arena per context,
+    // allocate each arena once and place every storage at its offset
+    const auto& offsets = graph_.GetAttr<std::vector<size_t> >("storage_offset");
+    std::map<Context, size_t> arena_bytes;
+    for (size_t i = 0; i < pool_info.size(); ++i) {
+      if (pool_info[i].bytes == 0) continue;
+      size_t& bytes = arena_bytes[pool_info[i].ctx];
+      bytes = std::max(bytes, offsets.at(i) + pool_info[i].bytes);
+    }
+    std::map<Context, NDArray> arenas;
+    for (const auto& kv : arena_bytes) {
+      const Context& ctx = kv.first;
+      bool allocated = false;
+      for (auto it = free_pool.lower_bound(kv.second); it != free_pool.end(); ++it) {
+        if (it->second.ctx() == ctx) {
+          arenas[ctx] = it->second;
+          free_pool.erase(it);
+          allocated = true;
+          break;
+        }
+      }
+      if (!allocated) {
+        size_t nword = (kv.second + 3) / 4;
+        CHECK_LE(nword, std::numeric_limits<nnvm::dim_t>::max());
+        NDArray nd(mxnet::TShape{static_cast<nnvm::dim_t>(nword)}, ctx, true);
+        arenas[ctx] = nd;
+        if (shared_pool != nullptr) {
+          shared_pool->push_back(nd);
+        }
+      }
+    }
+    for (size_t i = 0; i < pool_info.size(); ++i) {
+      if (pool_info[i].bytes == 0) continue;
+      size_t nword = (pool_info[i].bytes + 3) / 4;
+      data_pool_[i] = arenas.at(pool_info[i].ctx).AsArrayWithOffset(
+          offsets.at(i), mxnet::TShape{static_cast<nnvm::dim_t>(nword)}, mshadow::kFloat32);
+    }
+  }
+
   // sort the pool info the descending order before allocating memory
   std::vector<size_t> sorted_pool_index;
   for (size_t i = 0; i < pool_info.size(); i++) {
@@ -1118,6 +1163,7 @@ void GraphExecutor::InitDataEntryMemory(std::vector<NDArray>* shared_pool) {
   std::sort(sorted_pool_index.begin(), sorted_pool_index.end(), pool_comparator);
 
   for (size_t i : sorted_pool_index) {
+    if (!data_pool_[i].is_none()) continue;
     const Context& ctx = pool_info[i].ctx;
     size_t bytes = pool_info[i].bytes;
     bool allocated = false;
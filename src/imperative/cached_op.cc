@@ -78,6 +78,11 @@ struct CachedOp::CachedOpState {
   bool bwd_alloc = false;
   bool fwd_exec_init = false;
   bool bwd_exec_init = false;
+  // static_replay: data inputs and outputs are bound to the buffers below
+  bool replay_init = false;
+  std::vector<NDArray> replay_outputs;
+  // arrays handed out as outputs, reused once the caller released them
+  std::vector<std::vector<NDArray> > replay_output_pool;
 
   std::vector<NDArray> buff;
   std::vector<NDArray*> arrays;
@@ -106,6 +111,9 @@ CachedOp::CachedOp(
   if (config_.static_shape) {
     CHECK(config_.static_alloc) << "static_alloc must be True when static_shape is True";
   }
+  if (config_.static_replay) {
+    CHECK(config_.static_shape) << "static_shape must be True when static_replay is True";
+  }
 
   // construct forward graph
   {
@@ -537,7 +545,10 @@ void CachedOp::StaticAllocMemory(
       keep_fwd ? state.info.fwd_graph.indexed_graph().num_node_entries() : 0;
   size_t end_eid = idx.num_node_entries();
 
-  if (!keep_fwd) state.fwd_alloc = false;
+  if (!keep_fwd) {
+    state.fwd_alloc = false;
+    state.replay_init = false;
+  }
   state.bwd_alloc = false;
   for (size_t i = start_eid; i < state.buff.size(); ++i) {
     state.buff[i] = NDArray();
@@ -640,8 +651,8 @@ void CachedOp::StaticInitExec(
       else
         bulk_size = keep_fwd ? config_.backward_bulk_size : config_.forward_bulk_size;
     } else {
-      // Inference mode
-      if (!Imperative::PreferBulkExecInference())
+      // Inference mode, replay always runs the entire forward graph as one segment
+      if (!state.replay_init && !Imperative::PreferBulkExecInference())
         bulk_size = 0;
     }
 
@@ -656,6 +667,58 @@ void CachedOp::StaticInitExec(
   }
 }
 
+bool CachedOp::StaticInitReplay(
+    const OpStatePtr& state_ptr) {
+  using namespace nnvm;
+  using namespace imperative;
+
+  auto& state = state_ptr.get_state<CachedOpState>();
+  const auto& default_ctx = state.context;
+  const nnvm::Graph& g = state.info.fwd_graph;
+  const auto& idx = g.indexed_graph();
+  const auto& dtypes = g.GetAttr<DTypeVector>("dtype");
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& stypes = g.GetAttr<StorageTypeVector>("storage_type");
+
+  // Every input must be either data, copied into a buffer, or a parameter, bound once
+  if (static_cast<size_t>(config_.data_indices.ndim() + config_.param_indices.ndim()) !=
+      idx.input_nodes().size()) {
+    return false;
+  }
+  for (auto i : config_.param_indices) {
+    const uint32_t param_eid = idx.entry_id(idx.input_nodes()[i], 0);
+    for (const auto& e : idx.outputs()) {
+      if (idx.entry_id(e) == param_eid) return false;
+    }
+  }
+  std::vector<uint32_t> eids;
+  for (auto i : config_.data_indices) {
+    eids.push_back(idx.entry_id(idx.input_nodes()[i], 0));
+  }
+  for (const auto& e : idx.outputs()) {
+    eids.push_back(idx.entry_id(e));
+  }
+  for (auto eid : eids) {
+    if (stypes[eid] != kDefaultStorage) return false;
+  }
+  // Bind the data inputs and the outputs to static buffers, so that every node gets a fixed
+  // executor and the forward graph becomes a single engine operation.
+  for (auto eid : eids) {
+    if (!state.dynamic_entries[eid]) continue;
+    state.buff[eid] = NDArray(shapes[eid], default_ctx, false, dtypes[eid]);
+    state.arrays[eid] = &state.buff[eid];
+    state.dynamic_entries[eid] = false;
+  }
+  state.replay_outputs.clear();
+  for (const auto& e : idx.outputs()) {
+    state.replay_outputs.push_back(*state.arrays[idx.entry_id(e)]);
+  }
+  state.replay_output_pool.clear();
+  state.replay_output_pool.resize(idx.outputs().size());
+  state.replay_init = true;
+  return true;
+}
+
 void CachedOp::StaticRunOps(
     const Context& default_ctx,
     const nnvm::Graph& g,
@@ -739,6 +802,24 @@ void CachedOp::StaticRunOps(
   }
 }
 
+/*!
+ * \brief Returns an output array for a static_replay call. Arrays of the pool that no
+ *  caller holds anymore are reused, so steady-state calls allocate nothing.
+ */
+static NDArray TakeReplayOutput(std::vector<NDArray>* pool, const mxnet::TShape& shape,
+                                const Context& ctx, const int dtype) {
+  // bounds the scan and the memory kept when callers hold on to many outputs
+  const size_t kMaxReplayOutputPool = 4;
+  for (const NDArray& arr : *pool) {
+    if (arr.is_unique()) return arr;
+  }
+  if (pool->size() >= kMaxReplayOutputPool) {
+    return NDArray(shape, ctx, true, dtype);
+  }
+  pool->emplace_back(shape, ctx, true, dtype);
+  return pool->back();
+}
+
 OpStatePtr CachedOp::StaticForward(
     const Context& default_ctx,
     const std::vector<NDArray*>& inputs,
@@ -759,6 +840,13 @@ OpStatePtr CachedOp::StaticForward(
   if (!state.fwd_alloc || !match)  {
     StaticAllocMemory(state_ptr, recording, false);
   }
+  // Replay inference through static input and output buffers
+  bool replay = config_.static_replay && !recording;
+  if (replay && !state.replay_init) {
+    // The executors must be rebuilt over the replay buffers
+    replay = StaticInitReplay(state_ptr);
+    match = match && !replay;
+  }
 
   // We are going to add input and output arrays to the array list.
   // The input and output arrays should only be valid for this run,
@@ -778,7 +866,11 @@ OpStatePtr CachedOp::StaticForward(
     }
     for (auto i : config_.data_indices) {
       auto eid = idx.entry_id(idx.input_nodes()[i], 0);
-      arrays[eid] = inputs[i];
+      if (replay) {
+        CopyFromTo(*inputs[i], arrays[eid]);
+      } else {
+        arrays[eid] = inputs[i];
+      }
     }
   } else {
     for (size_t i = 0; i < num_inputs(); ++i) {
@@ -795,6 +887,19 @@ OpStatePtr CachedOp::StaticForward(
   const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
   const auto& stypes = g.GetAttr<StorageTypeVector>("storage_type");
 
+  if (replay) {
+    StaticRunOps(default_ctx, g, state_ptr, arrays, 0, idx.num_nodes());
+    for (size_t i = 0; i < outputs.size(); ++i) {
+      auto eid = idx.entry_id(idx.outputs()[i]);
+      if (outputs[i]->is_none()) {
+        *outputs[i] = TakeReplayOutput(&state.replay_output_pool[i], shapes[eid],
+                                       default_ctx, dtypes[eid]);
+      }
+      CopyFromTo(state.replay_outputs[i], outputs[i]);
+    }
+    return OpStatePtr();
+  }
+
   for (size_t i = 0; i < outputs.size(); ++i) {
     auto eid = idx.entry_id(idx.outputs()[i]);
     // An input and an output may share the same array.
@@ -35,6 +35,7 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
   uint32_t backward_bulk_size;
   bool static_alloc;
   bool static_shape;
+  bool static_replay;
   bool is_dynamic;
   mxnet::Tuple<uint32_t> data_indices;
   mxnet::Tuple<uint32_t> param_indices;
@@ -49,6 +50,14 @@ struct CachedOpConfig : public dmlc::Parameter<CachedOpConfig> {
     .describe("Optimize for invariant input shapes between iterations. "
               "Must also set static_alloc to True. "
               "Change of input shapes is still allowed but slower.");
+    DMLC_DECLARE_FIELD(static_replay)
+    .set_default(false)
+    .describe("Replay inference as a single engine operation over fixed arrays. "
+              "Inputs and outputs are copied through static buffers so that all "
+              "operators run on the static memory plan without per-call setup. "
+              "Each call pushes one copy per data input and output. Outputs are "
+              "taken from a small pool of arrays the caller released. "
+              "Must also set static_shape to True.");
     DMLC_DECLARE_FIELD(inline_limit)
     .set_default(2)
     .describe("Maximum number of operators that can be inlined.");
@@ -169,6 +178,8 @@ class CachedOp {
       const OpStatePtr& state_ptr,
       bool recording,
       bool keep_fwd);
+  bool StaticInitReplay(
+      const OpStatePtr& state_ptr);
   void StaticRunOps(
       const Context& default_ctx,
       const nnvm::Graph& g,
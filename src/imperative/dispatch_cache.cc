@@ -0,0 +1,142 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dispatch_cache.cc
+ * \brief cache of the dispatch of imperative operator calls
+ */
+#include <dmlc/parameter.h>
+#include <dmlc/thread_local.h>
+#include <functional>
+#include "./dispatch_cache.h"
+
+namespace mxnet {
+namespace imperative {
+
+std::atomic<uint64_t> DispatchCache::hits_{0};
+std::atomic<uint64_t> DispatchCache::misses_{0};
+std::atomic<uint64_t> DispatchCache::saved_ns_{0};
+
+namespace {
+
+inline uint64_t HashMix(uint64_t hash, uint64_t value) {
+  return hash ^ (value + 0x9e3779b97f4a7c15ULL + (hash << 6) + (hash >> 2));
+}
+
+inline void AddSign(const NDArray& arr, std::vector<int64_t> *sign) {
+  sign->push_back(arr.is_none());
+  sign->push_back(arr.storage_type());
+  sign->push_back(arr.dtype());
+  const mxnet::TShape& shape = arr.shape();
+  sign->push_back(shape.ndim());
+  for (int i = 0; i < shape.ndim(); ++i) {
+    sign->push_back(shape[i]);
+  }
+}
+
+size_t CacheCapacity() {
+  static const size_t capacity = dmlc::GetEnv("MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE", 1024);
+  return capacity;
+}
+
+}  // namespace
+
+DispatchCache::DispatchCache() : capacity_(CacheCapacity()) {}
+
+DispatchCache *DispatchCache::Get() {
+  if (CacheCapacity() == 0) return nullptr;
+  return dmlc::ThreadLocalStore<DispatchCache>::Get();
+}
+
+const DispatchInfo *DispatchCache::Lookup(const Context& ctx,
+                                          const nnvm::NodeAttrs& attrs,
+                                          const std::vector<NDArray*>& inputs,
+                                          const std::vector<NDArray*>& outputs) {
+  sign_.clear();
+  sign_.push_back(ctx.dev_type);
+  sign_.push_back(ctx.dev_id);
+  sign_.push_back(Imperative::Get()->is_training());
+  sign_.push_back(Imperative::Get()->is_np_shape());
+  sign_.push_back(inputs.size());
+  for (const auto& i : inputs) AddSign(*i, &sign_);
+  sign_.push_back(outputs.size());
+  for (const auto& i : outputs) AddSign(*i, &sign_);
+
+  hash_ = reinterpret_cast<uintptr_t>(attrs.op);
+  // the dictionary is unordered, its entries are combined independently of the order
+  std::hash<std::string> str_hash;
+  uint64_t dict_hash = 0;
+  for (const auto& kv : attrs.dict) {
+    dict_hash += HashMix(str_hash(kv.first), str_hash(kv.second));
+  }
+  hash_ = HashMix(hash_, dict_hash);
+  for (const auto& v : sign_) hash_ = HashMix(hash_, v);
+
+  auto it = entries_.find(hash_);
+  if (it != entries_.end()) {
+    for (const auto& entry : it->second) {
+      if (entry.op == attrs.op && entry.sign == sign_ && entry.dict == attrs.dict) {
+        hits_.fetch_add(1, std::memory_order_relaxed);
+        saved_ns_.fetch_add(entry.info->infer_ns, std::memory_order_relaxed);
+        return entry.info.get();
+      }
+    }
+  }
+  return nullptr;
+}
+
+const DispatchInfo *DispatchCache::Insert(const nnvm::NodeAttrs& attrs, DispatchInfo&& info) {
+  misses_.fetch_add(1, std::memory_order_relaxed);
+  if (size_ >= capacity_) {
+    entries_.clear();
+    size_ = 0;
+  }
+  ++size_;
+  std::vector<Entry>& bucket = entries_[hash_];
+  bucket.emplace_back(Entry{attrs.op, attrs.dict, sign_,
+                            std::unique_ptr<DispatchInfo>(new DispatchInfo(std::move(info)))});
+  return bucket.back().info.get();
+}
+
+bool DispatchCache::Cacheable(const nnvm::NodeAttrs& attrs, const DispatchInfo& info) {
+  static auto& infershape = nnvm::Op::GetAttr<mxnet::FInferShape>("FInferShape");
+  if (!attrs.subgraphs.empty() || !infershape.count(attrs.op)) return false;
+  for (const auto& s : info.in_shapes) {
+    if (!mxnet::shape_is_known(s)) return false;
+  }
+  for (const auto& s : info.out_shapes) {
+    if (!mxnet::shape_is_known(s)) return false;
+  }
+  return true;
+}
+
+void DispatchCache::Stats(uint64_t *hits, uint64_t *misses, uint64_t *saved_ns, bool reset) {
+  if (reset) {
+    *hits = hits_.exchange(0);
+    *misses = misses_.exchange(0);
+    *saved_ns = saved_ns_.exchange(0);
+  } else {
+    *hits = hits_.load();
+    *misses = misses_.load();
+    *saved_ns = saved_ns_.load();
+  }
+}
+
+}  // namespace imperative
+}  // namespace mxnet
@@ -0,0 +1,134 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file dispatch_cache.h
+ * \brief cache of the shape, type and storage inference and of the dispatch of imperative
+ *        operator calls, keyed by operator, attributes and input and output signature
+ */
+#ifndef MXNET_IMPERATIVE_DISPATCH_CACHE_H_
+#define MXNET_IMPERATIVE_DISPATCH_CACHE_H_
+
+#include <mxnet/imperative.h>
+#include <mxnet/op_attr_types.h>
+#include <mxnet/resource.h>
+#include <atomic>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace imperative {
+
+/*! \brief Everything Imperative::Invoke derives from the operator and the array signatures */
+struct DispatchInfo {
+  /*! \brief Input shapes and types after inference, for FCreateOpState */
+  mxnet::ShapeVector in_shapes;
+  std::vector<int> in_types;
+  /*! \brief Inferred output shapes, types and storage types */
+  mxnet::ShapeVector out_shapes;
+  std::vector<int> out_types;
+  std::vector<int> out_storage_types;
+  DispatchMode dispatch_mode = DispatchMode::kUndefined;
+  /*! \brief Resources to request for every call, including storage fallback */
+  std::vector<ResourceRequest> resource_reqs;
+  std::vector<uint32_t> mutate_idx;
+  FCompute fn = nullptr;
+  FComputeEx fn_ex = nullptr;
+  /*! \brief Time the inference took when the entry was created, saved by every hit */
+  int64_t infer_ns = 0;
+};
+
+/*!
+ * \brief Per-thread cache of DispatchInfo.
+ *        A call is looked up by operator, attribute dictionary, context, training and numpy
+ *        shape modes, and by the shape, type and storage type of every input and every
+ *        preallocated output. Operators with subgraphs or without static shape inference are
+ *        not cached. MXNET_IMPERATIVE_DISPATCH_CACHE_SIZE bounds the number of entries per
+ *        thread, the cache is cleared when it is full, 0 disables it.
+ */
+class DispatchCache {
+ public:
+  DispatchCache();
+
+  /*!
+   * \brief Get the cache of the calling thread
+   * \return The cache, or nullptr if caching is disabled
+   */
+  static DispatchCache *Get();
+
+  /*!
+   * \brief Find the dispatch of a call
+   * \return The cached entry, or nullptr on a miss. The signature of the call is kept for
+   *         a following Insert().
+   */
+  const DispatchInfo *Lookup(const Context& ctx,
+                             const nnvm::NodeAttrs& attrs,
+                             const std::vector<NDArray*>& inputs,
+                             const std::vector<NDArray*>& outputs);
+
+  /*!
+   * \brief Cache the dispatch of the call of the last Lookup() miss
+   * \param attrs Attributes of that call
+   * \param info Its dispatch
+   * \return The cached entry
+   */
+  const DispatchInfo *Insert(const nnvm::NodeAttrs& attrs, DispatchInfo&& info);
+
+  /*!
+   * \brief Whether a call may be cached
+   * \param attrs Attributes of the call
+   * \param info Its dispatch, as inferred
+   * \return false for subgraph operators and for dynamic or unknown shapes
+   */
+  static bool Cacheable(const nnvm::NodeAttrs& attrs, const DispatchInfo& info);
+
+  /*!
+   * \brief Process-wide statistics, summed over all threads
+   * \param hits Receives the number of calls that skipped inference
+   * \param misses Receives the number of cacheable calls that ran inference
+   * \param saved_ns Receives the inference time the hits skipped, in nanoseconds
+   * \param reset Whether to clear the statistics
+   */
+  static void Stats(uint64_t *hits, uint64_t *misses, uint64_t *saved_ns, bool reset);
+
+ private:
+  struct Entry {
+    const nnvm::Op *op;
+    std::unordered_map<std::string, std::string> dict;
+    std::vector<int64_t> sign;
+    std::unique_ptr<DispatchInfo> info;
+  };
+
+  size_t capacity_;
+  size_t size_ = 0;
+  std::unordered_map<uint64_t, std::vector<Entry>> entries_;
+  /*! \brief Signature and hash of the last lookup */
+  std::vector<int64_t> sign_;
+  uint64_t hash_ = 0;
+
+  static std::atomic<uint64_t> hits_;
+  static std::atomic<uint64_t> misses_;
+  static std::atomic<uint64_t> saved_ns_;
+};
+
+}  // namespace imperative
+}  // namespace mxnet
+#endif  // MXNET_IMPERATIVE_DISPATCH_CACHE_H_
@@ -18,8 +18,10 @@
  */
 #include <unordered_set>
 #include <iostream>
+#include <chrono>
 #include "./imperative_utils.h"
 #include "./cached_op.h"
+#include "./dispatch_cache.h"
 
 namespace mxnet {
 #if DMLC_CXX11_THREAD_LOCAL
@@ -44,7 +46,8 @@ OpStatePtr Imperative::InvokeOp(
     const std::vector<NDArray*>& outputs,
     const std::vector<OpReqType>& req,
     const DispatchMode dispatch_mode,
-    OpStatePtr state) {
+    OpStatePtr state,
+    const imperative::DispatchInfo* dispatch_info) {
   using namespace imperative;
   static auto& createop = nnvm::Op::GetAttr<FCreateOpState>("FCreateOpState");
   static auto& is_layer_backward = Op::GetAttr<bool>("TIsLayerOpBackward");
@@ -55,11 +58,20 @@ OpStatePtr Imperative::InvokeOp(
   std::vector<engine::VarHandle> read_vars, write_vars;
   std::vector<Resource> requested;
   std::vector<uint32_t> mutate_idx;
-  SetDependency(attrs, ctx, inputs, outputs,
-      &read_vars, &write_vars, &requested, &mutate_idx, dispatch_mode);
-
-  FCompute fn = common::GetFCompute<FCompute>(op, "FCompute", ctx);
-  FComputeEx fn_ex = common::GetFCompute<FComputeEx>(op, "FComputeEx", ctx);
+  FCompute fn;
+  FComputeEx fn_ex;
+  if (dispatch_info) {
+    mutate_idx = dispatch_info->mutate_idx;
+    SetDependency(dispatch_info->resource_reqs, mutate_idx, ctx, inputs, outputs,
+        &read_vars, &write_vars, &requested);
+    fn = dispatch_info->fn;
+    fn_ex = dispatch_info->fn_ex;
+  } else {
+    SetDependency(attrs, ctx, inputs, outputs,
+        &read_vars, &write_vars, &requested, &mutate_idx, dispatch_mode);
+    fn = common::GetFCompute<FCompute>(op, "FCompute", ctx);
+    fn_ex = common::GetFCompute<FComputeEx>(op, "FComputeEx", ctx);
+  }
 
   // FComputeEx is dispatched only when dispatch_mode is DispatchMode::kFComputeEx
   CHECK(dispatch_mode != DispatchMode::kUndefined);
@@ -82,6 +94,9 @@ OpStatePtr Imperative::InvokeOp(
       << "Operator " << op->name << " is not implemented for "
       << (ctx.dev_mask() == gpu::kDevMask ? "GPU." : "CPU.");
   }
+  for (const auto& r : requested) {
+    ResourceManager::Get()->Release(r);
+  }
 
   return state;
 }
@@ -105,10 +120,39 @@ OpStatePtr Imperative::Invoke(
   // TODO(piiswrong): infer ctx
   DispatchMode dispatch_mode = DispatchMode::kUndefined;
   Context ctx = GetContext(attrs, inputs, outputs, default_ctx);
-  SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+  DispatchCache* cache = DispatchCache::Get();
+  const DispatchInfo* dispatch_info = cache ? cache->Lookup(ctx, attrs, inputs, outputs) : nullptr;
+  if (dispatch_info) {
+    SetShapeType(ctx, *dispatch_info, outputs);
+    dispatch_mode = dispatch_info->dispatch_mode;
+  } else if (cache) {
+    auto begin = std::chrono::steady_clock::now();
+    SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+    DispatchInfo info;
+    MXAPIThreadLocalEntry<> *local_buff = MXAPIThreadLocalStore<>::Get();
+    info.in_shapes = local_buff->arg_shapes;
+    info.out_shapes = local_buff->out_shapes;
+    if (DispatchCache::Cacheable(attrs, info)) {
+      static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+      info.in_types = local_buff->arg_types;
+      info.out_types = local_buff->out_types;
+      info.out_storage_types = local_buff->out_storage_types;
+      info.dispatch_mode = dispatch_mode;
+      info.resource_reqs = GetResourceRequests(attrs, ctx, dispatch_mode);
+      if (fmutate.count(attrs.op)) info.mutate_idx = fmutate[attrs.op](attrs);
+      info.fn = common::GetFCompute<FCompute>(attrs.op, "FCompute", ctx);
+      info.fn_ex = common::GetFCompute<FComputeEx>(attrs.op, "FComputeEx", ctx);
+      info.infer_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+          std::chrono::steady_clock::now() - begin).count();
+      dispatch_info = cache->Insert(attrs, std::move(info));
+    }
+  } else {
+    SetShapeType(ctx, attrs, inputs, outputs, &dispatch_mode);
+  }
   std::vector<OpReqType> req;
   SetWriteInplaceReq(inputs, outputs, &req);
-  OpStatePtr ret = InvokeOp(ctx, attrs, inputs, outputs, req, dispatch_mode);
+  OpStatePtr ret = InvokeOp(ctx, attrs, inputs, outputs, req, dispatch_mode,
+                            OpStatePtr(), dispatch_info);
   // the followinng loop is used for finding out the correct shape when some shapes are dynamic
   for (size_t i = 0; i < outputs.size(); i++) {
     if (!shape_is_known(outputs[i]->shape())) {
@@ -25,6 +25,7 @@
 #include <vector>
 #include <map>
 #include <string>
+#include <limits>
 #include "../executor/graph_executor.h"
 #include "../executor/exec_pass.h"
 #include "../c_api/c_api_common.h"
@@ -32,6 +33,7 @@
 #include "../common/exec_utils.h"
 #include "../operator/nn/mkldnn/mkldnn_base-inl.h"
 #include "../operator/operator_common.h"
+#include "./dispatch_cache.h"
 
 #ifndef MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
 #define MXNET_IMPERATIVE_IMPERATIVE_UTILS_H_
@@ -44,8 +46,13 @@ struct MemoryPlanInfo {
   uint32_t root;
   size_t size;
   bool inplace;
+  // byte offset of the storage in the arena, kNoArenaOffset if not packed
+  size_t arena_offset;
 };
 
+/*! \brief arena_offset of storage that is not packed into an arena */
+constexpr size_t kNoArenaOffset = std::numeric_limits<size_t>::max();
+
 struct EngineOprDeleter {
   void operator()(engine::Opr* handle) {
     Engine::Get()->DeleteOperator(handle);
@@ -223,63 +230,84 @@ inline void SetShapeType(const Context& ctx,
   }
 }
 
-inline void SetDependency(const nnvm::NodeAttrs& attrs,
-                   const Context& ctx,
-                   const std::vector<NDArray*>& inputs,
-                   const std::vector<NDArray*>& outputs,
-                   std::vector<engine::VarHandle> *p_read_vars,
-                   std::vector<engine::VarHandle> *p_write_vars,
-                   std::vector<Resource> *p_requested,
-                   std::vector<uint32_t> *p_mutate_idx,
-                   const DispatchMode dispatch_mode) {
-  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+/*!
+ * \brief Allocate the outputs of a call whose inference was found in the dispatch cache
+ */
+inline void SetShapeType(const Context& ctx,
+                         const DispatchInfo& info,
+                         const std::vector<NDArray*>& outputs) {
+  MXAPIThreadLocalEntry<> *ret = MXAPIThreadLocalStore<>::Get();
+  ret->arg_shapes = info.in_shapes;
+  ret->arg_types = info.in_types;
+  for (size_t i = 0; i < outputs.size(); ++i) {
+    // preallocated outputs are part of the cache key, they were checked on the cache miss
+    if (outputs[i]->is_none() || mxnet::op::shape_is_none(outputs[i]->shape())) {
+      NDArrayStorageType storage_type = static_cast<NDArrayStorageType>(info.out_storage_types[i]);
+      if (storage_type == kDefaultStorage) {
+        *outputs[i] = NDArray(info.out_shapes[i], ctx, true, info.out_types[i]);
+      } else {
+        *outputs[i] = NDArray(storage_type, info.out_shapes[i], ctx, true, info.out_types[i]);
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Resources requested by an operator, including the temporary space of storage fallback
+ */
+inline std::vector<ResourceRequest> GetResourceRequests(const nnvm::NodeAttrs& attrs,
+                                                        const Context& ctx,
+                                                        const DispatchMode dispatch_mode) {
   static auto& ftmp_resource = nnvm::Op::GetAttr<FResourceRequest>("FResourceRequest");
   static auto& ftmp_resource_ex = nnvm::Op::GetAttr<FResourceRequestEx>("FResourceRequestEx");
 
-  std::vector<engine::VarHandle>& read_vars  = *p_read_vars;
-  std::vector<engine::VarHandle>& write_vars = *p_write_vars;
-  std::vector<Resource>& requested = *p_requested;
-  std::vector<uint32_t>& mutate_idx = *p_mutate_idx;
-
-  if (fmutate.count(attrs.op)) {
-    mutate_idx = fmutate[attrs.op](attrs);
-  }
+  std::vector<ResourceRequest> resource_reqs;
   const bool rsc_req = (ftmp_resource.count(attrs.op) != 0);
   const bool rsc_ex_req = (ftmp_resource_ex.count(attrs.op) != 0);
   if (rsc_req || rsc_ex_req) {
+    resource_reqs = rsc_ex_req ? ftmp_resource_ex[attrs.op](attrs,
+                                     static_cast<int>(ctx.dev_mask()), dispatch_mode)
+                               : ftmp_resource[attrs.op](attrs);
     int ntmp = 0;
-    auto resource_reqs = rsc_ex_req ? ftmp_resource_ex[attrs.op](attrs,
-                                          static_cast<int>(ctx.dev_mask()), dispatch_mode)
-                                    : ftmp_resource[attrs.op](attrs);
     for (const auto& req : resource_reqs) {
-      switch (req.type) {
-       case ResourceRequest::kTempSpace:
-        ++ntmp;
-       case ResourceRequest::kRandom:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
-       case ResourceRequest::kParallelRandom:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
-#if MXNET_USE_CUDNN == 1
-       case ResourceRequest::kCuDNNDropoutDesc:
-        requested.push_back(ResourceManager::Get()->Request(ctx, req));
-        write_vars.push_back(requested.back().var);
-        break;
-#endif  // MXNET_USE_CUDNN == 1
-       default:
-        LOG(FATAL) << "resource type not yet supported";
-      }
+      if (req.type == ResourceRequest::kTempSpace) ++ntmp;
     }
     CHECK_LE(ntmp, 1) << "Only support 1 temp space request";
   }
 
   // append extra resource requests for storage fallback
   if (dispatch_mode == DispatchMode::kFComputeFallback) {
-    requested.push_back(ResourceManager::Get()->Request(ctx, ResourceRequest::kTempSpace));
-    write_vars.push_back(requested.back().var);
+    resource_reqs.emplace_back(ResourceRequest::kTempSpace);
+  }
+  return resource_reqs;
+}
+
+inline void SetDependency(const std::vector<ResourceRequest>& resource_reqs,
+                          const std::vector<uint32_t>& mutate_idx,
+                          const Context& ctx,
+                          const std::vector<NDArray*>& inputs,
+                          const std::vector<NDArray*>& outputs,
+                          std::vector<engine::VarHandle> *p_read_vars,
+                          std::vector<engine::VarHandle> *p_write_vars,
+                          std::vector<Resource> *p_requested) {
+  std::vector<engine::VarHandle>& read_vars  = *p_read_vars;
+  std::vector<engine::VarHandle>& write_vars = *p_write_vars;
+  std::vector<Resource>& requested = *p_requested;
+
+  for (const auto& req : resource_reqs) {
+    switch (req.type) {
+     case ResourceRequest::kTempSpace:
+     case ResourceRequest::kRandom:
+     case ResourceRequest::kParallelRandom:
+#if MXNET_USE_CUDNN == 1
+     case ResourceRequest::kCuDNNDropoutDesc:
+#endif  // MXNET_USE_CUDNN == 1
+      requested.push_back(ResourceManager::Get()->Request(ctx, req));
+      write_vars.push_back(requested.back().var);
+      break;
+     default:
+      LOG(FATAL) << "resource type not yet supported";
+    }
   }
 
   read_vars.reserve(inputs.size());
@@ -296,6 +324,25 @@ inline void SetDependency(const nnvm::NodeAttrs& attrs,
   Engine::Get()->DeduplicateVarHandle(&read_vars, &write_vars);
 }
 
+inline void SetDependency(const nnvm::NodeAttrs& attrs,
+                   const Context& ctx,
+                   const std::vector<NDArray*>& inputs,
+                   const std::vector<NDArray*>& outputs,
+                   std::vector<engine::VarHandle> *p_read_vars,
+                   std::vector<engine::VarHandle> *p_write_vars,
+                   std::vector<Resource> *p_requested,
+                   std::vector<uint32_t> *p_mutate_idx,
+                   const DispatchMode dispatch_mode) {
+  static auto& fmutate = nnvm::Op::GetAttr<nnvm::FMutateInputs>("FMutateInputs");
+
+  std::vector<uint32_t>& mutate_idx = *p_mutate_idx;
+  if (fmutate.count(attrs.op)) {
+    mutate_idx = fmutate[attrs.op](attrs);
+  }
+  SetDependency(GetResourceRequests(attrs, ctx, dispatch_mode), mutate_idx, ctx,
+                inputs, outputs, p_read_vars, p_write_vars, p_requested);
+}
+
 inline void SetWriteInplaceReq(const std::vector<NDArray*>& inputs,
                         const std::vector<NDArray*>& outputs,
                         std::vector<OpReqType> *req) {
@@ -834,21 +881,25 @@ inline MemoryPlanVector PlanMemory(
   uint32_t entry_start = entry_range.first;
   uint32_t entry_end =
       entry_range.second > entry_start ? entry_range.second : idx.num_node_entries();
+  // offsets of the storage ids if the planner packed them into an arena
+  const std::vector<size_t>* storage_offset = g.attrs.count("storage_offset") ?
+      &g.GetAttr<std::vector<size_t> >("storage_offset") : nullptr;
   MemoryPlanVector mem_plan(idx.num_node_entries());
   std::unordered_map<int, uint32_t> sid_to_root;
 
   for (uint32_t i = entry_start; i < entry_end; ++i) {
     if (storage_ids[i] < 0) {
-      mem_plan[i] = {storage_ids[i], i, 0, false};
+      mem_plan[i] = {storage_ids[i], i, 0, false, kNoArenaOffset};
     } else if (!sid_to_root.count(storage_ids[i])) {
       CHECK_LT(storage_inplace[i], 0);
       sid_to_root[storage_ids[i]] = i;
       mem_plan[i] = {storage_ids[i], i,
                      mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size(),
-                     false};
+                     false,
+                     storage_offset ? storage_offset->at(storage_ids[i]) : kNoArenaOffset};
     } else {
       uint32_t root = sid_to_root[storage_ids[i]];
-      mem_plan[i] = {storage_ids[i], root, 0, storage_inplace[i] >= 0};
+      mem_plan[i] = {storage_ids[i], root, 0, storage_inplace[i] >= 0, kNoArenaOffset};
       mem_plan[root].size = std::max(mem_plan[root].size,
           mshadow::mshadow_sizeof(dtypes[i]) * shapes[i].Size());
     }
@@ -874,6 +925,27 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
 
   std::multimap<size_t, NDArray> new_pool;
 
+  // storage packed into an arena by the memory planner shares one buffer
+  size_t arena_bytes = 0;
+  for (uint32_t i = entry_start; i < entry_end; ++i) {
+    if (mem_plan[i].root == i && mem_plan[i].arena_offset != kNoArenaOffset) {
+      arena_bytes = std::max(arena_bytes, mem_plan[i].arena_offset + mem_plan[i].size);
+    }
+  }
+  NDArray arena;
+  if (arena_bytes > 0) {
+    auto iter = pool.lower_bound(arena_bytes);
+    if (iter != pool.end()) {
+      arena = iter->second;
+      new_pool.insert(*iter);
+      pool.erase(iter);
+    } else {
+      arena = NDArray(mxnet::TShape({static_cast<nnvm::dim_t>(arena_bytes)}),
+                      default_ctx, true, mshadow::kUint8);
+      new_pool.insert({arena_bytes, arena});
+    }
+  }
+
   for (uint32_t i = entry_start; i < entry_end; ++i) {
     if (mem_plan[i].storage_id == exec::kExternalStorageID) continue;
     CHECK(arrays[i]->is_none());
@@ -883,7 +955,9 @@ inline std::multimap<size_t, NDArray> AllocateMemory(
       continue;
     }
     CHECK_EQ(stypes[i], kDefaultStorage);
-    if (mem_plan[i].root == i) {
+    if (mem_plan[i].root == i && mem_plan[i].arena_offset != kNoArenaOffset) {
+      *arrays[i] = arena.AsArrayWithOffset(mem_plan[i].arena_offset, shapes[i], dtypes[i]);
+    } else if (mem_plan[i].root == i) {
       auto iter = pool.lower_bound(mem_plan[i].size);
       if (iter != pool.end()) {
         *arrays[i] = iter->second.AsArray(shapes[i], dtypes[i]);
@@ -135,6 +135,10 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
   int shuffle_chunk_seed;
   /*! \brief random seed for augmentations */
   dmlc::optional<int> seed_aug;
+  /*! \brief whether to memory map the RecordIO file and shuffle it globally */
+  bool mmap_recordio;
+  /*! \brief whether to decode, resize, crop and normalize JPEGs in one pass */
+  bool fused_decode;
 
   // declare parameters
   DMLC_DECLARE_PARAMETER(ImageRecParserParam) {
@@ -176,6 +180,15 @@ struct ImageRecParserParam : public dmlc::Parameter<ImageRecParserParam> {
         .describe("The random seed for shuffling");
     DMLC_DECLARE_FIELD(seed_aug).set_default(dmlc::optional<int>())
         .describe("Random seed for augmentations.");
+    DMLC_DECLARE_FIELD(mmap_recordio).set_default(false)
+        .describe("Memory map the local .rec file and read the records listed in path_imgidx. "\
+                  "With shuffle, all records are permuted every epoch, seeded by seed. "\
+                  "Only supported by ImageRecordIter.");
+    DMLC_DECLARE_FIELD(fused_decode).set_default(false)
+        .describe("Decode JPEGs with libjpeg-turbo DCT scaling, then resize, crop, "\
+                  "normalize and convert them in one pass into the batch. Applies when "\
+                  "the default augmenter only uses resize and rand_crop, other images "\
+                  "take the regular path. Only supported by ImageRecordIter.");
   }
 };
 
@@ -356,6 +369,15 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
   /*! \brief data type */
   dmlc::optional<int> dtype;
 
+  /*! \brief device type of the staging buffers, none to skip staging */
+  dmlc::optional<int> stage_dev_type;
+
+  /*! \brief device id of the staging buffers */
+  int stage_dev_id;
+
+  /*! \brief number of batches staged ahead on the staging device */
+  int stage_depth;
+
   // declare parameters
   DMLC_DECLARE_PARAMETER(PrefetcherParam) {
     DMLC_DECLARE_FIELD(prefetch_buffer).set_default(4)
@@ -374,6 +396,21 @@ struct PrefetcherParam : public dmlc::Parameter<PrefetcherParam> {
       .add_enum("int8", mshadow::kInt8)
       .set_default(dmlc::optional<int>())
       .describe("Output data type. ``None`` means no change.");
+    DMLC_DECLARE_FIELD(stage_dev_type)
+      .add_enum("cpu", Context::kCPU)
+      .add_enum("cpu_pinned", Context::kCPUPinned)
+      .add_enum("cpu_shared", Context::kCPUShared)
+      .add_enum("gpu", Context::kGPU)
+      .set_default(dmlc::optional<int>())
+      .describe("Device type of the staging buffers. When set, batches are copied "
+                "asynchronously by the engine into a ring of preallocated arrays "
+                "on this device. ``None`` returns batches in CPU memory.");
+    DMLC_DECLARE_FIELD(stage_dev_id).set_default(0)
+      .describe("Device id of the staging buffers.");
+    DMLC_DECLARE_FIELD(stage_depth).set_default(2)
+      .set_lower_bound(1)
+      .describe("Number of batches being copied to the staging device ahead of "
+                "the consumer. 2 gives double buffering.");
   }
 };
 
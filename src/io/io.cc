@@ -23,6 +23,7 @@
 #include <dmlc/registry.h>
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
+#include "./iter_text_parser.h"
 
 // Registers
 namespace dmlc {
@@ -38,5 +39,6 @@ DMLC_REGISTER_PARAMETER(ImageNormalizeParam);
 DMLC_REGISTER_PARAMETER(ImageRecParserParam);
 DMLC_REGISTER_PARAMETER(ImageRecordParam);
 DMLC_REGISTER_PARAMETER(ImageDetNormalizeParam);
+DMLC_REGISTER_PARAMETER(TextParserParam);
 }  // namespace io
 }  // namespace mxnet
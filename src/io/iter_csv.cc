@@ -26,9 +26,12 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
+#include <algorithm>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "./iter_prefetcher.h"
-#include "./iter_batchloader.h"
+#include "./iter_text_parser.h"
 
 namespace mxnet {
 namespace io {
@@ -57,39 +60,70 @@ struct CSVIterParam : public dmlc::Parameter<CSVIterParam> {
   }
 };
 
-class CSVIterBase: public IIterator<DataInst> {
+class CSVIterBase: public IIterator<TBlobBatch> {
  public:
-  CSVIterBase() {
-    out_.data.resize(2);
-  }
+  CSVIterBase() {}
   virtual ~CSVIterBase() {}
 
   // initialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) = 0;
   /*! \brief reset the iterator */
   virtual void BeforeFirst(void) = 0;
-  /*! \brief move to next item */
+  /*! \brief move to next batch */
   virtual bool Next(void) = 0;
-  /*! \brief get current data */
-  virtual const DataInst &Value(void) const {
+  /*! \brief get current batch */
+  virtual const TBlobBatch &Value(void) const {
     return out_;
   }
 
  protected:
   CSVIterParam param_;
+  BatchParam batch_param_;
+  TextParserParam parser_param_;
 
-  DataInst out_;
+  TBlobBatch out_;
 
   // internal instance counter
   unsigned inst_counter_{0};
-  // at end
-  bool end_{false};
-
-  // label parser
-  size_t label_ptr_{0}, label_size_{0};
-  size_t data_ptr_{0}, data_size_{0};
+  // number of instances read from the start of data to fill the last batch
+  size_t num_overflow_{0};
 };
 
+/*!
+ * \brief parses a CSV row of width numbers into out
+ * \return error message, empty on success
+ */
+template <typename DType>
+inline std::string ParseCSVRow(const char* begin, const char* end, DType* out, size_t width) {
+  const char* p = begin;
+  size_t col = 0;
+  while (true) {
+    p = SkipBlank(p, end);
+    DType val = 0;
+    const char* q = ParseNumber(p, end, &val);
+    if (q == p && p != end && *p != ',') {
+      return "Invalid number in CSV row: " + std::string(begin, end);
+    }
+    if (col < width) out[col] = val;
+    ++col;
+    p = SkipBlank(q, end);
+    if (p == end) break;
+    if (*p != ',') return "Invalid number in CSV row: " + std::string(begin, end);
+    ++p;
+  }
+  if (col != width) {
+    std::ostringstream os;
+    os << "The data size in CSV do not match size of shape: "
+       << "specified size=" << width << ", the csv row-length=" << col;
+    return os.str();
+  }
+  return std::string();
+}
+
+/*!
+ * \brief reads batches of CSV rows. The lines of a batch are parsed in parallel,
+ * straight into the batch buffers.
+ */
 template <typename DType>
 class CSVIterTyped: public CSVIterBase {
  public:
@@ -97,71 +131,121 @@ class CSVIterTyped: public CSVIterBase {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
-    data_parser_.reset(dmlc::Parser<uint32_t, DType>::Create(param_.data_csv.c_str(), 0, 1, "csv"));
+    batch_param_.InitAllowUnknown(kwargs);
+    parser_param_.InitAllowUnknown(kwargs);
+    const size_t batch_size = batch_param_.batch_size;
+    data_reader_.reset(new TextLineReader(param_.data_csv, 0, 1));
+    data_width_ = param_.data_shape.Size();
+    data_.resize(batch_size * data_width_);
+    // without label_csv all labels are 0, with shape (1,)
+    mxnet::TShape label_shape = mxnet::TShape(mshadow::Shape1(1));
     if (param_.label_csv != "NULL") {
-      label_parser_.reset(
-        dmlc::Parser<uint32_t, DType>::Create(param_.label_csv.c_str(), 0, 1, "csv"));
-    } else {
-      dummy_label.set_pad(false);
-      dummy_label.Resize(mshadow::Shape1(1));
-      dummy_label = 0;
+      label_reader_.reset(new TextLineReader(param_.label_csv, 0, 1));
+      label_shape = param_.label_shape;
     }
+    label_width_ = label_shape.Size();
+    label_.resize(batch_size * label_width_, DType(0));
+
+    out_.inst_index = new unsigned[batch_size];
+    out_.batch_size = batch_size;
+    out_.data.clear();
+    out_.data.emplace_back(data_.data(), BatchShape(param_.data_shape), cpu::kDevMask, 0);
+    out_.data.emplace_back(label_.data(), BatchShape(label_shape), cpu::kDevMask, 0);
   }
 
   virtual void BeforeFirst() {
-    data_parser_->BeforeFirst();
-    if (label_parser_.get() != nullptr) {
-      label_parser_->BeforeFirst();
+    if (!batch_param_.round_batch || num_overflow_ == 0) {
+      Rewind();
+    } else {
+      // the last batch already restarted from the beginning of the data
+      num_overflow_ = 0;
     }
-    data_ptr_ = label_ptr_ = 0;
-    data_size_ = label_size_ = 0;
-    inst_counter_ = 0;
-    end_ = false;
   }
 
   virtual bool Next() {
-    if (end_) return false;
-    while (data_ptr_ >= data_size_) {
-      if (!data_parser_->Next()) {
-        end_ = true; return false;
-      }
-      data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
+    out_.num_batch_padd = 0;
+    out_.batch_size = batch_param_.batch_size;
+    // after an overflow, wait till before first is called
+    if (num_overflow_ != 0) return false;
+    const size_t batch_size = batch_param_.batch_size;
+    size_t top = ReadRows(0, batch_size);
+    if (top == batch_size) return true;
+    if (parser_param_.verbose) {
+      throughput_.Report("CSVIter", data_reader_->bytes_read());
     }
-    out_.index = inst_counter_++;
-    CHECK_LT(data_ptr_, data_size_);
-    out_.data[0] = AsTBlob(data_parser_->Value()[data_ptr_++], param_.data_shape);
-
-    if (label_parser_.get() != nullptr) {
-      while (label_ptr_ >= label_size_) {
-        CHECK(label_parser_->Next())
-            << "Data CSV's row is smaller than the number of rows in label_csv";
-        label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
-      }
-      CHECK_LT(label_ptr_, label_size_);
-      out_.data[1] = AsTBlob(label_parser_->Value()[label_ptr_++], param_.label_shape);
+    if (top == 0) return false;
+    if (batch_param_.round_batch) {
+      Rewind();
+      num_overflow_ = ReadRows(top, batch_size - top);
+      CHECK_EQ(num_overflow_, batch_size - top) << "number of input must be bigger than batch size";
+      out_.num_batch_padd = num_overflow_;
     } else {
-      out_.data[1] = dummy_label;
+      out_.num_batch_padd = batch_size - top;
     }
     return true;
   }
 
  private:
-  inline TBlob AsTBlob(const dmlc::Row<uint32_t, DType>& row, const mxnet::TShape& shape) {
-    CHECK_EQ(row.length, shape.Size())
-        << "The data size in CSV do not match size of shape: "
-        << "specified shape=" << shape << ", the csv row-length=" << row.length;
-    const DType* ptr = row.value;
-    return TBlob((DType*)ptr, shape, cpu::kDevMask, 0);  // NOLINT(*)
+  mxnet::TShape BatchShape(const mxnet::TShape& shape) {
+    std::vector<index_t> shape_vec;
+    shape_vec.push_back(batch_param_.batch_size);
+    for (index_t dim = 0; dim < shape.ndim(); ++dim) {
+      shape_vec.push_back(shape[dim]);
+    }
+    return mxnet::TShape(shape_vec.begin(), shape_vec.end());
+  }
+
+  void Rewind() {
+    data_reader_->BeforeFirst();
+    if (label_reader_) label_reader_->BeforeFirst();
+    inst_counter_ = 0;
+  }
+
+  // parses up to n rows into the batch from row top on, returns the number of rows read
+  size_t ReadRows(const size_t top, const size_t n) {
+    throughput_.Start();
+    const index_t rows = std::min(n, data_reader_->Fill(n));
+    if (label_reader_) {
+      CHECK_GE(label_reader_->Fill(rows), static_cast<size_t>(rows))
+          << "Data CSV's row is smaller than the number of rows in label_csv";
+    }
+    std::string error;
+    #pragma omp parallel for num_threads(parser_param_.preprocess_threads) schedule(static)
+    for (index_t i = 0; i < rows; ++i) {
+      std::string err = ParseCSVRow(data_reader_->line_begin(i), data_reader_->line_end(i),
+                                    data_.data() + (top + i) * data_width_, data_width_);
+      if (err.empty() && label_reader_) {
+        err = ParseCSVRow(label_reader_->line_begin(i), label_reader_->line_end(i),
+                          label_.data() + (top + i) * label_width_, label_width_);
+      }
+      if (!err.empty()) {
+        #pragma omp critical
+        {
+          if (error.empty()) error = err;
+        }
+      }
+    }
+    if (!error.empty()) LOG(FATAL) << error;
+    for (index_t i = 0; i < rows; ++i) {
+      out_.inst_index[top + i] = inst_counter_++;
+    }
+    data_reader_->Consume(rows);
+    if (label_reader_) label_reader_->Consume(rows);
+    throughput_.Stop(rows);
+    return rows;
   }
-  // dummy label
-  mshadow::TensorContainer<cpu, 1, DType> dummy_label;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint32_t, DType> > data_parser_;
+
+  std::unique_ptr<TextLineReader> label_reader_;
+  std::unique_ptr<TextLineReader> data_reader_;
+  // batch buffers
+  std::vector<DType> data_;
+  std::vector<DType> label_;
+  size_t data_width_{0};
+  size_t label_width_{0};
+  ParseThroughput throughput_;
 };
 
-class CSVIter: public IIterator<DataInst> {
+class CSVIter: public IIterator<TBlobBatch> {
  public:
   CSVIter() {}
   virtual ~CSVIter() {}
@@ -203,7 +287,7 @@ class CSVIter: public IIterator<DataInst> {
     return iterator_->Next();
   }
 
-  virtual const DataInst &Value(void) const {
+  virtual const TBlobBatch &Value(void) const {
     return iterator_->Value();
   }
 
@@ -309,10 +393,10 @@ Examples::
 .add_arguments(CSVIterParam::__FIELDS__())
 .add_arguments(BatchParam::__FIELDS__())
 .add_arguments(PrefetcherParam::__FIELDS__())
+.add_arguments(TextParserParam::__FIELDS__())
 .set_body([]() {
     return new PrefetcherIter(
-        new BatchLoader(
-            new CSVIter()));
+        new CSVIter());
   });
 
 }  // namespace io
@@ -34,6 +34,7 @@
 #include <dmlc/common.h>
 #include <dmlc/timer.h>
 #include <type_traits>
+#include <unordered_set>
 #if MXNET_USE_LIBJPEG_TURBO
 #include <turbojpeg.h>
 #endif
@@ -41,15 +42,35 @@
 #include "./image_augmenter.h"
 #include "./image_iter_common.h"
 #include "./inst_vector.h"
+#include "./mmap_recordio_split.h"
 #include "../common/utils.h"
 
 namespace mxnet {
 
 namespace io {
+#if MXNET_USE_OPENCV && MXNET_USE_LIBJPEG_TURBO
+/*! \brief geometry of a JPEG decoded by the fused decode path */
+struct FusedDecodePlan {
+  /*! \brief size decoded with DCT scaling */
+  int scaled_width, scaled_height;
+  /*! \brief size the default augmenter resizes the image to before cropping */
+  int resized_width, resized_height;
+  /*! \brief crop position in the resized image */
+  int crop_x, crop_y;
+};
+#endif
+
 // parser to parse image recordio
 template<typename DType>
 class ImageRecordIOParser2 {
  public:
+  ~ImageRecordIOParser2() {
+#if MXNET_USE_OPENCV && MXNET_USE_LIBJPEG_TURBO
+    for (tjhandle handle : tj_handles_) {
+      if (handle != nullptr) tjDestroy(handle);
+    }
+#endif
+  }
   // initialize the parser
   inline void Init(const std::vector<std::pair<std::string, std::string> >& kwargs);
 
@@ -72,8 +93,16 @@ class ImageRecordIOParser2 {
   void ProcessImage(const cv::Mat& res,
     mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
     const float illumination_scaled);
+  void NormalizeFactors(const float contrast_scaled, const float illumination_scaled,
+    float mult[4], float bias[4], float mean[4], int16_t mean_int[4]);
 #if MXNET_USE_LIBJPEG_TURBO
   cv::Mat TJimdecode(cv::Mat buf, int color);
+  bool FusedDecode(const cv::Mat& buf, int tid, FusedDecodePlan* plan);
+  void FusedCrop(FusedDecodePlan* plan, common::RANDOM_ENGINE* prnd);
+  template<int n_channels>
+  void FusedProcessImage(const FusedDecodePlan& plan, int tid,
+    mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
+    const float illumination_scaled);
 #endif
 #endif
   inline size_t ParseChunk(DType* data_dptr, real_t* label_dptr, const size_t current_size,
@@ -122,6 +151,16 @@ class ImageRecordIOParser2 {
   bool meanfile_ready_;
   /*! \brief OMPException obj to store and rethrow exceptions from omp blocks*/
   dmlc::OMPException omp_exc_;
+  /*! \brief whether the default augmentation is simple enough for the fused decode path */
+  bool fused_decode_{false};
+  /*! \brief resize and rand_crop of the default augmenter, for the fused decode path */
+  int fused_resize_{-1};
+  bool fused_rand_crop_{false};
+#if MXNET_USE_OPENCV && MXNET_USE_LIBJPEG_TURBO
+  /*! \brief per thread decompressors and decoded images of the fused decode path */
+  std::vector<tjhandle> tj_handles_;
+  std::vector<std::vector<uint8_t> > decoded_;
+#endif
 };
 
 template<typename DType>
@@ -167,6 +206,35 @@ inline void ImageRecordIOParser2<DType>::Init(
     }
     prnds_.emplace_back(new common::RANDOM_ENGINE((i + 1) * kRandMagic));
   }
+#if MXNET_USE_LIBJPEG_TURBO
+  // the fused path implements the default augmenter with only resize and rand_crop
+  fused_decode_ = param_.fused_decode && param_.aug_seq == "aug_default" &&
+                  (param_.data_shape[0] == 1 || param_.data_shape[0] == 3);
+  std::unordered_set<std::string> aug_fields;
+  for (const auto& field : ListDefaultAugParams()) aug_fields.insert(field.name);
+  for (const auto& kwarg : kwargs) {
+    if (kwarg.first == "resize") {
+      fused_resize_ = std::stoi(kwarg.second);
+    } else if (kwarg.first == "rand_crop") {
+      fused_rand_crop_ = kwarg.second == "1" || kwarg.second == "True" || kwarg.second == "true";
+    } else if (kwarg.first == "inter_method") {
+      fused_decode_ = fused_decode_ && std::stoi(kwarg.second) == 1;
+    } else if (kwarg.first != "data_shape" && aug_fields.count(kwarg.first)) {
+      fused_decode_ = false;
+    }
+  }
+  if (param_.fused_decode && !fused_decode_) {
+    LOG(INFO) << "ImageRecordIOParser2: fused_decode only supports aug_default with resize, "
+              << "rand_crop and bilinear interpolation, using the regular decode path";
+  }
+  tj_handles_.assign(threadget, nullptr);
+  decoded_.resize(threadget);
+#else
+  if (param_.fused_decode) {
+    LOG(INFO) << "ImageRecordIOParser2: fused_decode needs libjpeg-turbo, "
+              << "using the regular decode path";
+  }
+#endif
   if (param_.path_imglist.length() != 0) {
     label_map_.reset(new ImageLabelMap(param_.path_imglist.c_str(),
       param_.label_width, !param_.verbose));
@@ -176,10 +244,19 @@ inline void ImageRecordIOParser2<DType>::Init(
 
   if (param_.verbose) {
     LOG(INFO) << "ImageRecordIOParser2: " << param_.path_imgrec
-              << ", use " << threadget << " threads for decoding..";
+              << ", use " << threadget << " threads for decoding"
+              << (fused_decode_ ? " with fused_decode.." : "..");
   }
   legacy_shuffle_ = false;
-  if (param_.path_imgidx.length() != 0) {
+  if (param_.mmap_recordio) {
+    CHECK(param_.path_imgidx.length() != 0)
+        << "ImageRecordIter2: mmap_recordio requires path_imgidx";
+    source_.reset(new MMapRecordIOSplit(
+        param_.path_imgrec, param_.path_imgidx,
+        param_.part_index, param_.num_parts,
+        record_param_.shuffle, record_param_.seed,
+        batch_param_.batch_size, param_.preprocess_threads));
+  } else if (param_.path_imgidx.length() != 0) {
     source_.reset(dmlc::InputSplit::Create(
         param_.path_imgrec.c_str(),
         param_.path_imgidx.c_str(),
@@ -380,26 +457,8 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   float RGBA_MEAN[4] = { 0 };
   int16_t RGBA_MEAN_INT[4] = {0};
   mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
-  if (!std::is_same<DType, uint8_t>::value) {
-    RGBA_MULT[0] = contrast_scaled / normalize_param_.std_r;
-    RGBA_MULT[1] = contrast_scaled / normalize_param_.std_g;
-    RGBA_MULT[2] = contrast_scaled / normalize_param_.std_b;
-    RGBA_MULT[3] = contrast_scaled / normalize_param_.std_a;
-    RGBA_BIAS[0] = illumination_scaled / normalize_param_.std_r;
-    RGBA_BIAS[1] = illumination_scaled / normalize_param_.std_g;
-    RGBA_BIAS[2] = illumination_scaled / normalize_param_.std_b;
-    RGBA_BIAS[3] = illumination_scaled / normalize_param_.std_a;
-    if (!meanfile_ready_) {
-      RGBA_MEAN[0] = normalize_param_.mean_r;
-      RGBA_MEAN[1] = normalize_param_.mean_g;
-      RGBA_MEAN[2] = normalize_param_.mean_b;
-      RGBA_MEAN[3] = normalize_param_.mean_a;
-      RGBA_MEAN_INT[0] = std::round(normalize_param_.mean_r);
-      RGBA_MEAN_INT[1] = std::round(normalize_param_.mean_g);
-      RGBA_MEAN_INT[2] = std::round(normalize_param_.mean_b);
-      RGBA_MEAN_INT[3] = std::round(normalize_param_.mean_a);
-    }
-  }
+  NormalizeFactors(contrast_scaled, illumination_scaled,
+                   RGBA_MULT, RGBA_BIAS, RGBA_MEAN, RGBA_MEAN_INT);
 
   int swap_indices[n_channels]; // NOLINT(*)
   if (n_channels == 1) {
@@ -460,6 +519,32 @@ void ImageRecordIOParser2<DType>::ProcessImage(const cv::Mat& res,
   }
 }
 
+template<typename DType>
+void ImageRecordIOParser2<DType>::NormalizeFactors(const float contrast_scaled,
+  const float illumination_scaled, float mult[4], float bias[4], float mean[4],
+  int16_t mean_int[4]) {
+  if (!std::is_same<DType, uint8_t>::value) {
+    mult[0] = contrast_scaled / normalize_param_.std_r;
+    mult[1] = contrast_scaled / normalize_param_.std_g;
+    mult[2] = contrast_scaled / normalize_param_.std_b;
+    mult[3] = contrast_scaled / normalize_param_.std_a;
+    bias[0] = illumination_scaled / normalize_param_.std_r;
+    bias[1] = illumination_scaled / normalize_param_.std_g;
+    bias[2] = illumination_scaled / normalize_param_.std_b;
+    bias[3] = illumination_scaled / normalize_param_.std_a;
+    if (!meanfile_ready_) {
+      mean[0] = normalize_param_.mean_r;
+      mean[1] = normalize_param_.mean_g;
+      mean[2] = normalize_param_.mean_b;
+      mean[3] = normalize_param_.mean_a;
+      mean_int[0] = std::round(normalize_param_.mean_r);
+      mean_int[1] = std::round(normalize_param_.mean_g);
+      mean_int[2] = std::round(normalize_param_.mean_b);
+      mean_int[3] = std::round(normalize_param_.mean_a);
+    }
+  }
+}
+
 #if MXNET_USE_LIBJPEG_TURBO
 
 bool is_jpeg(unsigned char * file) {
@@ -507,6 +592,158 @@ cv::Mat ImageRecordIOParser2<DType>::TJimdecode(cv::Mat image, int color) {
   tjDestroy(handle);
   return ret;
 }
+
+template<typename DType>
+bool ImageRecordIOParser2<DType>::FusedDecode(const cv::Mat& buf, int tid,
+                                              FusedDecodePlan* plan) {
+  unsigned char* jpeg = const_cast<unsigned char*>(buf.ptr());
+  const size_t jpeg_size = buf.rows * buf.cols;
+  if (jpeg_size < 2 || !is_jpeg(jpeg)) return false;
+  if (tj_handles_[tid] == nullptr) tj_handles_[tid] = tjInitDecompress();
+  tjhandle handle = tj_handles_[tid];
+  int width, height, subsamp;
+  if (tjDecompressHeader2(handle, jpeg, jpeg_size, &width, &height, &subsamp) != 0) {
+    return false;
+  }
+  // the size the default augmenter resizes to before cropping
+  const int out_h = param_.data_shape[1], out_w = param_.data_shape[2];
+  int resized_w = width, resized_h = height;
+  if (fused_resize_ != -1) {
+    if (height > width) {
+      resized_h = fused_resize_ * height / width;
+      resized_w = fused_resize_;
+    } else {
+      resized_h = fused_resize_;
+      resized_w = fused_resize_ * width / height;
+    }
+  }
+  if (resized_h < out_h) {
+    resized_w = static_cast<int>(static_cast<float>(out_h) / resized_h * resized_w);
+    resized_h = out_h;
+  }
+  if (resized_w < out_w) {
+    resized_h = static_cast<int>(static_cast<float>(out_w) / resized_w * resized_h);
+    resized_w = out_w;
+  }
+  // decode at the smallest DCT scaling that is still not smaller than the resized image
+  int num_factors = 0;
+  tjscalingfactor* factors = tjGetScalingFactors(&num_factors);
+  int scaled_w = width, scaled_h = height;
+  for (int i = 0; i < num_factors; ++i) {
+    if (factors[i].num > factors[i].denom) continue;
+    const int w = TJSCALED(width, factors[i]);
+    const int h = TJSCALED(height, factors[i]);
+    if (w >= resized_w && h >= resized_h && w < scaled_w) {
+      scaled_w = w;
+      scaled_h = h;
+    }
+  }
+  const int n_channels = param_.data_shape[0];
+  std::vector<uint8_t>& decoded = decoded_[tid];
+  decoded.resize(static_cast<size_t>(scaled_w) * scaled_h * n_channels);
+  if (tjDecompress2(handle, jpeg, jpeg_size, decoded.data(), scaled_w, 0, scaled_h,
+                    n_channels == 3 ? TJPF_RGB : TJPF_GRAY, 0) != 0) {
+    return false;
+  }
+  plan->scaled_width = scaled_w;
+  plan->scaled_height = scaled_h;
+  plan->resized_width = resized_w;
+  plan->resized_height = resized_h;
+  return true;
+}
+
+template<typename DType>
+void ImageRecordIOParser2<DType>::FusedCrop(FusedDecodePlan* plan,
+                                            common::RANDOM_ENGINE* prnd) {
+  // same draws as the center crop of the default augmenter
+  index_t y = plan->resized_height - param_.data_shape[1];
+  index_t x = plan->resized_width - param_.data_shape[2];
+  if (fused_rand_crop_) {
+    y = std::uniform_int_distribution<index_t>(0, y)(*prnd);
+    x = std::uniform_int_distribution<index_t>(0, x)(*prnd);
+  } else {
+    y /= 2; x /= 2;
+  }
+  plan->crop_x = x;
+  plan->crop_y = y;
+}
+
+/*!
+ * \brief bilinear source pixel and weight of a destination pixel,
+ *  with the pixel center convention of cv::resize
+ */
+inline void BilinearSource(const int dst, const float scale, const int src_size,
+                           int* src0, int* src1, float* weight) {
+  float f = (dst + 0.5f) * scale - 0.5f;
+  int s = static_cast<int>(std::floor(f));
+  f -= s;
+  if (s < 0) {
+    s = 0;
+    f = 0;
+  }
+  if (s >= src_size - 1) {
+    s = src_size - 1;
+    f = 0;
+  }
+  *src0 = s;
+  *src1 = std::min(s + 1, src_size - 1);
+  *weight = f;
+}
+
+// resizes, crops, mirrors, normalizes and converts the decoded image in one pass
+template<typename DType>
+template<int n_channels>
+void ImageRecordIOParser2<DType>::FusedProcessImage(const FusedDecodePlan& plan, int tid,
+  mshadow::Tensor<cpu, 3, DType>* data_ptr, const bool is_mirrored, const float contrast_scaled,
+  const float illumination_scaled) {
+  float RGBA_MULT[4] = { 0 };
+  float RGBA_BIAS[4] = { 0 };
+  float RGBA_MEAN[4] = { 0 };
+  int16_t RGBA_MEAN_INT[4] = {0};
+  NormalizeFactors(contrast_scaled, illumination_scaled,
+                   RGBA_MULT, RGBA_BIAS, RGBA_MEAN, RGBA_MEAN_INT);
+  mshadow::Tensor<cpu, 3, DType>& data = (*data_ptr);
+  const int out_h = param_.data_shape[1], out_w = param_.data_shape[2];
+  const int src_w = plan.scaled_width, src_h = plan.scaled_height;
+  const float scale_x = static_cast<float>(src_w) / plan.resized_width;
+  const float scale_y = static_cast<float>(src_h) / plan.resized_height;
+  // column offsets and weights are shared by all rows
+  std::vector<int> x0(out_w), x1(out_w);
+  std::vector<float> wx(out_w);
+  for (int j = 0; j < out_w; ++j) {
+    BilinearSource(plan.crop_x + j, scale_x, src_w, &x0[j], &x1[j], &wx[j]);
+    x0[j] *= n_channels;
+    x1[j] *= n_channels;
+  }
+  const uint8_t* img = decoded_[tid].data();
+  for (int i = 0; i < out_h; ++i) {
+    int y0, y1;
+    float wy;
+    BilinearSource(plan.crop_y + i, scale_y, src_h, &y0, &y1, &wy);
+    const uint8_t* row0 = img + static_cast<size_t>(y0) * src_w * n_channels;
+    const uint8_t* row1 = img + static_cast<size_t>(y1) * src_w * n_channels;
+    for (int k = 0; k < n_channels; ++k) {
+      DType* out = data[k][i].dptr_;
+      for (int j = 0; j < out_w; ++j) {
+        const float top = row0[x0[j] + k] + (row0[x1[j] + k] - row0[x0[j] + k]) * wx[j];
+        const float bottom = row1[x0[j] + k] + (row1[x1[j] + k] - row1[x0[j] + k]) * wx[j];
+        // round like the 8 bit image of the regular path
+        const float pixel = std::floor(top + (bottom - top) * wy + 0.5f);
+        const int col = is_mirrored ? out_w - j - 1 : j;
+        if (std::is_same<DType, int8_t>::value) {
+          const int16_t mean = meanfile_ready_ ?
+              static_cast<int16_t>(std::round(meanimg_[k][i][j])) : RGBA_MEAN_INT[k];
+          out[col] = cv::saturate_cast<int8_t>(static_cast<int16_t>(pixel) - mean);
+        } else if (std::is_same<DType, uint8_t>::value) {
+          out[col] = static_cast<DType>(pixel);
+        } else {
+          const float mean = meanfile_ready_ ? meanimg_[k][i][j] : RGBA_MEAN[k];
+          out[col] = (pixel - mean) * RGBA_MULT[k] + RGBA_BIAS[k];
+        }
+      }
+    }
+  }
+}
 #endif
 #endif
 
@@ -555,32 +792,40 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
         prnds_[tid]->seed(idx + param_.seed_aug.value() + kRandMagic);
       }
 
-      switch (param_.data_shape[0]) {
-       case 1:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 0);
+      FusedDecodePlan plan;
+      const bool fused = fused_decode_ && FusedDecode(buf, tid, &plan);
 #else
-        res = cv::imdecode(buf, 0);
+      const bool fused = false;
 #endif
-        break;
-       case 3:
+      if (!fused) {
+        switch (param_.data_shape[0]) {
+         case 1:
 #if MXNET_USE_LIBJPEG_TURBO
-        res = TJimdecode(buf, 1);
+          res = TJimdecode(buf, 0);
 #else
-        res = cv::imdecode(buf, 1);
+          res = cv::imdecode(buf, 0);
 #endif
-        break;
-       case 4:
-        // -1 to keep the number of channel of the encoded image, and not force gray or color.
-        res = cv::imdecode(buf, -1);
-        CHECK_EQ(res.channels(), 4)
-          << "Invalid image with index " << rec.image_index()
-          << ". Expected 4 channels, got " << res.channels();
-        break;
-       default:
-        LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+          break;
+         case 3:
+#if MXNET_USE_LIBJPEG_TURBO
+          res = TJimdecode(buf, 1);
+#else
+          res = cv::imdecode(buf, 1);
+#endif
+          break;
+         case 4:
+          // -1 to keep the number of channel of the encoded image, and not force gray or color.
+          res = cv::imdecode(buf, -1);
+          CHECK_EQ(res.channels(), 4)
+            << "Invalid image with index " << rec.image_index()
+            << ". Expected 4 channels, got " << res.channels();
+          break;
+         default:
+          LOG(FATAL) << "Invalid output shape " << param_.data_shape;
+        }
       }
-      const int n_channels = res.channels();
+      const int n_channels = fused ? param_.data_shape[0] : res.channels();
       // load label before augmentations
       std::vector<float> label_buf;
       if (label_map_ != nullptr) {
@@ -596,16 +841,27 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
              "or the rec file is packed with multi dimensional label";
         label_buf.assign(&rec.header.label, &rec.header.label + 1);
       }
-      for (auto& aug : augmenters_[tid]) {
-        res = aug->Process(res, &label_buf, prnds_[tid].get());
+      int rows, cols;
+      if (fused) {
+#if MXNET_USE_LIBJPEG_TURBO
+        FusedCrop(&plan, prnds_[tid].get());
+#endif
+        rows = param_.data_shape[1];
+        cols = param_.data_shape[2];
+      } else {
+        for (auto& aug : augmenters_[tid]) {
+          res = aug->Process(res, &label_buf, prnds_[tid].get());
+        }
+        rows = res.rows;
+        cols = res.cols;
       }
       mshadow::Tensor<cpu, 3, DType> data;
       if (idx < batch_param_.batch_size) {
         data = mshadow::Tensor<cpu, 3, DType>(data_dptr + idx*unit_size_[0],
-          mshadow::Shape3(n_channels, res.rows, res.cols));
+          mshadow::Shape3(n_channels, rows, cols));
       } else {
         out_tmp.Push(static_cast<size_t>(rec.image_index()),
-                 mshadow::Shape3(n_channels, res.rows, res.cols),
+                 mshadow::Shape3(n_channels, rows, cols),
                  mshadow::Shape1(param_.label_width));
         data = out_tmp.data().Back();
       }
@@ -625,8 +881,19 @@ inline size_t ImageRecordIOParser2<DType>::ParseChunk(DType* data_dptr, real_t*
           - normalize_param_.max_random_illumination) * normalize_param_.scale;
       }
       // For RGB or RGBA data, swap the B and R channel:
-      // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA)
-      if (n_channels == 1) {
+      // OpenCV store as BGR (or BGRA) and we want RGB (or RGBA).
+      // The fused path decodes to RGB already.
+      if (fused) {
+#if MXNET_USE_LIBJPEG_TURBO
+        if (n_channels == 1) {
+          FusedProcessImage<1>(plan, tid, &data, is_mirrored, contrast_scaled,
+                               illumination_scaled);
+        } else {
+          FusedProcessImage<3>(plan, tid, &data, is_mirrored, contrast_scaled,
+                               illumination_scaled);
+        }
+#endif
+      } else if (n_channels == 1) {
         ProcessImage<1>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
       } else if (n_channels == 3) {
         ProcessImage<3>(res, &data, is_mirrored, contrast_scaled, illumination_scaled);
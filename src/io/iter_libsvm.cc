@@ -25,9 +25,13 @@
 #include <dmlc/base.h>
 #include <dmlc/logging.h>
 #include <dmlc/parameter.h>
-#include <dmlc/data.h>
+#include <algorithm>
+#include <cstring>
+#include <sstream>
+#include <string>
+#include <vector>
 #include "./iter_sparse_prefetcher.h"
-#include "./iter_sparse_batchloader.h"
+#include "./iter_text_parser.h"
 
 namespace mxnet {
 namespace io {
@@ -64,7 +68,70 @@ struct LibSVMIterParam : public dmlc::Parameter<LibSVMIterParam> {
   }
 };
 
-class LibSVMIter: public SparseIIterator<DataInst> {
+/*! \brief a batch of CSR rows */
+struct LibSVMCSRBuffer {
+  std::vector<real_t> values;
+  std::vector<int64_t> indices;
+  std::vector<int64_t> indptr;
+};
+
+/*!
+ * \brief parses a LibSVM row ``label[:weight] [qid:n] index[:value] ...``.
+ *  With values == nullptr only the number of features is counted.
+ * \return error message, empty on success
+ */
+inline std::string ParseLibSVMRow(const char* begin, const char* end, const int64_t num_col,
+                                  real_t* label, real_t* values, int64_t* indices,
+                                  int64_t* nnz) {
+  const char* p = SkipBlank(begin, end);
+  const char* q = ParseNumber(p, end, label);
+  if (q == p) return "Invalid label in LibSVM row: " + std::string(begin, end);
+  p = q;
+  if (p != end && *p == ':') {
+    // skip the instance weight
+    real_t weight;
+    p = ParseNumber(p + 1, end, &weight);
+  }
+  int64_t count = 0;
+  while (true) {
+    p = SkipBlank(p, end);
+    if (p == end || *p == '#') break;
+    if (end - p > 4 && std::strncmp(p, "qid:", 4) == 0) {
+      while (p != end && *p != ' ' && *p != '\t') ++p;
+      continue;
+    }
+    int64_t index = 0;
+    q = ParseNumber(p, end, &index);
+    if (q == p) return "Invalid feature in LibSVM row: " + std::string(begin, end);
+    if (index < 0 || index >= num_col) {
+      std::ostringstream os;
+      os << "Feature index " << index << " is out of range [0, " << num_col
+         << ") in LibSVM row: " << std::string(begin, end);
+      return os.str();
+    }
+    real_t value = 1.0f;
+    if (q != end && *q == ':') {
+      p = q + 1;
+      q = ParseNumber(p, end, &value);
+      if (q == p) return "Invalid feature in LibSVM row: " + std::string(begin, end);
+    }
+    if (values != nullptr) {
+      values[count] = value;
+      indices[count] = index;
+    }
+    ++count;
+    p = q;
+  }
+  *nnz = count;
+  return std::string();
+}
+
+/*!
+ * \brief reads batches of LibSVM rows into CSR buffers. The rows of a batch are
+ *  parsed in parallel in two passes: the first counts the features of every row
+ *  to build indptr, the second writes values and indices in place.
+ */
+class LibSVMIter: public SparseIIterator<TBlobBatch> {
  public:
   LibSVMIter() {}
   virtual ~LibSVMIter() {}
@@ -72,79 +139,66 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   // intialize iterator loads data in
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
     param_.InitAllowUnknown(kwargs);
+    batch_param_.InitAllowUnknown(kwargs);
+    parser_param_.InitAllowUnknown(kwargs);
     CHECK_EQ(param_.data_shape.ndim(), 1) << "dimension of data_shape is expected to be 1";
     CHECK_GT(param_.num_parts, 0) << "number of parts should be positive";
     CHECK_GE(param_.part_index, 0) << "part index should be non-negative";
-    data_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.data_libsvm.c_str(),
-                                                      param_.part_index,
-                                                      param_.num_parts, "libsvm"));
+    if (batch_param_.round_batch == 0) {
+      LOG(FATAL) << "LibSVMIter doesn't support round_batch == false yet";
+    }
+    data_reader_.reset(new TextLineReader(param_.data_libsvm, param_.part_index,
+                                          param_.num_parts));
     if (param_.label_libsvm != "NULL") {
-      label_parser_.reset(dmlc::Parser<uint64_t>::Create(param_.label_libsvm.c_str(),
-                                                         param_.part_index,
-                                                         param_.num_parts, "libsvm"));
+      label_reader_.reset(new TextLineReader(param_.label_libsvm, param_.part_index,
+                                             param_.num_parts));
       CHECK_GT(param_.label_shape.Size(), 1)
         << "label_shape is not expected to be (1,) when param_.label_libsvm is set.";
     } else {
       CHECK_EQ(param_.label_shape.Size(), 1)
         << "label_shape is expected to be (1,) when param_.label_libsvm is NULL";
     }
-    // both data and label are of CSRStorage in libsvm format
-    if (param_.label_shape.Size() > 1) {
-      out_.data.resize(6);
-    } else {
-      // only data is of CSRStorage in libsvm format.
-      out_.data.resize(4);
-    }
+    const size_t batch_size = batch_param_.batch_size;
+    out_.inst_index = new unsigned[batch_size];
+    out_.batch_size = batch_size;
+    label_.resize(batch_size);
+    row_nnz_.resize(batch_size);
+    row_labels_.resize(batch_size);
   }
 
   virtual void BeforeFirst() {
-    data_parser_->BeforeFirst();
-    if (label_parser_.get() != nullptr) {
-      label_parser_->BeforeFirst();
+    if (num_overflow_ == 0) {
+      Rewind();
+    } else {
+      // the last batch already restarted from the beginning of the data
+      num_overflow_ = 0;
     }
-    data_ptr_ = label_ptr_ = 0;
-    data_size_ = label_size_ = 0;
-    inst_counter_ = 0;
-    end_ = false;
   }
 
   virtual bool Next() {
-    if (end_) return false;
-    while (data_ptr_ >= data_size_) {
-      if (!data_parser_->Next()) {
-        end_ = true; return false;
-      }
-      data_ptr_ = 0;
-      data_size_ = data_parser_->Value().size;
-    }
-    out_.index = inst_counter_++;
-    CHECK_LT(data_ptr_, data_size_);
-    const auto data_row = data_parser_->Value()[data_ptr_++];
-    // data, indices and indptr
-    out_.data[0] = AsDataBlob(data_row);
-    out_.data[1] = AsIdxBlob(data_row);
-    out_.data[2] = AsIndPtrPlaceholder(data_row);
-
-    if (label_parser_.get() != nullptr) {
-      while (label_ptr_ >= label_size_) {
-        CHECK(label_parser_->Next())
-            << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
-        label_ptr_ = 0;
-        label_size_ = label_parser_->Value().size;
+    out_.num_batch_padd = 0;
+    out_.batch_size = batch_param_.batch_size;
+    // after an overflow, wait till before first is called
+    if (num_overflow_ != 0) return false;
+    const size_t batch_size = batch_param_.batch_size;
+    ResetCSR(&data_);
+    if (label_reader_) ResetCSR(&label_csr_);
+    size_t top = ReadRows(0, batch_size);
+    if (top < batch_size) {
+      if (parser_param_.verbose) {
+        throughput_.Report("LibSVMIter", data_reader_->bytes_read());
       }
-      CHECK_LT(label_ptr_, label_size_);
-      const auto label_row = label_parser_->Value()[label_ptr_++];
-      // data, indices and indptr
-      out_.data[3] = AsDataBlob(label_row);
-      out_.data[4] = AsIdxBlob(label_row);
-      out_.data[5] = AsIndPtrPlaceholder(label_row);
-    } else {
-      out_.data[3] = AsScalarLabelBlob(data_row);
+      if (top == 0) return false;
+      Rewind();
+      num_overflow_ = ReadRows(top, batch_size - top);
+      CHECK_EQ(num_overflow_, batch_size - top) << "number of input must be bigger than batch size";
+      out_.num_batch_padd = num_overflow_;
     }
+    SetOutput();
     return true;
   }
 
-  virtual const DataInst &Value(void) const {
+  virtual const TBlobBatch &Value(void) const {
     return out_;
   }
 
@@ -154,44 +208,125 @@ class LibSVMIter: public SparseIIterator<DataInst> {
   }
 
   virtual const mxnet::TShape GetShape(bool is_data) const {
-    if (is_data) return param_.data_shape;
-    return param_.label_shape;
+    const mxnet::TShape& inst_shape = is_data ? param_.data_shape : param_.label_shape;
+    std::vector<index_t> shape_vec;
+    shape_vec.push_back(batch_param_.batch_size);
+    for (index_t dim = 0; dim < inst_shape.ndim(); ++dim) {
+      shape_vec.push_back(inst_shape[dim]);
+    }
+    return mxnet::TShape(shape_vec.begin(), shape_vec.end());
   }
 
  private:
-  inline TBlob AsDataBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.value;
-    mxnet::TShape shape(mshadow::Shape1(row.length));
-    return TBlob((real_t*) ptr, shape, cpu::kDevMask);  // NOLINT(*)
+  void Rewind() {
+    data_reader_->BeforeFirst();
+    if (label_reader_) label_reader_->BeforeFirst();
+    inst_counter_ = 0;
   }
 
-  inline TBlob AsIdxBlob(const dmlc::Row<uint64_t>& row) {
-    const uint64_t* ptr = row.index;
-    mxnet::TShape shape(mshadow::Shape1(row.length));
-    return TBlob((int64_t*) ptr, shape, cpu::kDevMask, mshadow::kInt64);  // NOLINT(*)
+  static void ResetCSR(LibSVMCSRBuffer* csr) {
+    csr->values.clear();
+    csr->indices.clear();
+    csr->indptr.assign(1, 0);
   }
 
-  inline TBlob AsIndPtrPlaceholder(const dmlc::Row<uint64_t>& row) {
-    return TBlob(nullptr, mshadow::Shape1(0), cpu::kDevMask, mshadow::kInt64);
+  // parses n lines of reader into csr, from row top on
+  void ParseCSR(const TextLineReader& reader, const index_t n, const size_t top,
+                const int64_t num_col, real_t* labels, LibSVMCSRBuffer* csr) {
+    const int nthread = parser_param_.preprocess_threads;
+    std::string error;
+    // first pass counts the features of every row
+    #pragma omp parallel for num_threads(nthread) schedule(static)
+    for (index_t i = 0; i < n; ++i) {
+      std::string err = ParseLibSVMRow(reader.line_begin(i), reader.line_end(i), num_col,
+                                       &row_labels_[i], nullptr, nullptr, &row_nnz_[i]);
+      if (!err.empty()) {
+        #pragma omp critical
+        {
+          if (error.empty()) error = err;
+        }
+      }
+    }
+    if (!error.empty()) LOG(FATAL) << error;
+    csr->indptr.resize(top + n + 1);
+    for (index_t i = 0; i < n; ++i) {
+      csr->indptr[top + i + 1] = csr->indptr[top + i] + row_nnz_[i];
+    }
+    csr->values.resize(csr->indptr[top + n]);
+    csr->indices.resize(csr->indptr[top + n]);
+    // second pass writes the features in place
+    #pragma omp parallel for num_threads(nthread) schedule(static)
+    for (index_t i = 0; i < n; ++i) {
+      const int64_t offset = csr->indptr[top + i];
+      int64_t nnz = 0;
+      ParseLibSVMRow(reader.line_begin(i), reader.line_end(i), num_col, &row_labels_[i],
+                     csr->values.data() + offset, csr->indices.data() + offset, &nnz);
+    }
+    if (labels != nullptr) {
+      std::copy(row_labels_.begin(), row_labels_.begin() + n, labels + top);
+    }
   }
 
-  inline TBlob AsScalarLabelBlob(const dmlc::Row<uint64_t>& row) {
-    const real_t* ptr = row.label;
-    return TBlob((real_t*) ptr, mshadow::Shape1(1), cpu::kDevMask);  // NOLINT(*)
+  // parses up to n rows into the batch from row top on, returns the number of rows read
+  size_t ReadRows(const size_t top, const size_t n) {
+    throughput_.Start();
+    const index_t rows = std::min(n, data_reader_->Fill(n));
+    ParseCSR(*data_reader_, rows, top, param_.data_shape[0],
+             label_reader_ ? nullptr : label_.data(), &data_);
+    data_reader_->Consume(rows);
+    if (label_reader_) {
+      CHECK_GE(label_reader_->Fill(rows), static_cast<size_t>(rows))
+          << "Data LibSVM's row is smaller than the number of rows in label_libsvm";
+      ParseCSR(*label_reader_, rows, top, param_.label_shape[0], nullptr, &label_csr_);
+      label_reader_->Consume(rows);
+    }
+    for (index_t i = 0; i < rows; ++i) {
+      out_.inst_index[top + i] = inst_counter_++;
+    }
+    throughput_.Stop(rows);
+    return rows;
+  }
+
+  static void AppendCSR(LibSVMCSRBuffer* csr, std::vector<TBlob>* out) {
+    out->emplace_back(csr->values.data(), mshadow::Shape1(csr->values.size()),
+                      cpu::kDevMask, 0);
+    out->emplace_back(csr->indices.data(), mshadow::Shape1(csr->indices.size()),
+                      cpu::kDevMask, 0);
+    out->emplace_back(csr->indptr.data(), mshadow::Shape1(csr->indptr.size()),
+                      cpu::kDevMask, 0);
+  }
+
+  // points the output blobs at the batch buffers
+  void SetOutput() {
+    out_.data.clear();
+    // data, indices and indptr
+    AppendCSR(&data_, &out_.data);
+    if (label_reader_) {
+      AppendCSR(&label_csr_, &out_.data);
+    } else {
+      out_.data.emplace_back(label_.data(), mshadow::Shape1(label_.size()), cpu::kDevMask, 0);
+    }
   }
 
   LibSVMIterParam param_;
-  // output instance
-  DataInst out_;
+  BatchParam batch_param_;
+  TextParserParam parser_param_;
+  // output batch
+  TBlobBatch out_;
   // internal instance counter
   unsigned inst_counter_{0};
-  // at end
-  bool end_{false};
-  // label parser
-  size_t label_ptr_{0}, label_size_{0};
-  size_t data_ptr_{0}, data_size_{0};
-  std::unique_ptr<dmlc::Parser<uint64_t> > label_parser_;
-  std::unique_ptr<dmlc::Parser<uint64_t> > data_parser_;
+  // number of instances read from the start of data to fill the last batch
+  size_t num_overflow_{0};
+  std::unique_ptr<TextLineReader> label_reader_;
+  std::unique_ptr<TextLineReader> data_reader_;
+  // batch buffers
+  LibSVMCSRBuffer data_;
+  LibSVMCSRBuffer label_csr_;
+  std::vector<real_t> label_;
+  // per row scratch of the two parsing passes
+  std::vector<int64_t> row_nnz_;
+  std::vector<real_t> row_labels_;
+  ParseThroughput throughput_;
 };
 
 
@@ -299,10 +434,10 @@ Example::
 .add_arguments(LibSVMIterParam::__FIELDS__())
 .add_arguments(BatchParam::__FIELDS__())
 .add_arguments(PrefetcherParam::__FIELDS__())
+.add_arguments(TextParserParam::__FIELDS__())
 .set_body([]() {
     return new SparsePrefetcherIter(
-        new SparseBatchLoader(
-            new LibSVMIter()));
+        new LibSVMIter());
   });
 
 }  // namespace io
@@ -33,6 +33,7 @@
 #include <dmlc/optional.h>
 #include <mshadow/tensor.h>
 #include <climits>
+#include <memory>
 #include <utility>
 #include <string>
 #include <vector>
@@ -40,6 +41,7 @@
 #include <algorithm>
 #include "./inst_vector.h"
 #include "./image_iter_common.h"
+#include "../profiler/profiler.h"
 
 namespace mxnet {
 namespace io {
@@ -50,12 +52,27 @@ class PrefetcherIter : public IIterator<DataBatch> {
       : loader_(base), out_(nullptr) {}
 
   ~PrefetcherIter() {
+    while (staged_queue_.size() != 0) {
+      recycle_queue_.push(staged_queue_.front().first);
+      staged_queue_.pop();
+    }
     while (recycle_queue_.size() != 0) {
       DataBatch *batch = recycle_queue_.front();
       recycle_queue_.pop();
       delete batch;
     }
-    delete out_;
+    if (!stage_ring_.empty()) {
+      // out_ points into the staging ring
+      for (DataBatch *batch : stage_ring_) {
+        if (batch == nullptr) continue;
+        for (NDArray& arr : batch->data) {
+          arr.WaitToWrite();
+        }
+        delete batch;
+      }
+    } else {
+      delete out_;
+    }
     iter.Destroy();
   }
 
@@ -67,6 +84,16 @@ class PrefetcherIter : public IIterator<DataBatch> {
     const int kMaxPrefetchBuffer = 16;
     // init thread iter
     iter.set_max_capacity(kMaxPrefetchBuffer);
+    if (param_.stage_dev_type) {
+      // staged batches hold on to their source batch until the copy is issued
+      CHECK_LE(param_.prefetch_buffer + param_.stage_depth, kMaxPrefetchBuffer)
+        << "prefetch_buffer + stage_depth must not exceed " << kMaxPrefetchBuffer;
+      stage_ctx_ = Context::Create(static_cast<Context::DeviceType>(param_.stage_dev_type.value()),
+                                   param_.stage_dev_id);
+      // returned batches stay valid for prefetch_buffer calls, as without staging,
+      // while stage_depth further slots are being filled
+      stage_ring_.resize(param_.stage_depth + param_.prefetch_buffer, nullptr);
+    }
   }
 
   virtual void Init(const std::vector<std::pair<std::string, std::string> >& kwargs) {
@@ -112,10 +139,16 @@ class PrefetcherIter : public IIterator<DataBatch> {
   }
 
   virtual void BeforeFirst(void) {
+    // batches staged from the previous epoch are dropped
+    while (staged_queue_.size() != 0) {
+      recycle_queue_.push(staged_queue_.front().first);
+      staged_queue_.pop();
+    }
     iter.BeforeFirst();
   }
 
   virtual bool Next(void) {
+    if (!stage_ring_.empty()) return NextStaged();
     if (out_ != nullptr) {
       recycle_queue_.push(out_); out_ = nullptr;
     }
@@ -129,7 +162,7 @@ class PrefetcherIter : public IIterator<DataBatch> {
       recycle_queue_.pop();
       iter.Recycle(&old_batch);
     }
-    return iter.Next(&out_);
+    return TimedNext(&out_);
   }
   virtual const DataBatch &Value(void) const {
     return *out_;
@@ -144,10 +177,105 @@ class PrefetcherIter : public IIterator<DataBatch> {
   std::unique_ptr<IIterator<TBlobBatch> > loader_;
 
  private:
+  /*!
+   * \brief Next() when a staging device is set. Keeps stage_depth batches in flight:
+   *  each CPU batch is copied into the next slot of the staging ring by engine
+   *  operators, so loading, the copy to the device and compute overlap. The ring has
+   *  prefetch_buffer more slots than stage_depth, so a returned slot is not refilled
+   *  before prefetch_buffer further calls; reusing it then is ordered after its
+   *  readers by the engine.
+   */
+  bool NextStaged() {
+    out_ = nullptr;
+    while (recycle_queue_.size() >= param_.prefetch_buffer) {
+      DataBatch *old_batch = recycle_queue_.front();
+      // wait for the staging copies reading from it
+      for (NDArray& arr : old_batch->data) {
+        arr.WaitToWrite();
+      }
+      recycle_queue_.pop();
+      iter.Recycle(&old_batch);
+    }
+    while (staged_queue_.size() < static_cast<size_t>(param_.stage_depth)) {
+      DataBatch *src = nullptr;
+      if (!TimedNext(&src)) break;
+      DataBatch *&dst = stage_ring_[stage_pos_];
+      stage_pos_ = (stage_pos_ + 1) % stage_ring_.size();
+      if (dst == nullptr) {
+        dst = new DataBatch();
+        dst->data.resize(src->data.size());
+        for (size_t i = 0; i < src->data.size(); ++i) {
+          const NDArray& arr = src->data[i];
+          if (arr.storage_type() == kDefaultStorage) {
+            dst->data[i] = NDArray(arr.shape(), stage_ctx_, false, arr.dtype());
+          } else {
+            dst->data[i] = NDArray(arr.storage_type(), arr.shape(), stage_ctx_, true,
+                                   arr.dtype());
+          }
+        }
+      }
+      CHECK_EQ(dst->data.size(), src->data.size());
+      for (size_t i = 0; i < src->data.size(); ++i) {
+        CopyFromTo(src->data[i], &dst->data[i]);
+      }
+      dst->index = src->index;
+      dst->num_batch_padd = src->num_batch_padd;
+      staged_queue_.push(std::make_pair(src, dst));
+    }
+    if (Profiling()) {
+      *prof_queue_depth_ = staged_queue_.size();
+    }
+    if (staged_queue_.empty()) return false;
+    recycle_queue_.push(staged_queue_.front().first);
+    out_ = staged_queue_.front().second;
+    staged_queue_.pop();
+    return true;
+  }
+
+  /*! \brief iter.Next() which records the time spent waiting on the loader */
+  bool TimedNext(DataBatch **dptr) {
+    if (!Profiling()) return iter.Next(dptr);
+    const uint64_t start = profiler::ProfileStat::NowInMicrosec();
+    const bool ret = iter.Next(dptr);
+    *prof_stall_us_ += static_cast<int64_t>(profiler::ProfileStat::NowInMicrosec() - start);
+    return ret;
+  }
+
+  /*! \brief whether prefetch counters should be recorded, creates them on first use */
+  bool Profiling() {
+    profiler::Profiler *prof = profiler::Profiler::Get();
+    if (!prof->IsProfiling(profiler::Profiler::kSymbolic) &&
+        !prof->IsProfiling(profiler::Profiler::kImperative)) {
+      return false;
+    }
+    if (prof_domain_ == nullptr) {
+      prof_domain_.reset(new profiler::ProfileDomain("Data Prefetch"));
+      prof_queue_depth_.reset(new profiler::ProfileCounter("Prefetch Queue Depth",
+                                                           prof_domain_.get()));
+      prof_stall_us_.reset(new profiler::ProfileCounter("Prefetch Stall Time (us)",
+                                                        prof_domain_.get()));
+    }
+    return true;
+  }
+
   /*! \brief output data */
   DataBatch *out_;
   /*! \brief queue to be recycled */
   std::queue<DataBatch*> recycle_queue_;
+  /*! \brief context of the staging ring */
+  Context stage_ctx_;
+  /*! \brief staging ring, empty when staging is disabled */
+  std::vector<DataBatch*> stage_ring_;
+  /*! \brief next slot of the staging ring to fill */
+  size_t stage_pos_ = 0;
+  /*! \brief staged batches not yet returned, paired with their source batch */
+  std::queue<std::pair<DataBatch*, DataBatch*> > staged_queue_;
+  /*! \brief profiler domain of the prefetch counters */
+  std::unique_ptr<profiler::ProfileDomain> prof_domain_;
+  /*! \brief number of staged batches after each Next() */
+  std::unique_ptr<profiler::ProfileCounter> prof_queue_depth_;
+  /*! \brief accumulated time the consumer waited on the loader */
+  std::unique_ptr<profiler::ProfileCounter> prof_stall_us_;
 };
 }  // namespace io
 }  // namespace mxnet
@@ -0,0 +1,310 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file iter_text_parser.h
+ * \brief line reader and number parsers shared by the CSV and LibSVM iterators
+ */
+#ifndef MXNET_IO_ITER_TEXT_PARSER_H_
+#define MXNET_IO_ITER_TEXT_PARSER_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+// parameters of the parallel text parsers
+struct TextParserParam : public dmlc::Parameter<TextParserParam> {
+  /*! \brief number of threads parsing the rows of a batch */
+  int preprocess_threads;
+  /*! \brief whether to log parsing throughput at the end of every epoch */
+  bool verbose;
+  // declare parameters
+  DMLC_DECLARE_PARAMETER(TextParserParam) {
+    DMLC_DECLARE_FIELD(preprocess_threads).set_lower_bound(1).set_default(4)
+        .describe("The number of threads to parse the rows of a batch.");
+    DMLC_DECLARE_FIELD(verbose).set_default(false)
+        .describe("Whether to log the parsing throughput at the end of every epoch.");
+  }
+};
+
+/*!
+ * \brief reads whole lines of text from a file or a directory in large chunks.
+ * Lines are kept in one owned buffer and terminated by '\0', so that a batch of
+ * lines can be parsed in parallel. Blank lines are skipped.
+ */
+class TextLineReader {
+ public:
+  TextLineReader(const std::string& uri, unsigned part_index, unsigned num_parts) {
+    split_.reset(dmlc::InputSplit::Create(uri.c_str(), part_index, num_parts, "text"));
+    split_->HintChunkSize(kChunkSize);
+  }
+
+  void BeforeFirst() {
+    split_->BeforeFirst();
+    buf_.clear();
+    starts_.clear();
+    ends_.clear();
+    pos_ = 0;
+    eof_ = false;
+  }
+
+  /*!
+   * \brief reads until at least n unconsumed lines are buffered or the input ends
+   * \return number of unconsumed lines, which is less than n only at the end of input
+   */
+  size_t Fill(const size_t n) {
+    while (ends_.size() - pos_ < n && !eof_) {
+      Compact();
+      dmlc::InputSplit::Blob chunk;
+      if (!split_->NextChunk(&chunk)) {
+        eof_ = true;
+        break;
+      }
+      const size_t begin = buf_.size();
+      const char* data = static_cast<const char*>(chunk.dptr);
+      buf_.insert(buf_.end(), data, data + chunk.size);
+      if (buf_.empty() || buf_.back() != '\n') buf_.push_back('\n');
+      bytes_read_ += chunk.size;
+      IndexLines(begin);
+    }
+    return ends_.size() - pos_;
+  }
+
+  /*! \brief start of the i-th unconsumed line */
+  const char* line_begin(const size_t i) const { return buf_.data() + starts_[pos_ + i]; }
+
+  /*! \brief end of the i-th unconsumed line, which points to a '\0' */
+  const char* line_end(const size_t i) const { return buf_.data() + ends_[pos_ + i]; }
+
+  /*! \brief marks the first n unconsumed lines as consumed */
+  void Consume(const size_t n) {
+    CHECK_LE(pos_ + n, ends_.size());
+    pos_ += n;
+  }
+
+  /*! \brief total number of bytes read so far */
+  size_t bytes_read() const { return bytes_read_; }
+
+ private:
+  static const size_t kChunkSize = 8 << 20;
+
+  // drops the consumed lines from the front of the buffer
+  void Compact() {
+    if (pos_ == 0) return;
+    const size_t offset = pos_ < starts_.size() ? starts_[pos_] : buf_.size();
+    buf_.erase(buf_.begin(), buf_.begin() + offset);
+    starts_.erase(starts_.begin(), starts_.begin() + pos_);
+    ends_.erase(ends_.begin(), ends_.begin() + pos_);
+    for (size_t i = 0; i < starts_.size(); ++i) {
+      starts_[i] -= offset;
+      ends_[i] -= offset;
+    }
+    pos_ = 0;
+  }
+
+  // finds the lines in buf_ from begin on, which ends with a newline
+  void IndexLines(size_t begin) {
+    char* data = buf_.data();
+    const size_t size = buf_.size();
+    while (begin < size) {
+      const char* nl = static_cast<const char*>(std::memchr(data + begin, '\n', size - begin));
+      size_t end = nl - data;
+      const size_t next = end + 1;
+      data[end] = '\0';
+      if (end > begin && data[end - 1] == '\r') data[--end] = '\0';
+      size_t first = begin;
+      while (first < end && (data[first] == ' ' || data[first] == '\t')) ++first;
+      if (first < end) {
+        starts_.push_back(begin);
+        ends_.push_back(end);
+      }
+      begin = next;
+    }
+  }
+
+  std::unique_ptr<dmlc::InputSplit> split_;
+  std::vector<char> buf_;
+  std::vector<size_t> starts_;
+  std::vector<size_t> ends_;
+  size_t pos_{0};
+  bool eof_{false};
+  size_t bytes_read_{0};
+};
+
+/*! \brief skips spaces and tabs */
+inline const char* SkipBlank(const char* p, const char* end) {
+  while (p != end && (*p == ' ' || *p == '\t')) ++p;
+  return p;
+}
+
+/*! \brief strtod for the inputs ParseDouble does not handle exactly */
+inline const char* ParseDoubleFallback(const char* p, const char* end, double* out) {
+  char* strtod_end = nullptr;
+  const double val = std::strtod(p, &strtod_end);
+  if (strtod_end == p || strtod_end > end) return p;
+  *out = val;
+  return strtod_end;
+}
+
+/*!
+ * \brief parses a decimal number like strtod, without its locale handling.
+ * Up to 19 significant digits with exponents within the exactly representable
+ * powers of ten are handled directly, other inputs fall back to strtod.
+ * \return the end of the number, or p if there is no number at p
+ */
+inline const char* ParseDouble(const char* p, const char* end, double* out) {
+  static const double kPow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+  };
+  const char* start = p;
+  bool negative = false;
+  if (p != end && (*p == '-' || *p == '+')) {
+    negative = *p == '-';
+    ++p;
+  }
+  uint64_t mantissa = 0;
+  int num_digits = 0;
+  int exponent = 0;
+  bool has_digits = false;
+  for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+    has_digits = true;
+    if (num_digits < 19) {
+      mantissa = mantissa * 10 + (*p - '0');
+      if (mantissa != 0) ++num_digits;
+    } else {
+      ++exponent;
+    }
+  }
+  if (p != end && *p == '.') {
+    ++p;
+    for (; p != end && *p >= '0' && *p <= '9'; ++p) {
+      has_digits = true;
+      if (num_digits < 19) {
+        mantissa = mantissa * 10 + (*p - '0');
+        if (mantissa != 0) ++num_digits;
+        --exponent;
+      }
+    }
+  }
+  if (!has_digits) {
+    // nan, inf and the like
+    return ParseDoubleFallback(start, end, out);
+  }
+  if (p != end && (*p == 'e' || *p == 'E')) {
+    const char* q = p + 1;
+    bool negative_exp = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative_exp = *q == '-';
+      ++q;
+    }
+    if (q != end && *q >= '0' && *q <= '9') {
+      int exp_val = 0;
+      for (; q != end && *q >= '0' && *q <= '9'; ++q) {
+        if (exp_val < 100000) exp_val = exp_val * 10 + (*q - '0');
+      }
+      exponent += negative_exp ? -exp_val : exp_val;
+      p = q;
+    }
+  }
+  double val;
+  if (mantissa == 0) {
+    val = 0;
+  } else if (mantissa < (1ULL << 53) && exponent >= -22 && exponent <= 22) {
+    // both operands are exact, so the result is correctly rounded
+    val = exponent < 0 ? mantissa / kPow10[-exponent] : mantissa * kPow10[exponent];
+  } else {
+    return ParseDoubleFallback(start, end, out);
+  }
+  *out = negative ? -val : val;
+  return p;
+}
+
+/*!
+ * \brief parses a number into DType. Integers are parsed directly, other
+ * forms of numbers are parsed as double and cast
+ * \return the end of the number, or p if there is no number at p
+ */
+template<typename DType>
+inline const char* ParseNumber(const char* p, const char* end, DType* out) {
+  if (std::is_integral<DType>::value) {
+    const char* q = p;
+    bool negative = false;
+    if (q != end && (*q == '-' || *q == '+')) {
+      negative = *q == '-';
+      ++q;
+    }
+    const char* digits = q;
+    int64_t val = 0;
+    for (; q != end && *q >= '0' && *q <= '9'; ++q) val = val * 10 + (*q - '0');
+    if (q != digits && (q == end || (*q != '.' && *q != 'e' && *q != 'E'))) {
+      *out = static_cast<DType>(negative ? -val : val);
+      return q;
+    }
+  }
+  double val = 0;
+  const char* q = ParseDouble(p, end, &val);
+  if (q != p) *out = static_cast<DType>(val);
+  return q;
+}
+
+/*!
+ * \brief measures the throughput of a parser, in parse time only
+ */
+class ParseThroughput {
+ public:
+  void Start() { start_ = std::chrono::steady_clock::now(); }
+  void Stop(size_t rows) {
+    seconds_ += std::chrono::duration<double>(std::chrono::steady_clock::now() - start_).count();
+    rows_ += rows;
+  }
+  /*! \brief logs throughput for the rows since the last call and resets */
+  void Report(const std::string& name, size_t bytes) {
+    if (rows_ == 0) return;
+    const double mb = (bytes - last_bytes_) / 1e6;
+    LOG(INFO) << name << ": parsed " << rows_ << " rows (" << mb << " MB) in "
+              << seconds_ << " sec, " << rows_ / seconds_ << " rows/sec, "
+              << mb / seconds_ << " MB/sec";
+    last_bytes_ = bytes;
+    rows_ = 0;
+    seconds_ = 0;
+  }
+
+ private:
+  std::chrono::steady_clock::time_point start_;
+  double seconds_{0};
+  size_t rows_{0};
+  size_t last_bytes_{0};
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_ITER_TEXT_PARSER_H_
@@ -0,0 +1,268 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file mmap_recordio_split.h
+ * \brief InputSplit over a memory mapped RecordIO file and its index,
+ *  shuffling all records globally every epoch
+ */
+#ifndef MXNET_IO_MMAP_RECORDIO_SPLIT_H_
+#define MXNET_IO_MMAP_RECORDIO_SPLIT_H_
+
+#include <dmlc/io.h>
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/recordio.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <numeric>
+#include <random>
+#include <string>
+#include <vector>
+
+namespace mxnet {
+namespace io {
+
+/*!
+ * \brief reads the records listed in a RecordIO index (.idx) from a memory mapped
+ *  RecordIO (.rec) file.
+ *
+ *  Every epoch all records are permuted with a generator seeded by seed and the
+ *  epoch number, so every part draws from the same permutation and the parts stay
+ *  disjoint. The part_index-th of num_parts contiguous slices of the permutation is
+ *  read. A batch is gathered with several threads, and the pages of the next batch
+ *  are hinted to the kernel with madvise while the current batch is decoded.
+ */
+class MMapRecordIOSplit : public dmlc::InputSplit {
+ public:
+  MMapRecordIOSplit(const std::string& rec_path, const std::string& idx_path,
+                    unsigned part_index, unsigned num_parts, bool shuffle, int seed,
+                    size_t batch_size, int num_threads)
+      : shuffle_(shuffle), seed_(seed), batch_size_(batch_size),
+        num_threads_(std::max(num_threads, 1)) {
+#ifdef _WIN32
+    LOG(FATAL) << "Memory mapped RecordIO is not supported on Windows";
+#else
+    const int fd = open(rec_path.c_str(), O_RDONLY);
+    CHECK_GE(fd, 0) << "Failed to open " << rec_path << ": " << strerror(errno)
+                    << ". Memory mapped RecordIO only supports local files";
+    struct stat st;
+    CHECK_EQ(fstat(fd, &st), 0) << "Failed to stat " << rec_path;
+    size_ = st.st_size;
+    if (size_ != 0) {
+      void* addr = mmap(nullptr, size_, PROT_READ, MAP_SHARED, fd, 0);
+      CHECK_NE(addr, MAP_FAILED) << "Failed to map " << rec_path << ": " << strerror(errno);
+      base_ = static_cast<const char*>(addr);
+      // a global shuffle reads pages in no particular order
+      madvise(addr, size_, shuffle_ ? MADV_RANDOM : MADV_SEQUENTIAL);
+    }
+    close(fd);
+#endif  // _WIN32
+    LoadIndex(idx_path);
+    ResetPartition(part_index, num_parts);
+  }
+
+  ~MMapRecordIOSplit() {
+#ifndef _WIN32
+    if (base_ != nullptr) munmap(const_cast<char*>(base_), size_);
+#endif  // _WIN32
+  }
+
+  void HintChunkSize(size_t chunk_size) override {}
+
+  size_t GetTotalSize(void) override {
+    return size_;
+  }
+
+  void BeforeFirst(void) override {
+    ++epoch_;
+    Permute();
+  }
+
+  void ResetPartition(unsigned part_index, unsigned num_parts) override {
+    CHECK_GT(num_parts, 0U) << "number of parts should be positive";
+    CHECK_LT(part_index, num_parts) << "part_index must be less than num_parts";
+    part_index_ = part_index;
+    num_parts_ = num_parts;
+    Permute();
+  }
+
+  bool NextRecord(Blob* out_rec) override {
+    while (!reader_ || !reader_->NextRecord(out_rec)) {
+      Blob chunk;
+      if (!NextBatch(&chunk, 1)) return false;
+      reader_.reset(new dmlc::RecordIOChunkReader(chunk, 0, 1));
+    }
+    return true;
+  }
+
+  bool NextChunk(Blob* out_chunk) override {
+    return NextBatch(out_chunk, batch_size_);
+  }
+
+  /*! \brief gathers the next n_records records into one RecordIO chunk */
+  bool NextBatch(Blob* out_chunk, size_t n_records) override {
+    if (pos_ >= order_.size()) return false;
+    const size_t n = std::min(n_records, order_.size() - pos_);
+    chunk_offsets_.resize(n + 1);
+    chunk_offsets_[0] = 0;
+    for (size_t i = 0; i < n; ++i) {
+      chunk_offsets_[i + 1] = chunk_offsets_[i] + RecordSize(order_[pos_ + i]);
+    }
+    // RecordIO records are padded to 4 bytes, the chunk is word aligned
+    chunk_.resize(chunk_offsets_[n] / sizeof(uint32_t));
+    char* dst = reinterpret_cast<char*>(chunk_.data());
+    #pragma omp parallel for num_threads(num_threads_) schedule(dynamic, 1)
+    for (int i = 0; i < static_cast<int>(n); ++i) {
+      const size_t rec = order_[pos_ + i];
+      std::memcpy(dst + chunk_offsets_[i], base_ + offsets_[rec], RecordSize(rec));
+    }
+    pos_ += n;
+    // hint the pages of the next batch while this one is decoded
+    Prefetch(pos_, n_records);
+    out_chunk->dptr = dst;
+    out_chunk->size = chunk_offsets_[n];
+    return true;
+  }
+
+ private:
+  // loads the record offsets from the text index of lines "<key>\t<offset>"
+  void LoadIndex(const std::string& idx_path) {
+    std::ifstream fin(idx_path);
+    CHECK(fin.good()) << "Failed to open " << idx_path;
+    size_t key, offset;
+    while (fin >> key >> offset) {
+      CHECK_LT(offset, size_) << "Record offset " << offset << " is out of the range of "
+                              << "the RecordIO file";
+      offsets_.push_back(offset);
+    }
+    CHECK(fin.eof()) << "Invalid RecordIO index file " << idx_path;
+    std::sort(offsets_.begin(), offsets_.end());
+    offsets_.erase(std::unique(offsets_.begin(), offsets_.end()), offsets_.end());
+    offsets_.push_back(size_);
+    // the index may list only some of the records, so each record is sized by the length
+    // fields of its parts rather than by the offset of the next listed record
+    sizes_.resize(offsets_.size() - 1);
+    for (size_t i = 0; i + 1 < offsets_.size(); ++i) {
+      CHECK_EQ(offsets_[i] % sizeof(uint32_t), 0U) << "Invalid RecordIO index file " << idx_path;
+      sizes_[i] = ParseRecordSize(offsets_[i], offsets_[i + 1], idx_path);
+    }
+  }
+
+  // size of the record at offset, with all its parts, which must end by limit
+  size_t ParseRecordSize(size_t offset, size_t limit, const std::string& idx_path) const {
+    const uint32_t kMagic = dmlc::RecordIOWriter::kMagic;
+    size_t pos = offset;
+    for (bool first = true; ; first = false) {
+      CHECK_LE(pos + 2 * sizeof(uint32_t), limit)
+          << "Record at offset " << offset << " in " << idx_path << " is truncated";
+      uint32_t header[2];
+      std::memcpy(header, base_ + pos, sizeof(header));
+      CHECK_EQ(header[0], kMagic)
+          << "Offset " << pos << " in " << idx_path << " is not a record";
+      const uint32_t cflag = dmlc::RecordIOWriter::DecodeFlag(header[1]);
+      const uint32_t len = dmlc::RecordIOWriter::DecodeLength(header[1]);
+      pos += sizeof(header) + ((len + 3U) & ~3U);
+      CHECK_LE(pos, limit)
+          << "Record at offset " << offset << " in " << idx_path << " overlaps the next one";
+      // a whole record has flag 0, a multi-part one flags 1, 2, ..., 2, 3
+      const bool last = cflag == 0 || cflag == 3;
+      CHECK_EQ(cflag, first ? (last ? 0U : 1U) : (last ? 3U : 2U))
+          << "Record at offset " << offset << " in " << idx_path << " has invalid parts";
+      if (last) break;
+    }
+    return pos - offset;
+  }
+
+  size_t num_records() const {
+    return offsets_.size() - 1;
+  }
+
+  size_t RecordSize(size_t rec) const {
+    return sizes_[rec];
+  }
+
+  // draws the permutation of this epoch and selects this part of it
+  void Permute() {
+    std::vector<size_t> perm(num_records());
+    std::iota(perm.begin(), perm.end(), 0);
+    if (shuffle_) {
+      std::mt19937 rnd(seed_ + kRandMagic * epoch_);
+      std::shuffle(perm.begin(), perm.end(), rnd);
+    }
+    const size_t begin = perm.size() * part_index_ / num_parts_;
+    const size_t end = perm.size() * (part_index_ + 1) / num_parts_;
+    order_.assign(perm.begin() + begin, perm.begin() + end);
+    pos_ = 0;
+    reader_.reset();
+    Prefetch(0, batch_size_);
+  }
+
+  // asks the kernel to read ahead the records [pos, pos + n) of order_
+  void Prefetch(size_t pos, size_t n) {
+#ifndef _WIN32
+    static const size_t page_size = sysconf(_SC_PAGESIZE);
+    const size_t end = std::min(pos + n, order_.size());
+    for (size_t i = pos; i < end; ++i) {
+      const size_t rec = order_[i];
+      const size_t begin = offsets_[rec] / page_size * page_size;
+      madvise(const_cast<char*>(base_) + begin, offsets_[rec] + sizes_[rec] - begin,
+              MADV_WILLNEED);
+    }
+#endif  // _WIN32
+  }
+
+  // magic number to seed the permutation of each epoch
+  static const int kRandMagic = 111;
+  bool shuffle_;
+  int seed_;
+  size_t batch_size_;
+  int num_threads_;
+  unsigned part_index_{0};
+  unsigned num_parts_{1};
+  unsigned epoch_{0};
+  /*! \brief mapped RecordIO file */
+  const char* base_{nullptr};
+  size_t size_{0};
+  /*! \brief sorted record offsets, followed by the file size */
+  std::vector<size_t> offsets_;
+  /*! \brief size of each record, from the length fields of its parts */
+  std::vector<size_t> sizes_;
+  /*! \brief records of this part in the order of this epoch */
+  std::vector<size_t> order_;
+  size_t pos_{0};
+  /*! \brief gathered batch */
+  std::vector<uint32_t> chunk_;
+  std::vector<size_t> chunk_offsets_;
+  /*! \brief reader of the current chunk for NextRecord */
+  std::unique_ptr<dmlc::RecordIOChunkReader> reader_;
+};
+
+}  // namespace io
+}  // namespace mxnet
+#endif  // MXNET_IO_MMAP_RECORDIO_SPLIT_H_
@@ -201,6 +201,7 @@ class CommCPU : public Comm {
           on_complete();
         }, Context::CPU(), const_vars, {buf_merged.var(), rsc.var},
         FnProperty::kCPUPrioritized, priority, "KVStoreReduce");
+      ResourceManager::Get()->Release(rsc);
     }
 
     return buf_merged;
@@ -25,6 +25,9 @@
 #ifndef MXNET_KVSTORE_GRADIENT_COMPRESSION_INL_H_
 #define MXNET_KVSTORE_GRADIENT_COMPRESSION_INL_H_
 
+#include <algorithm>
+#include <cmath>
+#include <cstring>
 #include <vector>
 #include "../operator/mxnet_op.h"
 
@@ -99,7 +102,8 @@ struct dequantize_2bit {
                                   float *out,
                                   float *in,
                                   const float neg_threshold,
-                                  const float pos_threshold) {
+                                  const float pos_threshold,
+                                  const bool accumulate) {
     // get position of dequantized value to fill
     float *outval = out + i;
     // gets byte which holds quantized value for this position
@@ -114,28 +118,29 @@ struct dequantize_2bit {
     const uint8_t mask = posbits[col];
     const uint8_t negmask = negbits[col];
     const uint8_t masked = *ch_ptr & mask;
+    float val = 0;
     if (masked == mask) {
-      *outval = pos_threshold;
+      val = pos_threshold;
     } else if (masked == negmask) {
       // use posbits for mask as posbits are both 1s
       // then compare masked with negbits to see if only negbits were set
-      *outval = neg_threshold;
-    } else {
-      *outval = 0;
+      val = neg_threshold;
     }
+    *outval = accumulate ? *outval + val : val;
   }
 };
 
 template<typename xpu>
 void Dequantize2BitKernelLaunch(mshadow::Stream<xpu> *s, const std::vector<mxnet::TBlob> &inputs,
-                                const float threshold) {
+                                const float threshold, const bool accumulate = false) {
   mxnet::op::mxnet_op::Kernel<dequantize_2bit, xpu>
   ::Launch(s,
           inputs[1].Size(),         // original size
           inputs[1].dptr<float>(),  // out array
           inputs[0].dptr<float>(),  // compressed array
           -1 *threshold,            // negative threshold
-          threshold);               // positive threshold
+          threshold,                // positive threshold
+          accumulate);              // add into out instead of overwriting
 }
 
 inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
@@ -146,9 +151,239 @@ inline void Quantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
 
 inline void Dequantize2BitImpl(mshadow::Stream<mshadow::cpu> *s,
                                const std::vector<mxnet::TBlob> &inputs,
-                               const float threshold) {
-  Dequantize2BitKernelLaunch(s, inputs, threshold);
+                               const float threshold,
+                               const bool accumulate = false) {
+  Dequantize2BitKernelLaunch(s, inputs, threshold, accumulate);
+}
+
+// The kernels below are only launched on cpu.
+
+/*!
+ * \brief 1bit compression works on blocks of kOneBitBlockSize gradients.
+ * Each compressed block holds one float scale followed by one sign bit per gradient.
+ */
+const int kOneBitBlockSize = 1024;
+const int kOneBitCompressedBlockSize = 1 + kOneBitBlockSize / 32;
+
+struct quantize_1bit {
+  static inline void Map(int block_id,
+                         int original_size,
+                         float *out,
+                         float *grad,
+                         float *residual) {
+    const int start = block_id * kOneBitBlockSize;
+    const int end = std::min(start + kOneBitBlockSize, original_size);
+    float *compr_block = out + block_id * kOneBitCompressedBlockSize;
+    uint32_t *sign_words = reinterpret_cast<uint32_t *>(compr_block + 1);
+    // scale is the mean magnitude of the error-corrected gradients in this block
+    float sum = 0;
+    for (int i = start; i < end; ++i) {
+      residual[i] += grad[i];
+      sum += std::fabs(residual[i]);
+    }
+    const float scale = sum / (end - start);
+    compr_block[0] = scale;
+    for (int w = 0; w < kOneBitBlockSize / 32; ++w) {
+      sign_words[w] = 0;
+    }
+    for (int i = start; i < end; ++i) {
+      const int offset = i - start;
+      if (residual[i] >= 0) {
+        sign_words[offset >> 5] |= (1u << (offset & 31));
+        residual[i] -= scale;
+      } else {
+        residual[i] += scale;
+      }
+    }
+  }
+};
+
+struct dequantize_1bit {
+  static inline void Map(int i,
+                         float *out,
+                         float *in,
+                         const bool accumulate) {
+    const float *compr_block = in + (i / kOneBitBlockSize) * kOneBitCompressedBlockSize;
+    const uint32_t *sign_words = reinterpret_cast<const uint32_t *>(compr_block + 1);
+    const int offset = i % kOneBitBlockSize;
+    const float val = ((sign_words[offset >> 5] >> (offset & 31)) & 1u) ?
+                      compr_block[0] : -compr_block[0];
+    out[i] = accumulate ? out[i] + val : val;
+  }
+};
+
+/*!
+ * \brief fp16 and bf16 compression pack two 16bit values into each float of the
+ * compressed array. The rounding error of the cast is kept in the residual.
+ */
+struct quantize_fp16 {
+  static inline void Map(int out_id,
+                         int original_size,
+                         float *out,
+                         float *grad,
+                         float *residual) {
+    uint16_t *out_half = reinterpret_cast<uint16_t *>(out);
+    for (int i = out_id * 2; i < out_id * 2 + 2; ++i) {
+      if (i < original_size) {
+        residual[i] += grad[i];
+        const mshadow::half::half_t val(residual[i]);
+        residual[i] -= static_cast<float>(val);
+        out_half[i] = val.half_;
+      } else {
+        out_half[i] = 0;
+      }
+    }
+  }
+};
+
+struct dequantize_fp16 {
+  static inline void Map(int i,
+                         float *out,
+                         float *in,
+                         const bool accumulate) {
+    const uint16_t *in_half = reinterpret_cast<const uint16_t *>(in);
+    const float val = static_cast<float>(mshadow::half::half_t::Binary(in_half[i]));
+    out[i] = accumulate ? out[i] + val : val;
+  }
+};
+
+/*! \brief converts float to bfloat16 bits, rounding to nearest even */
+inline uint16_t FloatToBF16(const float val) {
+  uint32_t bits;
+  std::memcpy(&bits, &val, sizeof(bits));
+  if ((bits & 0x7fffffffu) > 0x7f800000u) {
+    // keep NaN a quiet NaN instead of letting rounding turn it into inf
+    return static_cast<uint16_t>((bits >> 16) | 0x0040u);
+  }
+  bits += 0x7fffu + ((bits >> 16) & 1u);
+  return static_cast<uint16_t>(bits >> 16);
 }
+
+inline float BF16ToFloat(const uint16_t val) {
+  const uint32_t bits = static_cast<uint32_t>(val) << 16;
+  float ret;
+  std::memcpy(&ret, &bits, sizeof(ret));
+  return ret;
+}
+
+struct quantize_bf16 {
+  static inline void Map(int out_id,
+                         int original_size,
+                         float *out,
+                         float *grad,
+                         float *residual) {
+    uint16_t *out_half = reinterpret_cast<uint16_t *>(out);
+    for (int i = out_id * 2; i < out_id * 2 + 2; ++i) {
+      if (i < original_size) {
+        residual[i] += grad[i];
+        out_half[i] = FloatToBF16(residual[i]);
+        residual[i] -= BF16ToFloat(out_half[i]);
+      } else {
+        out_half[i] = 0;
+      }
+    }
+  }
+};
+
+struct dequantize_bf16 {
+  static inline void Map(int i,
+                         float *out,
+                         float *in,
+                         const bool accumulate) {
+    const float val = BF16ToFloat(reinterpret_cast<const uint16_t *>(in)[i]);
+    out[i] = accumulate ? out[i] + val : val;
+  }
+};
+
+/*!
+ * \brief topk and randomk compression select k gradients out of every block of
+ * kSparseBlockSize gradients. Each compressed block stores k (index, value) pairs,
+ * with the index relative to the start of the block. Blocks are independent so that
+ * a partition of whole blocks can be decompressed on its own by a server.
+ * Selected values are removed from the residual, the rest is fed back into the next step.
+ */
+const int kSparseBlockSize = 2048;
+
+/*!
+ * \brief number of gradients kept out of a block of n gradients, at least one.
+ * Only the last block of an array can be shorter than kSparseBlockSize, so the
+ * compressed block of block_id starts at block_id * 2 * SparseK(kSparseBlockSize, ratio).
+ */
+inline int SparseK(const int n, const float ratio) {
+  const int k = static_cast<int>(std::round(n * ratio));
+  return std::min(std::max(k, 1), n);
+}
+
+struct quantize_sparse {
+  static inline void Map(int block_id,
+                         int original_size,
+                         float *out,
+                         float *grad,
+                         float *residual,
+                         const float ratio,
+                         const bool random,
+                         const uint64_t seed) {
+    const int start = block_id * kSparseBlockSize;
+    const int n = std::min(kSparseBlockSize, original_size - start);
+    float *res = residual + start;
+    for (int i = 0; i < n; ++i) {
+      res[i] += grad[start + i];
+    }
+    int index[kSparseBlockSize];
+    for (int i = 0; i < n; ++i) {
+      index[i] = i;
+    }
+    const int num_selected = SparseK(n, ratio);
+    if (num_selected < n) {
+      if (random) {
+        // partial Fisher-Yates shuffle driven by a xorshift generator
+        uint64_t state = seed ^ (0x9e3779b97f4a7c15ULL * (block_id + 1));
+        for (int i = 0; i < num_selected; ++i) {
+          state ^= state << 13;
+          state ^= state >> 7;
+          state ^= state << 17;
+          const int j = i + static_cast<int>(state % static_cast<uint64_t>(n - i));
+          std::swap(index[i], index[j]);
+        }
+      } else {
+        std::nth_element(index, index + num_selected, index + n,
+                         [res](const int a, const int b) {
+                           return std::fabs(res[a]) > std::fabs(res[b]);
+                         });
+      }
+    }
+    float *compr_block = out + static_cast<int64_t>(block_id) * 2 *
+                         SparseK(kSparseBlockSize, ratio);
+    for (int i = 0; i < num_selected; ++i) {
+      // indices are below kSparseBlockSize so they are exact in float
+      compr_block[2 * i] = static_cast<float>(index[i]);
+      compr_block[2 * i + 1] = res[index[i]];
+      res[index[i]] = 0;
+    }
+  }
+};
+
+struct dequantize_sparse {
+  static inline void Map(int block_id,
+                         int original_size,
+                         float *out,
+                         float *in,
+                         const float ratio,
+                         const bool accumulate) {
+    const int start = block_id * kSparseBlockSize;
+    const int n = std::min(kSparseBlockSize, original_size - start);
+    float *out_block = out + start;
+    if (!accumulate) {
+      std::fill(out_block, out_block + n, 0.0f);
+    }
+    const float *compr_block = in + static_cast<int64_t>(block_id) * 2 *
+                               SparseK(kSparseBlockSize, ratio);
+    const int num_selected = SparseK(n, ratio);
+    for (int i = 0; i < num_selected; ++i) {
+      out_block[static_cast<int>(compr_block[2 * i])] += compr_block[2 * i + 1];
+    }
+  }
+};
 }  // namespace kvstore
 }  // namespace mxnet
 
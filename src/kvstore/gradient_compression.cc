@@ -23,6 +23,10 @@
  * \author Rahul Huilgol
  */
 
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <string>
 #include <vector>
 #include "kvstore_local.h"
 #include "gradient_compression.h"
@@ -44,6 +48,16 @@ void GradientCompression::SetParams(const std::vector<std::pair<std::string, std
   CHECK_GT(params.threshold, 0) << "threshold must be greater than 0";
   if (params.type == "2bit") {
     SetTwoBitCompression(params.threshold);
+  } else if (params.type == "1bit") {
+    SetCompression(CompressionType::kOneBit, params.ratio);
+  } else if (params.type == "topk") {
+    SetCompression(CompressionType::kTopK, params.ratio);
+  } else if (params.type == "randomk") {
+    SetCompression(CompressionType::kRandomK, params.ratio);
+  } else if (params.type == "fp16") {
+    SetCompression(CompressionType::kFP16, params.ratio);
+  } else if (params.type == "bf16") {
+    SetCompression(CompressionType::kBF16, params.ratio);
   } else {
     LOG(FATAL) << "Unknown type for gradient compression " << params.type;
   }
@@ -62,11 +76,30 @@ void GradientCompression::SetTwoBitCompression(const float threshold) {
   threshold_ = threshold;
 }
 
+void GradientCompression::SetCompression(const CompressionType type, const float ratio) {
+  CHECK(type != CompressionType::kNone && type != CompressionType::kTwoBit)
+    << "Use SetTwoBitCompression for 2bit compression";
+  if (type == CompressionType::kTopK || type == CompressionType::kRandomK) {
+    CHECK(ratio > 0 && ratio <= 1) << "ratio must be in (0, 1], got " << ratio;
+  }
+  type_ = type;
+  ratio_ = ratio;
+}
+
+/*!
+ * \brief prints a float with 9 significant digits, which stof reads back exactly.
+ * The server must derive the same SparseK as the workers from ratio.
+ */
+static std::string FloatToExactString(const float val) {
+  char buf[32];
+  snprintf(buf, sizeof(buf), "%.9g", val);
+  return buf;
+}
+
 std::string GradientCompression::EncodeParams() {
-  using namespace std;  // to reduce length of next line
-  string rval = get_type_str();
-  if (type_ == CompressionType::kTwoBit) {
-    rval += "," + to_string(threshold_);
+  std::string rval = get_type_str();
+  if (type_ != CompressionType::kNone) {
+    rval += "," + FloatToExactString(threshold_) + "," + FloatToExactString(ratio_);
   }
   return rval;
 }
@@ -80,22 +113,135 @@ void GradientCompression::DecodeParams(const std::string &s) {
       threshold_ = stof(elems[1]);
     }
   }
+  if (elems.size() > 2) {
+    if (!elems[2].empty()) {
+      ratio_ = stof(elems[2]);
+    }
+  }
 }
 
-int GradientCompression::GetCompressionFactor() {
-  if (type_ == CompressionType::kTwoBit) {
-    return 16;
-  } else {
-    LOG(FATAL) << "Unsupported compression type: " << get_type_str();
-    return 0;
+int GradientCompression::GetSparseK() {
+  return SparseK(kSparseBlockSize, ratio_);
+}
+
+int64_t GradientCompression::GetBlockSize() {
+  switch (type_) {
+    case CompressionType::kTwoBit:
+      return 16;
+    case CompressionType::kOneBit:
+      return kOneBitBlockSize;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      return kSparseBlockSize;
+    case CompressionType::kFP16:
+    case CompressionType::kBF16:
+      return 2;
+    default:
+      LOG(FATAL) << "Unsupported compression type: " << get_type_str();
+      return 0;
+  }
+}
+
+int64_t GradientCompression::GetCompressedBlockSize() {
+  switch (type_) {
+    case CompressionType::kTwoBit:
+    case CompressionType::kFP16:
+    case CompressionType::kBF16:
+      return 1;
+    case CompressionType::kOneBit:
+      return kOneBitCompressedBlockSize;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      // an (index, value) pair for each selected gradient of a full block
+      return 2 * GetSparseK();
+    default:
+      LOG(FATAL) << "Unsupported compression type: " << get_type_str();
+      return 0;
   }
 }
 
 int64_t GradientCompression::GetCompressedSize(const int64_t original_size) {
-  const int bits = GetCompressionFactor();
-  return ((original_size % bits == 0) ?
-          original_size / bits :
-          original_size / bits + 1);
+  const int64_t block = GetBlockSize();
+  if (type_ == CompressionType::kTopK || type_ == CompressionType::kRandomK) {
+    // a short last block keeps k in proportion to its own length
+    const int64_t last = original_size % block;
+    return (original_size / block) * GetCompressedBlockSize() +
+           (last ? 2 * SparseK(static_cast<int>(last), ratio_) : 0);
+  }
+  const int64_t num_blocks = (original_size % block == 0) ?
+                             original_size / block :
+                             original_size / block + 1;
+  return num_blocks * GetCompressedBlockSize();
+}
+
+/*!
+ * \brief quantizes inputs = {grad, residual, compressed} on cpu
+ * for the compression types other than 2bit
+ */
+void QuantizeCPUImpl(mshadow::Stream<mshadow::cpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                     const CompressionType type, const float ratio, const uint64_t seed) {
+  using mxnet::op::mxnet_op::Kernel;
+  const int original_size = inputs[0].Size();
+  float *grad = inputs[0].dptr<float>();
+  float *residual = inputs[1].dptr<float>();
+  float *out = inputs[2].dptr<float>();
+  const size_t compr_size = inputs[2].Size();
+  switch (type) {
+    case CompressionType::kOneBit:
+      Kernel<quantize_1bit, mshadow::cpu>::Launch(s, compr_size / kOneBitCompressedBlockSize,
+                                                  original_size, out, grad, residual);
+      break;
+    case CompressionType::kFP16:
+      Kernel<quantize_fp16, mshadow::cpu>::Launch(s, compr_size, original_size,
+                                                  out, grad, residual);
+      break;
+    case CompressionType::kBF16:
+      Kernel<quantize_bf16, mshadow::cpu>::Launch(s, compr_size, original_size,
+                                                  out, grad, residual);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      Kernel<quantize_sparse, mshadow::cpu>::Launch(s,
+                                                    (original_size + kSparseBlockSize - 1) /
+                                                    kSparseBlockSize, original_size,
+                                                    out, grad, residual, ratio,
+                                                    type == CompressionType::kRandomK, seed);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported quantization of type " << static_cast<int>(type);
+  }
+}
+
+/*!
+ * \brief dequantizes inputs = {compressed, out} on cpu
+ * for the compression types other than 2bit
+ */
+void DequantizeCPUImpl(mshadow::Stream<mshadow::cpu> *s, const std::vector<mxnet::TBlob> &inputs,
+                       const CompressionType type, const float ratio, const bool accumulate) {
+  using mxnet::op::mxnet_op::Kernel;
+  float *in = inputs[0].dptr<float>();
+  float *out = inputs[1].dptr<float>();
+  const int original_size = inputs[1].Size();
+  switch (type) {
+    case CompressionType::kOneBit:
+      Kernel<dequantize_1bit, mshadow::cpu>::Launch(s, original_size, out, in, accumulate);
+      break;
+    case CompressionType::kFP16:
+      Kernel<dequantize_fp16, mshadow::cpu>::Launch(s, original_size, out, in, accumulate);
+      break;
+    case CompressionType::kBF16:
+      Kernel<dequantize_bf16, mshadow::cpu>::Launch(s, original_size, out, in, accumulate);
+      break;
+    case CompressionType::kTopK:
+    case CompressionType::kRandomK:
+      Kernel<dequantize_sparse, mshadow::cpu>::Launch(s,
+                                                      (original_size + kSparseBlockSize - 1) /
+                                                      kSparseBlockSize,
+                                                      original_size, out, in, ratio, accumulate);
+      break;
+    default:
+      LOG(FATAL) << "Unsupported dequantization of type " << static_cast<int>(type);
+  }
 }
 
 void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *to,
@@ -130,13 +276,24 @@ void GradientCompression::Quantize(const mxnet::NDArray &from, mxnet::NDArray *t
     LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
     }
+  } else if (type_ != CompressionType::kNone) {
+    CHECK(a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask)
+      << "Gradient compression of type " << get_type_str() << " is only supported on cpu";
+    const CompressionType type = type_;
+    const float ratio = ratio_;
+    const uint64_t seed = num_quantized_++;
+    mxnet::Engine::Get()->PushSync([from, to, residual, type, ratio, seed](mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), residual->data(), to->data()};
+      QuantizeCPUImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, ratio, seed);
+    }, from.ctx(), {from.var()}, {to->var(), residual->var()},
+    mxnet::FnProperty::kNormal, priority, "QuantizeCPU");
   } else {
     LOG(FATAL) << "Unsupported quantization of type " << get_type_str();
   }
 }
 
 void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray *to,
-                                     const int priority) {
+                                     const int priority, const bool accumulate) {
   CHECK(shape_is_known(from.shape())) << "source operand has undefined shape";
   CHECK(shape_is_known(to->shape())) << "destination operand has undefined shape";
   const int a = from.ctx().dev_mask();
@@ -144,14 +301,15 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
   const float threshold = threshold_;
   if (type_ == CompressionType::kTwoBit) {
     if (a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask) {
-      mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
+      mxnet::Engine::Get()->PushSync([from, to, threshold, accumulate](mxnet::RunContext ctx) {
         std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
-        Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold);
+        Dequantize2BitImpl(ctx.get_stream<mshadow::cpu>(), inputs, threshold, accumulate);
       }, from.ctx(), {from.var()}, {to->var()},
       mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
     } else {
 #if MXNET_USE_CUDA
       if (a == mshadow::gpu::kDevMask && b == mshadow::gpu::kDevMask) {
+        CHECK(!accumulate) << "Accumulating dequantize is not supported on gpu";
         mxnet::Engine::Get()->PushSync([from, to, threshold](mxnet::RunContext ctx) {
           std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
           Dequantize2BitImpl(ctx.get_stream<mshadow::gpu>(), inputs, threshold);
@@ -166,6 +324,16 @@ void GradientCompression::Dequantize(const mxnet::NDArray &from, mxnet::NDArray
       LOG(FATAL) << MXNET_GPU_NOT_ENABLED_ERROR;
 #endif
     }
+  } else if (type_ != CompressionType::kNone) {
+    CHECK(a == mshadow::cpu::kDevMask && b == mshadow::cpu::kDevMask)
+      << "Gradient compression of type " << get_type_str() << " is only supported on cpu";
+    const CompressionType type = type_;
+    const float ratio = ratio_;
+    mxnet::Engine::Get()->PushSync([from, to, type, ratio, accumulate](mxnet::RunContext ctx) {
+      std::vector<mxnet::TBlob> inputs = {from.data(), to->data()};
+      DequantizeCPUImpl(ctx.get_stream<mshadow::cpu>(), inputs, type, ratio, accumulate);
+    }, from.ctx(), {from.var()}, {to->var()},
+    mxnet::FnProperty::kNormal, priority, "DequantizeCPU");
   } else {
     LOG(FATAL) << "Unsupported dequantization of type " << get_type_str();
   }
@@ -35,17 +35,21 @@ namespace mxnet {
 namespace kvstore {
 
 enum class CompressionType {
-  kNone, kTwoBit
+  kNone, kTwoBit, kOneBit, kTopK, kRandomK, kFP16, kBF16
 };
 
 struct GradientCompressionParam : public dmlc::Parameter<GradientCompressionParam> {
   std::string type;
   float threshold;
+  float ratio;
   DMLC_DECLARE_PARAMETER(GradientCompressionParam) {
     DMLC_DECLARE_FIELD(type)
-      .describe("Type of gradient compression to use, like `2bit` for example");
+      .describe("Type of gradient compression to use, one of `2bit`, `1bit`, "
+                "`topk`, `randomk`, `fp16` or `bf16`");
     DMLC_DECLARE_FIELD(threshold).set_default(0.5)
       .describe("Threshold to use for 2bit gradient compression");
+    DMLC_DECLARE_FIELD(ratio).set_default(0.01)
+      .describe("Fraction of gradients sent by topk and randomk gradient compression");
   }
 };
 
@@ -78,6 +82,13 @@ class GradientCompression {
    */
   void SetTwoBitCompression(const float threshold);
 
+  /*!
+   * \brief sets a compression type which takes no threshold
+   * \param type one of kOneBit, kTopK, kRandomK, kFP16 or kBF16
+   * \param ratio fraction of gradients kept by kTopK and kRandomK
+   */
+  void SetCompression(const CompressionType type, const float ratio);
+
   /*!
    * \brief encodes parameters of gc into a string
    */
@@ -89,10 +100,18 @@ class GradientCompression {
   void DecodeParams(const std::string &s);
 
   /*!
-   * \brief returns compression factor, which is the factor by which size of gradient
-   * reduces when using a particular type of compression
+   * \brief returns the number of original gradients compressed together as one block.
+   * Blocks are compressed independently, so an array may be split between servers
+   * at any multiple of the block size.
+   */
+  int64_t GetBlockSize();
+
+  /*!
+   * \brief returns the number of floats a compressed block occupies.
+   * For topk and randomk this is the size of a full block, a shorter last block
+   * of an array takes less.
    */
-  int GetCompressionFactor();
+  int64_t GetCompressedBlockSize();
 
   /*!
    * \brief returns the size of compressed gradients given an original sized gradient array
@@ -117,8 +136,10 @@ class GradientCompression {
   * \param from the ndarray containing quantized data
   * \param to the target ndarray which contains final dequantized data
   * \param priority Priority of the action.
+  * \param accumulate whether to add the dequantized data into `to` instead of overwriting it
   */
-  void Dequantize(const mxnet::NDArray &from, mxnet::NDArray *to, const int priority);
+  void Dequantize(const mxnet::NDArray &from, mxnet::NDArray *to, const int priority,
+                  const bool accumulate = false);
 
  private:
   /*!
@@ -132,6 +153,21 @@ class GradientCompression {
    * all negative gradients will be thresholded to -1*`threshold_`
    */
   float threshold_ = 0;
+
+  /*!
+   * \brief fraction of gradients in each block sent by topk and randomk compression
+   */
+  float ratio_ = 0.01;
+
+  /*!
+   * \brief number of quantize calls so far, seeds the selection of randomk compression
+   */
+  uint64_t num_quantized_ = 0;
+
+  /*!
+   * \brief number of gradients kept per block by topk and randomk compression
+   */
+  int GetSparseK();
 };
 }  // namespace kvstore
 }  // namespace mxnet
@@ -51,7 +51,11 @@ KVStore* KVStore::Create(const char *type_name) {
 
   if (has("dist")) {
 #if MXNET_USE_DIST_KVSTORE
-    kv = new kvstore::KVStoreDist(use_device_comm);
+    const bool hierarchical = has("hierarchical");
+    if (hierarchical && has("_async")) {
+      LOG(FATAL) << "Hierarchical kvstore supports only synchronous training, got " << tname;
+    }
+    kv = new kvstore::KVStoreDist(use_device_comm, hierarchical);
     if (!has("_async") && kv->IsWorkerNode() && kv->get_rank() == 0) {
       // configure the server to be the sync mode
       kv->SendCommandToServers(static_cast<int>(kvstore::CommandType::kSyncMode), "");
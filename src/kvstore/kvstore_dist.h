@@ -32,6 +32,7 @@
 #include "mxnet/engine.h"
 #include "ps/ps.h"
 #include "./kvstore_dist_server.h"
+#include "./kvstore_dist_node_comm.h"
 namespace mxnet {
 namespace kvstore {
 
@@ -43,7 +44,12 @@ namespace kvstore {
  */
 class KVStoreDist : public KVStoreLocal {
  public:
-  explicit KVStoreDist(bool use_device_comm)
+  /**
+   * \param use_device_comm whether to reduce over the devices of a worker on device
+   * \param hierarchical whether workers on the same machine first reduce through shared
+   * memory, so that only one worker per machine talks to the servers
+   */
+  explicit KVStoreDist(bool use_device_comm, bool hierarchical = false)
       : KVStoreLocal(use_device_comm), ps_worker_(nullptr), server_(nullptr) {
     if (IsWorkerNode()) {
       int new_customer_id = GetNewCustomerId();
@@ -54,6 +60,17 @@ class KVStoreDist : public KVStoreLocal {
           new_customer_id,
           ps::kWorkerGroup + ps::kServerGroup + ps::kScheduler);
       }
+      if (hierarchical) {
+        const std::string job_id = dmlc::GetEnv("DMLC_PS_ROOT_URI", std::string()) + ":" +
+                                   dmlc::GetEnv("DMLC_PS_ROOT_PORT", std::string());
+        node_comm_ = std::make_shared<NodeSharedMemComm>(job_id, get_rank(),
+                                                         [this]() { Barrier(); });
+        if (node_comm_->is_leader()) {
+          // servers wait for one push per machine instead of one per worker
+          SendCommandToServers(static_cast<int>(CommandType::kRegisterNodeLeader), "");
+        }
+        Barrier();
+      }
     }
     bigarray_bound_ = dmlc::GetEnv("MXNET_KVSTORE_BIGARRAY_BOUND", 1000 * 1000);
     log_verbose_ = dmlc::GetEnv("MXNET_KVSTORE_DIST_ROW_SPARSE_VERBOSE", false);
@@ -191,6 +208,16 @@ class KVStoreDist : public KVStoreLocal {
     for (size_t i = 0; i < keys.size(); ++i) {
       comm_->Init(keys[i], values[i].storage_type(), values[i].shape(), values[i].dtype());
     }
+    if (node_comm_) {
+      std::vector<std::pair<int, size_t> > key_sizes;
+      for (size_t i = 0; i < keys.size(); ++i) {
+        CHECK_EQ(values[i].storage_type(), kDefaultStorage)
+          << "Hierarchical kvstore supports only dense values";
+        const size_t num_bytes = mshadow::mshadow_sizeof(values[i].dtype());
+        key_sizes.emplace_back(keys[i], values[i].shape().Size() * num_bytes);
+      }
+      node_comm_->InitKeys(key_sizes);
+    }
     if (get_rank() == 0 && this->ps_worker_->get_customer()->customer_id() == 0) {
       Push_(keys, values, 0, false);
       // wait until the push is finished
@@ -233,6 +260,12 @@ class KVStoreDist : public KVStoreLocal {
         recv_buf = NDArray(grouped_vals[i][0]->shape(), pinned_ctx_,
                            true, grouped_vals[i][0]->dtype());
       }
+      if (node_comm_ && !node_comm_->is_leader() && node_comm_->PullFromLeader(key)) {
+        // the leader of this machine pulls for us
+        node_comm_->Broadcast(key, recv_buf, priority);
+        comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
+        continue;
+      }
       auto pull_from_servers = [this, key, recv_buf](
           RunContext rctx, Engine::CallbackOnComplete cb) {
         // convert to ps keys
@@ -262,6 +295,7 @@ class KVStoreDist : public KVStoreLocal {
           priority,
           "KVStoreDistDefaultStoragePull");
 
+      if (node_comm_) node_comm_->Broadcast(key, recv_buf, priority);
       comm_->Broadcast(key, recv_buf, grouped_vals[i], priority);
     }
   }
@@ -269,6 +303,7 @@ class KVStoreDist : public KVStoreLocal {
   void PullRowSparseImpl(const std::vector<int>& keys,
                          const std::vector<std::pair<NDArray*, NDArray>>& val_rowids,
                          int priority = 0) override {
+    CHECK(!node_comm_) << "Hierarchical kvstore doesn't support row_sparse pull";
     std::vector<int> uniq_keys;
     std::vector<std::vector<std::pair<NDArray*, NDArray>>> grouped_val_rowids;
     GroupKVPairsPullRsp(keys, val_rowids, &uniq_keys, &grouped_val_rowids, false);
@@ -339,6 +374,11 @@ class KVStoreDist : public KVStoreLocal {
         }
         CopyFromTo(merged, &comm_buf);
       }
+      if (node_comm_ && do_merge) {
+        // reduce over the workers of this machine, only the leader pushes to servers
+        node_comm_->Reduce(key, comm_buf, priority);
+        if (!node_comm_->is_leader()) continue;
+      }
       const int dtype = merged.dtype();
       const int num_bytes = mshadow::mshadow_sizeof(dtype);
       // push to servers
@@ -626,9 +666,14 @@ class KVStoreDist : public KVStoreLocal {
         push_pskv.size = compr_size;
         pull_pskv.size = original_size;
       } else {
-        // partition it to all servers
+        // partition it to all servers, at boundaries of compressed blocks
+        // so that each server can decompress its part independently
         push_pskv.size = 0;
         pull_pskv.size = 0;
+        const size_t block_size = gradient_compression_->GetBlockSize();
+        const size_t compr_block_size = gradient_compression_->GetCompressedBlockSize();
+        // every block but the last of the array is full, the last server takes the rest
+        const size_t num_blocks = (original_num_elem + block_size - 1) / block_size;
 
         for (int i = 0; i < num_servers; ++i) {
           size_t part_compr, part_orig;
@@ -636,10 +681,11 @@ class KVStoreDist : public KVStoreLocal {
             part_compr = compr_num_elem - push_pskv.size;
             part_orig = original_num_elem - pull_pskv.size;
           } else {
-            part_compr =
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i+1))) -
-              static_cast<size_t> (round(static_cast<double>(compr_num_elem)/num_servers*(i)));
-            part_orig = part_compr * gradient_compression_->GetCompressionFactor();
+            const size_t part_blocks =
+              static_cast<size_t> (round(static_cast<double>(num_blocks)/num_servers*(i+1))) -
+              static_cast<size_t> (round(static_cast<double>(num_blocks)/num_servers*(i)));
+            part_compr = part_blocks * compr_block_size;
+            part_orig = part_blocks * block_size;
           }
 
           // meta info
@@ -760,6 +806,11 @@ class KVStoreDist : public KVStoreLocal {
    * during gradient compression
    */
   std::unordered_map<int, NDArray> residual_;
+  /**
+   * \brief shared memory communication among the workers of this machine,
+   * only set in hierarchical mode
+   */
+  std::shared_ptr<NodeSharedMemComm> node_comm_;
   bool log_verbose_;
 };
 
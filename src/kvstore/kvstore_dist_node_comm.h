@@ -0,0 +1,373 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/**
+ * Copyright (c) 2019 by Contributors
+ * @file   kvstore_dist_node_comm.h
+ * @brief  shared memory reduce and broadcast among the workers of one machine,
+ *         used by the hierarchical mode of the distributed kvstore
+ */
+#ifndef MXNET_KVSTORE_KVSTORE_DIST_NODE_COMM_H_
+#define MXNET_KVSTORE_KVSTORE_DIST_NODE_COMM_H_
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/engine.h>
+#include <mxnet/ndarray.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstring>
+#include <functional>
+#include <list>
+#include <mutex>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+namespace mxnet {
+namespace kvstore {
+
+/**
+ * \brief reduces and broadcasts values among the worker processes of one machine
+ * through named POSIX shared memory.
+ *
+ * Workers on a machine find each other through a node directory segment. The worker
+ * with the smallest rank on the machine is the leader. On every push of a key, the
+ * other workers copy their value into their slot of the key's segment and the leader
+ * sums the slots into its own value, which it then pushes to the servers. On pull,
+ * the leader writes the value pulled from the servers into the result slot of the
+ * segment, from where the other workers copy it.
+ *
+ * All waiting for other processes is done on a background thread, so engine threads
+ * are never blocked. Each key keeps its own round counter, which requires that all
+ * workers push every key the same number of times, as in synchronous training.
+ */
+class NodeSharedMemComm {
+ public:
+  /**
+   * \param job_id string identifying the job, shared by all its workers
+   * \param rank global rank of this worker
+   * \param barrier global barrier among all workers
+   */
+  NodeSharedMemComm(const std::string& job_id, const int rank,
+                    const std::function<void()>& barrier)
+      : barrier_(barrier) {
+#ifdef _WIN32
+    LOG(FATAL) << "Hierarchical kvstore is not supported on Windows";
+#else
+    std::string node = dmlc::GetEnv("MXNET_KVSTORE_HIERARCHICAL_NODE", std::string());
+    if (node.empty()) {
+      char hostname[256] = {0};
+      CHECK_EQ(gethostname(hostname, sizeof(hostname) - 1), 0) << "gethostname failed";
+      node = hostname;
+    }
+    std::ostringstream prefix;
+    prefix << "/mx_hkv_" << std::hex << std::hash<std::string>()(job_id + "@" + node);
+    prefix_ = prefix.str();
+
+    // register in the node directory, then read it back once everyone has registered.
+    // The leader is not known before registration, so every worker drops a directory left
+    // behind by a crashed job with the same id, and the first one to open it after the
+    // barrier creates it zero-filled
+    const std::string dir_name = prefix_ + "_dir";
+    shm_unlink(dir_name.c_str());
+    barrier_();
+    NodeDirectory* dir = static_cast<NodeDirectory*>(
+        MapSegment(dir_name, sizeof(NodeDirectory), O_CREAT | O_RDWR));
+    const int slot = dir->count.fetch_add(1);
+    CHECK_LT(slot, static_cast<int>(kMaxLocalWorkers)) << "Too many workers on node " << node;
+    dir->ranks[slot] = rank;
+    barrier_();
+    local_size_ = dir->count.load();
+    std::vector<int> local_ranks(dir->ranks, dir->ranks + local_size_);
+    std::sort(local_ranks.begin(), local_ranks.end());
+    local_rank_ = std::find(local_ranks.begin(), local_ranks.end(), rank) - local_ranks.begin();
+    barrier_();
+    if (is_leader()) shm_unlink(dir_name.c_str());
+    munmap(dir, sizeof(NodeDirectory));
+    LOG(INFO) << "Worker " << rank << " is local worker " << local_rank_ << " of "
+              << local_size_ << " on node " << node;
+    if (local_size_ > 1) {
+      poller_ = std::thread(&NodeSharedMemComm::Poll, this);
+    }
+#endif  // _WIN32
+  }
+
+  ~NodeSharedMemComm() {
+    if (poller_.joinable()) {
+      {
+        std::lock_guard<std::mutex> lock(mu_);
+        stop_ = true;
+      }
+      cv_.notify_one();
+      poller_.join();
+    }
+#ifndef _WIN32
+    for (auto& kv : segments_) {
+      munmap(kv.second.ctrl, kv.second.size);
+    }
+#endif  // _WIN32
+  }
+
+  /*! \brief whether this worker talks to the servers for its machine */
+  bool is_leader() const { return local_rank_ == 0; }
+
+  /*! \brief number of workers on this machine */
+  int local_size() const { return local_size_; }
+
+  /**
+   * \brief creates the shared segments of keys. Must be called by all workers
+   * with the same keys and sizes
+   * \param keys pairs of key and the size in bytes of its value
+   */
+  void InitKeys(const std::vector<std::pair<int, size_t> >& keys) {
+    if (local_size_ == 1) return;
+#ifndef _WIN32
+    // the leader creates segments, the others open them after the barrier
+    for (int pass = 0; pass < 2; ++pass) {
+      if ((pass == 0) == is_leader()) {
+        for (const auto& kv : keys) {
+          CHECK_EQ(segments_.count(kv.first), 0U) << "Key " << kv.first << " is initialized twice";
+          Segment& seg = segments_[kv.first];
+          seg.bytes = kv.second;
+          seg.num_slots = local_size_;
+          seg.size = kHeaderSize + seg.bytes * seg.num_slots;
+          seg.ctrl = static_cast<KeyControl*>(
+              MapSegment(SegmentName(kv.first), seg.size,
+                         is_leader() ? (O_CREAT | O_TRUNC | O_RDWR) : O_RDWR));
+        }
+      }
+      barrier_();
+    }
+    if (is_leader()) {
+      for (const auto& kv : keys) shm_unlink(SegmentName(kv.first).c_str());
+    }
+#endif  // _WIN32
+  }
+
+  /**
+   * \brief starts a round of reduce on a key. The leader's `buf` becomes the sum of
+   * the values of all workers on this machine, the other workers contribute `buf`.
+   */
+  void Reduce(const int key, const NDArray& buf, const int priority) {
+    if (local_size_ == 1) return;
+    Segment& seg = GetSegment(key, buf);
+    const int64_t round = ++seg.round;
+    const int local_rank = local_rank_;
+    const int num_others = local_size_ - 1;
+    if (is_leader()) {
+      Engine::Get()->PushAsync(
+        [this, seg, buf, round, num_others](RunContext rctx, Engine::CallbackOnComplete cb) {
+          Enqueue([seg, round, num_others]() {
+              return seg.ctrl->arrived.load() >= round * num_others;
+            }, [seg, buf, round, num_others]() {
+              TBlob data = buf.data();
+              MSHADOW_TYPE_SWITCH(data.type_flag_, DType, {
+                DType* dst = data.dptr<DType>();
+                const size_t size = data.Size();
+                for (int i = 0; i < num_others; ++i) {
+                  const DType* src = reinterpret_cast<const DType*>(seg.slot(i));
+                  for (size_t j = 0; j < size; ++j) dst[j] += src[j];
+                }
+              });
+              seg.ctrl->reduced.store(round);
+            }, cb);
+        }, buf.ctx(), {}, {buf.var()}, FnProperty::kNormal, priority, "KVStoreNodeReduce");
+    } else {
+      Engine::Get()->PushAsync(
+        [this, seg, buf, round, local_rank](RunContext rctx, Engine::CallbackOnComplete cb) {
+          // wait till the leader has summed the slots of the previous round
+          Enqueue([seg, round]() {
+              return seg.ctrl->reduced.load() >= round - 1;
+            }, [seg, buf, local_rank]() {
+              std::memcpy(seg.slot(local_rank - 1), buf.data().dptr_, seg.bytes);
+              seg.ctrl->arrived.fetch_add(1);
+            }, cb);
+        }, buf.ctx(), {buf.var()}, {}, FnProperty::kNormal, priority, "KVStoreNodeReduce");
+    }
+  }
+
+  /**
+   * \brief whether pulls of a key are served by the leader. This is the case
+   * once the key has been pushed, before that every worker pulls from the servers
+   */
+  bool PullFromLeader(const int key) {
+    if (local_size_ == 1) return false;
+    auto it = segments_.find(key);
+    return it != segments_.end() && it->second.round > 0;
+  }
+
+  /**
+   * \brief on the leader, publishes `buf` pulled from the servers to the other workers.
+   * On the other workers, copies the value published by the leader into `buf`
+   */
+  void Broadcast(const int key, const NDArray& buf, const int priority) {
+    if (!PullFromLeader(key)) return;
+    Segment& seg = GetSegment(key, buf);
+    const int64_t round = seg.round;
+    if (is_leader()) {
+      Engine::Get()->PushSync([seg, buf, round](RunContext rctx) {
+          std::memcpy(seg.result(), buf.data().dptr_, seg.bytes);
+          seg.ctrl->published.store(round);
+        }, buf.ctx(), {buf.var()}, {}, FnProperty::kNormal, priority, "KVStoreNodeBroadcast");
+    } else {
+      Engine::Get()->PushAsync(
+        [this, seg, buf, round](RunContext rctx, Engine::CallbackOnComplete cb) {
+          Enqueue([seg, round]() {
+              return seg.ctrl->published.load() >= round;
+            }, [seg, buf]() {
+              std::memcpy(buf.data().dptr_, seg.result(), seg.bytes);
+            }, cb);
+        }, buf.ctx(), {}, {buf.var()}, FnProperty::kNormal, priority, "KVStoreNodeBroadcast");
+    }
+  }
+
+ private:
+  static const int kMaxLocalWorkers = 256;
+  static const size_t kHeaderSize = 64;
+
+  struct NodeDirectory {
+    std::atomic<int> count;
+    int ranks[kMaxLocalWorkers];
+  };
+
+  /*! \brief counters at the start of a key's segment, all counting rounds */
+  struct KeyControl {
+    /*! \brief total number of values copied in by the other workers */
+    std::atomic<int64_t> arrived;
+    /*! \brief last round whose slots were summed by the leader */
+    std::atomic<int64_t> reduced;
+    /*! \brief last round whose result was written by the leader */
+    std::atomic<int64_t> published;
+  };
+
+  /*!
+   * \brief shared segment of a key. It holds the counters, then a slot for each
+   * worker other than the leader, then the result slot
+   */
+  struct Segment {
+    KeyControl* ctrl = nullptr;
+    size_t bytes = 0;
+    size_t size = 0;
+    int num_slots = 0;
+    int64_t round = 0;
+    char* slot(int i) const {
+      return reinterpret_cast<char*>(ctrl) + kHeaderSize + bytes * i;
+    }
+    char* result() const {
+      return slot(num_slots - 1);
+    }
+  };
+
+  struct Task {
+    std::function<bool()> ready;
+    std::function<void()> run;
+    Engine::CallbackOnComplete cb;
+  };
+
+  std::string SegmentName(const int key) const {
+    return prefix_ + "_" + std::to_string(key);
+  }
+
+  Segment& GetSegment(const int key, const NDArray& buf) {
+    auto it = segments_.find(key);
+    CHECK(it != segments_.end()) << "Key " << key << " is not initialized in hierarchical kvstore";
+    CHECK_EQ(buf.storage_type(), kDefaultStorage)
+      << "Hierarchical kvstore supports only dense values";
+    CHECK_EQ(buf.shape().Size() * mshadow::mshadow_sizeof(buf.dtype()), it->second.bytes)
+      << "The value size can't be changed. For key " << key;
+    return it->second;
+  }
+
+  void* MapSegment(const std::string& name, const size_t size, const int flags) {
+#ifdef _WIN32
+    return nullptr;
+#else
+    const int fd = shm_open(name.c_str(), flags, 0600);
+    CHECK_NE(fd, -1) << "Failed to open shared memory " << name << ": " << strerror(errno);
+    if (flags & O_CREAT) {
+      CHECK_EQ(ftruncate(fd, size), 0) << "Failed to resize shared memory " << name;
+    }
+    void* ptr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    CHECK_NE(ptr, MAP_FAILED) << "Failed to map shared memory " << name << ": " << strerror(errno);
+    close(fd);
+    return ptr;
+#endif  // _WIN32
+  }
+
+  void Enqueue(std::function<bool()> ready, std::function<void()> run,
+               Engine::CallbackOnComplete cb) {
+    {
+      std::lock_guard<std::mutex> lock(mu_);
+      tasks_.push_back(Task{std::move(ready), std::move(run), cb});
+    }
+    cv_.notify_one();
+  }
+
+  /*! \brief runs tasks as soon as the other processes make them ready */
+  void Poll() {
+    std::list<Task> pending;
+    while (true) {
+      {
+        std::unique_lock<std::mutex> lock(mu_);
+        if (pending.empty()) {
+          cv_.wait(lock, [this]() { return stop_ || !tasks_.empty(); });
+        }
+        if (stop_) break;
+        pending.splice(pending.end(), tasks_);
+      }
+      bool progress = false;
+      for (auto it = pending.begin(); it != pending.end();) {
+        if (it->ready()) {
+          it->run();
+          it->cb();
+          it = pending.erase(it);
+          progress = true;
+        } else {
+          ++it;
+        }
+      }
+      if (!progress) std::this_thread::sleep_for(std::chrono::microseconds(20));
+    }
+  }
+
+  std::function<void()> barrier_;
+  std::string prefix_;
+  int local_rank_ = 0;
+  int local_size_ = 1;
+  std::unordered_map<int, Segment> segments_;
+  std::thread poller_;
+  std::mutex mu_;
+  std::condition_variable cv_;
+  std::list<Task> tasks_;
+  bool stop_ = false;
+};
+
+}  // namespace kvstore
+}  // namespace mxnet
+#endif  // MXNET_KVSTORE_KVSTORE_DIST_NODE_COMM_H_
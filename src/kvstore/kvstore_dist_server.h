@@ -45,7 +45,7 @@ namespace kvstore {
 // maintain same order in frontend.
 enum class CommandType {
   kController, kSetMultiPrecision, kStopServer, kSyncMode,
-  kSetGradientCompression, kSetProfilerParams
+  kSetGradientCompression, kSetProfilerParams, kRegisterNodeLeader
 };
 
 enum class RequestType {
@@ -208,6 +208,10 @@ class KVStoreDistServer {
       case CommandType::kSetGradientCompression:
         gradient_compression_->DecodeParams(recved.body);
         break;
+      case CommandType::kRegisterNodeLeader:
+        // in hierarchical mode only one worker per machine pushes
+        num_sync_workers_++;
+        break;
       case CommandType::kSetProfilerParams:
         // last char is the type of profiler command
         ProcessServerProfilerCommands(static_cast<KVStoreServerProfilerCommand>
@@ -345,7 +349,8 @@ class KVStoreDistServer {
 
   inline void ApplyUpdates(const DataHandleType type, const int key,
                            UpdateBuf *update_buf, ps::KVServer<char>* server) {
-    if (!sync_mode_ || update_buf->request.size() == (size_t) ps::NumWorkers()) {
+    const int num_sync_workers = num_sync_workers_ > 0 ? num_sync_workers_ : ps::NumWorkers();
+    if (!sync_mode_ || update_buf->request.size() == (size_t) num_sync_workers) {
       // let the main thread to execute updater_, which is necessary for python
       auto& stored = has_multi_precision_copy(type) ? store_realt_[key] : store_[key];
       auto& update =  sync_mode_ ? update_buf->merged : update_buf->temp_array;
@@ -642,12 +647,9 @@ class KVStoreDistServer {
         if (merged.merged.is_none()) {
           merged.merged = NDArray(dshape, Context());
         }
-        if (merged.request.size() == 0) {
-          gradient_compression_->Dequantize(recved, &merged.merged, 0);
-        } else {
-          gradient_compression_->Dequantize(recved, &decomp_buf, 0);
-          merged.merged += decomp_buf;
-        }
+        // later pushes are dequantized straight into the merge buffer
+        const bool accumulate = merged.request.size() != 0;
+        gradient_compression_->Dequantize(recved, &merged.merged, 0, accumulate);
         merged.request.push_back(req_meta);
         ApplyUpdates(type, key, &merged, server);
       } else {
@@ -749,6 +751,11 @@ class KVStoreDistServer {
    * \brief user defined mode for push
    */
   bool sync_mode_;
+  /**
+   * \brief number of pushes merged per round in sync mode, set by the node leaders
+   * of hierarchical mode. 0 means every worker pushes
+   */
+  int num_sync_workers_ = 0;
   KVStore::Controller controller_;
   KVStore::Updater updater_;
 
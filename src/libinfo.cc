@@ -92,6 +92,9 @@ class FeatureSet {
     // TVM operators
     feature_bits.set(TVM_OP, MXNET_USE_TVM_OP);
 
+    // JPEG decoding
+    feature_bits.set(LIBJPEG_TURBO, MXNET_USE_LIBJPEG_TURBO);
+
 #ifndef NDEBUG
     feature_bits.set(DEBUG);
 #endif
@@ -163,6 +166,7 @@ const std::vector<std::string> EnumNames::names = {
   "SIGNAL_HANDLER",
   "DEBUG",
   "TVM_OP",
+  "LIBJPEG_TURBO",
 };
 
 }  // namespace features
@@ -31,6 +31,14 @@
 #include <mxnet/resource.h>
 #include <mxnet/imperative.h>
 #include <mshadow/tensor.h>
+#ifndef _WIN32
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#endif  // _WIN32
+#include <cerrno>
+#include <cstring>
 #if MXNET_USE_MKLDNN == 1
 #include <mkldnn.hpp>
 #endif
@@ -1380,6 +1388,7 @@ void ElementwiseSum(const std::vector<NDArray> &source, NDArray *out, int priori
         }
       }, ret.ctx(), const_vars, {ret.var(), rsc.var},
     FnProperty::kNormal, priority, "RowSparseElementwiseSum");
+    ResourceManager::Get()->Release(rsc);
   } else {
     LOG(FATAL) << "Not implemented for storage_type " << common::stype_string(stype);
   }
@@ -1828,6 +1837,206 @@ bool NDArray::Load(dmlc::Stream *strm) {
 
 const uint64_t kMXAPINDArrayListMagic = 0x112;
 
+// Layout of the list written by SaveAligned:
+//   uint64_t magic, version, data_offset, index_size
+//   index of index_size bytes: uint64_t count, for each array
+//     {int32_t type_flag, TShape shape, uint64_t offset, uint64_t nbytes}, then the names
+//   zero padding up to data_offset, which is page aligned
+//   the data of each array at data_offset + offset
+// The first two words match the header of the kMXAPINDArrayListMagic list.
+const uint64_t kMXAPINDArrayListAlignedMagic = 0x113;
+const uint64_t kAlignedListVersion = 1;
+const uint64_t kAlignedListPageSize = 4096;
+const uint64_t kAlignedListArrayAlignment = 64;
+
+struct AlignedListEntry {
+  /*! \brief -1 for an empty NDArray */
+  int32_t type_flag;
+  mxnet::TShape shape;
+  /*! \brief offset of the data relative to data_offset */
+  uint64_t offset;
+  uint64_t nbytes;
+};
+
+static inline uint64_t AlignedListRoundUp(uint64_t x, uint64_t alignment) {
+  return (x + alignment - 1) / alignment * alignment;
+}
+
+static void WriteAlignedListPadding(dmlc::Stream* fo, uint64_t nbytes) {
+  static const char zeros[kAlignedListPageSize] = {0};
+  while (nbytes > 0) {
+    const uint64_t n = std::min(nbytes, kAlignedListPageSize);
+    fo->Write(zeros, n);
+    nbytes -= n;
+  }
+}
+
+static void SkipAlignedListPadding(dmlc::Stream* fi, uint64_t nbytes) {
+  char buf[kAlignedListPageSize];
+  while (nbytes > 0) {
+    const uint64_t n = std::min(nbytes, kAlignedListPageSize);
+    CHECK_EQ(fi->Read(buf, n), n) << "Invalid NDArray file format";
+    nbytes -= n;
+  }
+}
+
+static void ReadAlignedListIndex(void* index, uint64_t index_size,
+                                 std::vector<AlignedListEntry>* entries,
+                                 std::vector<std::string>* keys) {
+  dmlc::MemoryFixedSizeStream strm(index, index_size);
+  uint64_t count;
+  CHECK(strm.Read(&count)) << "Invalid NDArray file format";
+  entries->resize(count);
+  for (AlignedListEntry& e : *entries) {
+    CHECK(strm.Read(&e.type_flag) && e.shape.Load(&strm) &&
+          strm.Read(&e.offset) && strm.Read(&e.nbytes))
+        << "Invalid NDArray file format";
+    if (e.type_flag >= 0) {
+      CHECK_EQ(e.nbytes, e.shape.Size() * mshadow::mshadow_sizeof(e.type_flag))
+          << "Invalid NDArray file format";
+    }
+  }
+  CHECK(strm.Read(keys)) << "Invalid NDArray file format";
+  CHECK(keys->size() == 0 || keys->size() == entries->size())
+      << "Invalid NDArray file format";
+}
+
+void NDArray::SaveAligned(dmlc::Stream* fo,
+                          const std::vector<NDArray>& data,
+                          const std::vector<std::string>& names) {
+  std::vector<NDArray> cpu_data(data.size());
+  std::vector<AlignedListEntry> entries(data.size());
+  uint64_t offset = 0;
+  for (size_t i = 0; i < data.size(); ++i) {
+    AlignedListEntry& e = entries[i];
+    e.offset = offset;
+    e.nbytes = 0;
+    if (data[i].is_none()) {
+      e.type_flag = -1;
+      continue;
+    }
+    CHECK_EQ(data[i].storage_type(), kDefaultStorage)
+        << "Only default storage NDArrays can be saved in the aligned format";
+    NDArray nd_cpu = data[i].ctx().dev_mask() == cpu::kDevMask ?
+                     data[i] : data[i].Copy(Context::CPU());
+    nd_cpu.WaitToRead();
+#if MXNET_USE_MKLDNN == 1
+    if (nd_cpu.IsMKLDNNData())
+      nd_cpu = nd_cpu.Reorder2Default();
+#endif
+    cpu_data[i] = nd_cpu;
+    e.type_flag = nd_cpu.dtype();
+    e.shape = nd_cpu.shape();
+    e.nbytes = e.shape.Size() * mshadow::mshadow_sizeof(e.type_flag);
+    offset = AlignedListRoundUp(offset + e.nbytes, kAlignedListArrayAlignment);
+  }
+  std::string index;
+  {
+    dmlc::MemoryStringStream strm(&index);
+    const uint64_t count = entries.size();
+    strm.Write(count);
+    for (const AlignedListEntry& e : entries) {
+      strm.Write(e.type_flag);
+      e.shape.Save(&strm);
+      strm.Write(e.offset);
+      strm.Write(e.nbytes);
+    }
+    strm.Write(names);
+  }
+  uint64_t header[4] = {kMXAPINDArrayListAlignedMagic, kAlignedListVersion, 0, index.size()};
+  header[2] = AlignedListRoundUp(sizeof(header) + index.size(), kAlignedListPageSize);
+  fo->Write(header, sizeof(header));
+  fo->Write(index.data(), index.size());
+  WriteAlignedListPadding(fo, header[2] - sizeof(header) - index.size());
+  uint64_t pos = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const AlignedListEntry& e = entries[i];
+    if (e.nbytes == 0) continue;
+    WriteAlignedListPadding(fo, e.offset - pos);
+    const TBlob blob = cpu_data[i].data();
+    CHECK(blob.CheckContiguous());
+    fo->Write(blob.dptr_, e.nbytes);
+    pos = e.offset + e.nbytes;
+  }
+}
+
+/*! \brief reads the rest of an aligned list after its first two header words */
+static void LoadAlignedList(dmlc::Stream* fi,
+                            std::vector<NDArray>* data,
+                            std::vector<std::string>* keys) {
+  uint64_t data_offset, index_size;
+  CHECK(fi->Read(&data_offset) && fi->Read(&index_size))
+      << "Invalid NDArray file format";
+  const uint64_t header_size = 4 * sizeof(uint64_t);
+  CHECK_LE(header_size + index_size, data_offset) << "Invalid NDArray file format";
+  std::string index(index_size, '\0');
+  CHECK_EQ(fi->Read(&index[0], index_size), index_size) << "Invalid NDArray file format";
+  std::vector<AlignedListEntry> entries;
+  ReadAlignedListIndex(&index[0], index_size, &entries, keys);
+  SkipAlignedListPadding(fi, data_offset - header_size - index_size);
+  data->resize(entries.size());
+  uint64_t pos = 0;
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const AlignedListEntry& e = entries[i];
+    if (e.type_flag < 0) {
+      (*data)[i] = NDArray();
+      continue;
+    }
+    CHECK_GE(e.offset, pos) << "Invalid NDArray file format";
+    SkipAlignedListPadding(fi, e.offset - pos);
+    NDArray arr(e.shape, Context::CPU(), false, e.type_flag);
+    CHECK_EQ(fi->Read(arr.data().dptr_, e.nbytes), e.nbytes) << "Invalid NDArray file format";
+    (*data)[i] = arr;
+    pos = e.offset + e.nbytes;
+  }
+}
+
+bool NDArray::LoadMapped(const std::string& fname,
+                         std::vector<NDArray>* data,
+                         std::vector<std::string>* keys) {
+#ifdef _WIN32
+  return false;
+#else
+  // anything that is not a local file is left to dmlc::Stream
+  const int fd = open(fname.c_str(), O_RDONLY);
+  if (fd < 0) return false;
+  struct stat st;
+  uint64_t header[4];
+  if (fstat(fd, &st) != 0 ||
+      pread(fd, header, sizeof(header), 0) != static_cast<ssize_t>(sizeof(header)) ||
+      header[0] != kMXAPINDArrayListAlignedMagic) {
+    close(fd);
+    return false;
+  }
+  CHECK_EQ(header[1], kAlignedListVersion) << "Unsupported aligned NDArray file version";
+  const uint64_t size = st.st_size;
+  const uint64_t data_offset = header[2], index_size = header[3];
+  CHECK(sizeof(header) + index_size <= data_offset && data_offset <= size)
+      << "Invalid NDArray file format";
+  // private writable mapping: pages stay shared with the page cache until written
+  void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+  close(fd);
+  CHECK_NE(addr, MAP_FAILED) << "Failed to map " << fname << ": " << strerror(errno);
+  std::shared_ptr<void> mapping(addr, [size](void* p) { munmap(p, size); });
+  char* base = static_cast<char*>(addr);
+  std::vector<AlignedListEntry> entries;
+  ReadAlignedListIndex(base + sizeof(header), index_size, &entries, keys);
+  data->resize(entries.size());
+  for (size_t i = 0; i < entries.size(); ++i) {
+    const AlignedListEntry& e = entries[i];
+    if (e.type_flag < 0) {
+      (*data)[i] = NDArray();
+      continue;
+    }
+    CHECK_LE(data_offset + e.offset + e.nbytes, size) << "Invalid NDArray file format";
+    TBlob blob(base + data_offset + e.offset, e.shape, cpu::kDevMask, e.type_flag, 0);
+    // every array keeps the mapping alive
+    (*data)[i] = NDArray(blob, 0, [mapping]() {});
+  }
+  return true;
+#endif  // _WIN32
+}
+
 void NDArray::Save(dmlc::Stream* fo,
                    const std::vector<NDArray>& data,
                    const std::vector<std::string>& names) {
@@ -1846,6 +2055,11 @@ void NDArray::Load(dmlc::Stream* fi,
       << "Invalid NDArray file format";
   CHECK(fi->Read(&reserved))
       << "Invalid NDArray file format";
+  if (header == kMXAPINDArrayListAlignedMagic) {
+    CHECK_EQ(reserved, kAlignedListVersion) << "Unsupported aligned NDArray file version";
+    LoadAlignedList(fi, data, keys);
+    return;
+  }
   CHECK(header == kMXAPINDArrayListMagic)
       << "Invalid NDArray file format";
   CHECK(fi->Read(data))
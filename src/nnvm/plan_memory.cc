@@ -28,7 +28,13 @@
 #include <nnvm/op_attr_types.h>
 #include <nnvm/top/tensor.h>
 #include <mxnet/base.h>
+#include <algorithm>
+#include <limits>
+#include <map>
 #include <memory>
+#include <string>
+#include <utility>
+#include <vector>
 #include "graph_algorithm.h"
 #include "../operator/operator_common.h"
 
@@ -73,10 +79,18 @@ class GraphAllocator {
   static const StorageID kExternalStorageID = -2;
   // dynamic storage id
   static const StorageID kDynamicStorageID = -3;
+  // alignment of storage offsets inside an arena
+  static const size_t kArenaAlignment = 256;
 
   // request a free storage
   StorageID Request(int dev_id, int dtype, mxnet::TShape shape, uint32_t node_id) {
     if (!mxnet::shape_is_known(shape)) return kBadStorageID;
+    if (arena_) {
+      // every request gets its own storage, sharing is decided by PlanArena
+      StorageID id = this->Alloc(dev_id, shape.Size() * GetDTypeSize(dtype));
+      data_[id]->alloc_node = node_id;
+      return id;
+    }
     // search memory block in [size / match_range_, size * match_range_)
     // TODO(tqchen) add size of the dtype, assume 4 bytes for now
     size_t size = shape.Size() * 4;
@@ -118,9 +132,63 @@ class GraphAllocator {
     if (id == kExternalStorageID || id == kDynamicStorageID) return;
     StorageEntry *e = data_[id].get();
     e->released_by_node = node_id;
-    free_.insert({e->max_bytes, e});
+    e->released = true;
+    if (!arena_) free_.insert({e->max_bytes, e});
   }
 
+  /*!
+   * \brief Assign each storage an offset inside one arena per device.
+   *
+   * The lifetime of a storage is the range of nodes from its request to its
+   * release, storage that is never released lives until the end of the graph.
+   * Storage is placed in order of decreasing size at the lowest aligned offset
+   * that does not overlap any already placed storage with an overlapping
+   * lifetime (first-fit-decreasing).
+   *
+   * \param offsets the offset of each storage id in the arena of its device.
+   * \return the sum of the arena sizes of all devices, i.e. the planned peak.
+   */
+  size_t PlanArena(std::vector<size_t>* offsets) const {
+    const uint32_t kNeverReleased = std::numeric_limits<uint32_t>::max();
+    auto aligned = [](size_t bytes) {
+      return (bytes + kArenaAlignment - 1) / kArenaAlignment * kArenaAlignment;
+    };
+    auto end_node = [kNeverReleased](const StorageEntry* e) {
+      return e->released ? e->released_by_node : kNeverReleased;
+    };
+    std::vector<const StorageEntry*> order;
+    for (auto &p : data_) order.push_back(p.get());
+    std::stable_sort(order.begin(), order.end(),
+                     [](const StorageEntry* a, const StorageEntry* b) {
+                       return a->max_bytes > b->max_bytes;
+                     });
+    offsets->assign(data_.size(), 0);
+    std::map<int, size_t> arena_bytes;
+    std::vector<const StorageEntry*> placed;
+    std::vector<std::pair<size_t, size_t> > conflicts;
+    for (const StorageEntry* e : order) {
+      const size_t size = aligned(e->max_bytes);
+      conflicts.clear();
+      for (const StorageEntry* other : placed) {
+        if (other->device_id != e->device_id) continue;
+        if (other->alloc_node > end_node(e) || e->alloc_node > end_node(other)) continue;
+        const size_t begin = offsets->at(other->id);
+        conflicts.emplace_back(begin, begin + aligned(other->max_bytes));
+      }
+      std::sort(conflicts.begin(), conflicts.end());
+      size_t offset = 0;
+      for (const auto& c : conflicts) {
+        if (offset + size <= c.first) break;
+        offset = std::max(offset, c.second);
+      }
+      offsets->at(e->id) = offset;
+      arena_bytes[e->device_id] = std::max(arena_bytes[e->device_id], offset + size);
+      placed.push_back(e);
+    }
+    size_t total = 0;
+    for (const auto& kv : arena_bytes) total += kv.second;
+    return total;
+  }
   // totoal number of bytes allocated
   size_t TotalAllocBytes() const {
     size_t total = 0;
@@ -131,8 +199,9 @@ class GraphAllocator {
   }
 
   // constructor
-  explicit GraphAllocator(const IndexedGraph* idx, const size_t match_range) : idx_(idx) {
-    this->Init(match_range, dmlc::GetEnv("NNVM_EXEC_NUM_TEMP", 1));
+  explicit GraphAllocator(const IndexedGraph* idx, const size_t match_range,
+                          const bool arena = false) : idx_(idx), arena_(arena) {
+    this->Init(match_range, arena ? 1 : dmlc::GetEnv("NNVM_EXEC_NUM_TEMP", 1));
   }
 
  private:
@@ -170,6 +239,10 @@ class GraphAllocator {
     size_t max_bytes{0};
     // node index that released it last time
     uint32_t released_by_node{0};
+    // node index that requested it, only tracked in arena mode
+    uint32_t alloc_node{0};
+    // whether it has been released at least once
+    bool released{false};
   };
   // scale used for rough match
   size_t match_range_;
@@ -185,8 +258,30 @@ class GraphAllocator {
   std::vector<uint32_t> node_color_;
   // internal indexed graph
   const IndexedGraph* idx_;
+  // whether storage is packed into an arena instead of reused greedily
+  const bool arena_;
 };
 
+// Whether the memory plan should be packed into one arena per device,
+// selected by MXNET_MEM_PLAN_TYPE. Read on every plan so that it can be changed at runtime.
+bool UseArenaPlan() {
+  const std::string type = dmlc::GetEnv("MXNET_MEM_PLAN_TYPE", std::string("Greedy"));
+  if (type == "Greedy") return false;
+  CHECK_EQ(type, "Arena") << "Unknown memory plan type specified: " << type << ".";
+#if MXNET_USE_MKLDNN == 1
+  // MKLDNN memory is bound to the start of a chunk, it cannot live at an arena offset
+  static bool warned = false;
+  if (!warned) {
+    LOG(WARNING) << "MXNET_MEM_PLAN_TYPE=Arena is not supported with MKLDNN, "
+                 << "falling back to Greedy.";
+    warned = true;
+  }
+  return false;
+#else
+  return true;
+#endif  // MXNET_USE_MKLDNN == 1
+}
+
 /*
  * Internal method to perform the memory allocation for a graph
  * */
@@ -369,6 +464,23 @@ Graph PlanMemory(Graph ret) {
     storage.resize(idx.num_node_entries(), -1);
   }
 
+  if (UseArenaPlan()) {
+    std::vector<int> storage_inplace_index(idx.num_node_entries(), -1);
+    GraphAllocator allocator(&idx, 0, true);
+    size_t storage_num_not_allocated =
+      AllocMemory(ret, idx, node_range, &storage, &storage_inplace_index,
+                  ref_count, &allocator);
+    std::vector<size_t> storage_offset;
+    size_t storage_arena_bytes = allocator.PlanArena(&storage_offset);
+    ret.attrs["storage_id"] = std::make_shared<any>(std::move(storage));
+    ret.attrs["storage_inplace_index"] = std::make_shared<any>(std::move(storage_inplace_index));
+    ret.attrs["storage_allocated_bytes"] = std::make_shared<any>(allocator.TotalAllocBytes());
+    ret.attrs["storage_num_not_allocated"] = std::make_shared<any>(storage_num_not_allocated);
+    ret.attrs["storage_offset"] = std::make_shared<any>(std::move(storage_offset));
+    ret.attrs["storage_arena_bytes"] = std::make_shared<any>(storage_arena_bytes);
+    return ret;
+  }
+
   // Search the best NNVM_EXEC_MATCH_RANGE parameter. This is turned off by default
   size_t min_allocated_bytes = -1;
   size_t max_match_range = dmlc::GetEnv("NNVM_EXEC_MATCH_RANGE", 16);
@@ -32,12 +32,14 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
 #include <vector>
 #include <cmath>
 #include "../operator_common.h"
 #include "../mshadow_op.h"
 #include "../elemwise_op_common.h"
 #include "../mxnet_op.h"
+#include "../optimizer_op-inl.h"
 
 namespace mxnet {
 namespace op {
@@ -77,6 +79,50 @@ struct AdamWParam : public dmlc::Parameter<AdamWParam> {
   }
 };
 
+struct MultiAdamWParam : public dmlc::Parameter<MultiAdamWParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  mxnet::Tuple<float> etas;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float clip_gradient;
+  float clip_global_norm;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdamWParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(etas)
+    .describe("Learning rate schedule multipliers");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_global_norm)
+    .set_default(-1.0f)
+    .describe("If positive, all the gradients are scaled by "
+              "min(1, clip_global_norm / norm), where norm is the L2 norm of "
+              "rescale_grad*grad over all the updated weights.");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
 // rescale_grad is a reserved argument at position -1. Example:
 // n_in = 2: weight, grad (fp16)
 // n_out = 1: weight (fp16)
@@ -211,6 +257,124 @@ struct AdamWUpdate {
   }
 };
 
+// rescale_grad is a reserved argument at position -1, after the groups of
+// input_stride inputs of every weight.
+template<int input_stride>
+inline bool MultiAdamWInferShape(const nnvm::NodeAttrs& attrs,
+                                 mxnet::ShapeVector *in_attrs,
+                                 mxnet::ShapeVector *out_attrs) {
+  const MultiAdamWParam& param = dmlc::get<MultiAdamWParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights + 1)
+    << " in operator " << attrs.name;
+  CHECK_EQ(param.etas.ndim(), param.num_weights)
+    << "Number of learning rate schedule multipliers is inconsistent with num_weights "
+    << "parameter passed. Expected number of multipliers: "
+    << param.num_weights << ", and got " << param.etas.ndim();
+  // rescale_grad.shape = ()
+  SHAPE_ASSIGN_CHECK(*in_attrs, in_attrs->size() - 1, mxnet::TShape());
+  mxnet::ShapeVector weight_attrs(in_attrs->begin(), in_attrs->end() - 1);
+  const bool all_inferred =
+    MultiSGDShape<MultiAdamWParam, input_stride>(attrs, &weight_attrs, out_attrs);
+  std::copy(weight_attrs.begin(), weight_attrs.end(), in_attrs->begin());
+  return all_inferred;
+}
+
+template<int input_stride, int num_fp32_inputs>
+inline bool MultiAdamWInferType(const nnvm::NodeAttrs& attrs,
+                                std::vector<int> *in_attrs,
+                                std::vector<int> *out_attrs) {
+  const MultiAdamWParam& param = dmlc::get<MultiAdamWParam>(attrs.parsed);
+  CHECK_EQ(in_attrs->size(), input_stride * param.num_weights + 1)
+    << " in operator " << attrs.name;
+  TYPE_ASSIGN_CHECK(*in_attrs, in_attrs->size() - 1, mshadow::kFloat32);
+  std::vector<int> weight_attrs(in_attrs->begin(), in_attrs->end() - 1);
+  const bool all_inferred = num_fp32_inputs > 0 ?
+    MP_MultiSGD_InferType<MultiAdamWParam, input_stride, num_fp32_inputs>(
+      attrs, &weight_attrs, out_attrs) :
+    ElemwiseType<-1, -1>(attrs, &weight_attrs, out_attrs);
+  std::copy(weight_attrs.begin(), weight_attrs.end(), in_attrs->begin());
+  return all_inferred;
+}
+
+/*!
+ * \brief Arguments of the fused adam_w update, with the learning rate schedule multipliers
+ */
+template<typename DType, typename MPDType>
+struct MultiAdamWKernelParam : public MultiUpdateKernelParam<DType, MPDType> {
+  MPDType etas[MultiUpdateKernelParam<DType, MPDType>::N];
+};
+
+template <bool has_mixed_precision>
+struct MultiAdamWKernel {
+  typedef MultiAdamWParam ParamType;
+  template<typename DType, typename MPDType>
+  using KernelParam = MultiAdamWKernelParam<DType, MPDType>;
+  static const int kNumStates = 2;
+
+  template<typename DType, typename MPDType>
+  static void SetParam(const ParamType& p, MultiAdamWKernelParam<DType, MPDType>* param) {
+    param->beta1 = p.beta1;
+    param->beta2 = p.beta2;
+    param->epsilon = p.epsilon;
+    for (int i = 0; i < param->count; ++i) {
+      param->etas[i] = p.etas[i];
+    }
+  }
+
+  template<typename DType, typename MPDType>
+  MSHADOW_XINLINE static void Map(size_t i, int index,
+                                  const MultiAdamWKernelParam<DType, MPDType>& param,
+                                  const MPDType scale, const OpReqType req) {
+    MPDType w = has_mixed_precision ? param.weights32[index][i] :
+                                      MPDType(param.weights[index][i]);
+    MPDType grad = scale * param.rescale_grad * static_cast<MPDType>(param.grads[index][i]);
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    const MPDType mean = param.beta1 * param.states0[index][i] + (1 - param.beta1) * grad;
+    const MPDType var = param.beta2 * param.states1[index][i] +
+                        (1 - param.beta2) * mshadow_op::square::Map(grad);
+    param.states0[index][i] = mean;
+    param.states1[index][i] = var;
+    w = w - param.etas[index] * (param.lrs[index] * mean /
+                                 (mshadow_op::square_root::Map(var) + param.epsilon)
+                                 + param.wds[index] * w);
+    if (has_mixed_precision) {
+      param.weights32[index][i] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[index][i], req, w);
+  }
+};
+
+/*
+ * \brief adam_w update of multiple weights at once.
+ */
+template<typename xpu>
+struct MultiAdamWUpdate {
+  static inline void Forward(const nnvm::NodeAttrs& attrs,
+                             const OpContext &ctx,
+                             const std::vector<TBlob> &inputs,
+                             const std::vector<OpReqType> &req,
+                             const std::vector<TBlob> &outputs,
+                             const float rescale_grad) {
+    MultiUpdateImpl<xpu, MultiAdamWKernel, type_identity, 4>(
+      attrs, ctx, inputs, req, outputs, rescale_grad);
+  }
+};
+
+template<typename xpu>
+struct MultiMPAdamWUpdate {
+  static inline void Forward(const nnvm::NodeAttrs& attrs,
+                             const OpContext &ctx,
+                             const std::vector<TBlob> &inputs,
+                             const std::vector<OpReqType> &req,
+                             const std::vector<TBlob> &outputs,
+                             const float rescale_grad) {
+    MultiUpdateImpl<xpu, MultiAdamWKernel, single_precision, 5>(
+      attrs, ctx, inputs, req, outputs, rescale_grad);
+  }
+};
+
 }  // namespace op
 }  // namespace mxnet
 
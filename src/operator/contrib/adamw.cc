@@ -30,6 +30,7 @@ namespace mxnet {
 namespace op {
 
 DMLC_REGISTER_PARAMETER(AdamWParam);
+DMLC_REGISTER_PARAMETER(MultiAdamWParam);
 
 template<template <typename xpu> class F>
 inline void MPUpdateCPU(const nnvm::NodeAttrs& attrs,
@@ -137,5 +138,74 @@ the update is skipped.
               "the update is skipped.")
 .add_arguments(AdamWParam::__FIELDS__());
 
+NNVM_REGISTER_OP(_multi_adamw_update)
+.describe(R"code(Update function for AdamW optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see ``_adamw_update`` for the update
+of each weight. The inputs are grouped per weight as weight, grad, mean and var,
+followed by rescale_grad.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+If rescale_grad is NaN, Inf, or 0, the update is skipped.
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiAdamWParam, 4, 1>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiAdamWParam>)
+.set_attr_parser(ParamParser<MultiAdamWParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiAdamWInferShape<4>)
+.set_attr<nnvm::FInferType>("FInferType", MultiAdamWInferType<4, 0>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    std::vector<std::string> ret =
+      MultiUpdateInputNames(dmlc::get<MultiAdamWParam>(attrs.parsed).num_weights,
+                            {"weight_", "grad_", "mean_", "var_"});
+    ret.push_back("rescale_grad");
+    return ret;
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiAdamWParam, 4>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MPUpdateCPU<MultiAdamWUpdate>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means and variances, "
+              "followed by rescale_grad")
+.add_arguments(MultiAdamWParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_multi_mp_adamw_update)
+.describe(R"code(Update function for multi-precision AdamW optimizer, for multiple weights
+at once.
+
+All the weights are updated in a single operator, see ``_mp_adamw_update`` for the update
+of each weight. The inputs are grouped per weight as weight, grad, mean, var and the
+float32 copy of the weight, followed by rescale_grad.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+If rescale_grad is NaN, Inf, or 0, the update is skipped.
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiAdamWParam, 5, 1>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiAdamWParam>)
+.set_attr_parser(ParamParser<MultiAdamWParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiAdamWInferShape<5>)
+.set_attr<nnvm::FInferType>("FInferType", MultiAdamWInferType<5, 3>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    std::vector<std::string> ret =
+      MultiUpdateInputNames(dmlc::get<MultiAdamWParam>(attrs.parsed).num_weights,
+                            {"weight_", "grad_", "mean_", "var_", "weight32_"});
+    ret.push_back("rescale_grad");
+    return ret;
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiAdamWParam, 5>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MPUpdateCPU<MultiMPAdamWUpdate>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means, variances and "
+              "float32 weights, followed by rescale_grad")
+.add_arguments(MultiAdamWParam::__FIELDS__());
+
 }  // namespace op
 }  // namespace mxnet
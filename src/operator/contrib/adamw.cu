@@ -56,5 +56,11 @@ NNVM_REGISTER_OP(_adamw_update)
 NNVM_REGISTER_OP(_mp_adamw_update)
 .set_attr<FCompute>("FCompute<gpu>", MPUpdateGPU<MPAdamWUpdate>);
 
+NNVM_REGISTER_OP(_multi_adamw_update)
+.set_attr<FCompute>("FCompute<gpu>", MPUpdateGPU<MultiAdamWUpdate>);
+
+NNVM_REGISTER_OP(_multi_mp_adamw_update)
+.set_attr<FCompute>("FCompute<gpu>", MPUpdateGPU<MultiMPAdamWUpdate>);
+
 }  // namespace op
 }  // namespace mxnet
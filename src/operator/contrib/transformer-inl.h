@@ -25,6 +25,8 @@
 #ifndef MXNET_OPERATOR_CONTRIB_TRANSFORMER_INL_H_
 #define MXNET_OPERATOR_CONTRIB_TRANSFORMER_INL_H_
 
+#include <dmlc/optional.h>
+#include <dmlc/parameter.h>
 #include <mxnet/operator_util.h>
 #include <vector>
 #include "../mxnet_op.h"
@@ -34,6 +36,32 @@
 namespace mxnet {
 namespace op {
 
+namespace selfatt {
+enum InterleavedSelfAttOutputs {kOut, kLogSumExp};
+}  // namespace selfatt
+
+struct InterleavedSelfAttParam : public dmlc::Parameter<InterleavedSelfAttParam> {
+  int heads;
+  dmlc::optional<float> scale;
+  bool use_mask;
+  bool use_valid_length;
+  DMLC_DECLARE_PARAMETER(InterleavedSelfAttParam) {
+    DMLC_DECLARE_FIELD(heads)
+      .describe("Number of attention heads.");
+    DMLC_DECLARE_FIELD(scale)
+      .set_default(dmlc::optional<float>())
+      .describe("Scale of the query-key products. Defaults to 1 / sqrt(head dimension).");
+    DMLC_DECLARE_FIELD(use_mask)
+      .set_default(false)
+      .describe("Whether to add the mask input of shape (batch_size, seq_length, seq_length) "
+                "to the scaled query-key products before the softmax.");
+    DMLC_DECLARE_FIELD(use_valid_length)
+      .set_default(false)
+      .describe("Whether to ignore the keys at or after the valid_length input of shape "
+                "(batch_size,).");
+  }
+};
+
 template<typename xpu>
 static void DivSqrtDimForward_(const nnvm::NodeAttrs& attrs,
                   const OpContext& ctx,
@@ -23,12 +23,20 @@
  * \brief CPU implementation of the operators used in Transformer
  */
 #include <mxnet/base.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <string>
+#include <type_traits>
 #include "./transformer-inl.h"
+#include "../elemwise_op_common.h"
 #include "../tensor/elemwise_unary_op.h"
 
 namespace mxnet {
 namespace op {
 
+DMLC_REGISTER_PARAMETER(InterleavedSelfAttParam);
+
 // relu
 MXNET_OPERATOR_REGISTER_UNARY(_contrib_div_sqrt_dim)
 .describe(R"code(Rescale the input by the square root of the channel dimension.
@@ -39,5 +47,486 @@ MXNET_OPERATOR_REGISTER_UNARY(_contrib_div_sqrt_dim)
 .set_attr<FCompute>("FCompute<cpu>", DivSqrtDimForward_<cpu>)
 .set_attr<nnvm::FGradient>("FGradient", ElemwiseGradUseNone{"_contrib_div_sqrt_dim"});
 
+/* Fused self-attention on an interleaved query/key/value projection.
+ *
+ * queries_keys_values has shape (seq_length, batch_size, heads * 3 * head_dim), where the
+ * projections of each head are stored as [query, key, value] next to each other. For each batch
+ * and head, a thread copies the keys and values into contiguous buffers and walks the queries in
+ * blocks of kSelfAttQueryBlock. The scores of a query block are computed a block of
+ * kSelfAttKeyBlock keys at a time, so the keys stay in L1 while they are reused by the queries,
+ * and never leave the buffers of the thread: the (batch, heads, seq, seq) scores and attention
+ * weights are not materialized. The forward pass keeps the log-sum-exp of each softmax row, from
+ * which the backward pass recomputes the attention weights.
+ */
+const index_t kSelfAttQueryBlock = 32;
+const index_t kSelfAttKeyBlock = 64;
+
+inline int SelfAttNumInputs(const InterleavedSelfAttParam& param) {
+  return 1 + param.use_mask + param.use_valid_length;
+}
+
+template<typename AType>
+inline AType SelfAttDot(const AType* __restrict__ a, const AType* __restrict__ b,
+                        const index_t n) {
+  AType sum = 0;
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum)
+#endif
+  for (index_t i = 0; i < n; ++i) {
+    sum += a[i] * b[i];
+  }
+  return sum;
+}
+
+template<typename AType>
+inline void SelfAttAxpy(const AType alpha, const AType* __restrict__ x, AType* __restrict__ y,
+                        const index_t n) {
+#if !defined(_MSC_VER)
+#pragma omp simd
+#endif
+  for (index_t i = 0; i < n; ++i) {
+    y[i] += alpha * x[i];
+  }
+}
+
+template<typename DType, typename AType>
+inline void SelfAttLoad(const DType* __restrict__ src, const AType scale, AType* __restrict__ dst,
+                        const index_t n) {
+  for (index_t i = 0; i < n; ++i) {
+    dst[i] = static_cast<AType>(src[i]) * scale;
+  }
+}
+
+template<typename DType, typename AType>
+inline void SelfAttStore(const AType* __restrict__ src, const AType scale, const OpReqType req,
+                         DType* __restrict__ dst, const index_t n) {
+  if (req == kAddTo) {
+    for (index_t i = 0; i < n; ++i) {
+      dst[i] = static_cast<DType>(static_cast<AType>(dst[i]) + src[i] * scale);
+    }
+  } else {
+    for (index_t i = 0; i < n; ++i) {
+      dst[i] = static_cast<DType>(src[i] * scale);
+    }
+  }
+}
+
+/*! \brief Layout of the interleaved projection and the buffers of one (batch, head) task */
+struct SelfAttLayout {
+  index_t seq_length;
+  index_t batch_size;
+  index_t heads;
+  index_t head_dim;
+  /*! \brief Offset of the query of a position, batch and head in queries_keys_values */
+  index_t QueryOffset(const index_t pos, const index_t b, const index_t h) const {
+    return ((pos * batch_size + b) * heads + h) * 3 * head_dim;
+  }
+  /*! \brief Offset of a position, batch and head in the output */
+  index_t OutOffset(const index_t pos, const index_t b, const index_t h) const {
+    return ((pos * batch_size + b) * heads + h) * head_dim;
+  }
+};
+
+/* Scaled scores of the query block [i0, i0 + nq) against the first kv_len keys, plus the mask */
+template<typename DType, typename AType>
+inline void SelfAttScores(const SelfAttLayout& l, const index_t b, const index_t i0,
+                          const index_t nq, const index_t kv_len, const AType* q_buf,
+                          const AType* k_buf, const DType* mask, AType* score_buf) {
+  const index_t D = l.head_dim;
+  const index_t S = l.seq_length;
+  for (index_t j0 = 0; j0 < kv_len; j0 += kSelfAttKeyBlock) {
+    const index_t j1 = std::min(j0 + kSelfAttKeyBlock, kv_len);
+    for (index_t i = 0; i < nq; ++i) {
+      AType* scores = score_buf + i * S;
+      for (index_t j = j0; j < j1; ++j) {
+        scores[j] = SelfAttDot(q_buf + i * D, k_buf + j * D, D);
+      }
+      if (mask) {
+        const DType* mask_row = mask + (b * S + i0 + i) * S;
+        for (index_t j = j0; j < j1; ++j) {
+          scores[j] += static_cast<AType>(mask_row[j]);
+        }
+      }
+    }
+  }
+}
+
+template<typename DType, typename AType>
+void InterleavedSelfAttForwardCPU(const SelfAttLayout& l, const AType scale,
+                                  const DType* qkv, const DType* mask,
+                                  const index_t* valid_length, DType* out, AType* lse,
+                                  const OpReqType req, AType* workspace,
+                                  const size_t workspace_per_thread, const int omp_threads) {
+  const index_t S = l.seq_length;
+  const index_t D = l.head_dim;
+  const index_t ntasks = l.batch_size * l.heads;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t task = 0; task < ntasks; ++task) {
+    const index_t b = task / l.heads;
+    const index_t h = task % l.heads;
+    AType* k_buf = workspace + workspace_per_thread * omp_get_thread_num();
+    AType* v_buf = k_buf + S * D;
+    AType* q_buf = v_buf + S * D;
+    AType* o_buf = q_buf + kSelfAttQueryBlock * D;
+    AType* score_buf = o_buf + kSelfAttQueryBlock * D;
+    const index_t kv_len = valid_length ? std::max<index_t>(std::min(valid_length[b], S), 0) : S;
+    for (index_t j = 0; j < kv_len; ++j) {
+      const DType* src = qkv + l.QueryOffset(j, b, h);
+      SelfAttLoad(src + D, AType(1), k_buf + j * D, D);
+      SelfAttLoad(src + 2 * D, AType(1), v_buf + j * D, D);
+    }
+    for (index_t i0 = 0; i0 < S; i0 += kSelfAttQueryBlock) {
+      const index_t nq = std::min(kSelfAttQueryBlock, S - i0);
+      for (index_t i = 0; i < nq; ++i) {
+        SelfAttLoad(qkv + l.QueryOffset(i0 + i, b, h), scale, q_buf + i * D, D);
+      }
+      SelfAttScores(l, b, i0, nq, kv_len, q_buf, k_buf, mask, score_buf);
+      std::fill(o_buf, o_buf + nq * D, AType(0));
+      for (index_t i = 0; i < nq; ++i) {
+        AType* scores = score_buf + i * S;
+        AType* o = o_buf + i * D;
+        AType row_max = -std::numeric_limits<AType>::infinity();
+        for (index_t j = 0; j < kv_len; ++j) {
+          row_max = std::max(row_max, scores[j]);
+        }
+        AType* row_lse = lse + task * S + i0 + i;
+        if (row_max == -std::numeric_limits<AType>::infinity()) {
+          // Every key is masked: zero output, and zero attention weights in the backward pass
+          *row_lse = std::numeric_limits<AType>::infinity();
+          continue;
+        }
+        AType sum = 0;
+        for (index_t j = 0; j < kv_len; ++j) {
+          scores[j] = std::exp(scores[j] - row_max);
+          sum += scores[j];
+        }
+        for (index_t j = 0; j < kv_len; ++j) {
+          SelfAttAxpy(scores[j], v_buf + j * D, o, D);
+        }
+        const AType inv_sum = AType(1) / sum;
+        for (index_t d = 0; d < D; ++d) {
+          o[d] *= inv_sum;
+        }
+        *row_lse = row_max + std::log(sum);
+      }
+      for (index_t i = 0; i < nq; ++i) {
+        SelfAttStore(o_buf + i * D, AType(1), req, out + l.OutOffset(i0 + i, b, h), D);
+      }
+    }
+  }
+}
+
+/* Backward of the fused self-attention. With the scaled queries q, the attention weights
+ * P = softmax(q k^T + mask) recomputed from the log-sum-exp, and the output gradient dO:
+ *   dV = P^T dO
+ *   dS = P * (dO V^T - rowsum(P * (dO V^T)))
+ *   dQ = scale * dS K,  dK = dS^T q
+ */
+template<typename DType, typename AType>
+void InterleavedSelfAttBackwardCPU(const SelfAttLayout& l, const AType scale,
+                                   const DType* ograd, const DType* qkv, const DType* mask,
+                                   const index_t* valid_length, const AType* lse,
+                                   DType* qkv_grad, const OpReqType req, AType* workspace,
+                                   const size_t workspace_per_thread, const int omp_threads) {
+  const index_t S = l.seq_length;
+  const index_t D = l.head_dim;
+  const index_t ntasks = l.batch_size * l.heads;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t task = 0; task < ntasks; ++task) {
+    const index_t b = task / l.heads;
+    const index_t h = task % l.heads;
+    AType* k_buf = workspace + workspace_per_thread * omp_get_thread_num();
+    AType* v_buf = k_buf + S * D;
+    AType* dk_buf = v_buf + S * D;
+    AType* dv_buf = dk_buf + S * D;
+    AType* q_buf = dv_buf + S * D;
+    AType* do_buf = q_buf + kSelfAttQueryBlock * D;
+    AType* dq_buf = do_buf + kSelfAttQueryBlock * D;
+    AType* p_buf = dq_buf + kSelfAttQueryBlock * D;
+    AType* ds_buf = p_buf + kSelfAttQueryBlock * S;
+    const index_t kv_len = valid_length ? std::max<index_t>(std::min(valid_length[b], S), 0) : S;
+    for (index_t j = 0; j < kv_len; ++j) {
+      const DType* src = qkv + l.QueryOffset(j, b, h);
+      SelfAttLoad(src + D, AType(1), k_buf + j * D, D);
+      SelfAttLoad(src + 2 * D, AType(1), v_buf + j * D, D);
+    }
+    std::fill(dk_buf, dk_buf + 2 * S * D, AType(0));
+    for (index_t i0 = 0; i0 < S; i0 += kSelfAttQueryBlock) {
+      const index_t nq = std::min(kSelfAttQueryBlock, S - i0);
+      for (index_t i = 0; i < nq; ++i) {
+        SelfAttLoad(qkv + l.QueryOffset(i0 + i, b, h), scale, q_buf + i * D, D);
+        SelfAttLoad(ograd + l.OutOffset(i0 + i, b, h), AType(1), do_buf + i * D, D);
+      }
+      SelfAttScores(l, b, i0, nq, kv_len, q_buf, k_buf, mask, p_buf);
+      std::fill(dq_buf, dq_buf + nq * D, AType(0));
+      for (index_t i = 0; i < nq; ++i) {
+        AType* p = p_buf + i * S;
+        AType* ds = ds_buf + i * S;
+        const AType* dout = do_buf + i * D;
+        const AType row_lse = lse[task * S + i0 + i];
+        AType delta = 0;
+        for (index_t j = 0; j < kv_len; ++j) {
+          p[j] = std::exp(p[j] - row_lse);
+          ds[j] = SelfAttDot(dout, v_buf + j * D, D);
+          delta += p[j] * ds[j];
+        }
+        for (index_t j = 0; j < kv_len; ++j) {
+          ds[j] = p[j] * (ds[j] - delta);
+          SelfAttAxpy(p[j], dout, dv_buf + j * D, D);
+          SelfAttAxpy(ds[j], k_buf + j * D, dq_buf + i * D, D);
+          SelfAttAxpy(ds[j], q_buf + i * D, dk_buf + j * D, D);
+        }
+      }
+      for (index_t i = 0; i < nq; ++i) {
+        SelfAttStore(dq_buf + i * D, scale, req, qkv_grad + l.QueryOffset(i0 + i, b, h), D);
+      }
+    }
+    for (index_t j = 0; j < S; ++j) {
+      DType* dst = qkv_grad + l.QueryOffset(j, b, h);
+      SelfAttStore(dk_buf + j * D, AType(1), req, dst + D, D);
+      SelfAttStore(dv_buf + j * D, AType(1), req, dst + 2 * D, D);
+    }
+  }
+}
+
+inline SelfAttLayout GetSelfAttLayout(const InterleavedSelfAttParam& param,
+                                      const mxnet::TShape& qkv_shape) {
+  SelfAttLayout l;
+  l.seq_length = qkv_shape[0];
+  l.batch_size = qkv_shape[1];
+  l.heads = param.heads;
+  l.head_dim = qkv_shape[2] / param.heads / 3;
+  return l;
+}
+
+/* Valid lengths as indices, or an empty vector when not used */
+inline std::vector<index_t> GetSelfAttValidLength(const InterleavedSelfAttParam& param,
+                                                  const std::vector<TBlob>& inputs,
+                                                  const int input_index) {
+  std::vector<index_t> valid_length;
+  if (param.use_valid_length) {
+    const TBlob& blob = inputs[input_index];
+    valid_length.resize(blob.Size());
+    MSHADOW_TYPE_SWITCH(blob.type_flag_, IType, {
+      const IType* ptr = blob.dptr<IType>();
+      for (size_t i = 0; i < valid_length.size(); ++i) {
+        valid_length[i] = static_cast<index_t>(ptr[i]);
+      }
+    });
+  }
+  return valid_length;
+}
+
+void InterleavedSelfAttForward(const nnvm::NodeAttrs& attrs,
+                               const OpContext& ctx,
+                               const std::vector<TBlob>& inputs,
+                               const std::vector<OpReqType>& req,
+                               const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(inputs.size(), static_cast<size_t>(SelfAttNumInputs(param)));
+  CHECK_EQ(outputs.size(), 2U);
+  if (req[selfatt::kOut] == kNullOp) return;
+  const TBlob& qkv = inputs[0];
+  const SelfAttLayout l = GetSelfAttLayout(param, qkv.shape_);
+  const std::vector<index_t> valid_length =
+    GetSelfAttValidLength(param, inputs, 1 + param.use_mask);
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const int omp_threads = std::max(engine::OpenMP::Get()->GetRecommendedOMPThreadCount(), 1);
+  MXNET_REAL_ACC_TYPE_SWITCH(qkv.type_flag_, DType, AccType, {
+    // float16 accumulates in float32, the other types in themselves
+    typedef typename std::conditional<std::is_same<DType, half::half_t>::value,
+                                      AccType, DType>::type AType;
+    const AType scale = param.scale.has_value() ? param.scale.value()
+                        : AType(1) / std::sqrt(static_cast<AType>(l.head_dim));
+    const size_t per_thread = 2 * l.seq_length * l.head_dim
+                              + 2 * kSelfAttQueryBlock * l.head_dim
+                              + kSelfAttQueryBlock * l.seq_length;
+    Tensor<cpu, 1, AType> workspace = ctx.requested[0].get_space_typed<cpu, 1, AType>(
+      Shape1(per_thread * omp_threads), s);
+    InterleavedSelfAttForwardCPU<DType, AType>(
+      l, scale, qkv.dptr<DType>(), param.use_mask ? inputs[1].dptr<DType>() : nullptr,
+      param.use_valid_length ? valid_length.data() : nullptr,
+      outputs[selfatt::kOut].dptr<DType>(), outputs[selfatt::kLogSumExp].dptr<AType>(),
+      req[selfatt::kOut], workspace.dptr_, per_thread, omp_threads);
+  });
+}
+
+void InterleavedSelfAttBackward(const nnvm::NodeAttrs& attrs,
+                                const OpContext& ctx,
+                                const std::vector<TBlob>& inputs,
+                                const std::vector<OpReqType>& req,
+                                const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  const int num_inputs = SelfAttNumInputs(param);
+  // ograd, the forward inputs and the log-sum-exp
+  CHECK_EQ(inputs.size(), static_cast<size_t>(num_inputs + 2));
+  CHECK_EQ(outputs.size(), static_cast<size_t>(num_inputs));
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  // The mask and the valid lengths get no gradient
+  for (int i = 1; i < num_inputs; ++i) {
+    if (req[i] == kNullOp || req[i] == kAddTo) continue;
+    MSHADOW_TYPE_SWITCH(outputs[i].type_flag_, DType, {
+      outputs[i].FlatTo1D<cpu, DType>(s) = 0;
+    });
+  }
+  if (req[0] == kNullOp) return;
+  const TBlob& ograd = inputs[0];
+  const TBlob& qkv = inputs[1];
+  const TBlob& lse = inputs[num_inputs + 1];
+  const SelfAttLayout l = GetSelfAttLayout(param, qkv.shape_);
+  const std::vector<index_t> valid_length =
+    GetSelfAttValidLength(param, inputs, 2 + param.use_mask);
+  const int omp_threads = std::max(engine::OpenMP::Get()->GetRecommendedOMPThreadCount(), 1);
+  MXNET_REAL_ACC_TYPE_SWITCH(qkv.type_flag_, DType, AccType, {
+    typedef typename std::conditional<std::is_same<DType, half::half_t>::value,
+                                      AccType, DType>::type AType;
+    const AType scale = param.scale.has_value() ? param.scale.value()
+                        : AType(1) / std::sqrt(static_cast<AType>(l.head_dim));
+    const size_t per_thread = 4 * l.seq_length * l.head_dim
+                              + 3 * kSelfAttQueryBlock * l.head_dim
+                              + 2 * kSelfAttQueryBlock * l.seq_length;
+    Tensor<cpu, 1, AType> workspace = ctx.requested[0].get_space_typed<cpu, 1, AType>(
+      Shape1(per_thread * omp_threads), s);
+    InterleavedSelfAttBackwardCPU<DType, AType>(
+      l, scale, ograd.dptr<DType>(), qkv.dptr<DType>(),
+      param.use_mask ? inputs[2].dptr<DType>() : nullptr,
+      param.use_valid_length ? valid_length.data() : nullptr, lse.dptr<AType>(),
+      outputs[0].dptr<DType>(), req[0], workspace.dptr_, per_thread, omp_threads);
+  });
+}
+
+static bool InterleavedSelfAttShape(const nnvm::NodeAttrs& attrs,
+                                    mxnet::ShapeVector *in_shape,
+                                    mxnet::ShapeVector *out_shape) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_shape->size(), static_cast<size_t>(SelfAttNumInputs(param)));
+  const mxnet::TShape& qkv_shape = in_shape->at(0);
+  if (!mxnet::ndim_is_known(qkv_shape)) return false;
+  CHECK_EQ(qkv_shape.ndim(), 3)
+    << "queries_keys_values must be of shape (seq_length, batch_size, heads * 3 * head_dim)";
+  CHECK_GT(param.heads, 0);
+  if (qkv_shape[2] != -1) {
+    CHECK_EQ(qkv_shape[2] % (3 * param.heads), 0)
+      << "The last dimension of queries_keys_values must be a multiple of 3 * heads";
+  }
+  const dim_t seq_length = qkv_shape[0];
+  const dim_t batch_size = qkv_shape[1];
+  if (param.use_mask) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 1, mxnet::TShape({batch_size, seq_length, seq_length}));
+  }
+  if (param.use_valid_length) {
+    SHAPE_ASSIGN_CHECK(*in_shape, 1 + param.use_mask, mxnet::TShape({batch_size}));
+  }
+  out_shape->clear();
+  out_shape->push_back(mxnet::TShape({seq_length, batch_size,
+                                      qkv_shape[2] == -1 ? -1 : qkv_shape[2] / 3}));
+  out_shape->push_back(mxnet::TShape({batch_size, param.heads, seq_length}));
+  return shape_is_known(out_shape->at(0));
+}
+
+static bool InterleavedSelfAttType(const nnvm::NodeAttrs& attrs,
+                                   std::vector<int> *in_type,
+                                   std::vector<int> *out_type) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  CHECK_EQ(in_type->size(), static_cast<size_t>(SelfAttNumInputs(param)));
+  const int dtype = in_type->at(0);
+  if (dtype == -1) return false;
+  if (param.use_mask) {
+    TYPE_ASSIGN_CHECK(*in_type, 1, dtype);
+  }
+  if (param.use_valid_length && in_type->at(1 + param.use_mask) == -1) {
+    return false;
+  }
+  out_type->clear();
+  out_type->push_back(dtype);
+  // The log-sum-exp of the softmax rows is kept in the accumulation type
+  out_type->push_back(dtype == mshadow::kFloat16 ? mshadow::kFloat32 : dtype);
+  return true;
+}
+
+NNVM_REGISTER_OP(_contrib_interleaved_selfatt)
+.describe(R"code(Multi-head self-attention on an interleaved query/key/value projection.
+
+``queries_keys_values`` has shape (seq_length, batch_size, heads * 3 * head_dim). The projections
+of each head are stored next to each other as [query, key, value], which is the layout of a single
+FullyConnected layer computing all three with ``flatten=False``. For every batch and head computes
+
+.. math::
+
+  out = softmax(scale * Q K^T + mask) V
+
+and returns it with shape (seq_length, batch_size, heads * head_dim), ready for the output
+projection. ``scale`` defaults to 1 / sqrt(head_dim).
+
+The scores, scaling, masking, softmax and product with the values are fused in one cache-blocked
+CPU loop, no (batch_size, heads, seq_length, seq_length) tensor is materialized.
+
+With ``use_mask``, the additive ``mask`` of shape (batch_size, seq_length, seq_length) is shared
+by all heads. With ``use_valid_length``, keys at or after ``valid_length`` of shape (batch_size,)
+are ignored. Queries for which every key is masked produce zeros. The mask and the valid lengths
+do not receive gradients.
+
+float16 inputs are accumulated in float32.
+
+)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return static_cast<uint32_t>(SelfAttNumInputs(param));
+})
+.set_num_outputs(2)
+.set_attr<nnvm::FNumVisibleOutputs>("FNumVisibleOutputs",
+  [](const NodeAttrs& attrs) { return 1; })
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  std::vector<std::string> names{"queries_keys_values"};
+  if (param.use_mask) names.emplace_back("mask");
+  if (param.use_valid_length) names.emplace_back("valid_length");
+  return names;
+})
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs& attrs) {
+  return std::vector<std::string>{"output", "logsumexp"};
+})
+.set_attr<mxnet::FInferShape>("FInferShape", InterleavedSelfAttShape)
+.set_attr<nnvm::FInferType>("FInferType", InterleavedSelfAttType)
+.set_attr<FCompute>("FCompute<cpu>", InterleavedSelfAttForward)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<nnvm::FGradient>("FGradient", [](const nnvm::NodePtr& n,
+                                           const std::vector<nnvm::NodeEntry>& ograds) {
+  std::vector<nnvm::NodeEntry> heads;
+  heads.push_back(ograds[selfatt::kOut]);
+  for (const nnvm::NodeEntry& e : n->inputs) {
+    heads.push_back(e);
+  }
+  heads.emplace_back(n, selfatt::kLogSumExp, 0);
+  return MakeGradNode("_backward_interleaved_selfatt", n, heads, n->attrs.dict);
+})
+.add_argument("queries_keys_values", "NDArray-or-Symbol", "Interleaved queries, keys and values")
+.add_argument("mask", "NDArray-or-Symbol", "Additive mask, used with use_mask")
+.add_argument("valid_length", "NDArray-or-Symbol", "Valid key lengths, used with use_valid_length")
+.add_arguments(InterleavedSelfAttParam::__FIELDS__());
+
+NNVM_REGISTER_OP(_backward_interleaved_selfatt)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return static_cast<uint32_t>(SelfAttNumInputs(param) + 2);
+})
+.set_num_outputs([](const NodeAttrs& attrs) {
+  const InterleavedSelfAttParam& param = nnvm::get<InterleavedSelfAttParam>(attrs.parsed);
+  return static_cast<uint32_t>(SelfAttNumInputs(param));
+})
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr_parser(ParamParser<InterleavedSelfAttParam>)
+.set_attr<FCompute>("FCompute<cpu>", InterleavedSelfAttBackward)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+});
+
 }  // namespace op
 }  // namespace mxnet
@@ -121,44 +121,6 @@ MSHADOW_XINLINE static void sum_(index_t n, DType *in, DType *dst) {
   dst[0] = sum;
 }
 
-// LayerNorm on the last dimension
-template <typename DType>
-MSHADOW_XINLINE static void LayerNormLastDim(index_t m,
-                                             index_t n,
-                                             DType *a,
-                                             DType *b,
-                                             DType *gamma,
-                                             DType *beta,
-                                             DType *mean,
-                                             DType *var,
-                                             DType eps) {
-  auto nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-#pragma omp parallel for num_threads(nthreads)
-  for (index_t i = 0; i < m; i++) {
-    DType* in_offset = a + i * n;
-    DType* out_offset = b + i * n;
-    DType x_sum = 0.0f;
-    DType x_square_sum = 0.0f;
-
-#if !defined(_MSC_VER)
-#pragma omp simd
-#endif
-    for (index_t j = 0; j < n; j++) {
-      x_sum += in_offset[j];
-      x_square_sum += in_offset[j] * in_offset[j];
-    }
-    mean[i] = x_sum / n;
-    var[i] = math::sqrt(x_square_sum / n - mean[i] * mean[i] + eps);
-
-#if !defined(_MSC_VER)
-#pragma omp simd
-#endif
-    for (index_t j = 0; j < n; j++) {
-      out_offset[j] = (in_offset[j] - mean[i]) * gamma[j] / var[i] + beta[j];
-    }
-  }
-}
-
 }  // namespace mkl_func
 }  // namespace op
 }  // namespace mxnet
@@ -31,7 +31,9 @@
 #include <mxnet/engine.h>
 #include <mxnet/op_attr_types.h>
 #include <algorithm>
+#include <chrono>
 #include "./operator_tune.h"
+#include "./operator_tune_cache.h"
 #include "../engine/openmp.h"
 
 #ifdef __CUDACC__
@@ -679,6 +681,12 @@ struct op_with_req {
   }
 };
 
+/*!
+ * \brief Tag type identifying the launches of kernel OP with the workload of tuned_op TUNED
+ */
+template<typename OP, typename TUNED>
+struct tuned_launch {};
+
 template<typename OP, typename xpu>
 struct Kernel;
 
@@ -764,8 +772,28 @@ struct Kernel<OP, cpu> {
   static void LaunchTuned(mshadow::Stream<cpu> *, const size_t N, Args... args) {
 #ifdef _OPENMP
     const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
-    if (omp_threads < 2 || !tuned_op<PRIMITIVE_OP, DType>::UseOMP(
-      N, static_cast<size_t>(omp_threads))) {
+#ifdef MXNET_USE_OPERATOR_TUNING
+    // With MXNET_OPERATOR_RETUNE, time a sample of the launches, run serially, to measure the
+    // workload of this kernel, and use it instead of the workload of PRIMITIVE_OP once known.
+    // Launches that would use OMP are sampled less often, so a kernel can move both ways.
+    static LaunchWorkload *const retune = OperatorTuneCache::Get()->ForRetune(
+      typeid(tuned_launch<OP, tuned_op<PRIMITIVE_OP, DType>>),
+      typeid(tuned_op<PRIMITIVE_OP, DType>));
+    const float measured = retune ? retune->workload.load(std::memory_order_relaxed) : 0.0f;
+    bool use_omp = omp_threads >= 2 && (measured > 0.0f
+      ? OperatorTuneByType<DType>::UseOMP(N, static_cast<size_t>(omp_threads),
+                                          static_cast<uint64_t>(N * measured))
+      : tuned_op<PRIMITIVE_OP, DType>::UseOMP(N, static_cast<size_t>(omp_threads)));
+    const bool sample = retune && N >= LaunchWorkload::kMinSampleIterations
+                        && retune->ShouldSample(use_omp);
+    use_omp = use_omp && !sample;
+    const auto start = sample ? std::chrono::steady_clock::now()
+                              : std::chrono::steady_clock::time_point();
+#else
+    const bool use_omp = omp_threads >= 2 && tuned_op<PRIMITIVE_OP, DType>::UseOMP(
+      N, static_cast<size_t>(omp_threads));
+#endif  // MXNET_USE_OPERATOR_TUNING
+    if (!use_omp) {
       for (size_t i = 0; i < N; ++i) {
         OP::Map(i, args...);
       }
@@ -775,6 +803,13 @@ struct Kernel<OP, cpu> {
         OP::Map(i, args...);
       }
     }
+#ifdef MXNET_USE_OPERATOR_TUNING
+    if (sample) {
+      const int64_t duration_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now() - start).count();
+      OperatorTuneCache::Get()->Sample(retune, N, duration_ns);
+    }
+#endif  // MXNET_USE_OPERATOR_TUNING
 #else
     for (size_t i = 0; i < N; ++i) {
       OP::Map(i, args...);
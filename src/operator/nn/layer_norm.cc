@@ -25,12 +25,10 @@
 
 #include "layer_norm-inl.h"
 #include <nnvm/op_attr_types.h>
+#include <cmath>
+#include <type_traits>
 #include "../elemwise_op_common.h"
 
-#if MSHADOW_USE_MKL == 1
-#include "../mkl_functions-inl.h"
-#endif
-
 namespace mxnet {
 namespace op {
 
@@ -65,64 +63,281 @@ static bool LayerNormShape(const nnvm::NodeAttrs& attrs,
   return true;
 }
 
+/* Mean and variance of a contiguous row with Welford's algorithm, vectorized by blocks.
+ * The mean and the sum of squared deviations of each block of kLayerNormBlock elements are
+ * computed by two SIMD loops over the block, which is still in L1, and merged into the running
+ * statistics with Chan's parallel update. This reads the row from memory once and does not suffer
+ * from the cancellation of sum(x^2) - sum(x)^2.
+ */
+template<typename AType, typename DType>
+inline void LayerNormRowMoments(const DType* __restrict__ row, const index_t nchannel,
+                                AType* mean, AType* sigma2) {
+  const index_t kLayerNormBlock = 64;
+  AType row_mean = 0;
+  AType row_m2 = 0;
+  index_t count = 0;
+  for (index_t l = 0; l < nchannel; l += kLayerNormBlock) {
+    const index_t n = std::min(kLayerNormBlock, nchannel - l);
+    const DType* __restrict__ block = row + l;
+    AType sum = 0;
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum)
+#endif
+    for (index_t i = 0; i < n; ++i) {
+      sum += static_cast<AType>(block[i]);
+    }
+    const AType block_mean = sum / static_cast<AType>(n);
+    AType block_m2 = 0;
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:block_m2)
+#endif
+    for (index_t i = 0; i < n; ++i) {
+      const AType diff = static_cast<AType>(block[i]) - block_mean;
+      block_m2 += diff * diff;
+    }
+    const index_t new_count = count + n;
+    const AType delta = block_mean - row_mean;
+    row_mean += delta * static_cast<AType>(n) / static_cast<AType>(new_count);
+    row_m2 += block_m2 + delta * delta * static_cast<AType>(count) * static_cast<AType>(n)
+                         / static_cast<AType>(new_count);
+    count = new_count;
+  }
+  *mean = row_mean;
+  *sigma2 = row_m2 / static_cast<AType>(nchannel);
+}
+
+/* Fused LayerNorm forward when axis=-1 (contiguous case). Each row is read twice: once for the
+ * moments and once to write the normalized, scaled and shifted output.
+ */
+template<typename AType, typename DType>
+void LayerNormFusedForwardCPUContig(const index_t nbatch, const index_t nchannel, const AType eps,
+                                    const DType* in_data,
+                                    const DType* __restrict__ gamma,
+                                    const DType* __restrict__ beta,
+                                    DType* out_data, DType* mean_data, DType* std_data) {
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t b = 0; b < nbatch; ++b) {
+    const DType* row = in_data + b * nchannel;
+    DType* out_row = out_data + b * nchannel;
+    AType mean, sigma2;
+    LayerNormRowMoments(row, nchannel, &mean, &sigma2);
+    const AType std_val = std::sqrt(sigma2 + eps);
+    const AType invstd = AType(1) / std_val;
+    mean_data[b] = static_cast<DType>(mean);
+    std_data[b] = static_cast<DType>(std_val);
+    // out_row may alias row through FInplaceOption, so in_data is not __restrict__.
+    // Each element is read before it is written
+#if !defined(_MSC_VER)
+#pragma omp simd
+#endif
+    for (index_t i = 0; i < nchannel; ++i) {
+      out_row[i] = static_cast<DType>((static_cast<AType>(row[i]) - mean) * invstd
+                                      * static_cast<AType>(gamma[i])
+                                      + static_cast<AType>(beta[i]));
+    }
+  }
+}
+
+template<bool safe_acc = false>
+void LayerNormCPUContig(const LayerNormParam& param,
+                        const OpContext& ctx, const std::vector<TBlob>& inputs,
+                        const std::vector<OpReqType>& req,
+                        const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  CHECK_EQ(inputs.size(), 3U);
+  const TBlob& in_data = inputs[layernorm::kData];
+  const index_t nchannel = in_data.shape_[in_data.ndim() - 1];
+  const index_t nbatch = in_data.shape_.ProdShape(0, in_data.ndim() - 1);
+  CHECK_EQ(in_data.CheckContiguous(), true);
+  CHECK_EQ(outputs[layernorm::kOut].CheckContiguous(), true);
+  CHECK_EQ(outputs[layernorm::kMean].CheckContiguous(), true);
+  CHECK_EQ(outputs[layernorm::kStd].CheckContiguous(), true);
+  MXNET_REAL_ACC_TYPE_SWITCH(in_data.type_flag_, DType, AccType, {
+    // float16 always accumulates in float32
+    typedef typename std::conditional<safe_acc || std::is_same<DType, half::half_t>::value,
+                                      AccType, DType>::type AType;
+    LayerNormFusedForwardCPUContig<AType, DType>(
+      nbatch, nchannel, static_cast<AType>(param.eps),
+      in_data.dptr<DType>(), inputs[layernorm::kGamma].dptr<DType>(),
+      inputs[layernorm::kBeta].dptr<DType>(), outputs[layernorm::kOut].dptr<DType>(),
+      outputs[layernorm::kMean].dptr<DType>(), outputs[layernorm::kStd].dptr<DType>());
+  });
+}
+
 template<>
 void LayerNormCompute<cpu>(const nnvm::NodeAttrs& attrs,
                            const OpContext& ctx, const std::vector<TBlob>& inputs,
                            const std::vector<OpReqType>& req,
                            const std::vector<TBlob>& outputs) {
-  return LayerNormComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
-}
-
-#if MSHADOW_USE_MKL == 1
-void LayerNormComputeMKL(const nnvm::NodeAttrs& attrs,
-                         const OpContext& ctx,
-                         const std::vector<TBlob>& inputs,
-                         const std::vector<OpReqType>& req,
-                         const std::vector<TBlob>& outputs) {
-  using namespace mshadow;
   const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
   if (req[0] == kNullOp) return;
   CHECK_NE(req[0], kAddTo);
-  CHECK_EQ(inputs.size(), 3U);
   int axis = GetRealAxis(param.axis, inputs[0].ndim());
-
-  // This optimization only applys for LayerNorm on the last dimension with dtype FP32 or FP64.
-  if (axis == (inputs[layernorm::kData].ndim() - 1) &&
-      (inputs[0].type_flag_ == kFloat32 || inputs[0].type_flag_ == kFloat64)) {
-    // Compute necessary data for the reduce operation.
-    mxnet::TShape red_src_shape, red_dst_shape;
-    BroadcastReduceShapeCompact(inputs[layernorm::kData].shape_, outputs[layernorm::kMean].shape_,
-                                &red_src_shape, &red_dst_shape);
-    const TBlob in_data = inputs[layernorm::kData].reshape(red_src_shape);
-    const TBlob mean_data = outputs[layernorm::kMean].reshape(red_dst_shape);
-    const TBlob std_data = outputs[layernorm::kStd].reshape(red_dst_shape);
-    const int outter_size = red_dst_shape.Size();
-    const int channel_size = red_src_shape.Size() / red_dst_shape.Size();
-
-    // call
-    MSHADOW_SGL_DBL_TYPE_SWITCH(in_data.type_flag_, DType, {
-      mkl_func::LayerNormLastDim(outter_size, channel_size,
-                                 in_data.dptr<DType>(),
-                                 outputs[layernorm::kOut].dptr<DType>(),
-                                 inputs[layernorm::kGamma].dptr<DType>(),
-                                 inputs[layernorm::kBeta].dptr<DType>(),
-                                 outputs[layernorm::kMean].dptr<DType>(),
-                                 outputs[layernorm::kStd].dptr<DType>(),
-                                 static_cast<DType>(param.eps));
-    });
-  } else {
-    // fallback
-    LayerNormCompute<cpu>(attrs, ctx, inputs, req, outputs);
+  CHECK(axis >= 0 && axis < inputs[0].ndim()) << "Channel axis out of range: " << param.axis;
+  if (axis == inputs[0].ndim() - 1) {
+    // Use the fused CPU kernel
+    bool safe_acc = dmlc::GetEnv("MXNET_SAFE_ACCUMULATION", false);
+    if (safe_acc) {
+      return LayerNormCPUContig<true>(param, ctx, inputs, req, outputs);
+    } else {
+      return LayerNormCPUContig<false>(param, ctx, inputs, req, outputs);
+    }
   }
+  return LayerNormComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
 }
+
+/* Fused LayerNorm backward when axis=-1 (contiguous case).
+ * With xhat = (x - mean) / std and g = out_grad * gamma:
+ *   d_gamma = sum(out_grad * xhat, axis=0)
+ *   d_beta = sum(out_grad, axis=0)
+ *   d_x = (g - mean(g, axis=-1) - xhat * mean(g * xhat, axis=-1)) / std
+ * The first pass over a row accumulates the row sums of g and g * xhat, and the per-thread
+ * partial sums of d_gamma and d_beta. The second pass writes d_x. The partial sums of the threads
+ * are reduced at the end.
+ */
+template<typename AType, typename DType>
+void LayerNormFusedBackwardCPUContig(const index_t nbatch, const index_t nchannel,
+                                     const DType* __restrict__ out_grad,
+                                     const DType* __restrict__ in_data,
+                                     const DType* __restrict__ gamma,
+                                     const DType* __restrict__ mean_data,
+                                     const DType* __restrict__ std_data,
+                                     DType* data_grad, DType* gamma_grad, DType* beta_grad,
+                                     const OpReqType data_grad_req,
+                                     const OpReqType gamma_grad_req,
+                                     const OpReqType beta_grad_req,
+                                     AType* workspace, const int omp_threads) {
+  const bool need_gamma_beta = gamma_grad_req != kNullOp || beta_grad_req != kNullOp;
+  const bool need_data = data_grad_req != kNullOp;
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    const int nthreads = omp_get_num_threads();
+    AType* part_gamma_grad = workspace + 2 * nchannel * omp_get_thread_num();
+    AType* part_beta_grad = part_gamma_grad + nchannel;
+    if (need_gamma_beta) {
+      std::fill(part_gamma_grad, part_gamma_grad + 2 * nchannel, AType(0));
+    }
+    #pragma omp for
+    for (index_t b = 0; b < nbatch; ++b) {
+      const DType* og = out_grad + b * nchannel;
+      const DType* x = in_data + b * nchannel;
+      const AType mean = static_cast<AType>(mean_data[b]);
+      const AType invstd = AType(1) / static_cast<AType>(std_data[b]);
+      AType sum_g = 0;
+      AType sum_g_xhat = 0;
+      if (need_gamma_beta) {
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum_g, sum_g_xhat)
+#endif
+        for (index_t i = 0; i < nchannel; ++i) {
+          const AType xhat = (static_cast<AType>(x[i]) - mean) * invstd;
+          const AType ograd = static_cast<AType>(og[i]);
+          const AType g = ograd * static_cast<AType>(gamma[i]);
+          part_gamma_grad[i] += ograd * xhat;
+          part_beta_grad[i] += ograd;
+          sum_g += g;
+          sum_g_xhat += g * xhat;
+        }
+      } else if (need_data) {
+#if !defined(_MSC_VER)
+#pragma omp simd reduction(+:sum_g, sum_g_xhat)
 #endif
+        for (index_t i = 0; i < nchannel; ++i) {
+          const AType xhat = (static_cast<AType>(x[i]) - mean) * invstd;
+          const AType g = static_cast<AType>(og[i]) * static_cast<AType>(gamma[i]);
+          sum_g += g;
+          sum_g_xhat += g * xhat;
+        }
+      }
+      if (need_data) {
+        const AType mean_g = sum_g / static_cast<AType>(nchannel);
+        const AType mean_g_xhat = sum_g_xhat / static_cast<AType>(nchannel);
+        DType* dx = data_grad + b * nchannel;
+        const bool addto = data_grad_req == kAddTo;
+#if !defined(_MSC_VER)
+#pragma omp simd
+#endif
+        for (index_t i = 0; i < nchannel; ++i) {
+          const AType xhat = (static_cast<AType>(x[i]) - mean) * invstd;
+          const AType g = static_cast<AType>(og[i]) * static_cast<AType>(gamma[i]);
+          const AType val = (g - mean_g - xhat * mean_g_xhat) * invstd;
+          dx[i] = static_cast<DType>(addto ? static_cast<AType>(dx[i]) + val : val);
+        }
+      }
+    }
+    if (need_gamma_beta) {
+      // The implicit barrier of the loop above makes all partial sums visible
+      #pragma omp for
+      for (index_t i = 0; i < nchannel; ++i) {
+        AType sum_gamma = 0;
+        AType sum_beta = 0;
+        for (int t = 0; t < nthreads; ++t) {
+          sum_gamma += workspace[2 * nchannel * t + i];
+          sum_beta += workspace[2 * nchannel * t + nchannel + i];
+        }
+        if (gamma_grad_req == kAddTo) {
+          gamma_grad[i] = static_cast<DType>(static_cast<AType>(gamma_grad[i]) + sum_gamma);
+        } else if (gamma_grad_req != kNullOp) {
+          gamma_grad[i] = static_cast<DType>(sum_gamma);
+        }
+        if (beta_grad_req == kAddTo) {
+          beta_grad[i] = static_cast<DType>(static_cast<AType>(beta_grad[i]) + sum_beta);
+        } else if (beta_grad_req != kNullOp) {
+          beta_grad[i] = static_cast<DType>(sum_beta);
+        }
+      }
+    }
+  }
+}
 
+template<bool safe_acc = false>
+void LayerNormGradCPUContig(const LayerNormParam& param,
+                            const OpContext& ctx, const std::vector<TBlob>& inputs,
+                            const std::vector<OpReqType>& req,
+                            const std::vector<TBlob>& outputs) {
+  using namespace mshadow;
+  CHECK_EQ(inputs.size(), 5U);
+  const TBlob& out_grad = inputs[0];
+  const TBlob& in_data = inputs[1];
+  const index_t nchannel = in_data.shape_[in_data.ndim() - 1];
+  const index_t nbatch = in_data.shape_.ProdShape(0, in_data.ndim() - 1);
+  CHECK_EQ(out_grad.CheckContiguous(), true);
+  CHECK_EQ(in_data.CheckContiguous(), true);
+  CHECK_EQ(outputs[0].CheckContiguous(), true);
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  const int omp_threads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  MXNET_REAL_ACC_TYPE_SWITCH(in_data.type_flag_, DType, AccType, {
+    // float16 always accumulates in float32
+    typedef typename std::conditional<safe_acc || std::is_same<DType, half::half_t>::value,
+                                      AccType, DType>::type AType;
+    Tensor<cpu, 1, AType> workspace = ctx.requested[0].get_space_typed<cpu, 1, AType>(
+      Shape1(2 * nchannel * std::max(omp_threads, 1)), s);
+    LayerNormFusedBackwardCPUContig<AType, DType>(
+      nbatch, nchannel, out_grad.dptr<DType>(), in_data.dptr<DType>(),
+      inputs[2].dptr<DType>(), inputs[3].dptr<DType>(), inputs[4].dptr<DType>(),
+      outputs[0].dptr<DType>(), outputs[1].dptr<DType>(), outputs[2].dptr<DType>(),
+      req[0], req[1], req[2], workspace.dptr_, omp_threads);
+  });
+}
 
 template<>
 void LayerNormGradCompute<cpu>(const nnvm::NodeAttrs& attrs,
                                const OpContext& ctx, const std::vector<TBlob>& inputs,
                                const std::vector<OpReqType>& req,
                                const std::vector<TBlob>& outputs) {
+  const LayerNormParam& param = nnvm::get<LayerNormParam>(attrs.parsed);
+  int axis = GetRealAxis(param.axis, inputs[0].ndim());
+  CHECK(axis >= 0 && axis < inputs[0].ndim()) << "Channel axis out of range: " << param.axis;
+  if (axis == inputs[0].ndim() - 1) {
+    // Use the fused CPU kernel
+    bool safe_acc = dmlc::GetEnv("MXNET_SAFE_ACCUMULATION", false);
+    if (safe_acc) {
+      return LayerNormGradCPUContig<true>(param, ctx, inputs, req, outputs);
+    } else {
+      return LayerNormGradCPUContig<false>(param, ctx, inputs, req, outputs);
+    }
+  }
   return LayerNormGradComputeGeneral<cpu>(attrs, ctx, inputs, req, outputs);
 }
 
@@ -172,11 +387,7 @@ axis to be the last item in the input shape.
 })
 .set_attr<mxnet::FInferShape>("FInferShape", LayerNormShape)
 .set_attr<nnvm::FInferType>("FInferType", ElemwiseType<3, 3>)
-#if MSHADOW_USE_MKL == 1
-.set_attr<FCompute>("FCompute<cpu>", LayerNormComputeMKL)
-#else
 .set_attr<FCompute>("FCompute<cpu>", LayerNormCompute<cpu>)
-#endif
 .set_attr<nnvm::FGradient>("FGradient", [](const nnvm::NodePtr& n,
                                            const std::vector<nnvm::NodeEntry>& ograds) {
   std::vector<nnvm::NodeEntry> heads;
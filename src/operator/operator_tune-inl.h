@@ -32,8 +32,10 @@
 #include <list>
 #include <random>
 #include <unordered_set>
+#include <utility>
 #include "./mxnet_op.h"
 #include "./operator_tune.h"
+#include "./operator_tune_cache.h"
 
 #if (__GNUC__ >= 4 || (__GNUC__ >= 3 && __GNUC_MINOR__ >= 4)) && !defined(__mips__)
 #  define HAS_CXA_DEMANGLE 1
@@ -171,7 +173,14 @@ class OperatorTune : public OperatorTuneByType<DType> {
         if (!config.empty() && ::isdigit(config[0]) && std::atoi(config.c_str()) == 0) {
           OperatorTuneBase::omp_overhead_ns_ = INT_MAX;
         } else {
-          OperatorTuneBase::omp_overhead_ns_ = GetOMPLoopOverhead();
+          OperatorTuneCache *cache = OperatorTuneCache::Get();
+          int64_t omp_overhead_ns;
+          if (!output_tuning_data_ && cache->RestoreOMPOverhead(&omp_overhead_ns)) {
+            OperatorTuneBase::omp_overhead_ns_ = omp_overhead_ns;
+          } else {
+            OperatorTuneBase::omp_overhead_ns_ = GetOMPLoopOverhead();
+            cache->StoreOMPOverhead(OperatorTuneBase::omp_overhead_ns_);
+          }
         }
         ParseEnablerConfig(config);
       }
@@ -186,14 +195,18 @@ class OperatorTune : public OperatorTuneByType<DType> {
   /*!
    * \brief Schedule a tuning run
    * \tparam OP Operator to tune
+   * \tparam TUNED tuned_op<...> type whose workload_ the tuning run sets
    * \param tune_func Function to call which tunes the operator
+   * \param retunable Whether workload_[0] is the standard workload which launches may refine
    * \return true if the tune operation was scheduled
    */
-  template<typename OP>
-  static bool ScheduleTune(void (*tune_func)()) {
+  template<typename OP, typename TUNED>
+  static bool ScheduleTune(void (*tune_func)(), const bool retunable = true) {
 #ifdef MXNET_USE_OPERATOR_TUNING
     if (tune_func) {
-      GetTuningList()->push_back(tune_func);
+      TunedWorkload *entry = OperatorTuneCache::Get()->Register(
+        typeid(TUNED), type_name<TUNED>(), &TUNED::workload_, retunable);
+      GetTuningList()->emplace_back(tune_func, entry);
       operator_names_.insert(demangle(typeid(OP).name()));
       return true;
     }
@@ -218,7 +231,8 @@ class OperatorTune : public OperatorTuneByType<DType> {
    */
   static bool TuneAll() {
     Initialize();
-    std::list<void (*)()> *tl = GetTuningList();
+    std::list<TuneEntry> *tl = GetTuningList();
+    OperatorTuneCache *cache = OperatorTuneCache::Get();
     const size_t size_save = tl->size();  // For checking if anything asynchronous is
     // adding or removing items, which is forbidden
     if (output_tuning_data_ && !tl->empty()) {
@@ -230,9 +244,15 @@ class OperatorTune : public OperatorTuneByType<DType> {
       }
     }
     const Tick start = std::chrono::high_resolution_clock::now();
-    for (auto i : *tl) {
-      (*i)();
+    for (const TuneEntry& i : *tl) {
+      // Generating tuning data must measure everything, otherwise reuse the cached workload
+      if (!output_tuning_data_ && cache->Restore(i.second)) {
+        continue;
+      }
+      (*i.first)();
+      cache->Store(i.second);
     }
+    cache->Flush();
     if (OperatorTuneBase::verbose_tuning_info_) {
       const duration_t duration = OperatorTune::GetDurationInNanoseconds(start);
       LOG(INFO) << "Op Tuning  for " << type_name<DType>()
@@ -253,11 +273,14 @@ class OperatorTune : public OperatorTuneByType<DType> {
   }
 
  protected:
+  /*! \brief Tuning function of an operator and the cache entry of the workload it sets */
+  typedef std::pair<void (*)(), TunedWorkload *> TuneEntry;
+
   /*!
    * \brief Get the list of tuning function calls for the operators
    * \return Pointer to list of tuning function calls
    */
-  static std::list<void (*)()> *GetTuningList();
+  static std::list<TuneEntry> *GetTuningList();
 
   /*!
    * \brief Demangle typeid::name() in order to generate source macros
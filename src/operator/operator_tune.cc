@@ -44,8 +44,8 @@ double OperatorTuneBase::tuning_weight_scale_ = 0.0;
   template<> volatile int OperatorTune<__typ$>::volatile_int_ = 9;  /* arbitrary number */ \
   template<> std::unordered_set<std::string> OperatorTune<__typ$>::operator_names_({}); \
   template<> bool OperatorTune<__typ$>::output_tuning_data_ = false; \
-  template<> std::list<void (*)()> *OperatorTune<__typ$>::GetTuningList() { \
-    static std::list<void (*)()> ll; \
+  template<> std::list<OperatorTune<__typ$>::TuneEntry> *OperatorTune<__typ$>::GetTuningList() { \
+    static std::list<TuneEntry> ll; \
     return &ll; \
   }
 
@@ -101,7 +101,8 @@ struct static_init_var {
       N, omp_threads); \
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<__op$, __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>( \
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, \
+      mxnet_op::tuned_op<__op$, __typ$>>( \
       ::mxnet::op::UnaryOpTune<__typ$>::TuneBlankOperatorEx<__op$>)
 
 /*!
@@ -116,7 +117,8 @@ struct static_init_var {
       N, omp_threads); \
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<__op$, __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>( \
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, \
+      mxnet_op::tuned_op<__op$, __typ$>>( \
       ::mxnet::op::UnaryOpTune<__typ$>::TuneUnaryOperator<__op$>)
 
 /*!
@@ -132,7 +134,8 @@ struct static_init_var {
       ::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>(N, omp_threads); \
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>:: \
-    init_ = ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>( \
+    init_ = ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, \
+      mxnet_op::tuned_op<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>( \
       ::mxnet::op::UnaryOpTune<__typ$>::TuneUnaryBackwardOperator<__op$>)
 
 /*!
@@ -147,7 +150,8 @@ struct static_init_var {
       N, omp_threads); \
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<__op$, __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>( \
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, \
+      mxnet_op::tuned_op<__op$, __typ$>>( \
       ::mxnet::op::BinaryOpTune<__typ$>::TuneBinaryOperator<__op$>)
 
 /*!
@@ -165,7 +169,8 @@ struct static_init_var {
   }}  /* namespace mxnet_op */ \
   template<> bool static_init_var<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, \
     __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$>(  \
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$, \
+      mxnet_op::tuned_op<::mxnet::op::mxnet_op::backward_grad_tuned<__op$>, __typ$>>( \
       ::mxnet::op::BinaryOpTune<__typ$>::TuneBinaryBackwardOperator<__op$>)
 
 /*!
@@ -174,8 +179,8 @@ struct static_init_var {
 #define _IMPLEMENT_CUSTOM_WORKLOAD_FWD(__op$, __typ$) \
   IMPLEMENT_WORKLOAD_VALUE_FOR_TYPE(__op$<__typ$>, __typ$); \
   template<> bool static_init_var<__op$<__typ$>, __typ$>::init_ = \
-    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$<__typ$>>(\
-      __op$<__typ$>::Tune)
+    ::mxnet::op::OperatorTune<__typ$>::ScheduleTune<__op$<__typ$>, \
+      mxnet_op::tuned_op<__op$<__typ$>, __typ$>>(__op$<__typ$>::Tune, false)
 
 /*!
  * \brief Macros for manually adding new blank, unary and binary operators to the tuning set
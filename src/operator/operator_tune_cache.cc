@@ -0,0 +1,340 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file operator_tune_cache.cc
+ * \brief on-disk cache of the OperatorTune workloads and launch-time re-tuning
+ */
+#include <dmlc/logging.h>
+#include <dmlc/omp.h>
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <memory>
+#include <sstream>
+#include <thread>
+#if defined(__GNUC__) && !defined(__mips__)
+#include <cxxabi.h>
+#endif
+#include "./operator_tune.h"
+#include "./operator_tune_cache.h"
+
+#ifndef MXNET_BUILD_ID
+// Set by the build to the git revision of the source tree
+#define MXNET_BUILD_ID "unknown"
+#endif
+
+namespace mxnet {
+namespace op {
+
+namespace {
+/*! \brief First line of a cache file */
+const char kCacheHeader[] = "mxnet-operator-tune-cache";
+/*! \brief Weight of a new measurement when folding it into the workload */
+const float kRetuneWeight = 0.5f;
+/*! \brief Relative change of a refined workload worth rewriting the cache file for */
+const float kStoreThreshold = 0.1f;
+}  // namespace
+
+OperatorTuneCache *OperatorTuneCache::Get() {
+  // Intentionally leaked, tuned kernels may launch during static destruction
+  static OperatorTuneCache *inst = new OperatorTuneCache();
+  return inst;
+}
+
+OperatorTuneCache::OperatorTuneCache() {
+  const std::string dir = dmlc::GetEnv("MXNET_OPERATOR_TUNE_CACHE_DIR", std::string());
+  retune_ = dmlc::GetEnv("MXNET_OPERATOR_RETUNE", false);
+  retune_interval_ms_ = std::max(dmlc::GetEnv("MXNET_OPERATOR_RETUNE_INTERVAL_MS", 10000), 100);
+  if (!dir.empty()) {
+    key_ = CacheKey();
+    std::ostringstream os;
+    os << dir << "/operator_tune_" << std::hex << std::hash<std::string>()(key_) << ".txt";
+    path_ = os.str();
+    if (ReadFile(path_, key_, &cached_omp_overhead_ns_, &cached_)) {
+      LOG(INFO) << "Loaded " << cached_.size() << " operator tuning workloads from " << path_;
+    }
+  }
+}
+
+std::string OperatorTuneCache::CacheKey() {
+  std::string cpu_model = "unknown";
+  std::ifstream cpuinfo("/proc/cpuinfo");
+  std::string line;
+  while (std::getline(cpuinfo, line)) {
+    if (line.compare(0, 10, "model name") == 0) {
+      const size_t colon = line.find(':');
+      if (colon != std::string::npos) {
+        cpu_model = line.substr(line.find_first_not_of(' ', colon + 1));
+      }
+      break;
+    }
+  }
+  const int procs = omp_get_num_procs();
+  std::ostringstream os;
+  os << cpu_model
+     << "|procs=" << procs
+     << "|tune_cores="
+     << dmlc::GetEnv("MXNET_USE_NUM_CORES_OPERATOR_TUNING", std::max(procs / 2, 1))
+     << "|build=" << MXNET_VERSION << " " << MXNET_BUILD_ID;
+#ifdef __VERSION__
+  os << " " << __VERSION__;
+#endif
+  return os.str();
+}
+
+bool OperatorTuneCache::ReadFile(const std::string &path, const std::string &key,
+                                 int64_t *omp_overhead_ns,
+                                 std::unordered_map<std::string, std::vector<float>> *workloads) {
+  *omp_overhead_ns = -1;
+  workloads->clear();
+  std::ifstream is(path);
+  if (!is) {
+    return false;
+  }
+  std::string line, header;
+  int version = 0;
+  if (!std::getline(is, line)) {
+    return false;
+  }
+  std::istringstream(line) >> header >> version;
+  if (header != kCacheHeader || version != kVersion) {
+    LOG(INFO) << "Ignoring operator tuning cache " << path << " of another version";
+    return false;
+  }
+  if (!std::getline(is, line) || line.compare(0, 4, "key ") != 0 || line.substr(4) != key) {
+    LOG(INFO) << "Ignoring operator tuning cache " << path << " of another machine or build";
+    return false;
+  }
+  while (std::getline(is, line)) {
+    if (line.compare(0, 16, "omp_overhead_ns ") == 0) {
+      *omp_overhead_ns = std::strtoll(line.c_str() + 16, nullptr, 10);
+      continue;
+    }
+    // Kernel names contain spaces, the values follow the last tab
+    const size_t tab = line.rfind('\t');
+    if (tab == std::string::npos || tab == 0) {
+      continue;
+    }
+    std::istringstream values(line.substr(tab + 1));
+    std::vector<float> workload;
+    float value;
+    while (values >> value) {
+      workload.push_back(value);
+    }
+    if (!workload.empty()) {
+      (*workloads)[line.substr(0, tab)] = std::move(workload);
+    }
+  }
+  return true;
+}
+
+bool OperatorTuneCache::WriteFile(
+  const std::string &path, const std::string &key, int64_t omp_overhead_ns,
+  const std::unordered_map<std::string, std::vector<float>> &workloads) {
+  // Write a temporary file and rename it so that concurrent processes never see a partial file
+  std::ostringstream tmp;
+  tmp << path << ".tmp." << std::chrono::steady_clock::now().time_since_epoch().count()
+      << "." << std::hash<std::thread::id>()(std::this_thread::get_id());
+  const std::string tmp_path = tmp.str();
+  {
+    std::ofstream os(tmp_path);
+    if (!os) {
+      return false;
+    }
+    os << kCacheHeader << " " << kVersion << "\n"
+       << "key " << key << "\n";
+    if (omp_overhead_ns >= 0) {
+      os << "omp_overhead_ns " << omp_overhead_ns << "\n";
+    }
+    os << std::setprecision(9);
+    for (const auto &kv : workloads) {
+      os << kv.first << "\t";
+      for (size_t i = 0; i < kv.second.size(); ++i) {
+        os << (i ? " " : "") << kv.second[i];
+      }
+      os << "\n";
+    }
+    if (!os.good()) {
+      os.close();
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+    std::remove(path.c_str());
+    if (std::rename(tmp_path.c_str(), path.c_str()) != 0) {
+      std::remove(tmp_path.c_str());
+      return false;
+    }
+  }
+  return true;
+}
+
+TunedWorkload *OperatorTuneCache::Register(const std::type_index &type, const std::string &name,
+                                           std::vector<float> *workload, bool retunable) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  std::unique_ptr<TunedWorkload> &entry = entries_[type];
+  if (!entry) {
+    entry.reset(new TunedWorkload());
+    entry->name = name;
+    entry->workload = workload;
+    entry->retunable = retunable;
+  }
+  return entry.get();
+}
+
+LaunchWorkload *OperatorTuneCache::ForRetune(const std::type_index &launch,
+                                            const std::type_index &tuned) {
+  if (!retune_) {
+    return nullptr;
+  }
+  LaunchWorkload *entry = nullptr;
+  {
+    std::lock_guard<std::mutex> lock(mutex_);
+    auto iter = entries_.find(tuned);
+    if (iter == entries_.end() || !iter->second->retunable) {
+      return nullptr;
+    }
+    std::unique_ptr<LaunchWorkload> &launch_entry = launches_[launch];
+    if (!launch_entry) {
+      launch_entry.reset(new LaunchWorkload());
+      launch_entry->name = Demangle(launch.name());
+      auto cached = cached_.find(launch_entry->name);
+      if (cached != cached_.end() && !cached->second.empty()) {
+        launch_entry->stored = cached->second[0];
+        launch_entry->workload.store(cached->second[0], std::memory_order_relaxed);
+      }
+    }
+    entry = launch_entry.get();
+  }
+  std::call_once(retune_started_, [this]() {
+    std::thread(&OperatorTuneCache::RetuneLoop, this).detach();
+  });
+  return entry;
+}
+
+std::string OperatorTuneCache::Demangle(const char *name) {
+#if defined(__GNUC__) && !defined(__mips__)
+  int status = -4;
+  std::unique_ptr<char, void (*)(void *)> res{
+    abi::__cxa_demangle(name, nullptr, nullptr, &status),
+    &std::free
+  };
+  return status ? name : res.get();
+#else
+  return name;
+#endif
+}
+
+bool OperatorTuneCache::Restore(TunedWorkload *entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  auto iter = cached_.find(entry->name);
+  if (iter == cached_.end()) {
+    return false;
+  }
+  *entry->workload = iter->second;
+  return true;
+}
+
+void OperatorTuneCache::Store(const TunedWorkload *entry) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!path_.empty()) {
+    cached_[entry->name] = *entry->workload;
+    dirty_ = true;
+  }
+}
+
+bool OperatorTuneCache::RestoreOMPOverhead(int64_t *omp_overhead_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (cached_omp_overhead_ns_ < 0) {
+    return false;
+  }
+  *omp_overhead_ns = cached_omp_overhead_ns_;
+  return true;
+}
+
+void OperatorTuneCache::StoreOMPOverhead(int64_t omp_overhead_ns) {
+  std::lock_guard<std::mutex> lock(mutex_);
+  if (!path_.empty()) {
+    cached_omp_overhead_ns_ = omp_overhead_ns;
+    dirty_ = true;
+  }
+}
+
+void OperatorTuneCache::Sample(LaunchWorkload *entry, size_t N, int64_t duration_ns) {
+  entry->sampled_ns.fetch_add(static_cast<uint64_t>(duration_ns), std::memory_order_relaxed);
+  entry->sampled_iterations.fetch_add(N, std::memory_order_relaxed);
+}
+
+void OperatorTuneCache::Flush() {
+  std::lock_guard<std::mutex> lock(mutex_);
+  FlushLocked();
+}
+
+void OperatorTuneCache::FlushLocked() {
+  if (path_.empty() || !dirty_) {
+    return;
+  }
+  dirty_ = false;
+  if (!WriteFile(path_, key_, cached_omp_overhead_ns_, cached_)) {
+    LOG(WARNING) << "Failed to write operator tuning cache " << path_;
+  }
+}
+
+void OperatorTuneCache::RetuneLoop() {
+  while (true) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(retune_interval_ms_));
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (auto &kv : launches_) {
+      LaunchWorkload *entry = kv.second.get();
+      const uint64_t iterations = entry->sampled_iterations.exchange(0);
+      const uint64_t ns = entry->sampled_ns.exchange(0);
+      if (!iterations || !ns) {
+        continue;
+      }
+      const float measured = static_cast<float>(
+        static_cast<double>(ns) * OperatorTuneBase::WORKLOAD_COUNT / iterations);
+      // Launches only read the workload to choose between serial and OMP, they need no
+      // ordering with anything else
+      const float previous = entry->workload.load(std::memory_order_relaxed);
+      const float workload = previous > 0.0f
+                             ? (1.0f - kRetuneWeight) * previous + kRetuneWeight * measured
+                             : measured;
+      entry->workload.store(workload, std::memory_order_relaxed);
+      // Small fluctuations are not worth rewriting the file for
+      if (!path_.empty()
+          && std::abs(workload - entry->stored) > kStoreThreshold * entry->stored) {
+        cached_[entry->name] = { workload };
+        entry->stored = workload;
+        dirty_ = true;
+      }
+    }
+    FlushLocked();
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,218 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+/*!
+ * \file operator_tune_cache.h
+ * \brief on-disk cache of the OperatorTune workloads, and re-tuning of the workloads from
+ *        the timings of real Kernel::LaunchTuned() calls
+ */
+#ifndef MXNET_OPERATOR_OPERATOR_TUNE_CACHE_H_
+#define MXNET_OPERATOR_OPERATOR_TUNE_CACHE_H_
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <typeindex>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace op {
+
+/*!
+ * \brief Workload of one tuned kernel for one data type, as measured at startup or loaded
+ *        from the cache
+ */
+struct TunedWorkload {
+  /*! \brief Demangled name of the tuned_op type, unique per kernel and data type */
+  std::string name;
+  /*! \brief The tuned_op<...>::workload_ this entry tunes */
+  std::vector<float> *workload;
+  /*! \brief Whether workload[0] is the standard nanoseconds per WORKLOAD_COUNT iterations */
+  bool retunable;
+};
+
+/*!
+ * \brief Serial workload of one kernel launched by Kernel::LaunchTuned() with the workload of
+ *        a retunable tuned_op, refined from the timings of its serial launches. Launches
+ *        that would use OMP are also sampled, less often, by running them serially, so that
+ *        a kernel sent to OMP can be measured again and sent back.
+ *        Kernels sharing a tuned_op can differ a lot in cost, so each launched kernel has its
+ *        own entry, and the tuned_op<...>::workload_ itself is never changed after startup.
+ */
+struct LaunchWorkload {
+  /*! \brief Demangled name of the tuned_launch type, unique per kernel and tuned_op */
+  std::string name;
+  /*! \brief Nanoseconds per WORKLOAD_COUNT serial iterations, 0 until measured */
+  std::atomic<float> workload{0.0f};
+  /*! \brief Number of launches long enough to be sampled */
+  std::atomic<uint64_t> launches{0};
+  /*! \brief Sum of the sampled durations in nanoseconds */
+  std::atomic<uint64_t> sampled_ns{0};
+  /*! \brief Sum of the iterations of the sampled launches */
+  std::atomic<uint64_t> sampled_iterations{0};
+  /*! \brief Workload last recorded for the cache file, guarded by the registry mutex */
+  float stored = 0.0f;
+
+  /*! \brief Timing every launch would slow the launches down, time one in this many */
+  static constexpr uint64_t kSampleInterval = 64;
+  /*! \brief Launches that would use OMP are run serially to be timed one in this many */
+  static constexpr uint64_t kOMPSampleInterval = 1024;
+  /*! \brief Shorter launches are dominated by the timer, they are not sampled */
+  static constexpr size_t kMinSampleIterations = 4096;
+
+  /*!
+   * \brief Whether to time this launch
+   * \param use_omp Whether the launch would use OMP, it then runs serially if sampled
+   * \return true for every kSampleInterval-th launch, or kOMPSampleInterval-th with use_omp
+   */
+  inline bool ShouldSample(const bool use_omp) {
+    const uint64_t launch = launches.fetch_add(1, std::memory_order_relaxed);
+    return launch % (use_omp ? kOMPSampleInterval : kSampleInterval) == 0;
+  }
+};
+
+/*!
+ * \brief Process-wide registry of the tuned kernel workloads.
+ *        When MXNET_OPERATOR_TUNE_CACHE_DIR is set, the workloads and the OMP overhead are
+ *        loaded from a cache file keyed by CPU model, thread count and build, instead of being
+ *        measured at startup, and newly measured values are written back.
+ *        When MXNET_OPERATOR_RETUNE is set, a background thread folds the timings sampled from
+ *        Kernel::LaunchTuned() calls, run serially, into a workload per launched kernel.
+ */
+class OperatorTuneCache {
+ public:
+  /*! \brief Cache file format version, bump when the meaning of the workloads changes */
+  static constexpr int kVersion = 1;
+
+  /*!
+   * \brief Get the process-wide registry
+   * \return Pointer to the registry, safe to call during static initialization
+   */
+  static OperatorTuneCache *Get();
+
+  /*!
+   * \brief Register a tuned kernel workload
+   * \param type typeid of the tuned_op<...> type owning the workload
+   * \param name Demangled name of that type
+   * \param workload The tuned_op<...>::workload_ vector
+   * \param retunable Whether workload[0] may be refined from launch timings
+   * \return The registry entry
+   */
+  TunedWorkload *Register(const std::type_index &type, const std::string &name,
+                          std::vector<float> *workload, bool retunable);
+
+  /*!
+   * \brief Entry to sample the launches of a kernel for
+   * \param launch typeid of the tuned_launch<...> type of the launched kernel
+   * \param tuned typeid of the tuned_op<...> type whose workload the launches use
+   * \return The entry, or nullptr if re-tuning is off or the tuned_op is not retunable
+   */
+  LaunchWorkload *ForRetune(const std::type_index &launch, const std::type_index &tuned);
+
+  /*!
+   * \brief Set the workload of a registered kernel from the cache
+   * \param entry Registry entry
+   * \return true if the cache has a value for the kernel
+   */
+  bool Restore(TunedWorkload *entry);
+
+  /*!
+   * \brief Record a measured workload to be written to the cache
+   * \param entry Registry entry whose workload was measured
+   */
+  void Store(const TunedWorkload *entry);
+
+  /*!
+   * \brief OMP overhead from the cache
+   * \param omp_overhead_ns Receives the overhead in nanoseconds
+   * \return true if the cache has a value
+   */
+  bool RestoreOMPOverhead(int64_t *omp_overhead_ns);
+
+  /*!
+   * \brief Record the measured OMP overhead to be written to the cache
+   * \param omp_overhead_ns The overhead in nanoseconds
+   */
+  void StoreOMPOverhead(int64_t omp_overhead_ns);
+
+  /*!
+   * \brief Record the timing of a sampled serial launch
+   * \param entry Entry of the launched kernel
+   * \param N Number of iterations of the launch
+   * \param duration_ns Duration of the launch in nanoseconds
+   */
+  void Sample(LaunchWorkload *entry, size_t N, int64_t duration_ns);
+
+  /*!
+   * \brief Write the cache file if anything changed since it was loaded or written
+   */
+  void Flush();
+
+  /*!
+   * \brief Read a cache file
+   * \param path File path
+   * \param key Expected key, a file with another key is ignored
+   * \param omp_overhead_ns Receives the OMP overhead, -1 if absent
+   * \param workloads Receives the workloads by kernel name
+   * \return true if the file exists and matches the version and key
+   */
+  static bool ReadFile(const std::string &path, const std::string &key, int64_t *omp_overhead_ns,
+                       std::unordered_map<std::string, std::vector<float>> *workloads);
+
+  /*!
+   * \brief Write a cache file, atomically replacing an existing one
+   * \return true on success
+   */
+  static bool WriteFile(const std::string &path, const std::string &key, int64_t omp_overhead_ns,
+                        const std::unordered_map<std::string, std::vector<float>> &workloads);
+
+  /*!
+   * \brief Key of the cache of this process
+   * \return CPU model, number of processors, tuning core count and build, on one line
+   */
+  static std::string CacheKey();
+
+ private:
+  OperatorTuneCache();
+  void RetuneLoop();
+  void FlushLocked();
+  static std::string Demangle(const char *name);
+
+  /*! \brief Cache file path, empty when caching is disabled */
+  std::string path_;
+  std::string key_;
+  /*! \brief Guards the members below */
+  std::mutex mutex_;
+  std::unordered_map<std::type_index, std::unique_ptr<TunedWorkload>> entries_;
+  std::unordered_map<std::type_index, std::unique_ptr<LaunchWorkload>> launches_;
+  /*! \brief Workloads loaded from or to be written to the cache file */
+  std::unordered_map<std::string, std::vector<float>> cached_;
+  int64_t cached_omp_overhead_ns_ = -1;
+  bool dirty_ = false;
+  /*! \brief Background re-tuning */
+  bool retune_ = false;
+  int retune_interval_ms_ = 10000;
+  std::once_flag retune_started_;
+};
+
+}  // namespace op
+}  // namespace mxnet
+#endif  // MXNET_OPERATOR_OPERATOR_TUNE_CACHE_H_
@@ -507,6 +507,9 @@ void SimpleOpRegEntryImpl::RegisterSourceImperative() {
 #endif
       }, ret.ctx(), {}, write_vars,
       FnProperty::kNormal, 0, "RegisterSourceImperative");
+    for (const Resource& r : env.resource) {
+      ResourceManager::Get()->Release(r);
+    }
   };
   // register the function.
   NDArrayReg()
@@ -691,6 +694,9 @@ void SimpleOpRegEntryImpl::RegisterUnaryImperative() {
 #endif
       }, src.ctx(), const_vars, write_vars,
       FnProperty::kNormal, 0, "RegisterUnaryImperative");
+    for (const Resource& r : env.resource) {
+      ResourceManager::Get()->Release(r);
+    }
   };
   // register the function.
   NDArrayReg()
@@ -965,6 +971,9 @@ void SimpleOpRegEntryImpl::RegisterBinaryImperative() {
         #endif
       }, lhs.ctx(), const_vars, write_vars,
       FnProperty::kNormal, 0, "RegisterBinaryImperative");
+    for (const Resource& r : env.resource) {
+      ResourceManager::Get()->Release(r);
+    }
   };
   // register the function.
   NDArrayReg()
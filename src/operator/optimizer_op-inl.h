@@ -32,6 +32,9 @@
 #include <mshadow/base.h>
 #include <nnvm/op.h>
 #include <nnvm/op_attr_types.h>
+#include <algorithm>
+#include <string>
+#include <utility>
 #include <vector>
 #include "./operator_common.h"
 #include "./mshadow_op.h"
@@ -379,6 +382,515 @@ inline void MultiSGDMomUpdate(const nnvm::NodeAttrs& attrs,
   });
 }
 
+struct MultiAdamParam : public dmlc::Parameter<MultiAdamParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float beta1;
+  float beta2;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  float clip_global_norm;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiAdamParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(beta1)
+    .set_default(0.9f)
+    .describe("The decay rate for the 1st moment estimates.");
+    DMLC_DECLARE_FIELD(beta2)
+    .set_default(0.999f)
+    .describe("The decay rate for the 2nd moment estimates.");
+    DMLC_DECLARE_FIELD(epsilon)
+    .set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_global_norm)
+    .set_default(-1.0f)
+    .describe("If positive, all the gradients are scaled by "
+              "min(1, clip_global_norm / norm), where norm is the L2 norm of "
+              "rescale_grad*grad over all the updated weights.");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiRMSPropParam : public dmlc::Parameter<MultiRMSPropParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float gamma1;
+  float epsilon;
+  float rescale_grad;
+  float clip_gradient;
+  float clip_weights;
+  float clip_global_norm;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiRMSPropParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(gamma1).set_default(0.95f)
+    .describe("The decay rate of momentum estimates.");
+    DMLC_DECLARE_FIELD(epsilon).set_default(1e-8f)
+    .describe("A small constant for numerical stability.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_weights)
+    .set_default(-1.0f)
+    .describe("Clip weights to the range of [-clip_weights, clip_weights] "
+              "If clip_weights <= 0, weight clipping is turned off. "
+              "weights = max(min(weights, clip_weights), -clip_weights).");
+    DMLC_DECLARE_FIELD(clip_global_norm)
+    .set_default(-1.0f)
+    .describe("If positive, all the gradients are scaled by "
+              "min(1, clip_global_norm / norm), where norm is the L2 norm of "
+              "rescale_grad*grad over all the updated weights.");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+struct MultiNAGMomParam : public dmlc::Parameter<MultiNAGMomParam> {
+  mxnet::Tuple<float> lrs;
+  mxnet::Tuple<float> wds;
+  float momentum;
+  float rescale_grad;
+  float clip_gradient;
+  float clip_global_norm;
+  int num_weights;
+  DMLC_DECLARE_PARAMETER(MultiNAGMomParam) {
+    DMLC_DECLARE_FIELD(lrs)
+    .describe("Learning rates.");
+    DMLC_DECLARE_FIELD(wds)
+    .describe("Weight decay augments the objective function with a "
+              "regularization term that penalizes large weights. "
+              "The penalty scales with the square of the magnitude of each weight.");
+    DMLC_DECLARE_FIELD(momentum)
+    .set_default(0.0f)
+    .describe("The decay rate of momentum estimates at each epoch.");
+    DMLC_DECLARE_FIELD(rescale_grad)
+    .set_default(1.0f)
+    .describe("Rescale gradient to grad = rescale_grad*grad.");
+    DMLC_DECLARE_FIELD(clip_gradient)
+    .set_default(-1.0f)
+    .describe("Clip gradient to the range of [-clip_gradient, clip_gradient] "
+              "If clip_gradient <= 0, gradient clipping is turned off. "
+              "grad = max(min(grad, clip_gradient), -clip_gradient).");
+    DMLC_DECLARE_FIELD(clip_global_norm)
+    .set_default(-1.0f)
+    .describe("If positive, all the gradients are scaled by "
+              "min(1, clip_global_norm / norm), where norm is the L2 norm of "
+              "rescale_grad*grad over all the updated weights.");
+    DMLC_DECLARE_FIELD(num_weights)
+    .set_default(1)
+    .describe("Number of updated weights.");
+  }
+};
+
+/*!
+ * \brief Arguments of the fused multi-tensor updates. The struct is passed by value to the
+ *  GPU kernel, so N is bounded by the 4KB kernel argument limit. An update needing more
+ *  per-weight arguments derives from it and names the derived struct as its KernelParam.
+ */
+template<typename DType, typename MPDType>
+struct MultiUpdateKernelParam {
+  static const int N = 45;
+  int count;
+  size_t max_size;
+  size_t sizes[N];
+  DType * weights[N];
+  DType * grads[N];
+  MPDType * states0[N];
+  MPDType * states1[N];
+  MPDType * weights32[N];
+  DType * out_data[N];
+  MPDType lrs[N];
+  MPDType wds[N];
+  MPDType rescale_grad;
+  MPDType clip_gradient;
+  MPDType clip_weights;
+  MPDType clip_global_norm;
+  MPDType beta1;
+  MPDType beta2;
+  MPDType epsilon;
+  MPDType gamma1;
+  MPDType momentum;
+  // sum of squares of all the gradients, nullptr if clip_global_norm is off
+  float * sum_sq;
+};
+
+/*!
+ * \brief factor applied to the rescaled gradients by global norm clipping
+ */
+template<typename DType, typename MPDType>
+MSHADOW_XINLINE MPDType MultiUpdateGradScale(const MultiUpdateKernelParam<DType, MPDType>& param) {
+  if (param.sum_sq == nullptr) return MPDType(1);
+  const float norm = mshadow_op::abs::Map(static_cast<float>(param.rescale_grad)) *
+                     mshadow_op::square_root::Map(*param.sum_sq);
+  const float clip = static_cast<float>(param.clip_global_norm);
+  return norm > clip ? MPDType(clip / norm) : MPDType(1);
+}
+
+template <bool has_mixed_precision>
+struct MultiAdamKernel {
+  typedef MultiAdamParam ParamType;
+  template<typename DType, typename MPDType>
+  using KernelParam = MultiUpdateKernelParam<DType, MPDType>;
+  static const int kNumStates = 2;
+
+  template<typename DType, typename MPDType>
+  static void SetParam(const ParamType& p, MultiUpdateKernelParam<DType, MPDType>* param) {
+    param->beta1 = p.beta1;
+    param->beta2 = p.beta2;
+    param->epsilon = p.epsilon;
+  }
+
+  template<typename DType, typename MPDType>
+  MSHADOW_XINLINE static void Map(size_t i, int index,
+                                  const MultiUpdateKernelParam<DType, MPDType>& param,
+                                  const MPDType scale, const OpReqType req) {
+    MPDType w = has_mixed_precision ? param.weights32[index][i] :
+                                      MPDType(param.weights[index][i]);
+    MPDType grad = scale * param.rescale_grad * static_cast<MPDType>(param.grads[index][i])
+                   + param.wds[index] * w;
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    const MPDType mean = param.beta1 * param.states0[index][i] + (1 - param.beta1) * grad;
+    const MPDType var = param.beta2 * param.states1[index][i] +
+                        (1 - param.beta2) * mshadow_op::square::Map(grad);
+    param.states0[index][i] = mean;
+    param.states1[index][i] = var;
+    w = w - param.lrs[index] * mean / (mshadow_op::square_root::Map(var) + param.epsilon);
+    if (has_mixed_precision) {
+      param.weights32[index][i] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[index][i], req, w);
+  }
+};
+
+template <bool has_mixed_precision>
+struct MultiRMSPropKernel {
+  typedef MultiRMSPropParam ParamType;
+  template<typename DType, typename MPDType>
+  using KernelParam = MultiUpdateKernelParam<DType, MPDType>;
+  static const int kNumStates = 1;
+
+  template<typename DType, typename MPDType>
+  static void SetParam(const ParamType& p, MultiUpdateKernelParam<DType, MPDType>* param) {
+    param->gamma1 = p.gamma1;
+    param->epsilon = p.epsilon;
+    param->clip_weights = p.clip_weights;
+  }
+
+  template<typename DType, typename MPDType>
+  MSHADOW_XINLINE static void Map(size_t i, int index,
+                                  const MultiUpdateKernelParam<DType, MPDType>& param,
+                                  const MPDType scale, const OpReqType req) {
+    MPDType w = has_mixed_precision ? param.weights32[index][i] :
+                                      MPDType(param.weights[index][i]);
+    MPDType grad = scale * param.rescale_grad * static_cast<MPDType>(param.grads[index][i])
+                   + param.wds[index] * w;
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    const MPDType n = (1 - param.gamma1) * mshadow_op::square::Map(grad) +
+                      param.gamma1 * param.states0[index][i];
+    param.states0[index][i] = n;
+    w = w - param.lrs[index] * grad / mshadow_op::square_root::Map(n + param.epsilon);
+    if (param.clip_weights >= 0.0f) {
+      w = mshadow_op::clip::Map(w, param.clip_weights);
+    }
+    if (has_mixed_precision) {
+      param.weights32[index][i] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[index][i], req, w);
+  }
+};
+
+template <bool has_mixed_precision>
+struct MultiNAGMomKernel {
+  typedef MultiNAGMomParam ParamType;
+  template<typename DType, typename MPDType>
+  using KernelParam = MultiUpdateKernelParam<DType, MPDType>;
+  static const int kNumStates = 1;
+
+  template<typename DType, typename MPDType>
+  static void SetParam(const ParamType& p, MultiUpdateKernelParam<DType, MPDType>* param) {
+    param->momentum = p.momentum;
+  }
+
+  template<typename DType, typename MPDType>
+  MSHADOW_XINLINE static void Map(size_t i, int index,
+                                  const MultiUpdateKernelParam<DType, MPDType>& param,
+                                  const MPDType scale, const OpReqType req) {
+    MPDType w = has_mixed_precision ? param.weights32[index][i] :
+                                      MPDType(param.weights[index][i]);
+    MPDType grad = scale * param.rescale_grad * static_cast<MPDType>(param.grads[index][i]);
+    if (param.clip_gradient >= 0.0f) {
+      grad = mshadow_op::clip::Map(grad, param.clip_gradient);
+    }
+    const MPDType mom = param.momentum * param.states0[index][i] + grad + param.wds[index] * w;
+    param.states0[index][i] = mom;
+    w = w - param.lrs[index] * (param.momentum * mom + grad);
+    if (has_mixed_precision) {
+      param.weights32[index][i] = w;
+    }
+    KERNEL_ASSIGN(param.out_data[index][i], req, w);
+  }
+};
+
+/*!
+ * \brief element-wise kernel over the largest tensor, used on GPU
+ */
+template<typename UpdateOP>
+struct MultiUpdateKernel {
+  template<typename KernelParam>
+  MSHADOW_XINLINE static void Map(int i, const KernelParam& param, const OpReqType req) {
+    const auto scale = MultiUpdateGradScale(param);
+    for (int index = 0; index < param.count; ++index) {
+      if (static_cast<size_t>(i) < param.sizes[index]) {
+        UpdateOP::Map(i, index, param, scale, req);
+      }
+    }
+  }
+};
+
+/*! \brief number of elements of a tensor updated by one CPU task */
+const size_t kMultiUpdateChunk = 8192;
+
+/*!
+ * \brief Update all the tensors in one parallel loop. Every tensor is cut in chunks so that
+ *  small and large tensors balance over the threads, and the inner loop is contiguous.
+ */
+template<typename UpdateOP, typename KernelParam>
+inline void MultiUpdateLaunch(mshadow::Stream<cpu>* s,
+                              const KernelParam& param,
+                              const OpReqType req) {
+  std::vector<std::pair<int, size_t>> chunks;
+  for (int index = 0; index < param.count; ++index) {
+    for (size_t start = 0; start < param.sizes[index]; start += kMultiUpdateChunk) {
+      chunks.emplace_back(index, start);
+    }
+  }
+  const int num_chunks = static_cast<int>(chunks.size());
+  if (num_chunks == 0) return;
+  const int omp_threads =
+    std::max(1, std::min(num_chunks, engine::OpenMP::Get()->GetRecommendedOMPThreadCount()));
+  if (param.sum_sq != nullptr) {
+    double sum_sq = 0;
+    #pragma omp parallel for num_threads(omp_threads) reduction(+:sum_sq)
+    for (int c = 0; c < num_chunks; ++c) {
+      const auto* grad = param.grads[chunks[c].first];
+      const size_t end = std::min(chunks[c].second + kMultiUpdateChunk,
+                                  param.sizes[chunks[c].first]);
+      float chunk_sum = 0;
+      for (size_t i = chunks[c].second; i < end; ++i) {
+        const float g = static_cast<float>(grad[i]);
+        chunk_sum += g * g;
+      }
+      sum_sq += chunk_sum;
+    }
+    *param.sum_sq = static_cast<float>(sum_sq);
+  }
+  const auto scale = MultiUpdateGradScale(param);
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int c = 0; c < num_chunks; ++c) {
+    const int index = chunks[c].first;
+    const size_t end = std::min(chunks[c].second + kMultiUpdateChunk, param.sizes[index]);
+    for (size_t i = chunks[c].second; i < end; ++i) {
+      UpdateOP::Map(i, index, param, scale, req);
+    }
+  }
+}
+
+#ifdef __CUDACC__
+template<typename KernelParam>
+__global__ void MultiSumSqKernel(const KernelParam param) {
+  __shared__ float partial[mshadow::cuda::kBaseThreadNum];
+  const int index = blockIdx.y;
+  float sum = 0;
+  for (size_t i = blockIdx.x * blockDim.x + threadIdx.x; i < param.sizes[index];
+       i += blockDim.x * gridDim.x) {
+    const float g = static_cast<float>(param.grads[index][i]);
+    sum += g * g;
+  }
+  partial[threadIdx.x] = sum;
+  __syncthreads();
+  for (int offset = blockDim.x / 2; offset > 0; offset >>= 1) {
+    if (threadIdx.x < offset) {
+      partial[threadIdx.x] += partial[threadIdx.x + offset];
+    }
+    __syncthreads();
+  }
+  if (threadIdx.x == 0) {
+    atomicAdd(param.sum_sq, partial[0]);
+  }
+}
+
+template<typename UpdateOP, typename KernelParam>
+inline void MultiUpdateLaunch(mshadow::Stream<gpu>* s,
+                              const KernelParam& param,
+                              const OpReqType req) {
+  using namespace mxnet_op;
+  if (param.max_size == 0) return;
+  if (param.sum_sq != nullptr) {
+    cudaStream_t stream = mshadow::Stream<gpu>::GetStream(s);
+    CUDA_CALL(cudaMemsetAsync(param.sum_sq, 0, sizeof(float), stream));
+    const size_t num_blocks = std::min<size_t>(
+      mshadow::cuda::kMaxGridNum,
+      (param.max_size + mshadow::cuda::kBaseThreadNum - 1) / mshadow::cuda::kBaseThreadNum);
+    MultiSumSqKernel<KernelParam>
+      <<<dim3(num_blocks, param.count), mshadow::cuda::kBaseThreadNum, 0, stream>>>(param);
+    MSHADOW_CUDA_POST_KERNEL_CHECK(MultiSumSqKernel);
+  }
+  Kernel<MultiUpdateKernel<UpdateOP>, gpu>::Launch(s, param.max_size, param, req);
+}
+#endif  // __CUDACC__
+
+/*!
+ * \brief Fill the pointers of a fused update. Inputs come in groups of input_stride:
+ *  weight, grad, num_states states and, for mixed precision, the fp32 weight.
+ */
+template<typename xpu, typename DType, typename MPDType, typename ParamType,
+         int input_stride, int num_states>
+void FillMultiUpdateKernelParam(
+    const ParamType& p, const OpContext &ctx, const std::vector<TBlob> &inputs,
+    const std::vector<TBlob> &outputs, const float rescale_grad,
+    MultiUpdateKernelParam<DType, MPDType>* out) {
+  MultiUpdateKernelParam<DType, MPDType>& param = *out;
+  const int max_weights = MultiUpdateKernelParam<DType, MPDType>::N;
+  CHECK_LE(p.num_weights, max_weights)
+    << "At most " << max_weights << " weights can be updated by one fused update";
+  param.count = p.num_weights;
+  param.max_size = 0;
+  param.rescale_grad = rescale_grad;
+  param.clip_gradient = p.clip_gradient;
+  param.clip_global_norm = p.clip_global_norm;
+  param.sum_sq = nullptr;
+  for (int i = 0; i < param.count; ++i) {
+    param.sizes[i] = inputs[i * input_stride].shape_.Size();
+    param.max_size = std::max(param.max_size, param.sizes[i]);
+    param.weights[i] = inputs[i * input_stride].dptr<DType>();
+    param.grads[i] = inputs[i * input_stride + 1].dptr<DType>();
+    if (num_states > 0) {
+      param.states0[i] = inputs[i * input_stride + 2].dptr<MPDType>();
+    }
+    if (num_states > 1) {
+      param.states1[i] = inputs[i * input_stride + 3].dptr<MPDType>();
+    }
+    if (!std::is_same<DType, MPDType>::value) {
+      param.weights32[i] = inputs[i * input_stride + input_stride - 1].dptr<MPDType>();
+    }
+    param.out_data[i] = outputs[i].dptr<DType>();
+    param.lrs[i] = p.lrs[i];
+    param.wds[i] = p.wds[i];
+  }
+}
+
+template<typename xpu, template<bool> class UpdateKernel,
+         template<typename> class MPTypeChooser, int input_stride>
+inline void MultiUpdateImpl(const nnvm::NodeAttrs& attrs,
+                            const OpContext &ctx,
+                            const std::vector<TBlob> &inputs,
+                            const std::vector<OpReqType> &req,
+                            const std::vector<TBlob> &outputs,
+                            const float rescale_grad) {
+  using namespace mxnet_op;
+  typedef typename UpdateKernel<false>::ParamType ParamType;
+  const ParamType& p = nnvm::get<ParamType>(attrs.parsed);
+  Stream<xpu>* s = ctx.get_stream<xpu>();
+  MSHADOW_REAL_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    using MPDType = typename MPTypeChooser<DType>::type;
+    typedef UpdateKernel<!std::is_same<DType, MPDType>::value> UpdateOP;
+    typename UpdateOP::template KernelParam<DType, MPDType> param;
+    FillMultiUpdateKernelParam<xpu, DType, MPDType, ParamType, input_stride,
+                               UpdateOP::kNumStates>(p, ctx, inputs, outputs, rescale_grad,
+                                                     &param);
+    UpdateOP::SetParam(p, &param);
+    if (p.clip_global_norm > 0.0f) {
+      param.sum_sq = ctx.requested[0].get_space_typed<xpu, 1, float>(Shape1(1), s).dptr_;
+    }
+    MultiUpdateLaunch<UpdateOP>(s, param, req[0]);
+  });
+}
+
+template<typename xpu, template<bool> class UpdateKernel,
+         template<typename> class MPTypeChooser, int input_stride>
+inline void MultiUpdate(const nnvm::NodeAttrs& attrs,
+                        const OpContext &ctx,
+                        const std::vector<TBlob> &inputs,
+                        const std::vector<OpReqType> &req,
+                        const std::vector<TBlob> &outputs) {
+  typedef typename UpdateKernel<false>::ParamType ParamType;
+  const ParamType& p = nnvm::get<ParamType>(attrs.parsed);
+  MultiUpdateImpl<xpu, UpdateKernel, MPTypeChooser, input_stride>(
+    attrs, ctx, inputs, req, outputs, p.rescale_grad);
+}
+
+template<typename ParamType, int input_stride, int num_extra_inputs = 0>
+inline uint32_t MultiUpdateNumInputs(const nnvm::NodeAttrs& attrs) {
+  const ParamType& param = dmlc::get<ParamType>(attrs.parsed);
+  return static_cast<uint32_t>(param.num_weights * input_stride + num_extra_inputs);
+}
+
+template<typename ParamType>
+inline uint32_t MultiUpdateNumOutputs(const nnvm::NodeAttrs& attrs) {
+  const ParamType& param = dmlc::get<ParamType>(attrs.parsed);
+  return static_cast<uint32_t>(param.num_weights);
+}
+
+/*!
+ * \brief input names of a fused update, one group of prefixes per weight
+ */
+inline std::vector<std::string> MultiUpdateInputNames(const int num_weights,
+                                                      const std::vector<std::string>& prefixes) {
+  std::vector<std::string> ret;
+  for (int i = 0; i < num_weights; ++i) {
+    for (const auto& prefix : prefixes) {
+      ret.push_back(prefix + std::to_string(i));
+    }
+  }
+  return ret;
+}
+
+/*!
+ * \brief everything after weight and grad in a group is an updated state
+ */
+template<typename ParamType, int input_stride>
+inline std::vector<uint32_t> MultiUpdateMutateInputs(const nnvm::NodeAttrs& attrs) {
+  const ParamType& param = dmlc::get<ParamType>(attrs.parsed);
+  std::vector<uint32_t> ret;
+  for (int i = 0; i < param.num_weights; ++i) {
+    for (int j = 2; j < input_stride; ++j) {
+      ret.push_back(i * input_stride + j);
+    }
+  }
+  return ret;
+}
+
 struct SGDKernel {
   template<typename DType>
   MSHADOW_XINLINE static void Map(int i, DType* out_data, const DType* weight_data,
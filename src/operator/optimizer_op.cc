@@ -33,6 +33,9 @@ DMLC_REGISTER_PARAMETER(SGDParam);
 DMLC_REGISTER_PARAMETER(SGDMomParam);
 DMLC_REGISTER_PARAMETER(MultiSGDParam);
 DMLC_REGISTER_PARAMETER(MultiSGDMomParam);
+DMLC_REGISTER_PARAMETER(MultiAdamParam);
+DMLC_REGISTER_PARAMETER(MultiRMSPropParam);
+DMLC_REGISTER_PARAMETER(MultiNAGMomParam);
 DMLC_REGISTER_PARAMETER(FTMLParam);
 DMLC_REGISTER_PARAMETER(AdamParam);
 DMLC_REGISTER_PARAMETER(NAGParam);
@@ -505,6 +508,187 @@ Where the parameter ``momentum`` is the decay rate of momentum estimates at each
 .add_argument("data", "NDArray-or-Symbol[]", "Weights")
 .add_arguments(MultiSGDMomParam::__FIELDS__());
 
+NNVM_REGISTER_OP(multi_adam_update)
+.describe(R"code(Update function for Adam optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.adam_update`
+for the update of each weight. The inputs are grouped per weight as
+weight, grad, mean and var.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiAdamParam, 4>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiAdamParam>)
+.set_attr_parser(ParamParser<MultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdamParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiAdamParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "mean_", "var_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiAdamParam, 4>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiAdamKernel, type_identity, 4>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means and variances")
+.add_arguments(MultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_adam_update)
+.describe(R"code(Update function for multi-precision Adam optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.adam_update`
+for the update of each weight. The inputs are grouped per weight as
+weight, grad, mean, var and the float32 copy of the weight.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiAdamParam, 5>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiAdamParam>)
+.set_attr_parser(ParamParser<MultiAdamParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiAdamParam, 5>)
+.set_attr<nnvm::FInferType>("FInferType", MP_MultiSGD_InferType<MultiAdamParam, 5, 3>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiAdamParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "mean_", "var_", "weight32_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiAdamParam, 5>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiAdamKernel, single_precision, 5>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, means, variances and "
+              "float32 weights")
+.add_arguments(MultiAdamParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.describe(R"code(Update function for RMSProp optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.rmsprop_update`
+for the update of each weight. The inputs are grouped per weight as weight, grad and n.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiRMSPropParam, 3>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiRMSPropParam>)
+.set_attr_parser(ParamParser<MultiRMSPropParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiRMSPropParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiRMSPropParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "n_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiRMSPropParam, 3>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiRMSPropKernel, type_identity, 3>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and n")
+.add_arguments(MultiRMSPropParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_rmsprop_update)
+.describe(R"code(Update function for multi-precision RMSProp optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.rmsprop_update`
+for the update of each weight. The inputs are grouped per weight as
+weight, grad, n and the float32 copy of the weight.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiRMSPropParam, 4>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiRMSPropParam>)
+.set_attr_parser(ParamParser<MultiRMSPropParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiRMSPropParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType", MP_MultiSGD_InferType<MultiRMSPropParam, 4, 2>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiRMSPropParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "n_", "weight32_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiRMSPropParam, 4>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiRMSPropKernel, single_precision, 4>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, n and float32 weights")
+.add_arguments(MultiRMSPropParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.describe(R"code(Update function for Nesterov Accelerated Gradient (NAG) optimizer,
+for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.nag_mom_update`
+for the update of each weight. The inputs are grouped per weight as weight, grad and mom.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiNAGMomParam, 3>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiNAGMomParam>)
+.set_attr_parser(ParamParser<MultiNAGMomParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiNAGMomParam, 3>)
+.set_attr<nnvm::FInferType>("FInferType", ElemwiseType<-1, -1>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiNAGMomParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "mom_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiNAGMomParam, 3>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiNAGMomKernel, type_identity, 3>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients and momentum")
+.add_arguments(MultiNAGMomParam::__FIELDS__());
+
+NNVM_REGISTER_OP(multi_mp_nag_mom_update)
+.describe(R"code(Update function for multi-precision Nesterov Accelerated Gradient (NAG)
+optimizer, for multiple weights at once.
+
+All the weights are updated in a single operator, see :class:`~mxnet.ndarray.mp_nag_mom_update`
+for the update of each weight. The inputs are grouped per weight as
+weight, grad, mom and the float32 copy of the weight.
+
+If ``clip_global_norm`` is positive, the rescaled gradients are first scaled by
+min(1, clip_global_norm / norm), where norm is the L2 norm of all the rescaled gradients.
+
+)code" ADD_FILELINE)
+.set_num_inputs(MultiUpdateNumInputs<MultiNAGMomParam, 4>)
+.set_num_outputs(MultiUpdateNumOutputs<MultiNAGMomParam>)
+.set_attr_parser(ParamParser<MultiNAGMomParam>)
+.set_attr<mxnet::FInferShape>("FInferShape", MultiSGDShape<MultiNAGMomParam, 4>)
+.set_attr<nnvm::FInferType>("FInferType", MP_MultiSGD_InferType<MultiNAGMomParam, 4, 2>)
+.set_attr<nnvm::FListInputNames>("FListInputNames",
+  [](const NodeAttrs& attrs) {
+    return MultiUpdateInputNames(dmlc::get<MultiNAGMomParam>(attrs.parsed).num_weights,
+                                 {"weight_", "grad_", "mom_", "weight32_"});
+  })
+.set_attr<nnvm::FMutateInputs>("FMutateInputs", MultiUpdateMutateInputs<MultiNAGMomParam, 4>)
+.set_attr<FResourceRequest>("FResourceRequest",
+  [](const NodeAttrs& attrs) {
+    return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+  })
+.set_attr<FCompute>("FCompute<cpu>", MultiUpdate<cpu, MultiNAGMomKernel, single_precision, 4>)
+.add_argument("data", "NDArray-or-Symbol[]", "Weights, gradients, momentum and float32 weights")
+.add_arguments(MultiNAGMomParam::__FIELDS__());
+
 NNVM_REGISTER_OP(sgd_update)
 MXNET_ADD_SPARSE_OP_ALIAS(sgd_update)
 .describe(R"code(Update function for Stochastic Gradient Descent (SGD) optimizer.
@@ -250,6 +250,18 @@ NNVM_REGISTER_OP(multi_mp_sgd_update)
 .set_attr<FCompute>("FCompute<gpu>", MultiSGDUpdate<gpu, single_precision, 3>);
 NNVM_REGISTER_OP(multi_mp_sgd_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", MultiSGDMomUpdate<gpu, single_precision, 4>);
+NNVM_REGISTER_OP(multi_adam_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiAdamKernel, type_identity, 4>);
+NNVM_REGISTER_OP(multi_mp_adam_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiAdamKernel, single_precision, 5>);
+NNVM_REGISTER_OP(multi_rmsprop_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiRMSPropKernel, type_identity, 3>);
+NNVM_REGISTER_OP(multi_mp_rmsprop_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiRMSPropKernel, single_precision, 4>);
+NNVM_REGISTER_OP(multi_nag_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiNAGMomKernel, type_identity, 3>);
+NNVM_REGISTER_OP(multi_mp_nag_mom_update)
+.set_attr<FCompute>("FCompute<gpu>", MultiUpdate<gpu, MultiNAGMomKernel, single_precision, 4>);
 
 NNVM_REGISTER_OP(nag_mom_update)
 .set_attr<FCompute>("FCompute<gpu>", NAGMomUpdate<gpu>);
@@ -0,0 +1,526 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file quantized_rnn.cc
+ * \brief int8 LSTM and GRU inference on CPU
+ */
+#include <mxnet/op_attr_types.h>
+#include <algorithm>
+#include <cmath>
+#include <string>
+#include <vector>
+#include "quantization_utils.h"
+#include "../rnn-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace quantized_rnn {
+enum QuantizedRNNOutputs {kOut, kOutMin, kOutMax};
+enum QuantizedRNNResource {kTempSpace};
+}  // namespace quantized_rnn
+
+/*!
+ * \brief One int8 weight matrix of an RNN layer, [gates * state_size, cols].
+ *        Every gate has its own scale, real weight = scale[gate] * weight.
+ */
+struct QuantizedRNNMatrix {
+  std::vector<int8_t> weight;
+  /*! \brief Sum of every row of weight, to apply the offset of uint8 activations */
+  std::vector<int32_t> row_sum;
+  std::vector<float> scale;
+};
+
+inline int QuantizedRNNGates(int mode) {
+  return mode == rnn_enum::kLstm ? 4 : 3;
+}
+
+/*!
+ * \brief Largest absolute value of x, in parallel
+ */
+inline float QuantizedRNNAbsMax(const float *x, size_t n, int omp_threads) {
+  std::vector<float> part(omp_threads, 0.0f);
+  const size_t chunk = (n + omp_threads - 1) / omp_threads;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int p = 0; p < omp_threads; ++p) {
+    const size_t end = std::min(n, (p + 1) * chunk);
+    float amax = 0.0f;
+    for (size_t i = p * chunk; i < end; ++i) {
+      amax = std::max(amax, std::abs(x[i]));
+    }
+    part[p] = amax;
+  }
+  return *std::max_element(part.begin(), part.end());
+}
+
+/*!
+ * \brief Quantize activations to uint8 around 128, real value = scale * (q - 128)
+ * \return scale
+ */
+inline float QuantizedRNNActivation(const float *x, size_t n, uint8_t *q, int omp_threads) {
+  const float amax = QuantizedRNNAbsMax(x, n, omp_threads);
+  const float scale = amax > 0.0f ? amax / 127.0f : 1.0f;
+  const float inv_scale = 1.0f / scale;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < static_cast<index_t>(n); ++i) {
+    const float v = std::max(-127.0f, std::min(127.0f, x[i] * inv_scale));
+    q[i] = static_cast<uint8_t>(static_cast<int>(std::nearbyint(v)) + 128);
+  }
+  return scale;
+}
+
+/*!
+ * \brief Quantize the [gates * H, cols] weight matrix w with one scale per gate
+ */
+inline void QuantizeRNNMatrix(const float *w, int gates, int H, int cols,
+                              QuantizedRNNMatrix *m, int omp_threads) {
+  const int rows = gates * H;
+  m->weight.resize(static_cast<size_t>(rows) * cols);
+  m->row_sum.resize(rows);
+  m->scale.resize(gates);
+  for (int g = 0; g < gates; ++g) {
+    const float amax = QuantizedRNNAbsMax(w + static_cast<size_t>(g) * H * cols,
+                                          static_cast<size_t>(H) * cols, omp_threads);
+    m->scale[g] = amax > 0.0f ? amax / 127.0f : 1.0f;
+  }
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int r = 0; r < rows; ++r) {
+    const float inv_scale = 1.0f / m->scale[r / H];
+    const float *w_row = w + static_cast<size_t>(r) * cols;
+    int8_t *q_row = m->weight.data() + static_cast<size_t>(r) * cols;
+    int32_t sum = 0;
+    for (int k = 0; k < cols; ++k) {
+      const float v = std::max(-127.0f, std::min(127.0f, w_row[k] * inv_scale));
+      q_row[k] = static_cast<int8_t>(std::nearbyint(v));
+      sum += q_row[k];
+    }
+    m->row_sum[r] = sum;
+  }
+}
+
+/*!
+ * \brief c[M, N] = a[M, K] * b[N, K]^T with uint8 a, int8 b and int32 accumulation
+ */
+inline void QuantizedRNNGemm(const uint8_t *a, const int8_t *b, int32_t *c,
+                             int M, int N, int K, int omp_threads) {
+#if MSHADOW_USE_MKL == 1
+  MKL_INT32 oc = 0;
+  cblas_gemm_s8u8s32(CblasRowMajor, CblasNoTrans, CblasTrans, CblasFixOffset,
+                     M, N, K, 1.0f, a, K, 0, b, K, 0, 0.0f, c, N, &oc);
+#else
+  // every thread keeps a block of rows of b in cache and streams a through it
+  const int kBlock = 16;
+  const int num_blocks = (N + kBlock - 1) / kBlock;
+  #pragma omp parallel for num_threads(omp_threads)
+  for (int nb = 0; nb < num_blocks; ++nb) {
+    const int n_end = std::min(N, (nb + 1) * kBlock);
+    for (int m = 0; m < M; ++m) {
+      const uint8_t *a_row = a + static_cast<size_t>(m) * K;
+      for (int n = nb * kBlock; n < n_end; ++n) {
+        const int8_t *b_row = b + static_cast<size_t>(n) * K;
+        int32_t acc = 0;
+        for (int k = 0; k < K; ++k) {
+          acc += static_cast<int32_t>(a_row[k]) * static_cast<int32_t>(b_row[k]);
+        }
+        c[static_cast<size_t>(m) * N + n] = acc;
+      }
+    }
+  }
+#endif
+}
+
+class QuantizedRNNOperator {
+ public:
+  explicit QuantizedRNNOperator(const nnvm::NodeAttrs &attrs)
+      : param_(nnvm::get<RNNParam>(attrs.parsed)) {}
+
+  void Forward(const OpContext &ctx,
+               const std::vector<NDArray> &inputs,
+               const std::vector<OpReqType> &req,
+               const std::vector<NDArray> &outputs);
+
+ private:
+  void QuantizeWeights(const float *params, int I, int omp_threads);
+
+  RNNParam param_;
+  bool initialized_{false};
+  size_t params_ver_{0};
+  int input_size_{0};
+  /*! \brief Wx and Wh of every layer and direction, in the order of the parameter vector */
+  std::vector<QuantizedRNNMatrix> weights_;
+};
+
+void QuantizedRNNOperator::QuantizeWeights(const float *params, int I, int omp_threads) {
+  const int H = param_.state_size;
+  const int D = param_.bidirectional ? 2 : 1;
+  const int G = QuantizedRNNGates(param_.mode);
+  weights_.resize(param_.num_layers * D * 2);
+  const float *w = params;
+  for (uint32_t l = 0; l < param_.num_layers; ++l) {
+    const int cols = l ? D * H : I;
+    for (int d = 0; d < D; ++d) {
+      const size_t idx = (l * D + d) * 2;
+      QuantizeRNNMatrix(w, G, H, cols, &weights_[idx], omp_threads);
+      w += static_cast<size_t>(G) * H * cols;
+      QuantizeRNNMatrix(w, G, H, H, &weights_[idx + 1], omp_threads);
+      w += static_cast<size_t>(G) * H * H;
+    }
+  }
+}
+
+void QuantizedRNNOperator::Forward(const OpContext &ctx,
+                                   const std::vector<NDArray> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<NDArray> &outputs) {
+  using namespace mshadow;
+  const size_t num_inputs = GetNumInputArguments(param_);
+  CHECK_EQ(inputs.size(), num_inputs + 2U);
+  CHECK_EQ(outputs.size(), 3U);
+  const bool lstm = param_.mode == rnn_enum::kLstm;
+  const TBlob data = inputs[rnn_enum::kData].data();
+  const TBlob params = inputs[rnn_enum::kParams].data();
+  const float *hx = inputs[rnn_enum::kState].data().dptr<float>();
+  const float *cx = lstm ? inputs[rnn_enum::kStateCell].data().dptr<float>() : nullptr;
+  const float data_min = inputs[num_inputs].data().dptr<float>()[0];
+  const float data_max = inputs[num_inputs + 1].data().dptr<float>()[0];
+
+  const int T = data.shape_[0];
+  const int N = data.shape_[1];
+  const int I = data.shape_[2];
+  const int H = param_.state_size;
+  const int D = param_.bidirectional ? 2 : 1;
+  const int L = param_.num_layers;
+  const int G = QuantizedRNNGates(param_.mode);
+  const int GH = G * H;
+  const int omp_threads = mxnet::engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+
+  // the int8 weights are kept until the parameters are written again
+  if (!initialized_ || params_ver_ != inputs[rnn_enum::kParams].version() || input_size_ != I) {
+    QuantizeWeights(params.dptr<float>(), I, omp_threads);
+    params_ver_ = inputs[rnn_enum::kParams].version();
+    input_size_ = I;
+    initialized_ = true;
+  }
+  size_t weight_size = 0;
+  for (const auto &m : weights_) weight_size += m.weight.size();
+  const float *bias = params.dptr<float>() + weight_size;
+
+  // workspace
+  const size_t TN = static_cast<size_t>(T) * N;
+  const size_t act_cols = std::max(I, D * H);
+  auto align = [](size_t bytes) { return (bytes + 63) / 64 * 64; };
+  const size_t act_bytes = align(TN * act_cols);
+  const size_t xproj_i32_bytes = align(TN * GH * sizeof(int32_t));
+  const size_t xproj_bytes = align(TN * GH * sizeof(float));
+  const size_t h_u8_bytes = align(static_cast<size_t>(N) * H);
+  const size_t hproj_bytes = align(static_cast<size_t>(N) * GH * sizeof(int32_t));
+  const size_t state_bytes = align(static_cast<size_t>(N) * H * sizeof(float));
+  const size_t y_bytes = align(TN * D * H * sizeof(float));
+  const size_t total_bytes = act_bytes + xproj_i32_bytes + xproj_bytes + h_u8_bytes +
+                             hproj_bytes + 2 * state_bytes + 2 * y_bytes;
+  Stream<cpu> *s = ctx.get_stream<cpu>();
+  char *ws = ctx.requested[quantized_rnn::kTempSpace]
+                 .get_space_typed<cpu, 1, char>(Shape1(total_bytes), s).dptr_;
+  uint8_t *act = reinterpret_cast<uint8_t*>(ws);
+  int32_t *xproj_i32 = reinterpret_cast<int32_t*>(ws += act_bytes);
+  float *xproj = reinterpret_cast<float*>(ws += xproj_i32_bytes);
+  uint8_t *h_u8 = reinterpret_cast<uint8_t*>(ws += xproj_bytes);
+  int32_t *hproj = reinterpret_cast<int32_t*>(ws += h_u8_bytes);
+  float *h = reinterpret_cast<float*>(ws += hproj_bytes);
+  float *c = reinterpret_cast<float*>(ws += state_bytes);
+  float *y_buf[2] = {reinterpret_cast<float*>(ws += state_bytes),
+                     reinterpret_cast<float*>(ws + y_bytes)};
+
+  // layer 0 reads the quantized data, real value = act_scale * q + act_offset
+  float act_scale, act_offset;
+  if (data.type_flag_ == mshadow::kUint8) {
+    act_scale = (data_max - data_min) / 255.0f;
+    act_offset = data_min;
+    std::copy(data.dptr<uint8_t>(), data.dptr<uint8_t>() + TN * I, act);
+  } else {
+    act_scale = MaxAbs(data_min, data_max) / 127.0f;
+    act_offset = -128.0f * act_scale;
+    const int8_t *q = data.dptr<int8_t>();
+    #pragma omp parallel for num_threads(omp_threads)
+    for (index_t i = 0; i < static_cast<index_t>(TN * I); ++i) {
+      act[i] = static_cast<uint8_t>(q[i] + 128);
+    }
+  }
+
+  float *y = nullptr;
+  for (int l = 0; l < L; ++l) {
+    const int cols = l ? D * H : I;
+    if (l) {
+      act_scale = QuantizedRNNActivation(y, TN * D * H, act, omp_threads);
+      act_offset = -128.0f * act_scale;
+    }
+    y = y_buf[l % 2];
+    for (int d = 0; d < D; ++d) {
+      const QuantizedRNNMatrix &wx = weights_[(l * D + d) * 2];
+      const QuantizedRNNMatrix &wh = weights_[(l * D + d) * 2 + 1];
+      const float *bx = bias + static_cast<size_t>(l * D + d) * 2 * GH;
+      const float *bh = bx + GH;
+
+      // input projection of all time steps at once, with the biases of every gate
+      // except the GRU candidate, whose hidden bias is scaled by the reset gate
+      QuantizedRNNGemm(act, wx.weight.data(), xproj_i32, TN, GH, cols, omp_threads);
+      #pragma omp parallel for num_threads(omp_threads)
+      for (index_t i = 0; i < static_cast<index_t>(TN * GH); ++i) {
+        const int n = i % GH;
+        const int g = n / H;
+        float v = wx.scale[g] * (act_scale * xproj_i32[i] + act_offset * wx.row_sum[n]) + bx[n];
+        if (lstm || g != 2) v += bh[n];
+        xproj[i] = v;
+      }
+
+      const size_t state_offset = static_cast<size_t>(l * D + d) * N * H;
+      std::copy(hx + state_offset, hx + state_offset + N * H, h);
+      if (lstm) std::copy(cx + state_offset, cx + state_offset + N * H, c);
+      for (int i = 0; i < T; ++i) {
+        const int t = d ? T - 1 - i : i;
+        const float h_scale = QuantizedRNNActivation(h, N * H, h_u8, omp_threads);
+        const float h_offset = -128.0f * h_scale;
+        QuantizedRNNGemm(h_u8, wh.weight.data(), hproj, N, GH, H, omp_threads);
+        #pragma omp parallel for num_threads(omp_threads)
+        for (int jk = 0; jk < N * H; ++jk) {
+          const int j = jk / H;
+          const int k = jk % H;
+          const float *xp = xproj + (static_cast<size_t>(t) * N + j) * GH;
+          const int32_t *hp_i32 = hproj + static_cast<size_t>(j) * GH;
+          auto hp = [&](int g) {
+            const int n = g * H + k;
+            return wh.scale[g] * (h_scale * hp_i32[n] + h_offset * wh.row_sum[n]);
+          };
+          float ht;
+          if (lstm) {
+            const float it = sigmoid<float>(xp[k] + hp(0));
+            const float ft = sigmoid<float>(xp[H + k] + hp(1));
+            const float gt = std::tanh(xp[2 * H + k] + hp(2));
+            const float ot = sigmoid<float>(xp[3 * H + k] + hp(3));
+            const float ct = ft * c[jk] + it * gt;
+            ht = ot * std::tanh(ct);
+            c[jk] = ct;
+          } else {
+            const float rt = sigmoid<float>(xp[k] + hp(0));
+            const float zt = sigmoid<float>(xp[H + k] + hp(1));
+            const float nt = std::tanh(xp[2 * H + k] + rt * (hp(2) + bh[2 * H + k]));
+            ht = (1.0f - zt) * nt + zt * h[jk];
+          }
+          h[jk] = ht;
+          y[(static_cast<size_t>(t) * N + j) * D * H + d * H + k] = ht;
+        }
+      }
+    }
+  }
+
+  // quantize the output of the last layer into int8
+  float out_range;
+  if (param_.min_calib_range.has_value() && param_.max_calib_range.has_value()) {
+    out_range = MaxAbs(param_.min_calib_range.value(), param_.max_calib_range.value());
+  } else {
+    out_range = QuantizedRNNAbsMax(y, TN * D * H, omp_threads);
+  }
+  if (out_range <= 0.0f) out_range = 1.0f;
+  const float out_scale = 127.0f / out_range;
+  int8_t *out = outputs[quantized_rnn::kOut].data().dptr<int8_t>();
+  #pragma omp parallel for num_threads(omp_threads)
+  for (index_t i = 0; i < static_cast<index_t>(TN * D * H); ++i) {
+    const float v = std::max(-127.0f, std::min(127.0f, y[i] * out_scale));
+    out[i] = static_cast<int8_t>(std::nearbyint(v));
+  }
+  outputs[quantized_rnn::kOutMin].data().dptr<float>()[0] = -out_range;
+  outputs[quantized_rnn::kOutMax].data().dptr<float>()[0] = out_range;
+}
+
+static std::vector<std::string> QuantizedRNNListInputNames(const NodeAttrs &attrs) {
+  const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+  std::vector<std::string> names{"data", "parameters", "state"};
+  if (param.mode == rnn_enum::kLstm) names.emplace_back("state_cell");
+  names.emplace_back("min_data");
+  names.emplace_back("max_data");
+  return names;
+}
+
+static bool QuantizedRNNShape(const nnvm::NodeAttrs &attrs,
+                              mxnet::ShapeVector *in_shape,
+                              mxnet::ShapeVector *out_shape) {
+  const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+  const size_t num_inputs = GetNumInputArguments(param);
+  CHECK_EQ(in_shape->size(), num_inputs + 2U);
+  CHECK_EQ(out_shape->size(), 3U);
+
+  const mxnet::TShape &dshape = (*in_shape)[rnn_enum::kData];
+  if (!mxnet::ndim_is_known(dshape)) return false;
+  CHECK_EQ(dshape.ndim(), 3U)
+      << "Input data should be rank-3 tensor of dim [sequence length, batch size, input size]";
+  const int D = param.bidirectional ? 2 : 1;
+  const int batch_size = dshape[1];
+  const mxnet::TShape state_shape = Shape3(D * param.num_layers, batch_size, param.state_size);
+  SHAPE_ASSIGN_CHECK(*in_shape, rnn_enum::kParams,
+                     Shape1(GetRnnParamSize(param.num_layers, dshape[2], param.state_size,
+                                            D, param.mode, param.projection_size)));
+  SHAPE_ASSIGN_CHECK(*in_shape, rnn_enum::kState, state_shape);
+  if (param.mode == rnn_enum::kLstm) {
+    SHAPE_ASSIGN_CHECK(*in_shape, rnn_enum::kStateCell, state_shape);
+  }
+  SHAPE_ASSIGN_CHECK(*in_shape, num_inputs, mxnet::TShape(1, 1));
+  SHAPE_ASSIGN_CHECK(*in_shape, num_inputs + 1, mxnet::TShape(1, 1));
+
+  mxnet::TShape oshape = dshape;
+  oshape[2] = D * param.state_size;
+  SHAPE_ASSIGN_CHECK(*out_shape, quantized_rnn::kOut, oshape);
+  SHAPE_ASSIGN_CHECK(*out_shape, quantized_rnn::kOutMin, mxnet::TShape(1, 1));
+  SHAPE_ASSIGN_CHECK(*out_shape, quantized_rnn::kOutMax, mxnet::TShape(1, 1));
+  return true;
+}
+
+static bool QuantizedRNNType(const nnvm::NodeAttrs &attrs,
+                             std::vector<int> *in_type,
+                             std::vector<int> *out_type) {
+  const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+  const size_t num_inputs = GetNumInputArguments(param);
+  CHECK_EQ(in_type->size(), num_inputs + 2U);
+  CHECK_EQ(out_type->size(), 3U);
+
+  CHECK(in_type->at(0) == mshadow::kInt8 || in_type->at(0) == mshadow::kUint8)
+      << "QuantizedRNN only supports int8/uint8 input, while "
+      << in_type->at(0) << " is given.";
+  for (size_t i = 1; i < num_inputs + 2U; ++i) {
+    TYPE_ASSIGN_CHECK(*in_type, i, mshadow::kFloat32);
+  }
+  TYPE_ASSIGN_CHECK(*out_type, quantized_rnn::kOut, mshadow::kInt8);
+  TYPE_ASSIGN_CHECK(*out_type, quantized_rnn::kOutMin, mshadow::kFloat32);
+  TYPE_ASSIGN_CHECK(*out_type, quantized_rnn::kOutMax, mshadow::kFloat32);
+  return true;
+}
+
+static bool QuantizedRNNStorageType(const nnvm::NodeAttrs &attrs,
+                                    const int dev_mask,
+                                    DispatchMode *dispatch_mode,
+                                    std::vector<int> *in_attrs,
+                                    std::vector<int> *out_attrs) {
+  return storage_type_assign(out_attrs, mxnet::kDefaultStorage,
+                             dispatch_mode, DispatchMode::kFComputeEx);
+}
+
+static OpStatePtr CreateQuantizedRNNState(const nnvm::NodeAttrs &attrs,
+                                          Context ctx,
+                                          const mxnet::ShapeVector &in_shapes,
+                                          const std::vector<int> &in_types) {
+  const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+  CHECK(param.mode == rnn_enum::kLstm || param.mode == rnn_enum::kGru)
+      << "QuantizedRNN only supports lstm and gru mode";
+  CHECK(!param.state_outputs) << "QuantizedRNN does not support state_outputs";
+  CHECK(!param.projection_size.has_value()) << "QuantizedRNN does not support projection_size";
+  CHECK(!param.use_sequence_length) << "QuantizedRNN does not support use_sequence_length";
+  CHECK(!param.lstm_state_clip_min.has_value() && !param.lstm_state_clip_max.has_value())
+      << "QuantizedRNN does not support LSTM state clipping";
+  return OpStatePtr::Create<QuantizedRNNOperator>(attrs);
+}
+
+static void QuantizedRNNForwardCPU(const OpStatePtr &state_ptr,
+                                   const OpContext &ctx,
+                                   const std::vector<NDArray> &inputs,
+                                   const std::vector<OpReqType> &req,
+                                   const std::vector<NDArray> &outputs) {
+  std::vector<NDArray> in_data(inputs);
+#if MXNET_USE_MKLDNN == 1
+  for (auto &in : in_data) {
+    if (in.IsMKLDNNData()) in = in.Reorder2Default();
+  }
+#endif
+  QuantizedRNNOperator &op = state_ptr.get_state<QuantizedRNNOperator>();
+  op.Forward(ctx, in_data, req, outputs);
+}
+
+NNVM_REGISTER_OP(_contrib_quantized_rnn)
+.describe(R"code(RNN operator for input data type of int8 or uint8, supporting lstm and gru mode.
+
+The input projection and the recurrent projection of every time step are int8 GEMMs with
+int32 accumulation. The weights are quantized from the float32 ``parameters`` with one scale
+per gate, and the hidden states are quantized at every time step. The output is quantized to
+int8 with the ``min_calib_range`` and ``max_calib_range`` thresholds when they are given, or
+with the range of the output otherwise.
+
+.. Note::
+    This operator only supports forward propogation. DO NOT use it in training.)code" ADD_FILELINE)
+.set_num_inputs([](const NodeAttrs &attrs) {
+  const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+  return static_cast<uint32_t>(GetNumInputArguments(param) + 2U);
+})
+.set_num_outputs(3)
+.set_attr_parser(ParamParser<RNNParam>)
+.set_attr<nnvm::FListInputNames>("FListInputNames", QuantizedRNNListInputNames)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames",
+  [](const NodeAttrs &attrs) {
+    return std::vector<std::string>{"output", "min_output", "max_output"};
+  })
+.set_attr<mxnet::FInferShape>("FInferShape", QuantizedRNNShape)
+.set_attr<nnvm::FInferType>("FInferType", QuantizedRNNType)
+.set_attr<FInferStorageType>("FInferStorageType", QuantizedRNNStorageType)
+.set_attr<FCreateOpState>("FCreateOpState", CreateQuantizedRNNState)
+.set_attr<FStatefulComputeEx>("FStatefulComputeEx<cpu>", QuantizedRNNForwardCPU)
+.set_attr<nnvm::FGradient>("FGradient", MakeZeroGradNodes)
+.set_attr<FNeedRequantize>("FNeedRequantize", [](const NodeAttrs &attrs) { return false; })
+.set_attr<FNeedCalibrateOutput>("FNeedCalibrateOutput", [](const NodeAttrs &attrs) {
+  return std::vector<int>{0};
+})
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs &attrs) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.add_argument("data", "NDArray-or-Symbol", "Input data.")
+.add_argument("parameters", "NDArray-or-Symbol",
+              "Vector of all float32 RNN parameters concatenated.")
+.add_argument("state", "NDArray-or-Symbol", "initial hidden state of the RNN")
+.add_argument("state_cell", "NDArray-or-Symbol",
+              "initial cell state for LSTM networks (only for LSTM)")
+.add_argument("min_data", "NDArray-or-Symbol", "Minimum value of data.")
+.add_argument("max_data", "NDArray-or-Symbol", "Maximum value of data.")
+.add_arguments(RNNParam::__FIELDS__());
+
+NNVM_REGISTER_OP(RNN)
+.set_attr<FQuantizable>("FQuantizable", [](const NodeAttrs &attrs) {
+    return QuantizeType::kMust;
+})
+.set_attr<FQuantizedOp>("FQuantizedOp", [](const NodeAttrs &attrs) {
+    const RNNParam &param = nnvm::get<RNNParam>(attrs.parsed);
+    nnvm::NodePtr node = nnvm::Node::Create();
+    node->attrs.name = "quantized_" + attrs.name;
+    // configurations without an int8 kernel keep the float32 RNN
+    if ((param.mode != rnn_enum::kLstm && param.mode != rnn_enum::kGru) ||
+        param.state_outputs || param.projection_size.has_value() ||
+        param.use_sequence_length || param.lstm_state_clip_min.has_value() ||
+        param.lstm_state_clip_max.has_value()) {
+      return node;
+    }
+    node->attrs.op = Op::Get("_contrib_quantized_rnn");
+    node->attrs.dict = attrs.dict;
+    if (node->op()->attr_parser != nullptr) {
+      node->op()->attr_parser(&(node->attrs));
+    }
+    return node;
+  })
+.set_attr<FAvoidQuantizeInput>("FAvoidQuantizeInput", [](const NodeAttrs &attrs, size_t index) {
+  // only the data is quantized, the parameters are quantized by the operator itself
+  return index != rnn_enum::kData;
+});
+
+}  // namespace op
+}  // namespace mxnet
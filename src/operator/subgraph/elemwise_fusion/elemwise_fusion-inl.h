@@ -0,0 +1,430 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file elemwise_fusion-inl.h
+ * \brief Fused evaluation of chains of elementwise operators on CPU
+ */
+
+#ifndef MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
+#define MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
+
+#include <mxnet/operator.h>
+#include <algorithm>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include "../common.h"
+#include "../../mshadow_op.h"
+#include "../../mxnet_op.h"
+#include "../../nn/activation-inl.h"
+
+namespace mxnet {
+namespace op {
+
+namespace elemwise_fusion {
+enum FusedOpType {
+  // unary
+  kRelu, kSigmoid, kTanh, kSoftReLU, kSoftSign, kExp, kLog, kSqrt, kSquare, kAbs,
+  kNegative, kReciprocal,
+  // binary, both operands have the same shape
+  kAdd, kSub, kMul, kDiv,
+  // tensor-scalar
+  kPlusScalar, kMinusScalar, kRMinusScalar, kMulScalar, kDivScalar, kRDivScalar,
+  kPowerScalar, kMaximumScalar, kMinimumScalar
+};
+
+/*! \brief number of elements evaluated per instruction before moving to the next one */
+const int kTileSize = 256;
+}  // namespace elemwise_fusion
+
+/*!
+ * \brief Returns whether the node can be part of a fused elementwise chain and
+ *        which fused instruction it maps to.
+ */
+inline bool GetElemwiseFusedOpType(const nnvm::Node& node,
+                                   elemwise_fusion::FusedOpType* type) {
+  using namespace elemwise_fusion;
+  static const std::unordered_map<std::string, FusedOpType> op_types = {
+    {"relu", kRelu}, {"sigmoid", kSigmoid}, {"tanh", kTanh}, {"softsign", kSoftSign},
+    {"exp", kExp}, {"log", kLog}, {"sqrt", kSqrt}, {"square", kSquare}, {"abs", kAbs},
+    {"negative", kNegative}, {"reciprocal", kReciprocal},
+    {"elemwise_add", kAdd}, {"elemwise_sub", kSub}, {"elemwise_mul", kMul},
+    {"elemwise_div", kDiv},
+    {"_plus_scalar", kPlusScalar}, {"_minus_scalar", kMinusScalar},
+    {"_rminus_scalar", kRMinusScalar}, {"_mul_scalar", kMulScalar},
+    {"_div_scalar", kDivScalar}, {"_rdiv_scalar", kRDivScalar},
+    {"_power_scalar", kPowerScalar}, {"_maximum_scalar", kMaximumScalar},
+    {"_minimum_scalar", kMinimumScalar},
+  };
+  if (node.is_variable()) return false;
+  const std::string& op_name = node.op()->name;
+  if (op_name == "Activation") {
+    switch (nnvm::get<ActivationParam>(node.attrs.parsed).act_type) {
+      case activation::kReLU: *type = kRelu; return true;
+      case activation::kSigmoid: *type = kSigmoid; return true;
+      case activation::kTanh: *type = kTanh; return true;
+      case activation::kSoftReLU: *type = kSoftReLU; return true;
+      case activation::kSoftSign: *type = kSoftSign; return true;
+      default: return false;
+    }
+  }
+  auto it = op_types.find(op_name);
+  if (it == op_types.end()) return false;
+  *type = it->second;
+  return true;
+}
+
+inline bool IsElemwiseFusedBinary(elemwise_fusion::FusedOpType type) {
+  return type >= elemwise_fusion::kAdd && type <= elemwise_fusion::kDiv;
+}
+
+inline bool IsElemwiseFusedScalar(elemwise_fusion::FusedOpType type) {
+  return type >= elemwise_fusion::kPlusScalar;
+}
+
+/*! \brief One step of a fused program. Registers are tiles of kTileSize elements. */
+struct ElemwiseFusedInstr {
+  elemwise_fusion::FusedOpType type;
+  /*! \brief register written by this instruction */
+  uint32_t out;
+  /*! \brief first operand */
+  uint32_t lhs;
+  /*! \brief second operand of binary instructions, equal to lhs otherwise */
+  uint32_t rhs;
+  /*! \brief scalar operand of tensor-scalar instructions */
+  double scalar;
+};
+
+/*!
+ * \brief Straight-line program equivalent to a subgraph of elementwise operators.
+ *  Registers [0, num_inputs) hold the subgraph inputs, every instruction writes
+ *  one new register in topological order.
+ */
+struct ElemwiseFusedProgram {
+  uint32_t num_inputs;
+  uint32_t num_regs;
+  std::vector<ElemwiseFusedInstr> instrs;
+  /*! \brief register holding each subgraph output */
+  std::vector<uint32_t> outputs;
+};
+
+inline ElemwiseFusedProgram CompileElemwiseFusedProgram(const nnvm::Symbol& sym) {
+  nnvm::Graph g;
+  g.outputs = sym.outputs;
+  const auto& idx = g.indexed_graph();
+  ElemwiseFusedProgram prog;
+  std::vector<uint32_t> entry_reg(idx.num_node_entries(), 0);
+  uint32_t num_regs = 0;
+  for (const uint32_t nid : idx.input_nodes()) {
+    entry_reg[idx.entry_id(nid, 0)] = num_regs++;
+  }
+  prog.num_inputs = num_regs;
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) continue;
+    ElemwiseFusedInstr instr;
+    CHECK(GetElemwiseFusedOpType(*inode.source, &instr.type))
+      << "Operator " << inode.source->op()->name << " cannot be fused";
+    CHECK_EQ(inode.source->num_outputs(), 1U);
+    CHECK_EQ(inode.inputs.size(), IsElemwiseFusedBinary(instr.type) ? 2U : 1U);
+    instr.lhs = entry_reg[idx.entry_id(inode.inputs[0])];
+    instr.rhs = IsElemwiseFusedBinary(instr.type) ?
+                entry_reg[idx.entry_id(inode.inputs[1])] : instr.lhs;
+    instr.scalar = IsElemwiseFusedScalar(instr.type) ?
+                   std::stod(inode.source->attrs.dict.at("scalar")) : 0.0;
+    instr.out = num_regs++;
+    entry_reg[idx.entry_id(nid, 0)] = instr.out;
+    prog.instrs.push_back(instr);
+  }
+  for (const auto& e : idx.outputs()) {
+    prog.outputs.push_back(entry_reg[idx.entry_id(e)]);
+  }
+  prog.num_regs = num_regs;
+  return prog;
+}
+
+namespace elemwise_fusion {
+
+template<typename OP, typename DType>
+inline void TileMap(DType* out, const DType* a, const int len) {
+  for (int i = 0; i < len; ++i) out[i] = OP::Map(a[i]);
+}
+
+template<typename OP, typename DType>
+inline void TileMap(DType* out, const DType* a, const DType* b, const int len) {
+  for (int i = 0; i < len; ++i) out[i] = OP::Map(a[i], b[i]);
+}
+
+template<typename OP, typename DType>
+inline void TileMapScalar(DType* out, const DType* a, const DType s, const int len) {
+  for (int i = 0; i < len; ++i) out[i] = OP::Map(a[i], s);
+}
+
+/*! \brief grad += ograd * OP(a) */
+template<typename OP, typename DType>
+inline void TileGrad(DType* grad, const DType* ograd, const DType* a, const int len) {
+  for (int i = 0; i < len; ++i) grad[i] += ograd[i] * OP::Map(a[i]);
+}
+
+/*! \brief grad += ograd * OP(a, b) */
+template<typename OP, typename DType>
+inline void TileGrad(DType* grad, const DType* ograd, const DType* a, const DType* b,
+                     const int len) {
+  for (int i = 0; i < len; ++i) grad[i] += ograd[i] * OP::Map(a[i], b[i]);
+}
+
+/*! \brief grad += ograd * OP(a, s) */
+template<typename OP, typename DType>
+inline void TileGradScalar(DType* grad, const DType* ograd, const DType* a, const DType s,
+                           const int len) {
+  for (int i = 0; i < len; ++i) grad[i] += ograd[i] * OP::Map(a[i], s);
+}
+
+/*! \brief grad += ograd or grad -= ograd */
+template<bool negate, typename DType>
+inline void TileGradPass(DType* grad, const DType* ograd, const int len) {
+  for (int i = 0; i < len; ++i) {
+    if (negate) {
+      grad[i] -= ograd[i];
+    } else {
+      grad[i] += ograd[i];
+    }
+  }
+}
+
+/*!
+ * \brief Runs the whole program over one tile. regs[r] points at the tile of register r;
+ *        input registers may point straight into the input tensors.
+ */
+template<typename DType>
+inline void ForwardTile(const ElemwiseFusedProgram& prog, DType* const* regs, const int len) {
+  using namespace mshadow_op;
+  for (const auto& instr : prog.instrs) {
+    DType* out = regs[instr.out];
+    const DType* a = regs[instr.lhs];
+    const DType* b = regs[instr.rhs];
+    const DType s = DType(instr.scalar);
+    switch (instr.type) {
+      case kRelu: TileMap<relu>(out, a, len); break;
+      case kSigmoid: TileMap<sigmoid>(out, a, len); break;
+      case kTanh: TileMap<mshadow_op::tanh>(out, a, len); break;
+      case kSoftReLU: TileMap<softrelu>(out, a, len); break;
+      case kSoftSign: TileMap<softsign>(out, a, len); break;
+      case kExp: TileMap<mshadow_op::exp>(out, a, len); break;
+      case kLog: TileMap<mshadow_op::log>(out, a, len); break;
+      case kSqrt: TileMap<square_root>(out, a, len); break;
+      case kSquare: TileMap<square>(out, a, len); break;
+      case kAbs: TileMap<mshadow_op::abs>(out, a, len); break;
+      case kNegative: TileMap<negation>(out, a, len); break;
+      case kReciprocal: TileMap<reciprocal>(out, a, len); break;
+      case kAdd: TileMap<plus>(out, a, b, len); break;
+      case kSub: TileMap<minus>(out, a, b, len); break;
+      case kMul: TileMap<mul>(out, a, b, len); break;
+      case kDiv: TileMap<mshadow_op::div>(out, a, b, len); break;
+      case kPlusScalar: TileMapScalar<plus>(out, a, s, len); break;
+      case kMinusScalar: TileMapScalar<minus>(out, a, s, len); break;
+      case kRMinusScalar: TileMapScalar<rminus>(out, a, s, len); break;
+      case kMulScalar: TileMapScalar<mul>(out, a, s, len); break;
+      case kDivScalar: TileMapScalar<mshadow_op::div>(out, a, s, len); break;
+      case kRDivScalar: TileMapScalar<rdiv>(out, a, s, len); break;
+      case kPowerScalar: TileMapScalar<power>(out, a, s, len); break;
+      case kMaximumScalar: TileMapScalar<maximum>(out, a, s, len); break;
+      case kMinimumScalar: TileMapScalar<minimum>(out, a, s, len); break;
+      default: LOG(FATAL) << "Unknown fused instruction " << instr.type;
+    }
+  }
+}
+
+/*!
+ * \brief Reverse-mode pass over one tile. regs must hold the values computed by
+ *        ForwardTile, grads[r] accumulates the gradient w.r.t. register r and must be
+ *        seeded with the output gradients.
+ */
+template<typename DType>
+inline void BackwardTile(const ElemwiseFusedProgram& prog, DType* const* regs,
+                         DType* const* grads, const int len) {
+  using namespace mshadow_op;
+  for (auto it = prog.instrs.rbegin(); it != prog.instrs.rend(); ++it) {
+    const ElemwiseFusedInstr& instr = *it;
+    const DType* ograd = grads[instr.out];
+    const DType* y = regs[instr.out];
+    const DType* a = regs[instr.lhs];
+    const DType* b = regs[instr.rhs];
+    DType* ga = grads[instr.lhs];
+    DType* gb = grads[instr.rhs];
+    const DType s = DType(instr.scalar);
+    switch (instr.type) {
+      case kRelu: TileGrad<relu_grad>(ga, ograd, a, len); break;
+      case kSigmoid: TileGrad<sigmoid_grad>(ga, ograd, y, len); break;
+      case kTanh: TileGrad<tanh_grad>(ga, ograd, y, len); break;
+      case kSoftReLU: TileGrad<softrelu_grad>(ga, ograd, y, len); break;
+      case kSoftSign: TileGrad<softsign_grad>(ga, ograd, a, len); break;
+      case kExp: TileGrad<identity>(ga, ograd, y, len); break;
+      case kLog: TileGrad<log_grad>(ga, ograd, a, len); break;
+      case kSqrt: TileGrad<square_root_grad>(ga, ograd, y, len); break;
+      case kSquare: TileGrad<square_grad>(ga, ograd, a, len); break;
+      case kAbs: TileGrad<sign>(ga, ograd, a, len); break;
+      case kNegative: TileGradPass<true>(ga, ograd, len); break;
+      case kReciprocal: TileGrad<reciprocal_grad>(ga, ograd, a, len); break;
+      case kAdd:
+        TileGradPass<false>(ga, ograd, len);
+        TileGradPass<false>(gb, ograd, len);
+        break;
+      case kSub:
+        TileGradPass<false>(ga, ograd, len);
+        TileGradPass<true>(gb, ograd, len);
+        break;
+      case kMul:
+        TileGrad<right>(ga, ograd, a, b, len);
+        TileGrad<left>(gb, ograd, a, b, len);
+        break;
+      case kDiv:
+        TileGrad<div_grad>(ga, ograd, a, b, len);
+        TileGrad<div_rgrad>(gb, ograd, a, b, len);
+        break;
+      case kPlusScalar:
+      case kMinusScalar: TileGradPass<false>(ga, ograd, len); break;
+      case kRMinusScalar: TileGradPass<true>(ga, ograd, len); break;
+      case kMulScalar: TileGradScalar<right>(ga, ograd, a, s, len); break;
+      case kDivScalar: TileGradScalar<div_grad>(ga, ograd, a, s, len); break;
+      case kRDivScalar: TileGradScalar<rdiv_grad>(ga, ograd, a, s, len); break;
+      case kPowerScalar: TileGradScalar<power_grad>(ga, ograd, a, s, len); break;
+      case kMaximumScalar: TileGradScalar<ge>(ga, ograd, a, s, len); break;
+      case kMinimumScalar: TileGradScalar<le>(ga, ograd, a, s, len); break;
+      default: LOG(FATAL) << "Unknown fused instruction " << instr.type;
+    }
+  }
+}
+
+template<typename DType>
+inline void StoreTile(DType* out, const DType* in, const OpReqType req, const int len) {
+  for (int i = 0; i < len; ++i) {
+    KERNEL_ASSIGN(out[i], req, in[i]);
+  }
+}
+
+/*!
+ * \brief Bytes of temp space one thread needs for num_sets register files, each made of
+ *        a tile per register followed by the table of register pointers
+ */
+template<typename DType>
+inline size_t ThreadWorkspaceBytes(const ElemwiseFusedProgram& prog, const int num_sets) {
+  return static_cast<size_t>(prog.num_regs) * num_sets
+         * (kTileSize * sizeof(DType) + sizeof(DType*));
+}
+
+}  // namespace elemwise_fusion
+
+/*!
+ * \brief Evaluates the program over whole tensors in a single parallel pass. Each thread
+ *        walks its tiles through every instruction so intermediates stay in L1 and are
+ *        never written back to memory.
+ */
+template<typename DType>
+void ElemwiseFusedForwardImpl(const ElemwiseFusedProgram& prog,
+                              const OpContext& ctx,
+                              const std::vector<TBlob>& inputs,
+                              const std::vector<OpReqType>& req,
+                              const std::vector<TBlob>& outputs) {
+  using namespace elemwise_fusion;
+  const index_t size = outputs[0].Size();
+  const int64_t num_tiles = (size + kTileSize - 1) / kTileSize;
+  const int omp_threads = num_tiles > 1 ?
+                          engine::OpenMP::Get()->GetRecommendedOMPThreadCount() : 1;
+  const size_t thread_bytes = ThreadWorkspaceBytes<DType>(prog, 1);
+  char* workspace = ctx.requested[0].get_space_typed<cpu, 1, char>(
+    mshadow::Shape1(thread_bytes * omp_threads), ctx.get_stream<cpu>()).dptr_;
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    DType* scratch = reinterpret_cast<DType*>(workspace + thread_bytes * omp_get_thread_num());
+    DType** regs = reinterpret_cast<DType**>(
+      scratch + static_cast<size_t>(prog.num_regs) * kTileSize);
+    for (uint32_t r = prog.num_inputs; r < prog.num_regs; ++r) {
+      regs[r] = scratch + static_cast<size_t>(r) * kTileSize;
+    }
+    #pragma omp for
+    for (int64_t t = 0; t < num_tiles; ++t) {
+      const index_t begin = t * kTileSize;
+      const int len = static_cast<int>(std::min<index_t>(kTileSize, size - begin));
+      for (uint32_t i = 0; i < prog.num_inputs; ++i) {
+        regs[i] = inputs[i].dptr<DType>() + begin;
+      }
+      ForwardTile(prog, regs, len);
+      for (size_t i = 0; i < outputs.size(); ++i) {
+        StoreTile(outputs[i].dptr<DType>() + begin, regs[prog.outputs[i]], req[i], len);
+      }
+    }
+  }
+}
+
+/*!
+ * \brief Inputs are the output gradients followed by the forward inputs. The forward
+ *        program is replayed per tile instead of keeping intermediates alive in memory.
+ */
+template<typename DType>
+void ElemwiseFusedBackwardImpl(const ElemwiseFusedProgram& prog,
+                               const OpContext& ctx,
+                               const std::vector<TBlob>& inputs,
+                               const std::vector<OpReqType>& req,
+                               const std::vector<TBlob>& outputs) {
+  using namespace elemwise_fusion;
+  const size_t num_ograds = prog.outputs.size();
+  const index_t size = inputs[0].Size();
+  const int64_t num_tiles = (size + kTileSize - 1) / kTileSize;
+  const int omp_threads = num_tiles > 1 ?
+                          engine::OpenMP::Get()->GetRecommendedOMPThreadCount() : 1;
+  const size_t thread_bytes = ThreadWorkspaceBytes<DType>(prog, 2);
+  char* workspace = ctx.requested[0].get_space_typed<cpu, 1, char>(
+    mshadow::Shape1(thread_bytes * omp_threads), ctx.get_stream<cpu>()).dptr_;
+  #pragma omp parallel num_threads(omp_threads)
+  {
+    const size_t num_elems = static_cast<size_t>(prog.num_regs) * kTileSize;
+    DType* scratch = reinterpret_cast<DType*>(workspace + thread_bytes * omp_get_thread_num());
+    DType* grad_base = scratch + num_elems;
+    DType** regs = reinterpret_cast<DType**>(grad_base + num_elems);
+    DType** grads = regs + prog.num_regs;
+    for (uint32_t r = 0; r < prog.num_regs; ++r) {
+      regs[r] = scratch + static_cast<size_t>(r) * kTileSize;
+      grads[r] = grad_base + static_cast<size_t>(r) * kTileSize;
+    }
+    #pragma omp for
+    for (int64_t t = 0; t < num_tiles; ++t) {
+      const index_t begin = t * kTileSize;
+      const int len = static_cast<int>(std::min<index_t>(kTileSize, size - begin));
+      for (uint32_t i = 0; i < prog.num_inputs; ++i) {
+        regs[i] = inputs[num_ograds + i].dptr<DType>() + begin;
+      }
+      ForwardTile(prog, regs, len);
+      std::fill(grad_base, grad_base + num_elems, DType(0));
+      for (size_t i = 0; i < num_ograds; ++i) {
+        TileGradPass<false>(grads[prog.outputs[i]], inputs[i].dptr<DType>() + begin, len);
+      }
+      BackwardTile(prog, regs, grads, len);
+      for (uint32_t i = 0; i < prog.num_inputs; ++i) {
+        StoreTile(outputs[i].dptr<DType>() + begin, grads[i], req[i], len);
+      }
+    }
+  }
+}
+
+}  // namespace op
+}  // namespace mxnet
+
+#endif  // MXNET_OPERATOR_SUBGRAPH_ELEMWISE_FUSION_ELEMWISE_FUSION_INL_H_
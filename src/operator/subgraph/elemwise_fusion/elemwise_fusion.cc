@@ -0,0 +1,116 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file elemwise_fusion.cc
+ * \brief Fused elementwise operator created by the ELEMWISE_FUSION subgraph backend
+ */
+
+#include <vector>
+#include "./elemwise_fusion-inl.h"
+
+namespace mxnet {
+namespace op {
+
+static void SgElemwiseFusedParamParser(nnvm::NodeAttrs *attrs) {
+  CHECK_EQ(attrs->subgraphs.size(), 1U)
+    << "_sg_elemwise_fused expects exactly one subgraph, got " << attrs->subgraphs.size();
+  attrs->parsed = CompileElemwiseFusedProgram(*attrs->subgraphs[0]);
+}
+
+static void SgElemwiseFusedForward(const nnvm::NodeAttrs& attrs,
+                                   const OpContext& ctx,
+                                   const std::vector<TBlob>& inputs,
+                                   const std::vector<OpReqType>& req,
+                                   const std::vector<TBlob>& outputs) {
+  const ElemwiseFusedProgram& prog = nnvm::get<ElemwiseFusedProgram>(attrs.parsed);
+  CHECK_EQ(inputs.size(), prog.num_inputs);
+  CHECK_EQ(outputs.size(), prog.outputs.size());
+  for (const TBlob& in : inputs) {
+    CHECK_EQ(in.Size(), outputs[0].Size()) << "Fused elementwise inputs must have the same size";
+  }
+  MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    ElemwiseFusedForwardImpl<DType>(prog, ctx, inputs, req, outputs);
+  });
+}
+
+static void SgElemwiseFusedBackward(const nnvm::NodeAttrs& attrs,
+                                    const OpContext& ctx,
+                                    const std::vector<TBlob>& inputs,
+                                    const std::vector<OpReqType>& req,
+                                    const std::vector<TBlob>& outputs) {
+  const ElemwiseFusedProgram& prog = nnvm::get<ElemwiseFusedProgram>(attrs.parsed);
+  CHECK_EQ(inputs.size(), prog.outputs.size() + prog.num_inputs);
+  CHECK_EQ(outputs.size(), prog.num_inputs);
+  MSHADOW_TYPE_SWITCH(outputs[0].type_flag_, DType, {
+    ElemwiseFusedBackwardImpl<DType>(prog, ctx, inputs, req, outputs);
+  });
+}
+
+/*!
+ * \brief The backward node takes the output gradients followed by the forward inputs
+ *        and recomputes the intermediates itself, so no forward intermediate is kept.
+ */
+static std::vector<nnvm::NodeEntry> SgElemwiseFusedGradient(
+    const nnvm::NodePtr& n, const std::vector<nnvm::NodeEntry>& ograds) {
+  nnvm::NodePtr p = nnvm::Node::Create();
+  p->attrs.op = nnvm::Op::Get("_backward_sg_elemwise_fused");
+  p->attrs.name = n->attrs.name + "_backward";
+  p->attrs.subgraphs = n->attrs.subgraphs;
+  p->attrs.parsed = n->attrs.parsed;
+  p->control_deps.emplace_back(n);
+  p->inputs.insert(p->inputs.end(), ograds.begin(), ograds.end());
+  p->inputs.insert(p->inputs.end(), n->inputs.begin(), n->inputs.end());
+  std::vector<nnvm::NodeEntry> ret;
+  for (uint32_t i = 0; i < n->num_inputs(); ++i) {
+    ret.emplace_back(nnvm::NodeEntry{p, i, 0});
+  }
+  return ret;
+}
+
+NNVM_REGISTER_OP(_sg_elemwise_fused)
+.describe(R"code(Fused chain of elementwise operators, evaluated in a single pass.)code"
+ADD_FILELINE)
+.set_num_inputs(DefaultSubgraphOpNumInputs)
+.set_num_outputs(DefaultSubgraphOpNumOutputs)
+.set_attr_parser(SgElemwiseFusedParamParser)
+.set_attr<nnvm::FListInputNames>("FListInputNames", DefaultSubgraphOpListInputs)
+.set_attr<nnvm::FListOutputNames>("FListOutputNames", DefaultSubgraphOpListOutputs)
+.set_attr<mxnet::FInferShape>("FInferShape", DefaultSubgraphOpShape)
+.set_attr<nnvm::FInferType>("FInferType", DefaultSubgraphOpType)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", SgElemwiseFusedForward)
+.set_attr<nnvm::FGradient>("FGradient", SgElemwiseFusedGradient);
+
+NNVM_REGISTER_OP(_backward_sg_elemwise_fused)
+.set_num_inputs([](const NodeAttrs& attrs) {
+  return DefaultSubgraphOpNumInputs(attrs) + DefaultSubgraphOpNumOutputs(attrs);
+})
+.set_num_outputs(DefaultSubgraphOpNumInputs)
+.set_attr_parser(SgElemwiseFusedParamParser)
+.set_attr<nnvm::TIsBackward>("TIsBackward", true)
+.set_attr<FResourceRequest>("FResourceRequest", [](const NodeAttrs& n) {
+  return std::vector<ResourceRequest>{ResourceRequest::kTempSpace};
+})
+.set_attr<FCompute>("FCompute<cpu>", SgElemwiseFusedBackward);
+
+}  // namespace op
+}  // namespace mxnet
@@ -0,0 +1,93 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file elemwise_fusion_property.cc
+ * \brief Partition graph property collapsing chains of elementwise operators
+ */
+
+#include <string>
+#include <vector>
+#include "./elemwise_fusion-inl.h"
+#include "../subgraph_property.h"
+
+namespace mxnet {
+namespace op {
+
+/*
+ * This selects maximal connected sets of elementwise operators that the fused op
+ * can evaluate. All of them are same-shape operators, so every tensor in a
+ * selected subgraph has the same number of elements.
+ */
+class ElemwiseFusionSelector : public SubgraphSelector {
+ public:
+  bool Select(const nnvm::Node &n) override {
+    return CanFuse(n);
+  }
+
+  bool SelectInput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    return CanFuse(new_node);
+  }
+
+  bool SelectOutput(const nnvm::Node &n, const nnvm::Node &new_node) override {
+    return CanFuse(new_node);
+  }
+
+  std::vector<nnvm::Node*> Filter(const std::vector<nnvm::Node*>& candidates) override {
+    // a single operator gains nothing from fusion
+    if (candidates.size() < 2) return std::vector<nnvm::Node*>();
+    return candidates;
+  }
+
+ private:
+  static bool CanFuse(const nnvm::Node &n) {
+    elemwise_fusion::FusedOpType type;
+    return GetElemwiseFusedOpType(n, &type);
+  }
+};
+
+class ElemwiseFusionProperty : public SubgraphProperty {
+ public:
+  static SubgraphPropertyPtr Create() {
+    return std::make_shared<ElemwiseFusionProperty>();
+  }
+
+  nnvm::NodePtr CreateSubgraphNode(const nnvm::Symbol &sym,
+                                   const int subgraph_id = 0) const override {
+    nnvm::NodePtr n = nnvm::Node::Create();
+    n->attrs.op = Op::Get("_sg_elemwise_fused");
+    CHECK(n->attrs.op);
+    n->attrs.name = "sg_elemwise_fused_" + std::to_string(subgraph_id);
+    n->attrs.subgraphs.emplace_back(std::make_shared<nnvm::Symbol>(sym));
+    n->op()->attr_parser(&(n->attrs));
+    return n;
+  }
+
+  SubgraphSelectorPtr CreateSubgraphSelector() const override {
+    return std::make_shared<ElemwiseFusionSelector>();
+  }
+};
+
+MXNET_REGISTER_SUBGRAPH_BACKEND(ELEMWISE_FUSION)
+.set_attr("context", Context::CPU());
+
+MXNET_REGISTER_SUBGRAPH_PROPERTY(ELEMWISE_FUSION, ElemwiseFusionProperty);
+
+}  // namespace op
+}  // namespace mxnet
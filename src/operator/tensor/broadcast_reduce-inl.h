@@ -194,11 +194,220 @@ void BinaryBroadcastComputeImpl(Stream<cpu> *s, const OpReqType req,
                            out.shape_.get<ndim>());
 }
 
+/*! \brief memory layout of a reduction */
+enum ReduceLayoutType {
+  /*! \brief no contiguous structure, reduced with coordinate arithmetic */
+  kReduceGeneric,
+  /*! \brief big is [N, M], reducing the contiguous trailing axes */
+  kReduceInner,
+  /*! \brief big is [M, N], reducing the leading axes */
+  kReduceOuter
+};
+
+template<int ndim>
+inline ReduceLayoutType ReduceLayout(const Shape<ndim>& small, const Shape<ndim>& big) {
+  bool seen_kept = false, seen_reduced = false;
+  bool inner = true, outer = true;
+  for (int i = 0; i < ndim; ++i) {
+    if (big[i] == 1) continue;
+    if (small[i] == big[i]) {
+      inner = inner && !seen_reduced;
+      seen_kept = true;
+    } else {
+      outer = outer && !seen_kept;
+      seen_reduced = true;
+    }
+  }
+  if (inner) return kReduceInner;
+  if (outer) return kReduceOuter;
+  return kReduceGeneric;
+}
+
+/*!
+ * \brief Reduction step of the contiguous paths. It is free of volatile so the compiler can
+ *  vectorize it for the common reducers, others go through Reducer::Reduce.
+ */
+template<typename Reducer>
+struct SimdReducer {
+  template<typename AType>
+  MSHADOW_XINLINE static void Reduce(AType& dst, AType src, AType& residual) {  // NOLINT(*)
+    Reducer::Reduce(dst, src, residual);
+  }
+};
+
+/*! \brief Kahan summation, as the sum reducers do */
+struct SimdSumReducer {
+  template<typename AType>
+  MSHADOW_XINLINE static void Reduce(AType& dst, AType src, AType& residual) {  // NOLINT(*)
+    AType y = src - residual;
+    AType t = dst + y;
+    residual = (t - dst) - y;
+    dst = t;
+  }
+};
+
+template<>
+struct SimdReducer<red::sum> : public SimdSumReducer {};
+
+template<>
+struct SimdReducer<mshadow_op::sum> : public SimdSumReducer {};
+
+template<>
+struct SimdReducer<red::maximum> {
+  template<typename AType>
+  MSHADOW_XINLINE static void Reduce(AType& dst, AType src, AType& residual) {  // NOLINT(*)
+    dst = dst < src ? src : dst;
+  }
+};
+
+template<>
+struct SimdReducer<red::minimum> {
+  template<typename AType>
+  MSHADOW_XINLINE static void Reduce(AType& dst, AType src, AType& residual) {  // NOLINT(*)
+    dst = src < dst ? src : dst;
+  }
+};
+
+/*! \brief number of independent accumulators of the inner axis path */
+const int kReduceLanes = 16;
+/*! \brief number of output columns a task of the outer axis path accumulates */
+const index_t kReduceBlock = 256;
+/*! \brief minimum number of reduced elements a task is given */
+const index_t kReduceMinChunk = 4096;
+
+/*!
+ * \brief number of chunks the reduced axis is split into so that all threads get work
+ *  when there are fewer tasks than threads
+ */
+inline index_t ReduceChunks(const index_t tasks, const index_t M, const int nthreads) {
+  if (tasks >= nthreads) return 1;
+  const index_t chunks = (nthreads + tasks - 1) / tasks;
+  return std::max<index_t>(1, std::min(chunks, M / kReduceMinChunk));
+}
+
+/*!
+ * \brief reduce M contiguous elements into kReduceLanes accumulators, which are then
+ *  merged pairwise
+ */
+template<typename Reducer, typename AType, typename DType, typename OP>
+inline void lane_reduce(const DType* big, const index_t M, AType* val, AType* residual) {
+  AType lval[kReduceLanes], lres[kReduceLanes];
+  for (int l = 0; l < kReduceLanes; ++l) {
+    Reducer::SetInitValue(lval[l], lres[l]);
+  }
+  index_t k = 0;
+  for (; k + kReduceLanes <= M; k += kReduceLanes) {
+    #pragma omp simd
+    for (int l = 0; l < kReduceLanes; ++l) {
+      SimdReducer<Reducer>::Reduce(lval[l], AType(OP::Map(big[k + l])), lres[l]);
+    }
+  }
+  for (int l = 0; k < M; ++k, ++l) {
+    SimdReducer<Reducer>::Reduce(lval[l], AType(OP::Map(big[k])), lres[l]);
+  }
+  for (int width = kReduceLanes / 2; width > 0; width /= 2) {
+    for (int l = 0; l < width; ++l) {
+      Reducer::Merge(lval[l], lres[l], lval[l + width], lres[l + width]);
+    }
+  }
+  *val = lval[0];
+  *residual = lres[0];
+}
+
+/*! \brief reduce big of shape [N, M] into small of shape [N] */
+template<typename Reducer, typename AType, typename DType, typename OType, typename OP>
+void inner_reduce_compute(const index_t N, const index_t M, const bool addto,
+                          const DType *big, OType *small) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t chunks = ReduceChunks(N, M, nthreads);
+  if (chunks == 1) {
+    #pragma omp parallel for num_threads(nthreads)
+    for (index_t idx = 0; idx < N; ++idx) {
+      AType val, residual;
+      lane_reduce<Reducer, AType, DType, OP>(big + idx * M, M, &val, &residual);
+      Reducer::Finalize(val, residual);
+      assign(&small[idx], addto, OType(val));
+    }
+    return;
+  }
+  const index_t chunk_size = (M + chunks - 1) / chunks;
+  std::vector<AType> vals(N * chunks), residuals(N * chunks);
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t t = 0; t < N * chunks; ++t) {
+    const index_t begin = std::min(M, (t % chunks) * chunk_size);
+    const index_t end = std::min(M, begin + chunk_size);
+    lane_reduce<Reducer, AType, DType, OP>(big + (t / chunks) * M + begin, end - begin,
+                                           &vals[t], &residuals[t]);
+  }
+  for (index_t idx = 0; idx < N; ++idx) {
+    AType& val = vals[idx * chunks];
+    AType& residual = residuals[idx * chunks];
+    for (index_t c = 1; c < chunks; ++c) {
+      Reducer::Merge(val, residual, vals[idx * chunks + c], residuals[idx * chunks + c]);
+    }
+    Reducer::Finalize(val, residual);
+    assign(&small[idx], addto, OType(val));
+  }
+}
+
+/*!
+ * \brief reduce big of shape [M, N] into small of shape [N], accumulating blocks of
+ *  kReduceBlock columns while streaming over the rows
+ */
+template<typename Reducer, typename AType, typename DType, typename OType, typename OP>
+void outer_reduce_compute(const index_t N, const index_t M, const bool addto,
+                          const DType *big, OType *small) {
+  const int nthreads = engine::OpenMP::Get()->GetRecommendedOMPThreadCount();
+  const index_t blocks = (N + kReduceBlock - 1) / kReduceBlock;
+  const index_t chunks = ReduceChunks(blocks, M * std::min(N, kReduceBlock), nthreads);
+  const index_t chunk_size = (M + chunks - 1) / chunks;
+  std::vector<AType> vals(N * chunks), residuals(N * chunks);
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t t = 0; t < blocks * chunks; ++t) {
+    const index_t j0 = (t / chunks) * kReduceBlock;
+    const index_t width = std::min(kReduceBlock, N - j0);
+    const index_t begin = std::min(M, (t % chunks) * chunk_size);
+    const index_t end = std::min(M, begin + chunk_size);
+    AType* val = &vals[(t % chunks) * N + j0];
+    AType* residual = &residuals[(t % chunks) * N + j0];
+    for (index_t j = 0; j < width; ++j) {
+      Reducer::SetInitValue(val[j], residual[j]);
+    }
+    for (index_t i = begin; i < end; ++i) {
+      const DType* row = big + i * N + j0;
+      #pragma omp simd
+      for (index_t j = 0; j < width; ++j) {
+        SimdReducer<Reducer>::Reduce(val[j], AType(OP::Map(row[j])), residual[j]);
+      }
+    }
+  }
+  #pragma omp parallel for num_threads(nthreads)
+  for (index_t j = 0; j < N; ++j) {
+    AType& val = vals[j];
+    AType& residual = residuals[j];
+    for (index_t c = 1; c < chunks; ++c) {
+      Reducer::Merge(val, residual, vals[c * N + j], residuals[c * N + j]);
+    }
+    Reducer::Finalize(val, residual);
+    assign(&small[j], addto, OType(val));
+  }
+}
+
 template<typename Reducer, int ndim, typename AType, typename DType, typename OType, typename OP>
 void seq_reduce_compute(const size_t N, const size_t M, const bool addto,
                         const DType *big, OType *small, const Shape<ndim> bshape,
                         const Shape<ndim> sshape, const Shape<ndim> rshape,
                         const Shape<ndim> rstride) {
+  switch (ReduceLayout(sshape, bshape)) {
+    case kReduceInner:
+      inner_reduce_compute<Reducer, AType, DType, OType, OP>(N, M, addto, big, small);
+      return;
+    case kReduceOuter:
+      outer_reduce_compute<Reducer, AType, DType, OType, OP>(N, M, addto, big, small);
+      return;
+    default:
+      break;
+  }
   #pragma omp parallel for num_threads(engine::OpenMP::Get()->GetRecommendedOMPThreadCount())
   for (index_t idx = 0; idx < static_cast<index_t>(N); ++idx) {
     seq_reduce_assign<Reducer, ndim, AType, DType, OType, OP>(idx, M, addto, big, small,
@@ -0,0 +1,286 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file streaming_profiler.cc
+ * \brief implements the streaming profiler
+ */
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <iomanip>
+#include <map>
+#include "./streaming_profiler.h"
+
+namespace mxnet {
+namespace profiler {
+
+int LatencyHistogram::BucketIndex(uint64_t value) {
+  if (value < static_cast<uint64_t>(kSubBuckets)) {
+    return static_cast<int>(value);
+  }
+  int e = kSubBucketBits;
+  while ((value >> (e + 1)) != 0) ++e;
+  const int mantissa = static_cast<int>(value >> (e - kSubBucketBits));
+  return (e - kSubBucketBits + 1) * kSubBuckets + (mantissa - kSubBuckets);
+}
+
+uint64_t LatencyHistogram::BucketValue(int index) {
+  if (index < kSubBuckets) {
+    return index;
+  }
+  const int e = index / kSubBuckets + kSubBucketBits - 1;
+  const uint64_t mantissa = index % kSubBuckets + kSubBuckets;
+  const int shift = e - kSubBucketBits;
+  return (mantissa << shift) + ((uint64_t(1) << shift) >> 1);
+}
+
+void LatencyHistogram::Add(uint64_t value) {
+  ++counts_[BucketIndex(value)];
+  ++count_;
+  total_ += value;
+  min_ = std::min(min_, value);
+  max_ = std::max(max_, value);
+}
+
+uint64_t LatencyHistogram::Percentile(double p) const {
+  if (count_ == 0) return 0;
+  const uint64_t rank = std::min(count_, std::max<uint64_t>(
+      1, static_cast<uint64_t>(std::ceil(p / 100.0 * count_))));
+  uint64_t seen = 0;
+  for (int i = 0; i < kNumBuckets; ++i) {
+    seen += counts_[i];
+    if (seen >= rank) {
+      return std::min(max_, std::max(min_, BucketValue(i)));
+    }
+  }
+  return max_;
+}
+
+namespace {
+/*! \brief releases the ring of a thread when the thread exits */
+struct ThreadBufferHolder {
+  std::shared_ptr<StreamRingBuffer> buffer;
+  ~ThreadBufferHolder() {
+    if (buffer) buffer->orphaned = true;
+  }
+};
+}  // namespace
+
+StreamingProfiler::StreamingProfiler() {
+  buffer_size_ = dmlc::GetEnv("MXNET_PROFILER_STREAM_BUFFER", static_cast<size_t>(8192));
+  period_ms_ = dmlc::GetEnv("MXNET_PROFILER_STREAM_PERIOD_MS", 500);
+  filename_ = dmlc::GetEnv("MXNET_PROFILER_STREAM_FILENAME", std::string());
+  max_file_size_ = dmlc::GetEnv("MXNET_PROFILER_STREAM_FILE_SIZE_MB",
+                                static_cast<size_t>(64)) << 20;
+  num_files_ = dmlc::GetEnv("MXNET_PROFILER_STREAM_FILE_COUNT", 4);
+  CHECK_GT(buffer_size_, 0U) << "MXNET_PROFILER_STREAM_BUFFER must be positive";
+  CHECK_GT(period_ms_, 0) << "MXNET_PROFILER_STREAM_PERIOD_MS must be positive";
+  CHECK_GT(num_files_, 0) << "MXNET_PROFILER_STREAM_FILE_COUNT must be positive";
+  if (dmlc::GetEnv("MXNET_PROFILER_STREAM", false)) {
+    SetEnabled(true);
+  }
+}
+
+StreamingProfiler::~StreamingProfiler() {
+  enabled_ = false;
+  {
+    std::lock_guard<std::mutex> lock(thread_mutex_);
+    shutdown_ = true;
+  }
+  thread_cv_.notify_all();
+  if (drain_thread_.joinable()) {
+    drain_thread_.join();
+  }
+  Drain();
+}
+
+StreamingProfiler* StreamingProfiler::Get(std::shared_ptr<StreamingProfiler>* sp) {
+  static std::mutex mtx;
+  static std::shared_ptr<StreamingProfiler> prof = nullptr;
+  if (!prof) {
+    std::unique_lock<std::mutex> lk(mtx);
+    if (!prof) {
+      prof = std::make_shared<StreamingProfiler>();
+    }
+  }
+  if (sp) {
+    *sp = prof;
+  }
+  return prof.get();
+}
+
+void StreamingProfiler::SetEnabled(bool enabled) {
+  std::lock_guard<std::mutex> lock(thread_mutex_);
+  if (enabled && !drain_thread_.joinable()) {
+    {
+      std::lock_guard<std::mutex> drain_lock(drain_mutex_);
+      OpenFile();
+    }
+    drain_thread_ = std::thread([this]() { DrainLoop(); });
+  }
+  enabled_ = enabled;
+}
+
+StreamRingBuffer* StreamingProfiler::ThreadBuffer() {
+  static thread_local ThreadBufferHolder holder;
+  if (!holder.buffer) {
+    holder.buffer = std::make_shared<StreamRingBuffer>(buffer_size_);
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers_.push_back(holder.buffer);
+  }
+  return holder.buffer.get();
+}
+
+void StreamingProfiler::Record(const char* name, const Context& ctx,
+                               uint64_t start_us, uint64_t stop_us) {
+  StreamRecord record;
+  record.start_us = start_us;
+  const uint64_t duration = stop_us > start_us ? stop_us - start_us : 0;
+  record.duration_us = static_cast<uint32_t>(std::min<uint64_t>(duration, UINT32_MAX));
+  record.dev_type = static_cast<uint8_t>(ctx.dev_type);
+  record.reserved = 0;
+  record.dev_id = static_cast<uint16_t>(ctx.dev_id);
+  strncpy(record.name, name, StreamRecord::kNameSize - 1);
+  record.name[StreamRecord::kNameSize - 1] = '\0';
+  ThreadBuffer()->Push(record);
+}
+
+void StreamingProfiler::Drain() {
+  std::vector<std::shared_ptr<StreamRingBuffer> > buffers;
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    buffers = buffers_;
+  }
+  std::vector<std::shared_ptr<StreamRingBuffer> > released;
+  {
+    std::lock_guard<std::mutex> lock(drain_mutex_);
+    char line[StreamRecord::kNameSize + 64];
+    for (const std::shared_ptr<StreamRingBuffer>& buffer : buffers) {
+      // the owner has exited before the drain, so the ring is empty afterwards
+      if (buffer->orphaned) released.push_back(buffer);
+      buffer->Drain([&](const StreamRecord& record) {
+        histograms_[record.name].Add(record.duration_us);
+        if (file_.is_open()) {
+          const int n = snprintf(line, sizeof(line), "%llu,%u,%d,%d,%s\n",
+                                 static_cast<unsigned long long>(record.start_us),  // NOLINT(*)
+                                 record.duration_us, record.dev_type, record.dev_id,
+                                 record.name);
+          file_.write(line, std::min<int>(n, sizeof(line) - 1));
+          file_size_ += n;
+          if (file_size_ >= max_file_size_) RotateFile();
+        }
+      });
+    }
+    if (file_.is_open()) file_.flush();
+  }
+  if (!released.empty()) {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    for (const std::shared_ptr<StreamRingBuffer>& buffer : released) {
+      released_dropped_ += buffer->dropped();
+      buffers_.erase(std::find(buffers_.begin(), buffers_.end(), buffer));
+    }
+  }
+}
+
+void StreamingProfiler::DrainLoop() {
+  std::unique_lock<std::mutex> lock(thread_mutex_);
+  while (!shutdown_) {
+    thread_cv_.wait_for(lock, std::chrono::milliseconds(period_ms_));
+    if (shutdown_) break;
+    lock.unlock();
+    Drain();
+    lock.lock();
+  }
+}
+
+void StreamingProfiler::OpenFile() {
+  if (filename_.empty()) return;
+  file_.open(filename_, std::ios::trunc | std::ios::out);
+  CHECK(file_.is_open()) << "Cannot open streaming profile file " << filename_;
+  const char header[] = "# start_us,duration_us,dev_type,dev_id,name\n";
+  file_ << header;
+  file_size_ = sizeof(header) - 1;
+}
+
+void StreamingProfiler::RotateFile() {
+  file_.close();
+  // filename_.1 is the newest of the rotated files
+  for (int i = num_files_ - 1; i >= 1; --i) {
+    const std::string src = i == 1 ? filename_ : filename_ + "." + std::to_string(i - 1);
+    std::rename(src.c_str(), (filename_ + "." + std::to_string(i)).c_str());
+  }
+  OpenFile();
+}
+
+void StreamingProfiler::DumpTable(std::ostream& os, bool reset) {
+  Drain();
+  uint64_t dropped = 0;
+  {
+    std::lock_guard<std::mutex> lock(buffers_mutex_);
+    dropped = released_dropped_;
+    for (const std::shared_ptr<StreamRingBuffer>& buffer : buffers_) {
+      dropped += buffer->dropped();
+    }
+  }
+  std::lock_guard<std::mutex> lock(drain_mutex_);
+  std::ios state(nullptr);
+  state.copyfmt(os);
+  os << std::endl
+     << "Streaming Profile Statistics:" << std::endl
+     << "\tTimes are in microseconds. Dropped records: " << dropped << std::endl;
+  os << std::setw(25) << std::left << "Name"
+     << std::setw(14) << std::right << "Count"
+     << std::setw(14) << std::right << "Avg"
+     << std::setw(14) << std::right << "P50"
+     << std::setw(14) << std::right << "P99"
+     << std::setw(14) << std::right << "P99.9"
+     << std::setw(14) << std::right << "Max" << std::endl;
+  os << std::setw(25) << std::left << "----"
+     << std::setw(14) << std::right << "-----"
+     << std::setw(14) << std::right << "---"
+     << std::setw(14) << std::right << "---"
+     << std::setw(14) << std::right << "---"
+     << std::setw(14) << std::right << "-----"
+     << std::setw(14) << std::right << "---" << std::endl;
+  std::map<std::string, const LatencyHistogram*> sorted;
+  for (const auto& kv : histograms_) sorted[kv.first] = &kv.second;
+  for (const auto& kv : sorted) {
+    const LatencyHistogram& h = *kv.second;
+    os << std::setw(25) << std::left << kv.first
+       << std::setw(14) << std::right << h.count()
+       << std::setw(14) << std::right << std::fixed << std::setprecision(1)
+       << static_cast<double>(h.total()) / h.count()
+       << std::setw(14) << std::right << h.Percentile(50)
+       << std::setw(14) << std::right << h.Percentile(99)
+       << std::setw(14) << std::right << h.Percentile(99.9)
+       << std::setw(14) << std::right << h.max() << std::endl;
+  }
+  os << std::endl;
+  os.copyfmt(state);
+  if (reset) histograms_.clear();
+}
+
+}  // namespace profiler
+}  // namespace mxnet
@@ -0,0 +1,206 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file streaming_profiler.h
+ * \brief low overhead, always-on operator profiler
+ *
+ * Operator executions are written as fixed-size records into preallocated per-thread ring
+ * buffers. A background thread periodically drains them into per-operator latency
+ * histograms and, optionally, a size-rotated text file.
+ */
+#ifndef MXNET_PROFILER_STREAMING_PROFILER_H_
+#define MXNET_PROFILER_STREAMING_PROFILER_H_
+
+#include <mxnet/base.h>
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+
+namespace mxnet {
+namespace profiler {
+
+/*!
+ * \brief Log-linear latency histogram in the spirit of HdrHistogram. Values below
+ *  2^kSubBucketBits are exact, larger values are kept with a relative error below
+ *  2^-kSubBucketBits.
+ */
+class LatencyHistogram {
+ public:
+  static const int kSubBucketBits = 5;
+  static const int kSubBuckets = 1 << kSubBucketBits;
+  static const int kNumBuckets = (64 - kSubBucketBits + 1) * kSubBuckets;
+
+  LatencyHistogram() : counts_(kNumBuckets, 0) {}
+  /*! \brief record a value */
+  void Add(uint64_t value);
+  /*! \brief value at percentile p in [0, 100] */
+  uint64_t Percentile(double p) const;
+
+  uint64_t count() const { return count_; }
+  uint64_t total() const { return total_; }
+  uint64_t min() const { return count_ ? min_ : 0; }
+  uint64_t max() const { return max_; }
+
+ private:
+  static int BucketIndex(uint64_t value);
+  /*! \brief middle of the value range of a bucket */
+  static uint64_t BucketValue(int index);
+
+  std::vector<uint64_t> counts_;
+  uint64_t count_ = 0;
+  uint64_t total_ = 0;
+  uint64_t min_ = UINT64_MAX;
+  uint64_t max_ = 0;
+};
+
+/*! \brief one operator execution, sized to a cache line */
+struct StreamRecord {
+  static const int kNameSize = 48;
+  uint64_t start_us;
+  uint32_t duration_us;
+  uint8_t dev_type;
+  uint8_t reserved;
+  uint16_t dev_id;
+  char name[kNameSize];
+};
+static_assert(sizeof(StreamRecord) == 64, "StreamRecord should fill a cache line");
+
+/*!
+ * \brief Single producer, single consumer ring of records. The owning thread pushes, the
+ *  drain thread pops; records are dropped instead of blocking when the ring is full.
+ */
+class StreamRingBuffer {
+ public:
+  explicit StreamRingBuffer(size_t capacity) : records_(capacity) {}
+
+  inline void Push(const StreamRecord& record) {
+    const size_t head = head_.load(std::memory_order_relaxed);
+    if (head - tail_.load(std::memory_order_acquire) >= records_.size()) {
+      dropped_.fetch_add(1, std::memory_order_relaxed);
+      return;
+    }
+    records_[head % records_.size()] = record;
+    head_.store(head + 1, std::memory_order_release);
+  }
+
+  /*! \brief pass all pending records to fn, returns their number */
+  template<typename Fn>
+  size_t Drain(Fn fn) {
+    const size_t tail = tail_.load(std::memory_order_relaxed);
+    const size_t head = head_.load(std::memory_order_acquire);
+    for (size_t i = tail; i < head; ++i) {
+      fn(records_[i % records_.size()]);
+    }
+    tail_.store(head, std::memory_order_release);
+    return head - tail;
+  }
+
+  uint64_t dropped() const { return dropped_.load(std::memory_order_relaxed); }
+  /*! \brief whether the owning thread has exited */
+  std::atomic<bool> orphaned{false};
+
+ private:
+  std::vector<StreamRecord> records_;
+  std::atomic<size_t> head_{0};
+  std::atomic<size_t> tail_{0};
+  std::atomic<uint64_t> dropped_{0};
+};
+
+/*!
+ * \brief Always-on streaming operator profiler, independent of the state of the Chrome
+ *  trace Profiler
+ */
+class StreamingProfiler {
+ public:
+  StreamingProfiler();
+  ~StreamingProfiler();
+
+  /*!
+   * \brief get the singleton
+   * \param sp shared pointer to fill, for holders that must outlive it
+   */
+  static StreamingProfiler* Get(std::shared_ptr<StreamingProfiler>* sp = nullptr);
+
+  /*! \brief start or stop recording */
+  void SetEnabled(bool enabled);
+  inline bool IsEnabled() const {
+    return enabled_.load(std::memory_order_relaxed);
+  }
+
+  /*! \brief record one operator execution from the calling thread */
+  void Record(const char* name, const Context& ctx, uint64_t start_us, uint64_t stop_us);
+
+  /*! \brief move all pending records into the histograms and the output file */
+  void Drain();
+
+  /*!
+   * \brief print per-operator count, average and latency percentiles
+   * \param reset clear the histograms afterwards
+   */
+  void DumpTable(std::ostream& os, bool reset);
+
+ private:
+  StreamRingBuffer* ThreadBuffer();
+  void OpenFile();
+  void RotateFile();
+  void DrainLoop();
+
+  std::atomic<bool> enabled_{false};
+  /*! \brief records per thread ring */
+  size_t buffer_size_;
+  /*! \brief drain period in milliseconds */
+  int period_ms_;
+  /*! \brief output file, no output if empty */
+  std::string filename_;
+  /*! \brief size at which the output file is rotated */
+  size_t max_file_size_;
+  /*! \brief number of files kept, including the current one */
+  int num_files_;
+
+  /*! \brief guards buffers_ */
+  std::mutex buffers_mutex_;
+  std::vector<std::shared_ptr<StreamRingBuffer> > buffers_;
+  /*! \brief records dropped by rings that have been released */
+  uint64_t released_dropped_ = 0;
+
+  /*! \brief guards the histograms and the output file */
+  std::mutex drain_mutex_;
+  std::unordered_map<std::string, LatencyHistogram> histograms_;
+  std::ofstream file_;
+  size_t file_size_ = 0;
+
+  std::mutex thread_mutex_;
+  std::condition_variable thread_cv_;
+  bool shutdown_ = false;
+  std::thread drain_thread_;
+};
+
+}  // namespace profiler
+}  // namespace mxnet
+#endif  // MXNET_PROFILER_STREAMING_PROFILER_H_
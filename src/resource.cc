@@ -32,13 +32,82 @@
 #include <mxnet/storage.h>
 #include <limits>
 #include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <vector>
 #include "./common/lazy_alloc_array.h"
 #include "./common/utils.h"
 #include "./common/cuda_utils.h"
+#include "./profiler/profiler.h"
 
 namespace mxnet {
 namespace resource {
 
+// statistics of a pool of temporary workspaces
+struct TempSpaceStats {
+  // bytes currently held by the workspaces
+  std::atomic<size_t> bytes{0};
+  // maximum of bytes
+  std::atomic<size_t> peak_bytes{0};
+  // number of times a workspace grew
+  std::atomic<uint64_t> reallocs{0};
+  // number of requests handed a workspace still held by an earlier request
+  std::atomic<uint64_t> shared_requests{0};
+  // profiler counters, created on first use
+  std::unique_ptr<profiler::ProfileDomain> prof_domain;
+  std::unique_ptr<profiler::ProfileCounter> prof_bytes;
+  std::unique_ptr<profiler::ProfileCounter> prof_peak_bytes;
+  std::unique_ptr<profiler::ProfileCounter> prof_reallocs;
+  std::unique_ptr<profiler::ProfileCounter> prof_shared_requests;
+  std::mutex prof_mutex;
+
+  // account for a workspace growing from old_size to new_size
+  inline void OnRealloc(size_t old_size, size_t new_size) {
+    const size_t now = (bytes += new_size - old_size);
+    size_t peak = peak_bytes.load();
+    while (now > peak && !peak_bytes.compare_exchange_weak(peak, now)) {}
+    ++reallocs;
+    UpdateCounters();
+  }
+
+  // account for the buffer of an idle workspace being freed
+  inline void OnFree(size_t size) {
+    bytes -= size;
+    UpdateCounters();
+  }
+
+  inline void UpdateCounters() {
+    if (!profiler::Profiler::Get()->IsProfiling(profiler::Profiler::kMemory)) return;
+    std::lock_guard<std::mutex> lock(prof_mutex);
+    if (!prof_domain) {
+      prof_domain.reset(new profiler::ProfileDomain("Temp Space"));
+      prof_bytes.reset(new profiler::ProfileCounter("Temp Space Bytes", prof_domain.get()));
+      prof_peak_bytes.reset(new profiler::ProfileCounter("Temp Space Peak Bytes",
+                                                         prof_domain.get()));
+      prof_reallocs.reset(new profiler::ProfileCounter("Temp Space Reallocs",
+                                                       prof_domain.get()));
+      prof_shared_requests.reset(new profiler::ProfileCounter("Temp Space Shared Requests",
+                                                              prof_domain.get()));
+    }
+    *prof_bytes = bytes.load();
+    *prof_peak_bytes = peak_bytes.load();
+    *prof_reallocs = reallocs.load();
+    *prof_shared_requests = shared_requests.load();
+  }
+};
+
+// round a workspace size up to a size class, less than 1/16 above the request
+inline size_t RoundTempSpaceSize(size_t size) {
+  const size_t kMinSize = 4096;
+  if (size <= kMinSize) return kMinSize;
+  size_t step = 1;
+  while ((step << 4) <= size) step <<= 1;
+  return (size + step - 1) / step * step;
+}
+
+struct TempSpacePoolState;
+
 // internal structure for space allocator
 struct SpaceAllocator {
   // internal context
@@ -47,6 +116,8 @@ struct SpaceAllocator {
   Storage::Handle handle;
   // internal CPU handle
   Storage::Handle host_handle;
+  // the pool this workspace belongs to, nullptr for round robin copies
+  TempSpacePoolState* pool{nullptr};
 
   SpaceAllocator() {
     handle.dptr = nullptr;
@@ -68,6 +139,7 @@ struct SpaceAllocator {
   inline void* GetSpace(size_t size) {
     if (handle.size >= size) return handle.dptr;
 
+    if (pool != nullptr) return GetPooledSpace(size);
     Storage::Get()->DirectFree(handle);
     handle = Storage::Get()->Alloc(size, ctx);
     return handle.dptr;
@@ -80,8 +152,72 @@ struct SpaceAllocator {
     host_handle = Storage::Get()->Alloc(size, Context());
     return host_handle.dptr;
   }
+
+  // grow a workspace of a pool, defined below
+  inline void* GetPooledSpace(size_t size);
+};
+
+// workspaces of a pool and their bookkeeping. Owned by the pool and by the pending engine
+// operations that hand workspaces back, so that these can outlive the pool.
+struct TempSpacePoolState : public std::enable_shared_from_this<TempSpacePoolState> {
+  /*! \brief total workspace size above which idle workspaces drop their buffers */
+  size_t max_bytes;
+  /*! \brief the workspaces, a deque so that resources can point into it */
+  std::deque<SpaceAllocator> space;
+  /*! \brief number of requests holding each workspace */
+  std::vector<uint32_t> users;
+  /*! \brief workspaces no request holds */
+  std::vector<int32_t> idle;
+  /*! \brief usage statistics */
+  TempSpaceStats stats;
+  /*! \brief guards the members above and the buffers of idle workspaces */
+  std::mutex mutex;
+  /*! \brief constructor */
+  explicit TempSpacePoolState(size_t max_bytes) : max_bytes(max_bytes) {}
+  // free the buffer of an idle workspace, mutex must be held
+  inline void Drop(int32_t id) {
+    SpaceAllocator& alloc = space[id];
+    if (alloc.handle.dptr == nullptr) return;
+    stats.OnFree(alloc.handle.size);
+    Storage::Get()->Free(alloc.handle);
+    alloc.handle.dptr = nullptr;
+    alloc.handle.size = 0;
+  }
+  // free idle workspaces until extra bytes fit below max_bytes, mutex must be held
+  inline void Trim(size_t extra) {
+    for (size_t i = 0; i < idle.size() && stats.bytes.load() + extra > max_bytes; ++i) {
+      Drop(idle[i]);
+    }
+  }
+  // make a workspace idle once the operations pushed on it so far have completed
+  inline void Release(const Resource& res) {
+    std::shared_ptr<TempSpacePoolState> self = shared_from_this();
+    const int32_t id = res.id;
+    Engine::Get()->PushSync(
+        [self, id](RunContext rctx) {
+          std::lock_guard<std::mutex> lock(self->mutex);
+          if (--self->users[id] > 0) return;
+          self->idle.push_back(id);
+          if (self->stats.bytes.load() > self->max_bytes) self->Drop(id);
+        }, static_cast<SpaceAllocator*>(res.ptr_)->ctx, {res.var}, {},
+        FnProperty::kNormal, 0, "ResourceTempSpaceRelease");
+  }
 };
 
+inline void* SpaceAllocator::GetPooledSpace(size_t size) {
+  std::lock_guard<std::mutex> lock(pool->mutex);
+  // give the old buffer back to the storage pool, grow to a size class so that
+  // slowly increasing requests don't realloc every time. Idle workspaces make room
+  // for it when the pool is at its size limit.
+  const size_t old_size = handle.size;
+  const size_t new_size = RoundTempSpaceSize(size);
+  pool->Trim(new_size - old_size);
+  if (handle.dptr != nullptr) Storage::Get()->Free(handle);
+  handle = Storage::Get()->Alloc(new_size, ctx);
+  pool->stats.OnRealloc(old_size, handle.size);
+  return handle.dptr;
+}
+
 
 // Implements resource manager
 class ResourceManagerImpl : public ResourceManager {
@@ -89,6 +225,11 @@ class ResourceManagerImpl : public ResourceManager {
   ResourceManagerImpl() noexcept(false)
       : global_seed_(0) {
     cpu_temp_space_copy_ = dmlc::GetEnv("MXNET_CPU_TEMP_COPY", 4);
+    cpu_temp_space_pool_ = dmlc::GetEnv("MXNET_CPU_TEMP_SPACE_MODE", std::string("RoundRobin"))
+                           == "Pool";
+    cpu_temp_pool_max_copy_ = dmlc::GetEnv("MXNET_CPU_TEMP_POOL_MAX_COPY", 64);
+    cpu_temp_pool_max_bytes_ =
+        dmlc::GetEnv("MXNET_CPU_TEMP_POOL_SIZE_MB", static_cast<size_t>(1024)) << 20;
     gpu_temp_space_copy_ = dmlc::GetEnv("MXNET_GPU_TEMP_COPY", 1);
     cpu_native_rand_copy_ = dmlc::GetEnv("MXNET_CPU_PARALLEL_RAND_COPY", 1);
     gpu_native_rand_copy_ = dmlc::GetEnv("MXNET_GPU_PARALLEL_RAND_COPY", 4);
@@ -99,8 +240,13 @@ class ResourceManagerImpl : public ResourceManager {
     storage_ref_ = Storage::_GetSharedRef();
     cpu_rand_.reset(new ResourceRandom<cpu>(
         Context::CPU(), global_seed_));
-    cpu_space_.reset(new ResourceTempSpace<ResourceRequest::kTempSpace>(
-        Context::CPU(), cpu_temp_space_copy_));
+    if (cpu_temp_space_pool_) {
+      cpu_space_pool_.reset(new ResourceTempSpacePool(
+          Context::CPU(), cpu_temp_pool_max_copy_, cpu_temp_pool_max_bytes_));
+    } else {
+      cpu_space_.reset(new ResourceTempSpace<ResourceRequest::kTempSpace>(
+          Context::CPU(), cpu_temp_space_copy_));
+    }
     cpu_parallel_rand_.reset(new ResourceParallelRandom<cpu>(
         Context::CPU(), cpu_native_rand_copy_, global_seed_));
   }
@@ -108,6 +254,7 @@ class ResourceManagerImpl : public ResourceManager {
     // need explicit delete, before engine get killed
     cpu_rand_.reset(nullptr);
     cpu_space_.reset(nullptr);
+    cpu_space_pool_.reset(nullptr);
     cpu_parallel_rand_.reset(nullptr);
 #if MXNET_USE_CUDA
     gpu_rand_.Clear();
@@ -130,7 +277,8 @@ class ResourceManagerImpl : public ResourceManager {
     if (ctx.dev_mask() == Context::kCPU) {
       switch (req.type) {
         case ResourceRequest::kRandom: return cpu_rand_->resource;
-        case ResourceRequest::kTempSpace: return cpu_space_->GetNext();
+        case ResourceRequest::kTempSpace:
+          return cpu_temp_space_pool_ ? cpu_space_pool_->GetNext() : cpu_space_->GetNext();
         case ResourceRequest::kParallelRandom: return cpu_parallel_rand_->GetNext();
         default: LOG(FATAL) << "Unknown supported type " << req.type;
       }
@@ -171,6 +319,12 @@ class ResourceManagerImpl : public ResourceManager {
     return ret;
   }
 
+  void Release(const Resource &res) override {
+    if (res.req.type != ResourceRequest::kTempSpace) return;
+    TempSpacePoolState* pool = static_cast<SpaceAllocator*>(res.ptr_)->pool;
+    if (pool != nullptr) pool->Release(res);
+  }
+
   void SeedRandom(uint32_t seed) override {
     global_seed_ = seed;
     cpu_rand_->SeedWithDeviceID(global_seed_);
@@ -293,6 +447,68 @@ class ResourceManagerImpl : public ResourceManager {
     }
   };
 
+  // temporary space resource with a workspace per request. Released workspaces are reused
+  // once their operations complete. Requests only share workspaces, and thus serialize, when
+  // none is idle and the number of workspaces or their total size hits its limit.
+  struct ResourceTempSpacePool {
+    /*! \brief the context of the device */
+    Context ctx;
+    /*! \brief maximum number of workspaces */
+    size_t max_copy;
+    /*! \brief the workspaces and their bookkeeping */
+    std::shared_ptr<TempSpacePoolState> state;
+    /*! \brief resource representation, guarded by the mutex of state */
+    std::vector<Resource> resource;
+    /*! \brief next workspace handed out to a shared request */
+    size_t next_shared{0};
+    /*! \brief constructor */
+    ResourceTempSpacePool(Context ctx, size_t max_copy, size_t max_bytes)
+        : ctx(ctx), max_copy(max_copy), state(std::make_shared<TempSpacePoolState>(max_bytes)) {
+      CHECK_GT(max_copy, 0U) << "MXNET_CPU_TEMP_POOL_MAX_COPY must be positive";
+    }
+    ~ResourceTempSpacePool() {
+      for (size_t i = 0; i < resource.size(); ++i) {
+        std::shared_ptr<TempSpacePoolState> s = state;
+        Engine::Get()->DeleteVariable(
+            [s, i](RunContext rctx){
+              std::lock_guard<std::mutex> lock(s->mutex);
+              MSHADOW_CATCH_ERROR(s->space[i].ReleaseAll());
+            }, ctx, resource[i].var);
+      }
+    }
+    // get an idle workspace, or a fresh one unless the pool is exhausted
+    inline Resource GetNext() {
+      std::lock_guard<std::mutex> lock(state->mutex);
+      if (!state->idle.empty()) {
+        const int32_t id = state->idle.back();
+        state->idle.pop_back();
+        ++state->users[id];
+        return resource[id];
+      }
+      if (resource.size() < max_copy && state->stats.bytes.load() < state->max_bytes) {
+        state->space.emplace_back();
+        SpaceAllocator& alloc = state->space.back();
+        alloc.ctx = ctx;
+        alloc.pool = state.get();
+        state->users.push_back(1);
+        Resource r;
+        r.var = Engine::Get()->NewVariable();
+        r.id = static_cast<int32_t>(resource.size());
+        r.ptr_ = &alloc;
+        r.req = ResourceRequest(ResourceRequest::kTempSpace);
+        resource.push_back(r);
+        return r;
+      }
+      // every workspace is held by a request that has not been released or whose
+      // operations have not completed
+      const size_t id = next_shared++ % resource.size();
+      ++state->users[id];
+      ++state->stats.shared_requests;
+      state->stats.UpdateCounters();
+      return resource[id];
+    }
+  };
+
   // the parallel random sampler resources
   // it use device API for GPU
   template<typename xpu>
@@ -374,6 +590,12 @@ class ResourceManagerImpl : public ResourceManager {
 
   /*! \brief number of copies in CPU temp space */
   int cpu_temp_space_copy_;
+  /*! \brief whether CPU temp space comes from a pool of per-request workspaces */
+  bool cpu_temp_space_pool_;
+  /*! \brief maximum number of workspaces in the CPU temp space pool */
+  int cpu_temp_pool_max_copy_;
+  /*! \brief total size above which requests share CPU temp space workspaces */
+  size_t cpu_temp_pool_max_bytes_;
   /*! \brief number of copies in GPU temp space */
   int gpu_temp_space_copy_;
   /*! \brief number of copies in CPU native random sampler */
@@ -390,6 +612,8 @@ class ResourceManagerImpl : public ResourceManager {
   std::unique_ptr<ResourceRandom<cpu> > cpu_rand_;
   /*! \brief CPU temp space resources */
   std::unique_ptr<ResourceTempSpace<ResourceRequest::kTempSpace>> cpu_space_;
+  /*! \brief CPU temp space pool, used instead of cpu_space_ in Pool mode */
+  std::unique_ptr<ResourceTempSpacePool> cpu_space_pool_;
   /*! \brief CPU parallel random number resources */
   std::unique_ptr<ResourceParallelRandom<cpu> > cpu_parallel_rand_;
 #if MXNET_USE_CUDA
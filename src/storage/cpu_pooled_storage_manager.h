@@ -0,0 +1,348 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file cpu_pooled_storage_manager.h
+ * \brief Storage manager with a size-class memory pool and per-thread caches on cpu.
+ */
+#ifndef MXNET_STORAGE_CPU_POOLED_STORAGE_MANAGER_H_
+#define MXNET_STORAGE_CPU_POOLED_STORAGE_MANAGER_H_
+
+#if defined(__linux__)
+  #include <sys/mman.h>
+#endif  // defined(__linux__)
+
+#include <dmlc/logging.h>
+#include <dmlc/parameter.h>
+#include <mxnet/base.h>
+#include <mxnet/storage.h>
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <unordered_map>
+#include <vector>
+#include "./storage_manager.h"
+#include "./cpu_device_storage.h"
+#include "../common/utils.h"
+
+namespace mxnet {
+namespace storage {
+
+/*!
+ * \brief Storage manager with a memory pool on cpu.
+ *
+ * Requested sizes are mapped to size classes and freed chunks are kept in per-class free
+ * lists instead of being handed back to the system allocator. Two levels of free lists are
+ * kept: a small per-thread cache that is looked up without touching any shared lock, and a
+ * global pool that the thread caches spill into once they exceed
+ * MXNET_CPU_MEM_POOL_THREAD_CACHE_SIZE bytes.
+ *
+ * Size classes are chosen by the strategy:
+ * - kExact rounds each request up to a multiple of MXNET_CPU_MEM_POOL_PAGE_SIZE and reuses
+ *   chunks based on exact size match, like GPUPooledStorageManager.
+ * - kRound rounds to the next power of two below 2^MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF
+ *   and to the next multiple of 2^cutoff above it, like GPUPooledRoundedStorageManager.
+ *
+ * When MXNET_CPU_MEM_POOL_HUGEPAGE is set, chunks of at least 2MB are mapped directly with
+ * mmap and advised for transparent huge pages, which cuts the number of page faults taken
+ * when large workspaces are touched for the first time.
+ */
+class CPUPooledStorageManager final : public StorageManager {
+ public:
+  /*! \brief size class strategy of the pool */
+  enum class Strategy { kExact, kRound };
+  /*!
+   * \brief Default constructor.
+   *
+   * \param strategy how requested sizes are mapped to size classes
+   */
+  explicit CPUPooledStorageManager(Strategy strategy) :
+    strategy_(strategy), id_(NextId()) {
+    page_size_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_PAGE_SIZE", 64);
+    cut_off_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF", 24);
+    thread_cache_size_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_THREAD_CACHE_SIZE", 16 << 20);
+    use_hugepage_ = dmlc::GetEnv("MXNET_CPU_MEM_POOL_HUGEPAGE", false);
+    if (page_size_ < 16 || page_size_ != 1ul << (common::ilog2ul(page_size_) - 1)) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_PAGE_SIZE must be a power of 2 and no smaller than 16. "
+                 << "Got: " << page_size_ << ".";
+    }
+    if (cut_off_ < 12 || cut_off_ > kLog2MaxMem) {
+      LOG(FATAL) << "MXNET_CPU_MEM_POOL_ROUND_LINEAR_CUTOFF cannot be set to a value "
+                 << "smaller than 12 or greater than " << kLog2MaxMem << ". Got: "
+                 << cut_off_ << ".";
+    }
+#if !defined(__linux__)
+    if (use_hugepage_) {
+      LOG(WARNING) << "MXNET_CPU_MEM_POOL_HUGEPAGE is only supported on Linux, ignored.";
+      use_hugepage_ = false;
+    }
+#endif  // !defined(__linux__)
+    // chunks larger than a quarter of the thread cache always go to the global pool so that a
+    // single huge buffer cannot flush every small chunk out of the cache
+    thread_cache_max_chunk_ = thread_cache_size_ / 4;
+  }
+  /*!
+   * \brief Default destructor.
+   */
+  ~CPUPooledStorageManager() {
+    ReleaseAll();
+  }
+
+  void Alloc(Storage::Handle* handle) override;
+  void Free(Storage::Handle handle) override;
+
+  void DirectFree(Storage::Handle handle) override {
+    if (handle.dptr == nullptr) return;
+    FreeToSystem(handle.dptr, RoundAllocSize(handle.size));
+  }
+
+  void ReleaseAll() override;
+
+  /*!
+   * \brief Bytes currently obtained from the system, whether in use or cached in the pool.
+   */
+  size_t used_memory() const {
+    return used_memory_.load(std::memory_order_relaxed);
+  }
+
+  /*!
+   * \brief Size class a request of the given size is served from.
+   */
+  size_t RoundAllocSize(size_t size) const {
+    size = std::max(size, page_size_);
+    if (use_hugepage_ && size >= kHugePageSize) {
+      return RoundToMultiple(size, kHugePageSize);
+    }
+    if (strategy_ == Strategy::kExact) {
+      return RoundToMultiple(size, page_size_);
+    }
+    const int log_size = common::ilog2ul(size - 1);
+    if (log_size > static_cast<int>(cut_off_)) {
+      return RoundToMultiple(size, 1ul << cut_off_);
+    }
+    return 1ul << log_size;
+  }
+
+ private:
+  /*! \brief free lists owned by a single thread */
+  struct ThreadCache {
+    /*! \brief only contended when another thread calls ReleaseAll */
+    std::mutex mutex;
+    /*! \brief total bytes held by this cache */
+    size_t cached_bytes = 0;
+    /*! \brief free lists keyed by size class */
+    std::unordered_map<size_t, std::vector<void*>> pool;
+  };
+
+  static uint64_t NextId() {
+    static std::atomic<uint64_t> counter{0};
+    return counter++;
+  }
+
+  static size_t RoundToMultiple(size_t x, size_t multiple) {
+    return ((x + multiple - 1) / multiple) * multiple;
+  }
+
+  /*!
+   * \brief Get the cache of the calling thread, creating and registering it on first use.
+   *
+   * Caches are shared between the thread (through a thread local table keyed by manager id)
+   * and the manager, so neither the thread exiting nor the manager being destroyed first
+   * leaves a dangling reference. Chunks held by the cache of an exited thread stay accounted
+   * for and are returned to the system by the next ReleaseAll.
+   */
+  ThreadCache* GetThreadCache() {
+    static thread_local std::unordered_map<uint64_t, std::shared_ptr<ThreadCache>> caches;
+    std::shared_ptr<ThreadCache>& cache = caches[id_];
+    if (!cache) {
+      cache = std::make_shared<ThreadCache>();
+      std::lock_guard<std::mutex> lock(registry_mutex_);
+      thread_caches_.push_back(cache);
+    }
+    return cache.get();
+  }
+
+  void* AllocFromSystem(size_t size);
+  void FreeToSystem(void* ptr, size_t size);
+  void ReleasePoolNoLock(std::unordered_map<size_t, std::vector<void*>>* pool);
+
+ private:
+  // 2MB, the size of a transparent huge page on x86
+  static constexpr size_t kHugePageSize = 2ul << 20;
+  // log2 of maximum size class. 16GB
+  static constexpr size_t kLog2MaxMem = 34;
+  // size class strategy
+  const Strategy strategy_;
+  // identifier of this manager in the thread local cache tables
+  const uint64_t id_;
+  // minimum chunk size, also the rounding granularity of kExact
+  size_t page_size_;
+  // log2 of memory size before switching from exponential to linear rounding
+  size_t cut_off_;
+  // maximum bytes kept in each thread cache
+  size_t thread_cache_size_;
+  // chunks larger than this bypass the thread cache
+  size_t thread_cache_max_chunk_;
+  // whether large chunks are backed by transparent huge pages
+  bool use_hugepage_;
+  // bytes obtained from the system
+  std::atomic<size_t> used_memory_{0};
+  // protects memory_pool_
+  std::mutex pool_mutex_;
+  // global memory pool
+  std::unordered_map<size_t, std::vector<void*>> memory_pool_;
+  // protects thread_caches_
+  std::mutex registry_mutex_;
+  // all thread caches created for this manager
+  std::vector<std::shared_ptr<ThreadCache>> thread_caches_;
+  DISALLOW_COPY_AND_ASSIGN(CPUPooledStorageManager);
+};  // class CPUPooledStorageManager
+
+inline void* CPUPooledStorageManager::AllocFromSystem(size_t size) {
+  void* ret = nullptr;
+  for (int attempt = 0; attempt < 2 && ret == nullptr; ++attempt) {
+    if (attempt > 0) {
+      // give cached memory back to the system and retry once
+      ReleaseAll();
+    }
+#if defined(__linux__)
+    if (use_hugepage_ && size >= kHugePageSize) {
+      void* addr = mmap(nullptr, size, PROT_READ | PROT_WRITE,
+                        MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+      if (addr != MAP_FAILED) {
+        madvise(addr, size, MADV_HUGEPAGE);
+        ret = addr;
+      }
+      continue;
+    }
+#endif  // defined(__linux__)
+    Storage::Handle handle;
+    handle.size = size;
+    try {
+      CPUDeviceStorage::Alloc(&handle);
+    } catch (const dmlc::Error&) {
+      handle.dptr = nullptr;
+    }
+    ret = handle.dptr;
+  }
+  if (ret == nullptr) {
+    LOG(FATAL) << "Failed to allocate CPU Memory of " << size << " bytes";
+  }
+  used_memory_ += size;
+  return ret;
+}
+
+inline void CPUPooledStorageManager::FreeToSystem(void* ptr, size_t size) {
+#if defined(__linux__)
+  if (use_hugepage_ && size >= kHugePageSize) {
+    munmap(ptr, size);
+    used_memory_ -= size;
+    return;
+  }
+#endif  // defined(__linux__)
+  Storage::Handle handle;
+  handle.dptr = ptr;
+  handle.size = size;
+  CPUDeviceStorage::Free(handle);
+  used_memory_ -= size;
+}
+
+inline void CPUPooledStorageManager::ReleasePoolNoLock(
+    std::unordered_map<size_t, std::vector<void*>>* pool) {
+  for (auto&& i : *pool) {
+    for (auto&& j : i.second) {
+      FreeToSystem(j, i.first);
+    }
+  }
+  pool->clear();
+}
+
+inline void CPUPooledStorageManager::Alloc(Storage::Handle* handle) {
+  // Set dptr to nullptr when handle size is 0.
+  if (handle->size == 0) {
+    handle->dptr = nullptr;
+    return;
+  }
+
+  const size_t size = RoundAllocSize(handle->size);
+  if (size <= thread_cache_max_chunk_) {
+    ThreadCache* cache = GetThreadCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    auto&& reuse_it = cache->pool.find(size);
+    if (reuse_it != cache->pool.end() && !reuse_it->second.empty()) {
+      handle->dptr = reuse_it->second.back();
+      reuse_it->second.pop_back();
+      cache->cached_bytes -= size;
+      return;
+    }
+  }
+  {
+    std::lock_guard<std::mutex> lock(pool_mutex_);
+    auto&& reuse_it = memory_pool_.find(size);
+    if (reuse_it != memory_pool_.end() && !reuse_it->second.empty()) {
+      handle->dptr = reuse_it->second.back();
+      reuse_it->second.pop_back();
+      return;
+    }
+  }
+  handle->dptr = AllocFromSystem(size);
+}
+
+inline void CPUPooledStorageManager::Free(Storage::Handle handle) {
+  // Do nothing if dptr is nullptr. Otherwise, nullptr may be reused.
+  if (handle.dptr == nullptr) return;
+
+  const size_t size = RoundAllocSize(handle.size);
+  if (size <= thread_cache_max_chunk_) {
+    ThreadCache* cache = GetThreadCache();
+    std::lock_guard<std::mutex> lock(cache->mutex);
+    if (cache->cached_bytes + size <= thread_cache_size_) {
+      cache->pool[size].push_back(handle.dptr);
+      cache->cached_bytes += size;
+      return;
+    }
+  }
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  memory_pool_[size].push_back(handle.dptr);
+}
+
+inline void CPUPooledStorageManager::ReleaseAll() {
+  {
+    std::lock_guard<std::mutex> lock(registry_mutex_);
+    for (auto&& cache : thread_caches_) {
+      std::lock_guard<std::mutex> cache_lock(cache->mutex);
+      ReleasePoolNoLock(&cache->pool);
+      cache->cached_bytes = 0;
+    }
+    // caches only referenced from here belong to threads that have exited
+    thread_caches_.erase(
+        std::remove_if(thread_caches_.begin(), thread_caches_.end(),
+                       [](const std::shared_ptr<ThreadCache>& c) { return c.use_count() == 1; }),
+        thread_caches_.end());
+  }
+  std::lock_guard<std::mutex> lock(pool_mutex_);
+  ReleasePoolNoLock(&memory_pool_);
+}
+
+}  // namespace storage
+}  // namespace mxnet
+
+#endif  // MXNET_STORAGE_CPU_POOLED_STORAGE_MANAGER_H_
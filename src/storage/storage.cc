@@ -24,6 +24,7 @@
 #include "./storage_manager.h"
 #include "./naive_storage_manager.h"
 #include "./pooled_storage_manager.h"
+#include "./cpu_pooled_storage_manager.h"
 #include "./cpu_shared_storage_manager.h"
 #include "./cpu_device_storage.h"
 #include "./gpu_device_storage.h"
@@ -67,7 +68,22 @@ void StorageImpl::Alloc(Storage::Handle* handle) {
         storage::StorageManager *ptr = nullptr;
         switch (handle->ctx.dev_type) {
           case Context::kCPU: {
-            ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            const char *type = getenv("MXNET_CPU_MEM_POOL_TYPE");
+            std::string strategy = (type == nullptr) ? "Unpooled" : type;
+
+            if (strategy == "Round") {
+              ptr = new storage::CPUPooledStorageManager(
+                  storage::CPUPooledStorageManager::Strategy::kRound);
+              LOG(INFO) << "Using CPUPooledStorageManager with rounded size classes.";
+            } else if (strategy == "Naive") {
+              ptr = new storage::CPUPooledStorageManager(
+                  storage::CPUPooledStorageManager::Strategy::kExact);
+              LOG(INFO) << "Using CPUPooledStorageManager.";
+            } else if (strategy == "Unpooled") {
+              ptr = new storage::NaiveStorageManager<storage::CPUDeviceStorage>();
+            } else {
+              LOG(FATAL) << "Unknown CPU memory pool strategy specified: " << strategy << ".";
+            }
             break;
           }
           case Context::kCPUShared: {
@@ -34,6 +34,8 @@
 #include <cstdio>
 #include <thread>
 #include <chrono>
+#include <memory>
+#include <string>
 #include <vector>
 
 #include "../src/engine/engine_impl.h"
@@ -124,12 +126,14 @@ double EvaluateWorkloads(const std::vector<Workload>& workloads,
 }
 
 TEST(Engine, start_stop) {
-  const int num_engine = 3;
+  const int num_engine = 4;
   std::vector<mxnet::Engine*> engine(num_engine);
   engine[0] = mxnet::engine::CreateNaiveEngine();
   engine[1] = mxnet::engine::CreateThreadedEnginePooled();
   engine[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engine[3] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
 
   for (int i = 0; i < num_engine; ++i) {
     LOG(INFO) << "Stopping: " << type_names[i];
@@ -143,7 +147,7 @@ TEST(Engine, start_stop) {
 TEST(Engine, RandSumExpr) {
   std::vector<Workload> workloads;
   int num_repeat = 5;
-  const int num_engine = 4;
+  const int num_engine = 5;
 
   std::vector<double> t(num_engine, 0.0);
   std::vector<mxnet::Engine*> engine(num_engine);
@@ -152,6 +156,7 @@ TEST(Engine, RandSumExpr) {
   engine[1] = mxnet::engine::CreateNaiveEngine();
   engine[2] = mxnet::engine::CreateThreadedEnginePooled();
   engine[3] = mxnet::engine::CreateThreadedEnginePerDevice();
+  engine[4] = mxnet::engine::CreateThreadedEngineWorkStealing();
 
   for (int repeat = 0; repeat < num_repeat; ++repeat) {
     srand(time(NULL) + repeat);
@@ -174,6 +179,101 @@ TEST(Engine, RandSumExpr) {
   LOG(INFO) << "NaiveEngine\t\t"  << t[1] << " sec";
   LOG(INFO) << "ThreadedEnginePooled\t" << t[2] << " sec";
   LOG(INFO) << "ThreadedEnginePerDevice\t" << t[3] << " sec";
+  LOG(INFO) << "ThreadedEngineWorkStealing\t" << t[4] << " sec";
+}
+
+/**
+ * push many tiny independent chains of operators from the main thread,
+ * return the number of operators executed per second
+ */
+double SmallOpThroughput(mxnet::Engine* engine, int num_chains, int num_ops) {
+  using namespace mxnet;
+  std::vector<Engine::VarHandle> vars;
+  for (int i = 0; i < num_chains; ++i) {
+    vars.push_back(engine->NewVariable());
+  }
+  std::vector<double> data(num_chains, 0.0);
+  double t = dmlc::GetTime();
+  for (int i = 0; i < num_ops; ++i) {
+    const int chain = i % num_chains;
+    double* ptr = &data[chain];
+    engine->PushSync([ptr](RunContext ctx) {
+      // a few hundred nanoseconds of work, like a small imperative operator
+      double tmp = *ptr;
+      for (int k = 0; k < 64; ++k) tmp = tmp * 0.5 + 1.0;
+      *ptr = tmp;
+    }, Context::CPU(), {}, {vars[chain]});
+  }
+  engine->WaitForAll();
+  t = dmlc::GetTime() - t;
+  for (auto var : vars) {
+    engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return num_ops / t;
+}
+
+TEST(Engine, SmallOpThroughput) {
+  const int num_ops = mxnet::test::performance_run ? 1000000 : 20000;
+  const int num_engine = 3;
+  std::vector<std::unique_ptr<mxnet::Engine>> engine(num_engine);
+  engine[0].reset(mxnet::engine::CreateThreadedEnginePooled());
+  engine[1].reset(mxnet::engine::CreateThreadedEnginePerDevice());
+  engine[2].reset(mxnet::engine::CreateThreadedEngineWorkStealing());
+  std::string type_names[3] = {"ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
+  for (int num_chains : {1, 8, 64, 1024}) {
+    for (int i = 0; i < num_engine; ++i) {
+      const double ops = SmallOpThroughput(engine[i].get(), num_chains, num_ops);
+      LOG(INFO) << type_names[i] << "\t" << num_chains << " chains\t"
+                << ops / 1e3 << " K ops/sec";
+    }
+  }
+}
+
+/**
+ * push empty operators from num_threads threads at once, every operator reads
+ * the same few shared variables and writes a variable private to its thread,
+ * return the number of operators pushed and executed per second
+ */
+double VarContentionThroughput(mxnet::Engine* engine, int num_threads, int ops_per_thread) {
+  using namespace mxnet;
+  const int num_shared = 4;
+  std::vector<Engine::VarHandle> shared_vars, private_vars;
+  for (int i = 0; i < num_shared; ++i) shared_vars.push_back(engine->NewVariable());
+  for (int i = 0; i < num_threads; ++i) private_vars.push_back(engine->NewVariable());
+  double t = dmlc::GetTime();
+  std::vector<std::thread> threads;
+  for (int i = 0; i < num_threads; ++i) {
+    threads.emplace_back([engine, &shared_vars, &private_vars, i, ops_per_thread]() {
+      for (int k = 0; k < ops_per_thread; ++k) {
+        engine->PushSync([](RunContext ctx) {}, Context::CPU(),
+                         shared_vars, {private_vars[i]});
+      }
+    });
+  }
+  for (auto& thread : threads) thread.join();
+  engine->WaitForAll();
+  t = dmlc::GetTime() - t;
+  for (auto var : shared_vars) {
+    engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  }
+  for (auto var : private_vars) {
+    engine->DeleteVariable([](RunContext) {}, Context::CPU(), var);
+  }
+  engine->WaitForAll();
+  return static_cast<double>(num_threads) * ops_per_thread / t;
+}
+
+TEST(Engine, VarContention) {
+  const int total_ops = mxnet::test::performance_run ? 640000 : 6400;
+  std::unique_ptr<mxnet::Engine> engine(mxnet::engine::CreateThreadedEnginePerDevice());
+  for (int num_threads : {1, 2, 4, 8, 16, 32, 64}) {
+    const double ops = VarContentionThroughput(engine.get(), num_threads,
+                                               total_ops / num_threads);
+    LOG(INFO) << "ThreadedEnginePerDevice\t" << num_threads << " pushing threads\t"
+              << ops / 1e3 << " K ops/sec";
+  }
 }
 
 void Foo(mxnet::RunContext, int i) { printf("The fox says %d\n", i); }
@@ -433,12 +533,14 @@ TEST(Engine, basics) {
 }
 
 TEST(Engine, VarVersion) {
-  const size_t num_engines = 3;
+  const size_t num_engines = 4;
   std::vector<mxnet::Engine*> engines(num_engines);
   engines[0] = mxnet::engine::CreateNaiveEngine();
   engines[1] = mxnet::engine::CreateThreadedEnginePooled();
   engines[2] = mxnet::engine::CreateThreadedEnginePerDevice();
-  std::string type_names[3] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice"};
+  engines[3] = mxnet::engine::CreateThreadedEngineWorkStealing();
+  std::string type_names[4] = {"NaiveEngine", "ThreadedEnginePooled", "ThreadedEnginePerDevice",
+                               "ThreadedEngineWorkStealing"};
   for (size_t k = 0; k < num_engines; ++k) {
     auto engine = engines[k];
     std::vector<mxnet::Engine::OprHandle> oprs;
@@ -0,0 +1,154 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * \file gradient_compression_test.cc
+ * \brief gradient compression round trip tests
+*/
+
+#include <gtest/gtest.h>
+#include <mxnet/base.h>
+#include <mxnet/ndarray.h>
+#include <cmath>
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+#include "../../src/kvstore/gradient_compression.h"
+
+using mxnet::NDArray;
+using mxnet::kvstore::GradientCompression;
+
+static GradientCompression MakeCompression(const std::string& type,
+                                           const std::string& ratio = "0.01") {
+  GradientCompression gc;
+  gc.SetParams({{"type", type}, {"ratio", ratio}});
+  return gc;
+}
+
+static NDArray MakeArray(const std::vector<float>& data) {
+  NDArray arr(mxnet::TShape{static_cast<int64_t>(data.size())}, mxnet::Context::CPU());
+  arr.SyncCopyFromCPU(data.data(), data.size());
+  return arr;
+}
+
+static std::vector<float> ToVector(const NDArray& arr) {
+  std::vector<float> ret(arr.shape().Size());
+  arr.SyncCopyToCPU(ret.data(), ret.size());
+  return ret;
+}
+
+/*!
+ * \brief compresses `grad` once and returns the decompressed gradient and the residual
+ */
+static std::pair<std::vector<float>, std::vector<float>>
+RoundTrip(GradientCompression* gc, const std::vector<float>& grad) {
+  const int64_t n = grad.size();
+  NDArray from = MakeArray(grad);
+  NDArray residual = MakeArray(std::vector<float>(n, 0.0f));
+  NDArray compressed(mxnet::TShape{gc->GetCompressedSize(n)}, mxnet::Context::CPU());
+  NDArray out(mxnet::TShape{n}, mxnet::Context::CPU());
+  gc->Quantize(from, &compressed, &residual, 0);
+  gc->Dequantize(compressed, &out, 0);
+  return {ToVector(out), ToVector(residual)};
+}
+
+static std::vector<float> RandomGrad(const int n) {
+  std::mt19937 gen(17);
+  std::normal_distribution<float> dis(0.0f, 1.0f);
+  std::vector<float> grad(n);
+  for (auto& g : grad) g = dis(gen);
+  return grad;
+}
+
+TEST(GradientCompression, CompressedSize) {
+  EXPECT_EQ(MakeCompression("2bit").GetCompressedSize(33), 3);
+  EXPECT_EQ(MakeCompression("fp16").GetCompressedSize(5), 3);
+  EXPECT_EQ(MakeCompression("bf16").GetCompressedSize(4), 2);
+  EXPECT_EQ(MakeCompression("1bit").GetCompressedSize(1025), 2 * 33);
+  // 2048 * 0.01 rounds to 20 (index, value) pairs per block
+  EXPECT_EQ(MakeCompression("topk").GetCompressedSize(4096), 2 * 40);
+  // a short array keeps k in proportion to its length
+  EXPECT_EQ(MakeCompression("randomk", "0.5").GetCompressedSize(100), 2 * 50);
+  EXPECT_EQ(MakeCompression("topk").GetCompressedSize(2048 + 100), 2 * 20 + 2 * 1);
+}
+
+TEST(GradientCompression, EncodeParams) {
+  // 2048 * 0.00073245 rounds to 2, six decimals of the ratio would round it to 1
+  GradientCompression worker = MakeCompression("topk", "0.00073245");
+  GradientCompression server;
+  server.DecodeParams(worker.EncodeParams());
+  EXPECT_EQ(worker.GetCompressedSize(4096), 2 * 4);
+  EXPECT_EQ(server.GetCompressedSize(4096), worker.GetCompressedSize(4096));
+}
+
+TEST(GradientCompression, ErrorFeedback) {
+  // for every type, decompressed gradient plus residual must give back the gradient
+  const std::vector<float> grad = RandomGrad(5000);
+  for (const std::string type : {"2bit", "1bit", "topk", "randomk", "fp16", "bf16"}) {
+    GradientCompression gc = MakeCompression(type);
+    auto result = RoundTrip(&gc, grad);
+    for (size_t i = 0; i < grad.size(); ++i) {
+      EXPECT_NEAR(result.first[i] + result.second[i], grad[i], 1e-5) << type << " at " << i;
+    }
+  }
+}
+
+TEST(GradientCompression, TopK) {
+  // one value is kept out of each of the three blocks
+  const int n = 5000;
+  std::vector<float> grad(n, 0.01f);
+  grad[7] = -5.0f;
+  grad[2047] = 3.0f;
+  grad[2900] = 4.0f;
+  grad[4500] = 0.5f;
+  GradientCompression gc = MakeCompression("topk", "0.0005");
+  auto result = RoundTrip(&gc, grad);
+  for (int i = 0; i < n; ++i) {
+    const bool selected = (i == 7 || i == 2900 || i == 4500);
+    EXPECT_EQ(result.first[i], selected ? grad[i] : 0.0f) << i;
+  }
+}
+
+TEST(GradientCompression, HalfPrecision) {
+  const std::vector<float> grad = RandomGrad(1001);
+  GradientCompression fp16 = MakeCompression("fp16");
+  GradientCompression bf16 = MakeCompression("bf16");
+  auto fp16_result = RoundTrip(&fp16, grad);
+  auto bf16_result = RoundTrip(&bf16, grad);
+  for (size_t i = 0; i < grad.size(); ++i) {
+    EXPECT_NEAR(fp16_result.first[i], grad[i], std::fabs(grad[i]) * 1e-3 + 1e-7);
+    EXPECT_NEAR(bf16_result.first[i], grad[i], std::fabs(grad[i]) * 1e-2 + 1e-7);
+  }
+}
+
+TEST(GradientCompression, OneBitAccumulate) {
+  const std::vector<float> grad = {1.0f, -3.0f, 2.0f};
+  GradientCompression gc = MakeCompression("1bit");
+  NDArray from = MakeArray(grad);
+  NDArray residual = MakeArray({0.0f, 0.0f, 0.0f});
+  NDArray compressed(mxnet::TShape{gc.GetCompressedSize(3)}, mxnet::Context::CPU());
+  NDArray out = MakeArray({1.0f, 1.0f, 1.0f});
+  gc.Quantize(from, &compressed, &residual, 0);
+  gc.Dequantize(compressed, &out, 0, true);
+  const std::vector<float> result = ToVector(out);
+  EXPECT_FLOAT_EQ(result[0], 3.0f);
+  EXPECT_FLOAT_EQ(result[1], -1.0f);
+  EXPECT_FLOAT_EQ(result[2], 3.0f);
+}
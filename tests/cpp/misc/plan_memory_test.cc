@@ -0,0 +1,152 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file plan_memory_test.cc
+ * \brief static memory planner tests
+*/
+#include <stdlib.h>
+#include <gtest/gtest.h>
+#include <mxnet/base.h>
+#include <nnvm/graph.h>
+#include <nnvm/op.h>
+#include <nnvm/pass.h>
+#include <algorithm>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "executor/exec_pass.h"
+
+#if !defined(_WIN32) && MXNET_USE_MKLDNN != 1
+namespace {
+
+nnvm::NodeEntry Var(const std::string& name, const std::string& shape) {
+  nnvm::NodePtr n = nnvm::Node::Create();
+  n->attrs.name = name;
+  n->attrs.dict["__shape__"] = shape;
+  n->attrs.dict["__dtype__"] = std::to_string(mshadow::kFloat32);
+  return nnvm::NodeEntry{n, 0, 0};
+}
+
+nnvm::NodeEntry MakeNode(const std::string& op, const std::vector<nnvm::NodeEntry>& inputs,
+                         const std::unordered_map<std::string, std::string>& params = {}) {
+  static int count = 0;
+  nnvm::NodePtr n = nnvm::Node::Create();
+  n->attrs.op = nnvm::Op::Get(op);
+  n->attrs.name = op + std::to_string(count++);
+  n->attrs.dict = params;
+  if (n->op()->attr_parser) {
+    n->op()->attr_parser(&n->attrs);
+  }
+  n->inputs = inputs;
+  return nnvm::NodeEntry{n, 0, 0};
+}
+
+nnvm::NodeEntry FullyConnected(const nnvm::NodeEntry& data, const std::string& name,
+                               const int num_hidden, const int num_input) {
+  const std::string shape =
+    "(" + std::to_string(num_hidden) + "," + std::to_string(num_input) + ")";
+  return MakeNode("FullyConnected", {data, Var(name, shape)},
+                  {{"num_hidden", std::to_string(num_hidden)}, {"no_bias", "True"}});
+}
+
+/*!
+ * \brief MLP with a residual connection, so that some entries stay alive across several
+ *        nodes while others are released early and their space can be reused
+ */
+nnvm::Graph MakeGraph() {
+  nnvm::NodeEntry data = Var("data", "(8,1024)");
+  nnvm::NodeEntry r1 = MakeNode("relu", {data});
+  nnvm::NodeEntry s1 = MakeNode("sigmoid", {FullyConnected(r1, "w1", 4096, 1024)});
+  nnvm::NodeEntry a1 = MakeNode("elemwise_add", {FullyConnected(s1, "w2", 1024, 4096), r1});
+  nnvm::NodeEntry s3 = MakeNode("tanh", {FullyConnected(a1, "w3", 4096, 1024)});
+  nnvm::NodeEntry f4 = FullyConnected(s3, "w4", 256, 4096);
+  nnvm::Graph g;
+  g.outputs = {f4, a1};
+  g = mxnet::exec::InferShape(std::move(g), mxnet::ShapeVector(), "__shape__");
+  g = mxnet::exec::InferType(std::move(g), nnvm::DTypeVector(), "__dtype__");
+  return g;
+}
+
+}  // namespace
+
+TEST(PlanMemory, ArenaOffsetsDoNotOverlap) {
+  setenv("MXNET_MEM_PLAN_TYPE", "Arena", 1);
+  nnvm::Graph g = nnvm::ApplyPass(MakeGraph(), "MXPlanMemory");
+  unsetenv("MXNET_MEM_PLAN_TYPE");
+  ASSERT_EQ(g.attrs.count("storage_offset"), 1U);
+  const auto& idx = g.indexed_graph();
+  const auto& storage_id = g.GetAttr<nnvm::StorageVector>("storage_id");
+  const auto& offsets = g.GetAttr<std::vector<size_t> >("storage_offset");
+  const size_t arena_bytes = g.GetAttr<size_t>("storage_arena_bytes");
+  const auto& shapes = g.GetAttr<mxnet::ShapeVector>("shape");
+  const auto& dtypes = g.GetAttr<nnvm::DTypeVector>("dtype");
+
+  // live range of each storage, from the first node writing it to the last node using it
+  const size_t num_storage = offsets.size();
+  std::vector<uint32_t> first(num_storage, std::numeric_limits<uint32_t>::max());
+  std::vector<uint32_t> last(num_storage, 0);
+  std::vector<size_t> bytes(num_storage, 0);
+  auto use = [&](const uint32_t eid, const uint32_t nid, const bool write) {
+    const int sid = storage_id[eid];
+    if (sid < 0) return;
+    ASSERT_LT(static_cast<size_t>(sid), num_storage);
+    if (write) {
+      first[sid] = std::min(first[sid], nid);
+      bytes[sid] = std::max(bytes[sid],
+                            shapes[eid].Size() * mshadow::mshadow_sizeof(dtypes[eid]));
+    }
+    last[sid] = std::max(last[sid], nid);
+  };
+  for (uint32_t nid = 0; nid < idx.num_nodes(); ++nid) {
+    const auto& inode = idx[nid];
+    if (inode.source->is_variable()) continue;
+    for (const auto& e : inode.inputs) use(idx.entry_id(e), nid, false);
+    for (uint32_t i = 0; i < inode.source->num_outputs(); ++i) {
+      use(idx.entry_id(nid, i), nid, true);
+    }
+  }
+  for (const auto& e : idx.outputs()) use(idx.entry_id(e), idx.num_nodes(), false);
+
+  size_t total_bytes = 0;
+  for (size_t i = 0; i < num_storage; ++i) {
+    total_bytes += bytes[i];
+    EXPECT_LE(offsets[i] + bytes[i], arena_bytes);
+    for (size_t j = i + 1; j < num_storage; ++j) {
+      if (first[i] > last[j] || first[j] > last[i]) continue;
+      EXPECT_TRUE(offsets[i] + bytes[i] <= offsets[j] || offsets[j] + bytes[j] <= offsets[i])
+        << "storage " << i << " [" << offsets[i] << ", " << offsets[i] + bytes[i] << ") and "
+        << "storage " << j << " [" << offsets[j] << ", " << offsets[j] + bytes[j] << ") "
+        << "overlap while both are alive";
+    }
+  }
+  // the 8x4096 entries of the first and the second half of the graph share their space
+  EXPECT_LT(arena_bytes, total_bytes);
+}
+
+TEST(PlanMemory, GreedyIsDefault) {
+  unsetenv("MXNET_MEM_PLAN_TYPE");
+  nnvm::Graph g = nnvm::ApplyPass(MakeGraph(), "MXPlanMemory");
+  EXPECT_EQ(g.attrs.count("storage_id"), 1U);
+  EXPECT_EQ(g.attrs.count("storage_offset"), 0U);
+}
+#endif  // !defined(_WIN32) && MXNET_USE_MKLDNN != 1
@@ -0,0 +1,139 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file random_generator_test.cc
+ * \brief cpu parallel random generator tests
+*/
+#include <gtest/gtest.h>
+#include <dmlc/logging.h>
+#include <dmlc/timer.h>
+#include <mxnet/random_generator.h>
+#include <random>
+#include <vector>
+#include "test_util.h"
+
+using mxnet::common::random::Philox4x32;
+using mxnet::common::random::RandGenerator;
+
+TEST(RandomGenerator, PhiloxKnownAnswer) {
+  // Random123 known answer, followed by the next counter
+  const uint32_t key[2] = {0, 0};
+  uint32_t out[Philox4x32::kBatchWords];
+  Philox4x32::Generate(key, 0, out);
+  const uint32_t expected[8] = {0x6627e8d5, 0xe169c58d, 0xbc57ac4c, 0x9b00dbd8,
+                                0xf8e4cca4, 0x5cb200db, 0xb1a574eb, 0x097eff67};
+  for (int i = 0; i < 8; ++i) {
+    EXPECT_EQ(out[i], expected[i]);
+  }
+}
+
+TEST(RandomGenerator, CPUStreams) {
+  RandGenerator<mxnet::cpu, float> gen1, gen2;
+  RandGenerator<mxnet::cpu, float>::AllocState(&gen1);
+  RandGenerator<mxnet::cpu, float>::AllocState(&gen2);
+  gen1.Seed(nullptr, 42);
+  gen2.Seed(nullptr, 42);
+  std::vector<float> a, b, c;
+  {
+    RandGenerator<mxnet::cpu, float>::Impl impl(&gen1, 7);
+    for (int i = 0; i < 10; ++i) a.push_back(impl.uniform());
+  }
+  {
+    // the stream of a state doesn't depend on the use of other states
+    RandGenerator<mxnet::cpu, float>::Impl other(&gen2, 3);
+    other.uniform();
+    RandGenerator<mxnet::cpu, float>::Impl impl(&gen2, 7);
+    for (int i = 0; i < 10; ++i) b.push_back(impl.uniform());
+  }
+  EXPECT_EQ(a, b);
+  {
+    // the state continues where the previous kernel stopped
+    RandGenerator<mxnet::cpu, float>::Impl impl(&gen1, 7);
+    for (int i = 0; i < 10; ++i) c.push_back(impl.uniform());
+  }
+  EXPECT_NE(a, c);
+  for (float v : a) {
+    EXPECT_GE(v, 0.0f);
+    EXPECT_LT(v, 1.0f);
+  }
+  RandGenerator<mxnet::cpu, float>::FreeState(&gen1);
+  RandGenerator<mxnet::cpu, float>::FreeState(&gen2);
+}
+
+TEST(RandomGenerator, CPUNormalMoments) {
+  RandGenerator<mxnet::cpu, double> gen;
+  RandGenerator<mxnet::cpu, double>::AllocState(&gen);
+  gen.Seed(nullptr, 0);
+  RandGenerator<mxnet::cpu, double>::Impl impl(&gen, 0);
+  const int n = 100000;
+  double sum = 0, sum_sq = 0;
+  for (int i = 0; i < n; ++i) {
+    const double v = impl.normal();
+    sum += v;
+    sum_sq += v * v;
+  }
+  EXPECT_NEAR(sum / n, 0.0, 0.02);
+  EXPECT_NEAR(sum_sq / n, 1.0, 0.02);
+  RandGenerator<mxnet::cpu, double>::FreeState(&gen);
+}
+
+/*!
+ * \brief Throughput of the Philox generator against the mt19937 it replaced
+ */
+TEST(RandomGenerator, CPUPerf) {
+  const int n = mxnet::test::performance_run ? (1 << 26) : (1 << 20);
+  RandGenerator<mxnet::cpu, float> gen;
+  RandGenerator<mxnet::cpu, float>::AllocState(&gen);
+  gen.Seed(nullptr, 0);
+  float sink = 0;
+  double start = dmlc::GetTime();
+  {
+    RandGenerator<mxnet::cpu, float>::Impl impl(&gen, 0);
+    for (int i = 0; i < n; ++i) sink += impl.uniform();
+  }
+  const double philox_uniform = dmlc::GetTime() - start;
+  start = dmlc::GetTime();
+  {
+    RandGenerator<mxnet::cpu, float>::Impl impl(&gen, 0);
+    for (int i = 0; i < n; ++i) sink += impl.normal();
+  }
+  const double philox_normal = dmlc::GetTime() - start;
+  RandGenerator<mxnet::cpu, float>::FreeState(&gen);
+
+  std::mt19937 engine(0);
+  std::uniform_real_distribution<float> uniform;
+  std::normal_distribution<float> normal;
+  start = dmlc::GetTime();
+  for (int i = 0; i < n; ++i) sink += uniform(engine);
+  const double mt_uniform = dmlc::GetTime() - start;
+  start = dmlc::GetTime();
+  for (int i = 0; i < n; ++i) sink += normal(engine);
+  const double mt_normal = dmlc::GetTime() - start;
+  start = dmlc::GetTime();
+  std::vector<std::mt19937> states(RandGenerator<mxnet::cpu, float>::kNumRandomStates);
+  for (size_t i = 0; i < states.size(); ++i) states[i].seed(i);
+  const double mt_seed = dmlc::GetTime() - start;
+
+  LOG(INFO) << n << " samples (sink " << sink << ")";
+  LOG(INFO) << "uniform: philox " << philox_uniform << "s, mt19937 " << mt_uniform << "s";
+  LOG(INFO) << "normal: philox " << philox_normal << "s, mt19937 " << mt_normal << "s";
+  LOG(INFO) << "seeding " << states.size() << " mt19937 states: " << mt_seed << "s";
+}
@@ -0,0 +1,90 @@
+/*
+ * Licensed to the Apache Software Foundation (ASF) under one
+ * or more contributor license agreements.  See the NOTICE file
+ * distributed with this work for additional information
+ * regarding copyright ownership.  The ASF licenses this file
+ * to you under the Apache License, Version 2.0 (the
+ * "License"); you may not use this file except in compliance
+ * with the License.  You may obtain a copy of the License at
+ *
+ *   http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing,
+ * software distributed under the License is distributed on an
+ * "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+ * KIND, either express or implied.  See the License for the
+ * specific language governing permissions and limitations
+ * under the License.
+ */
+
+/*!
+ * Copyright (c) 2019 by Contributors
+ * \file resource_test.cc
+ * \brief temp space resource tests
+*/
+#include <stdlib.h>
+#include <gtest/gtest.h>
+#include <mxnet/engine.h>
+#include <mxnet/resource.h>
+#include <set>
+#include <thread>
+#include <vector>
+
+#if !defined(_WIN32)
+TEST(Resource, TempSpacePool) {
+  setenv("MXNET_CPU_TEMP_SPACE_MODE", "Pool", 1);
+  setenv("MXNET_CPU_TEMP_POOL_MAX_COPY", "3", 1);
+  // the resource manager is thread local, a new thread picks up the environment
+  std::thread t([]() {
+    mxnet::ResourceManager* rm = mxnet::ResourceManager::Get();
+    const mxnet::ResourceRequest req(mxnet::ResourceRequest::kTempSpace);
+    std::vector<mxnet::Resource> res;
+    std::set<mxnet::engine::VarHandle> vars;
+    for (int i = 0; i < 5; ++i) {
+      res.push_back(rm->Request(mxnet::Context::CPU(), req));
+      vars.insert(res.back().var);
+    }
+    // every request gets its own workspace until the pool is exhausted
+    EXPECT_EQ(vars.size(), 3U);
+    EXPECT_NE(res[0].var, res[1].var);
+    EXPECT_NE(res[1].var, res[2].var);
+    EXPECT_EQ(res[3].var, res[0].var);
+    // workspaces grow to size classes
+    void* small = res[0].get_space_internal(5000);
+    EXPECT_NE(small, nullptr);
+    EXPECT_EQ(res[0].get_space_internal(5100), small);
+    EXPECT_EQ(res[0].get_space_internal(100), small);
+    // released workspaces are reused once their operations complete
+    rm->Release(res[1]);
+    rm->Release(res[4]);
+    mxnet::Engine::Get()->WaitForAll();
+    EXPECT_EQ(rm->Request(mxnet::Context::CPU(), req).var, res[1].var);
+  });
+  t.join();
+  unsetenv("MXNET_CPU_TEMP_SPACE_MODE");
+  unsetenv("MXNET_CPU_TEMP_POOL_MAX_COPY");
+}
+
+TEST(Resource, TempSpacePoolSizeLimit) {
+  setenv("MXNET_CPU_TEMP_SPACE_MODE", "Pool", 1);
+  setenv("MXNET_CPU_TEMP_POOL_SIZE_MB", "1", 1);
+  std::thread t([]() {
+    mxnet::ResourceManager* rm = mxnet::ResourceManager::Get();
+    const mxnet::ResourceRequest req(mxnet::ResourceRequest::kTempSpace);
+    mxnet::Resource a = rm->Request(mxnet::Context::CPU(), req);
+    EXPECT_NE(a.get_space_internal(3 << 19), nullptr);
+    // past the size limit, requests share workspaces
+    mxnet::Resource b = rm->Request(mxnet::Context::CPU(), req);
+    EXPECT_EQ(b.var, a.var);
+    // and idle workspaces drop their buffers, which makes room for new workspaces
+    rm->Release(a);
+    rm->Release(b);
+    mxnet::Engine::Get()->WaitForAll();
+    EXPECT_EQ(rm->Request(mxnet::Context::CPU(), req).var, a.var);
+    EXPECT_NE(rm->Request(mxnet::Context::CPU(), req).var, a.var);
+  });
+  t.join();
+  unsetenv("MXNET_CPU_TEMP_SPACE_MODE");
+  unsetenv("MXNET_CPU_TEMP_POOL_SIZE_MB");
+}
+#endif  // !defined(_WIN32)
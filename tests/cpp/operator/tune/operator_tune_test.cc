@@ -20,6 +20,7 @@
 #include <mxnet/tensor_blob.h>
 #include "../../src/operator/nn/activation-inl.h"
 #include "../../src/operator/operator_tune-inl.h"
+#include "../../src/operator/operator_tune_cache.h"
 #include "../include/test_op_runner.h"
 #include "../include/test_core_op.h"
 #include "../include/test_tune.h"
@@ -174,5 +175,28 @@ TEST(OMP_TUNING, EvaluateTuneTestInt64) {
   std::cout << "Success rate for type " << test::type_name<DType>() << ": " << result << std::endl;
 }
 
+/*! \brief Operator tuning cache file survives a round trip and rejects other keys */
+TEST(OMP_TUNING, CacheFileRoundTrip) {
+  const std::string path = "operator_tune_cache_test.txt";
+  const std::string key = op::OperatorTuneCache::CacheKey();
+  std::unordered_map<std::string, std::vector<float>> workloads = {
+    { "mxnet::op::mxnet_op::tuned_op<mxnet::op::mshadow_op::plus, float>", { 1234.5f } },
+    { "mxnet::op::mxnet_op::tuned_op<custom, double>", { 1.0f, 2.0f, 3.0f } }
+  };
+  EXPECT_TRUE(op::OperatorTuneCache::WriteFile(path, key, 4321, workloads));
+
+  int64_t omp_overhead_ns = 0;
+  std::unordered_map<std::string, std::vector<float>> loaded;
+  EXPECT_TRUE(op::OperatorTuneCache::ReadFile(path, key, &omp_overhead_ns, &loaded));
+  EXPECT_EQ(omp_overhead_ns, 4321);
+  EXPECT_EQ(loaded, workloads);
+
+  EXPECT_FALSE(op::OperatorTuneCache::ReadFile(path, key + " other", &omp_overhead_ns, &loaded));
+  EXPECT_EQ(omp_overhead_ns, -1);
+  EXPECT_TRUE(loaded.empty());
+  std::remove(path.c_str());
+  EXPECT_FALSE(op::OperatorTuneCache::ReadFile(path, key, &omp_overhead_ns, &loaded));
+}
+
 #endif  // MXNET_USE_OPERATOR_TUNING
 
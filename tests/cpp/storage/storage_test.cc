@@ -24,9 +24,17 @@
 #include <stdlib.h>
 #include <gtest/gtest.h>
 #include <dmlc/logging.h>
+#include <dmlc/timer.h>
 #include <mxnet/storage.h>
 #include <cstdio>
+#include <memory>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
 #include "test_util.h"
+#include "../../src/storage/cpu_pooled_storage_manager.h"
+#include "../../src/storage/naive_storage_manager.h"
 
 TEST(Storage, Basic_CPU) {
   constexpr size_t kSize = 1024;
@@ -47,6 +55,97 @@ TEST(Storage, Basic_CPU) {
   storage->Free(handle);
 }
 
+TEST(Storage, CPU_Pooled) {
+  using mxnet::storage::CPUPooledStorageManager;
+  for (auto strategy : {CPUPooledStorageManager::Strategy::kExact,
+                        CPUPooledStorageManager::Strategy::kRound}) {
+    CPUPooledStorageManager manager(strategy);
+    mxnet::Storage::Handle handle;
+    handle.ctx = mxnet::Context::CPU();
+    handle.size = 1000;
+    manager.Alloc(&handle);
+    ASSERT_NE(handle.dptr, nullptr);
+    auto ptr = handle.dptr;
+    const size_t used = manager.used_memory();
+    EXPECT_GE(used, 1000U);
+    manager.Free(handle);
+
+    // a request in the same size class reuses the chunk from the thread cache
+    handle.size = manager.RoundAllocSize(1000);
+    manager.Alloc(&handle);
+    EXPECT_EQ(handle.dptr, ptr);
+    EXPECT_EQ(manager.used_memory(), used);
+
+    // a chunk freed on another thread is still reusable
+    std::thread([&manager, handle]() { manager.Free(handle); }).join();
+    manager.Alloc(&handle);
+    EXPECT_NE(handle.dptr, nullptr);
+    manager.Free(handle);
+
+    handle.size = 0;
+    manager.Alloc(&handle);
+    EXPECT_EQ(handle.dptr, nullptr);
+    manager.Free(handle);
+
+    manager.ReleaseAll();
+    EXPECT_EQ(manager.used_memory(), 0U);
+  }
+}
+
+TEST(Storage, CPU_PooledRoundSizeClasses) {
+  using mxnet::storage::CPUPooledStorageManager;
+  CPUPooledStorageManager manager(CPUPooledStorageManager::Strategy::kRound);
+  EXPECT_EQ(manager.RoundAllocSize(1), 64U);
+  EXPECT_EQ(manager.RoundAllocSize(65), 128U);
+  EXPECT_EQ(manager.RoundAllocSize(4096), 4096U);
+  EXPECT_EQ(manager.RoundAllocSize(4097), 8192U);
+  EXPECT_EQ(manager.RoundAllocSize((1UL << 24) + 1), 2UL << 24);
+  EXPECT_EQ(manager.RoundAllocSize((2UL << 24) + 1), 3UL << 24);
+}
+
+/*!
+ * \brief Alloc/free throughput of the cpu storage managers with mixed sizes and threads
+ */
+TEST(Storage, CPU_PooledPerf) {
+  using mxnet::storage::CPUPooledStorageManager;
+  using mxnet::storage::StorageManager;
+  const size_t kIterations = mxnet::test::performance_run ? 200000 : 2000;
+  const std::vector<size_t> sizes = {4, 64, 300, 4096, 10000, 65536, 1 << 20};
+  std::vector<std::pair<std::string, std::unique_ptr<StorageManager>>> managers;
+  managers.emplace_back("Unpooled", std::unique_ptr<StorageManager>(
+      new mxnet::storage::NaiveStorageManager<mxnet::storage::CPUDeviceStorage>()));
+  managers.emplace_back("Naive", std::unique_ptr<StorageManager>(
+      new CPUPooledStorageManager(CPUPooledStorageManager::Strategy::kExact)));
+  managers.emplace_back("Round", std::unique_ptr<StorageManager>(
+      new CPUPooledStorageManager(CPUPooledStorageManager::Strategy::kRound)));
+  for (int num_threads : {1, 4}) {
+    for (auto&& m : managers) {
+      StorageManager* manager = m.second.get();
+      const double start = dmlc::GetTime();
+      std::vector<std::thread> threads;
+      for (int t = 0; t < num_threads; ++t) {
+        threads.emplace_back([manager, &sizes, kIterations, t]() {
+          std::vector<mxnet::Storage::Handle> live(8);
+          for (size_t i = 0; i < kIterations; ++i) {
+            mxnet::Storage::Handle& handle = live[i % live.size()];
+            manager->Free(handle);
+            handle.size = sizes[(i * 7 + t) % sizes.size()];
+            manager->Alloc(&handle);
+            // touch the first page like a real kernel would
+            static_cast<char*>(handle.dptr)[0] = 1;
+          }
+          for (auto& handle : live) manager->Free(handle);
+        });
+      }
+      for (auto& thread : threads) thread.join();
+      const double elapsed = dmlc::GetTime() - start;
+      LOG(INFO) << m.first << "\t" << num_threads << " threads\t"
+                << (kIterations * num_threads) / elapsed / 1e6 << " M alloc/free per sec";
+      manager->ReleaseAll();
+    }
+  }
+}
+
 #if MXNET_USE_CUDA
 TEST(Storage_GPU, Basic_GPU) {
   if (mxnet::test::unitTestsWithCuda) {
@@ -0,0 +1,76 @@
+#!/usr/bin/env python
+
+# Licensed to the Apache Software Foundation (ASF) under one
+# or more contributor license agreements.  See the NOTICE file
+# distributed with this work for additional information
+# regarding copyright ownership.  The ASF licenses this file
+# to you under the Apache License, Version 2.0 (the
+# "License"); you may not use this file except in compliance
+# with the License.  You may obtain a copy of the License at
+#
+#   http://www.apache.org/licenses/LICENSE-2.0
+#
+# Unless required by applicable law or agreed to in writing,
+# software distributed under the License is distributed on an
+# "AS IS" BASIS, WITHOUT WARRANTIES OR CONDITIONS OF ANY
+# KIND, either express or implied.  See the License for the
+# specific language governing permissions and limitations
+# under the License.
+
+# pylint: skip-file
+import os
+import sys
+sys.path.insert(0, "../../python/")
+import argparse
+import mxnet as mx
+import numpy as np
+
+shape = (2, 3)
+big_shape = (1200, 1200)        # bigger than MXNET_KVSTORE_BIGARRAY_BOUND
+keys_shapes = [('3', shape), ('5', shape), ('99', big_shape)]
+fp16_keys_shapes = [('4', shape), ('100', big_shape)]
+rate = 2
+
+def check_diff(A, x, rank=None):
+    """ assert A == x
+        x can be scalar as well as numpy array
+    """
+    assert (np.sum(np.abs((A - x).asnumpy())) == 0), (rank, A.asnumpy(), x.asnumpy())
+
+def test_hierarchical_push_pull(kv, nrepeat):
+    my_rank = kv.rank
+    nworker = kv.num_workers
+    for dtype, ks in [('float32', keys_shapes), ('float16', fp16_keys_shapes)]:
+        for k, s in ks:
+            kv.init(k, mx.nd.ones(s, dtype=dtype))
+    kv.set_optimizer(mx.optimizer.create('test', rescale_grad=rate))
+    for dtype, ks in [('float32', keys_shapes), ('float16', fp16_keys_shapes)]:
+        for k, s in ks:
+            # before the first push every worker pulls from the servers
+            val = mx.nd.zeros(s, dtype=dtype)
+            kv.pull(k, out=val)
+            check_diff(val, 1, my_rank)
+            expected = 1
+            for i in range(nrepeat):
+                # a different value in every round catches stale shared slots
+                kv.push(k, mx.nd.ones(s, dtype=dtype) * (my_rank + 1) * (i + 1))
+                expected += (nworker + 1) * nworker * rate / 2 * (i + 1)
+                val = mx.nd.zeros(s, dtype=dtype)
+                kv.pull(k, out=val)
+                check_diff(val, expected, my_rank)
+    print('worker ' + str(my_rank) + ' is done')
+
+if __name__ == "__main__":
+    parser = argparse.ArgumentParser(description='test hierarchical dist_sync kvstore')
+    parser.add_argument('--nrepeat', type=int, default=5)
+    parser.add_argument('--num-nodes', type=int, default=2,
+                        help='number of simulated machines the local workers are split into')
+    opt = parser.parse_args()
+    # the node is picked before the kvstore assigns ranks, so split the workers into
+    # contiguous, equally sized groups by the task id the local launcher gives them
+    num_workers = int(os.environ['DMLC_NUM_WORKER'])
+    workers_per_node = (num_workers + opt.num_nodes - 1) // opt.num_nodes
+    node = int(os.environ['DMLC_TASK_ID']) // workers_per_node
+    os.environ['MXNET_KVSTORE_HIERARCHICAL_NODE'] = 'node' + str(node)
+    kv = mx.kv.create('dist_sync_hierarchical')
+    test_hierarchical_push_pull(kv, opt.nrepeat)
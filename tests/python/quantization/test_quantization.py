@@ -677,6 +677,59 @@ def test_quantized_bn():
       check_quantized_bn((32, 1024, 8, 8), qdtype)
       check_quantized_bn((32, 3, 224, 224), qdtype)
 
+@with_seed()
+def test_quantized_rnn():
+    def check_quantized_rnn(mode, num_layers, bidirectional, qdtype):
+        if is_test_for_gpu():
+            print('skipped testing quantized_rnn for gpu since it is not supported yet')
+            return
+
+        seq_len, batch_size, input_size, state_size = 8, 4, 32, 32
+        directions = 2 if bidirectional else 1
+        data_low = 0.0 if qdtype == 'uint8' else -1.0
+        data = mx.nd.random.uniform(low=data_low, high=1.0,
+                                    shape=(seq_len, batch_size, input_size))
+        state_shape = (num_layers * directions, batch_size, state_size)
+        data_sym = mx.sym.Variable('data')
+        rnn_fp32 = mx.sym.RNN(data=data_sym, state_size=state_size, num_layers=num_layers,
+                              bidirectional=bidirectional, mode=mode, name='rnn')
+        arg_shapes, _, _ = rnn_fp32.infer_shape(data=data.shape)
+        args = {'data': data, 'rnn_parameters': mx.nd.random.uniform(low=-0.2, high=0.2,
+                                                                      shape=arg_shapes[1]),
+                'rnn_state': mx.nd.random.uniform(low=-0.5, high=0.5, shape=state_shape)}
+        if mode == 'lstm':
+            args['rnn_state_cell'] = mx.nd.random.uniform(low=-0.5, high=0.5, shape=state_shape)
+        states = [args['rnn_state']] + ([args['rnn_state_cell']] if mode == 'lstm' else [])
+        output = mx.nd.RNN(data, args['rnn_parameters'], *states, state_size=state_size,
+                           num_layers=num_layers, bidirectional=bidirectional, mode=mode)
+
+        qdata, min_data, max_data = mx.nd.contrib.quantize_v2(data, out_type=qdtype)
+        out_range = float(mx.nd.max(mx.nd.abs(output)).asscalar())
+        qoutput, min_output, max_output = mx.nd.contrib.quantized_rnn(
+            qdata, args['rnn_parameters'], *(states + [min_data, max_data]),
+            state_size=state_size, num_layers=num_layers, bidirectional=bidirectional,
+            mode=mode, min_calib_range=-out_range, max_calib_range=out_range)
+        assert qoutput.dtype == np.int8
+        assert qoutput.shape == output.shape
+        assert_almost_equal(min_output.asnumpy(), np.array([-out_range]), rtol=1e-5)
+        assert_almost_equal(max_output.asnumpy(), np.array([out_range]), rtol=1e-5)
+        output_int8_to_fp32 = mx.nd.contrib.dequantize(qoutput, min_output, max_output)
+        assert_almost_equal(output.asnumpy(), output_int8_to_fp32.asnumpy(), rtol=0, atol=0.1)
+
+        # the quantization pass replaces the RNN and keeps its parameters in float32
+        offline_params = [name for name in rnn_fp32.list_arguments() if name != 'data']
+        qsym, _ = mx.contrib.quant._quantize_symbol(rnn_fp32, ctx=mx.current_context(),
+                                                    offline_params=offline_params,
+                                                    quantize_mode='full')
+        assert qsym.tojson().find('_contrib_quantized_rnn') != -1
+        assert 'rnn_parameters' in qsym.list_arguments()
+
+    for mode in ['lstm', 'gru']:
+        for num_layers in [1, 2]:
+            for bidirectional in [False, True]:
+                for qdtype in ['int8', 'uint8']:
+                    check_quantized_rnn(mode, num_layers, bidirectional, qdtype)
+
 @with_seed()
 def test_quantize_params():
     if is_test_for_native_cpu():
@@ -191,6 +191,40 @@ def test_adamw():
     mx.test_utils.assert_almost_equal(weight_fp16_ref.asnumpy(), weight_fp16.asnumpy())
 
 
+def test_multi_adamw():
+    shapes = [(3, 4), (7,), (2, 3, 2)]
+    lrs, wds, etas = [0.1, 0.2, 0.3], [0.01, 0.0, 0.02], [1.0, 0.5, 0.9]
+    kwargs = {'beta1': 0.9, 'beta2': 0.999, 'epsilon': 1e-8}
+    weights = [mx.nd.random.uniform(shape=s) for s in shapes]
+    grads = [mx.nd.random.uniform(shape=s) for s in shapes]
+    means = [mx.nd.random.uniform(shape=s) for s in shapes]
+    variances = [mx.nd.random.uniform(shape=s) for s in shapes]
+    rescale_grad = mx.nd.array([0.5])
+    ref_weights = [w.copy() for w in weights]
+    ref_means = [m.copy() for m in means]
+    ref_variances = [v.copy() for v in variances]
+    for w, g, m, v, lr, wd, eta in zip(ref_weights, grads, ref_means, ref_variances,
+                                       lrs, wds, etas):
+        mx.nd.contrib.adamw_update(w, g, m, v, rescale_grad, out=w, lr=lr, wd=wd, eta=eta,
+                                   **kwargs)
+
+    # update is skipped for rescale = nan
+    weights_before = [w.copy() for w in weights]
+    mx.nd.contrib.multi_adamw_update(weights, grads, means, variances, np.nan,
+                                     out=weights, lrs=lrs, wds=wds, etas=etas, **kwargs)
+    for w, w_before in zip(weights, weights_before):
+        mx.test_utils.assert_almost_equal(w_before.asnumpy(), w.asnumpy())
+
+    mx.nd.contrib.multi_adamw_update(weights, grads, means, variances, rescale_grad,
+                                     out=weights, lrs=lrs, wds=wds, etas=etas, **kwargs)
+    for w, ref_w in zip(weights, ref_weights):
+        mx.test_utils.assert_almost_equal(ref_w.asnumpy(), w.asnumpy())
+    for m, ref_m in zip(means, ref_means):
+        mx.test_utils.assert_almost_equal(ref_m.asnumpy(), m.asnumpy())
+    for v, ref_v in zip(variances, ref_variances):
+        mx.test_utils.assert_almost_equal(ref_v.asnumpy(), v.asnumpy())
+
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
@@ -18,7 +18,7 @@
 import numpy as np
 import mxnet as mx
 from common import setup_module, with_seed, teardown
-from mxnet.test_utils import assert_almost_equal
+from mxnet.test_utils import assert_almost_equal, EnvManager
 
 
 def check_bind_with_uniform(uf, gf, dim, sf=None, lshape=None, rshape=None):
@@ -165,6 +165,51 @@ def test_reshape():
     assert np.all(new_exe.arg_arrays[1].asnumpy() == 1)
 
 
+@with_seed()
+def test_arena_memory_plan():
+    # MXNET_MEM_PLAN_TYPE=Arena packs the entries into one buffer, results must not change
+    data = mx.sym.var('data')
+    r1 = mx.sym.relu(data)
+    s1 = mx.sym.sigmoid(mx.sym.FullyConnected(r1, num_hidden=256, name='fc1'))
+    a1 = mx.sym.FullyConnected(s1, num_hidden=64, name='fc2') + r1
+    s3 = mx.sym.tanh(mx.sym.FullyConnected(a1, num_hidden=256, name='fc3'))
+    sym = mx.sym.Group([mx.sym.FullyConnected(s3, num_hidden=16, name='fc4'), a1 * 2])
+    args = {name: mx.nd.random.uniform(-1, 1, shape)
+            for name, shape in zip(sym.list_arguments(), sym.infer_shape(data=(8, 64))[0])}
+    out_grads = [mx.nd.random.uniform(-1, 1, shape)
+                 for shape in sym.infer_shape(data=(8, 64))[1]]
+
+    def run_executor():
+        grads = {name: mx.nd.zeros_like(arg) for name, arg in args.items()}
+        exe = sym.bind(mx.cpu(), args=args, args_grad=grads)
+        exe.forward(is_train=True)
+        exe.backward(out_grads)
+        return [out.asnumpy() for out in exe.outputs] + \
+               [grads[name].asnumpy() for name in sym.list_arguments()]
+
+    def run_cached_op(static_alloc):
+        net = mx.gluon.SymbolBlock(sym, [data])
+        net.collect_params().initialize()
+        for name, param in net.collect_params().items():
+            param.set_data(args[name])
+        net.hybridize(static_alloc=static_alloc, static_shape=static_alloc)
+        x = args['data'].copy()
+        x.attach_grad()
+        with mx.autograd.record():
+            outs = net(x)
+        mx.autograd.backward(outs, out_grads)
+        return [out.asnumpy() for out in outs] + [x.grad.asnumpy()] + \
+               [param.grad().asnumpy() for param in net.collect_params().values()]
+
+    expected = [run_executor(), run_cached_op(False), run_cached_op(True)]
+    with EnvManager('MXNET_MEM_PLAN_TYPE', 'Arena'):
+        results = [run_executor(), run_cached_op(False), run_cached_op(True)]
+    for expected_arrays, arrays in zip(expected, results):
+        assert len(expected_arrays) == len(arrays)
+        for expected_array, array in zip(expected_arrays, arrays):
+            assert_almost_equal(array, expected_array)
+
+
 if __name__ == "__main__":
     import nose
     nose.runmodule()
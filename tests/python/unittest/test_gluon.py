@@ -1445,6 +1445,61 @@ def test_hybrid_static_memory():
     check_hybrid_static_memory(static_alloc=True)
     check_hybrid_static_memory(static_alloc=True, static_shape=True)
 
+@with_seed()
+def test_hybrid_static_replay():
+    def get_net():
+        net = nn.HybridSequential(prefix='net_')
+        with net.name_scope():
+            net.add(nn.Dense(32, activation='relu'))
+            net.add(nn.Dense(16, activation='tanh'))
+            net.add(nn.Dense(4))
+        net.initialize(mx.init.Xavier())
+        return net
+
+    net1 = get_net()
+    net2 = get_net()
+    net1(mx.nd.ones((1, 8)))
+    net2(mx.nd.ones((1, 8)))
+    for p1, p2 in zip(net1.collect_params().values(), net2.collect_params().values()):
+        p2.set_data(p1.data())
+    net1.hybridize(static_alloc=True, static_shape=True)
+    net2.hybridize(static_alloc=True, static_shape=True, static_replay=True)
+
+    for shape in [(1, 8), (1, 8), (3, 8), (3, 8), (1, 8)]:
+        x = mx.nd.random.uniform(shape=shape)
+        y1 = net1(x)
+        y2 = net2(x)
+        assert_almost_equal(y1.asnumpy(), y2.asnumpy(), rtol=1e-5, atol=1e-6)
+        # outputs of earlier calls must not be overwritten by later ones
+        z2 = net2(x * 2)
+        assert_almost_equal(y1.asnumpy(), y2.asnumpy(), rtol=1e-5, atol=1e-6)
+        assert_almost_equal(net1(x * 2).asnumpy(), z2.asnumpy(), rtol=1e-5, atol=1e-6)
+
+    # released outputs are reused, while more outputs than the pool holds stay valid
+    x = mx.nd.random.uniform(shape=(1, 8))
+    for _ in range(3):
+        assert_almost_equal(net1(x).asnumpy(), net2(x).asnumpy(), rtol=1e-5, atol=1e-6)
+    xs = [x * i for i in range(6)]
+    ys = [net2(xi) for xi in xs]
+    for xi, yi in zip(xs, ys):
+        assert_almost_equal(net1(xi).asnumpy(), yi.asnumpy(), rtol=1e-5, atol=1e-6)
+
+    # recording falls back to the regular static path
+    def record(net, x):
+        x = x.copy()
+        x.attach_grad()
+        with mx.autograd.record():
+            y = net(x)
+        y.backward()
+        return y.asnumpy(), x.grad.asnumpy()
+
+    x = mx.nd.random.uniform(shape=(2, 8))
+    y1, grad1 = record(net1, x)
+    y2, grad2 = record(net2, x)
+    assert_almost_equal(y1, y2, rtol=1e-5, atol=1e-6)
+    assert_almost_equal(grad1, grad2, rtol=1e-5, atol=1e-6)
+    assert_almost_equal(net1(x).asnumpy(), net2(x).asnumpy(), rtol=1e-5, atol=1e-6)
+
 def check_hybrid_static_memory_switching(**kwargs):
     net = gluon.model_zoo.vision.get_resnet(
         1, 18, pretrained=True, ctx=mx.context.current_context())
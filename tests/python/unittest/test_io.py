@@ -30,7 +30,7 @@ try:
 except ImportError:
     h5py = None
 import sys
-from common import assertRaises
+from common import assertRaises, TemporaryDirectory
 import unittest
 try:
     from itertools import izip_longest as zip_longest
@@ -443,6 +443,172 @@ def test_CSVIter():
     for dtype in ['int32', 'int64', 'float32']:
         check_CSVIter_synthetic(dtype=dtype)
 
+def test_CSVIter_staged_prefetch():
+    with TemporaryDirectory() as tmpdir:
+        data_path = os.path.join(tmpdir, 'data_staged.t')
+        with open(data_path, 'w') as fout:
+            for i in range(1000):
+                fout.write(','.join([str(i)] * 4) + '\n')
+        batch_size = 100
+        expected = np.arange(1000, dtype='float32').reshape((-1, 1)).repeat(4, axis=1)
+        for stage_dev_type in ['cpu', 'cpu_pinned', 'cpu_shared']:
+            for stage_depth in [1, 2, 3]:
+                data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(4,),
+                                          batch_size=batch_size, stage_dev_type=stage_dev_type,
+                                          stage_depth=stage_depth)
+                for _ in range(2):
+                    data_iter.reset()
+                    num_batches = 0
+                    prev = None
+                    for i, batch in enumerate(data_iter):
+                        data = batch.data[0]
+                        assert data.context.device_type == stage_dev_type
+                        assert_almost_equal(data.asnumpy(),
+                                            expected[i * batch_size:(i + 1) * batch_size])
+                        # a batch held across next() is not overwritten
+                        if prev is not None:
+                            assert_almost_equal(prev.asnumpy(),
+                                                expected[(i - 1) * batch_size:i * batch_size])
+                        prev = data
+                        num_batches += 1
+                    assert num_batches == 1000 // batch_size
+
+def test_CSVIter_parser():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_parser.t')
+    np.random.seed(0)
+    num_rows, num_cols = 1003, 7
+    expected = np.random.uniform(-1e5, 1e5, size=(num_rows, num_cols)).astype('float32')
+    expected[::3] = np.round(expected[::3])
+    with open(data_path, 'w') as fout:
+        for i, row in enumerate(expected):
+            if i % 5 == 0:
+                fout.write(','.join(['%e' % v for v in row]) + '\r\n')
+            else:
+                fout.write(' , '.join(['%r' % float(v) for v in row]) + '\n')
+            if i % 7 == 0:
+                fout.write('\n')
+    batch_size = 50
+    for preprocess_threads in [1, 4]:
+        data_iter = mx.io.CSVIter(data_csv=data_path, data_shape=(num_cols,),
+                                  batch_size=batch_size, round_batch=False,
+                                  preprocess_threads=preprocess_threads)
+        for _ in range(2):
+            data_iter.reset()
+            num_batches = 0
+            for i, batch in enumerate(data_iter):
+                data = batch.data[0].asnumpy()
+                valid = batch_size - batch.pad
+                assert_almost_equal(data[:valid],
+                                    expected[i * batch_size:i * batch_size + valid])
+                num_batches += 1
+            assert num_batches == (num_rows + batch_size - 1) // batch_size
+
+def test_LibSVMIter_parser():
+    cwd = os.getcwd()
+    data_path = os.path.join(cwd, 'data_parser.t')
+    np.random.seed(0)
+    num_rows, num_cols = 1000, 50
+    expected = np.random.uniform(-10, 10, size=(num_rows, num_cols)).astype('float32')
+    expected[np.random.uniform(size=expected.shape) < 0.8] = 0
+    labels = np.random.randint(0, 10, size=(num_rows,)).astype('float32')
+    with open(data_path, 'w') as fout:
+        for label, row in zip(labels, expected):
+            features = ['%d:%r' % (j, float(v)) for j, v in enumerate(row) if v != 0]
+            fout.write(' '.join(['%d' % label] + features) + '\n')
+    batch_size = 64
+    for preprocess_threads in [1, 4]:
+        data_iter = mx.io.LibSVMIter(data_libsvm=data_path, data_shape=(num_cols,),
+                                     batch_size=batch_size, preprocess_threads=preprocess_threads)
+        offset = 0
+        for _ in range(3):
+            data_iter.reset()
+            for batch in data_iter:
+                data = batch.data[0]
+                data.check_format(True)
+                rows = np.arange(offset, offset + batch_size) % num_rows
+                assert_almost_equal(data.asnumpy(), expected[rows])
+                assert_almost_equal(batch.label[0].asnumpy(), labels[rows])
+                offset += batch_size
+
+def test_ImageRecordIter_mmap():
+    get_cifar10()
+    # repack the first records with their position as label, together with an index
+    num_images = 500
+    rec_path = os.path.join('data', 'cifar', 'mmap_test.rec')
+    idx_path = os.path.join('data', 'cifar', 'mmap_test.idx')
+    reader = mx.recordio.MXRecordIO('data/cifar/test.rec', 'r')
+    writer = mx.recordio.MXIndexedRecordIO(idx_path, rec_path, 'w')
+    for i in range(num_images):
+        header, img = mx.recordio.unpack(reader.read())
+        writer.write_idx(i, mx.recordio.pack(header._replace(label=float(i)), img))
+    reader.close()
+    writer.close()
+
+    def read_labels(shuffle, seed, num_parts, part_index, num_epochs=1, idx_path=idx_path):
+        data_iter = mx.io.ImageRecordIter(path_imgrec=rec_path, path_imgidx=idx_path,
+                                          mmap_recordio=True, data_shape=(3, 28, 28),
+                                          batch_size=50, round_batch=False, shuffle=shuffle,
+                                          seed=seed, num_parts=num_parts, part_index=part_index)
+        epochs = []
+        for _ in range(num_epochs):
+            data_iter.reset()
+            labels = []
+            for batch in data_iter:
+                labels += list(batch.label[0].asnumpy()[:50 - batch.pad])
+            epochs.append(labels)
+        return epochs
+
+    assert read_labels(False, 0, 1, 0)[0] == list(range(num_images))
+    # every epoch is a new global permutation, the same for the same seed
+    first, second = read_labels(True, 3, 1, 0, num_epochs=2)
+    assert sorted(first) == list(range(num_images))
+    assert sorted(second) == list(range(num_images))
+    assert first != second
+    assert read_labels(True, 3, 1, 0, num_epochs=2) == [first, second]
+    # the parts are disjoint slices of the same permutation
+    parts = [read_labels(True, 3, 3, i)[0] for i in range(3)]
+    assert sum(parts, []) == first
+    # an index listing only some records reads exactly those
+    subset_idx_path = os.path.join('data', 'cifar', 'mmap_test_subset.idx')
+    with open(idx_path) as fin, open(subset_idx_path, 'w') as fout:
+        for line in fin:
+            if int(line.split('\t')[0]) % 2 == 0:
+                fout.write(line)
+    assert read_labels(False, 0, 1, 0, idx_path=subset_idx_path)[0] == \
+        list(range(0, num_images, 2))
+
+def test_ImageRecordIter_fused_decode():
+    get_cifar10()
+    fused_available = mx.runtime.Features().is_enabled('LIBJPEG_TURBO')
+    configs = [dict(),
+               dict(resize=64),
+               dict(resize=40, rand_crop=True, rand_mirror=True, seed_aug=3),
+               dict(mean_r=123.68, mean_g=116.779, mean_b=103.939, std_r=58.4, std_g=57.1,
+                    std_b=57.4)]
+    for dtype in ['uint8', 'float32']:
+        for config in configs:
+            if dtype == 'uint8' and 'mean_r' in config:
+                continue
+            batches = []
+            for fused_decode in [False, True]:
+                data_iter = mx.io.ImageRecordIter(path_imgrec='data/cifar/test.rec',
+                                                  data_shape=(3, 28, 28), batch_size=100,
+                                                  dtype=dtype, preprocess_threads=1,
+                                                  fused_decode=fused_decode, **config)
+                batches.append([batch.data[0].asnumpy().astype('float32')
+                                for _, batch in zip(range(3), data_iter)])
+            if 'resize' in config:
+                # only the fused path rounds the interpolation differently
+                differs = any(not np.array_equal(regular, fused)
+                              for regular, fused in zip(*batches))
+                assert differs == fused_available
+            # the fused path only differs in the rounding of the interpolation,
+            # one level of the unnormalized values, scaled by std when normalized
+            atol = 1.01 / 57.1 if 'std_r' in config else 1.01
+            for regular, fused in zip(*batches):
+                assert_almost_equal(regular, fused, rtol=0, atol=atol)
+
 def test_ImageRecordIter_seed_augmentation():
     get_cifar10()
     seed_aug = 3
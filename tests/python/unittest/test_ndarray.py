@@ -396,6 +396,33 @@ def test_ndarray_saveload():
     os.remove(fname)
 
 
+@with_seed()
+def test_ndarray_saveload_aligned():
+    with TemporaryDirectory(prefix='test_ndarray_saveload_aligned_') as tmpdir:
+        fname = os.path.join(tmpdir, 'aligned.params')
+        dtypes = ['float32', 'float16', 'float64', 'int32', 'int8', 'uint8']
+        dmap = {'arr%d' % i: mx.nd.array(np.random.uniform(-10, 10, size=(i + 1, 3)), dtype=dtype)
+                for i, dtype in enumerate(dtypes)}
+        mx.nd.save(fname, dmap, aligned=True)
+        for mmap in ['0', '1']:
+            os.environ['MXNET_NDARRAY_LOAD_MMAP'] = mmap
+            dmap2 = mx.nd.load(fname)
+            assert len(dmap2) == len(dmap)
+            for k, x in dmap.items():
+                y = dmap2[k]
+                assert x.dtype == y.dtype
+                assert_almost_equal(x.asnumpy(), y.asnumpy())
+            # writes go to private pages and never reach the file
+            dmap2['arr0'][:] = 0
+            assert_almost_equal(mx.nd.load(fname)['arr0'].asnumpy(), dmap['arr0'].asnumpy())
+        del os.environ['MXNET_NDARRAY_LOAD_MMAP']
+        # the aligned layout is also readable from a buffer
+        with open(fname, 'rb') as f:
+            data = mx.nd.load_frombuffer(f.read())
+        for k, x in dmap.items():
+            assert_almost_equal(x.asnumpy(), data[k].asnumpy())
+
+
 @with_seed()
 def test_ndarray_legacy_load():
     data = []
@@ -2741,6 +2741,24 @@ def test_reduce():
                           mx.symbol.norm, test_exclude=False, test_none_axis=test_none)
 
 
+@with_seed()
+def test_reduce_contiguous_axes():
+    # inner and outer axis reductions, large enough to be split across threads
+    for shape, axis in [((3, 50000), 1), ((50000, 3), 0), ((2, 3, 9000), (1, 2)),
+                        ((9000, 2, 3), (0, 1)), ((700, 513), 0), ((513, 700), 1),
+                        ((4, 5, 6), 1)]:
+        data = np.random.uniform(-1, 1, shape).astype(np.float32)
+        x = mx.nd.array(data)
+        assert_almost_equal(mx.nd.sum(x, axis=axis).asnumpy(),
+                            np.sum(data.astype(np.float64), axis=axis), rtol=1e-4, atol=1e-3)
+        assert_almost_equal(mx.nd.mean(x, axis=axis).asnumpy(),
+                            np.mean(data.astype(np.float64), axis=axis), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(mx.nd.max(x, axis=axis).asnumpy(), np.max(data, axis=axis))
+        assert_almost_equal(mx.nd.min(x, axis=axis).asnumpy(), np.min(data, axis=axis))
+        assert_almost_equal(mx.nd.norm(x, axis=axis).asnumpy(),
+                            np.linalg.norm(data.astype(np.float64), axis=axis), rtol=1e-4, atol=1e-4)
+
+
 @with_seed()
 def test_broadcast():
     sample_num = 200
@@ -3790,6 +3808,23 @@ def test_layer_norm():
                                                   finite_grad_check=finite_grad_check)
 
 
+@with_seed()
+def test_layer_norm_large_mean():
+    # Rows whose mean is large relative to their spread lose all precision with
+    # E[x^2] - E[x]^2, the moments must be computed from the centered data
+    for dtype in [np.float16, np.float32]:
+        in_shape = (8, 300)
+        data = (np.random.normal(0, 1, in_shape) + 100).astype(dtype)
+        gamma = np.ones((in_shape[-1],), dtype=dtype)
+        beta = np.zeros((in_shape[-1],), dtype=dtype)
+        out = mx.nd.LayerNorm(mx.nd.array(data, dtype=dtype), mx.nd.array(gamma, dtype=dtype),
+                              mx.nd.array(beta, dtype=dtype), axis=-1, eps=1E-5)
+        data = data.astype(np.float64)
+        expected = (data - data.mean(axis=-1, keepdims=True)) / \
+                   np.sqrt(data.var(axis=-1, keepdims=True) + 1E-5)
+        assert_almost_equal(out.asnumpy().astype(np.float64), expected, rtol=1E-2, atol=1E-2)
+
+
 # Numpy Implementation of Sequence Ops
 def sequence_last_numpy(array, lengths, axis):
     # create new array of dims [batch, seqlen, ...]
@@ -5684,6 +5719,63 @@ def test_div_sqrt_dim():
     check_symbolic_forward(test, [data_tmp], [data_tmp / np.sqrt(data_tmp.shape[-1])])
 
 
+@with_seed()
+def test_interleaved_selfatt():
+    def ref_selfatt(qkv, heads, scale, mask, valid_length):
+        seq_length, batch_size, _ = qkv.shape
+        qkv = qkv.reshape((seq_length, batch_size, heads, 3, -1))
+        q, k, v = [mx.nd.transpose(mx.nd.slice_axis(qkv, axis=3, begin=i, end=i + 1)
+                                   .reshape((seq_length, batch_size, heads, -1)), axes=(1, 2, 0, 3))
+                   .reshape((batch_size * heads, seq_length, -1)) for i in range(3)]
+        scores = mx.nd.batch_dot(q, k, transpose_b=True) * scale
+        scores = mx.nd.broadcast_add(scores.reshape((batch_size, heads, seq_length, seq_length)),
+                                     mask.expand_dims(1))
+        att = mx.nd.softmax(scores, axis=-1).reshape((batch_size * heads, seq_length, seq_length))
+        out = mx.nd.batch_dot(att, v).reshape((batch_size, heads, seq_length, -1))
+        return mx.nd.transpose(out, axes=(2, 0, 1, 3)).reshape((seq_length, batch_size, -1))
+
+    # the operator has only a CPU implementation
+    if default_context().device_type != 'cpu':
+        return
+    batch_size, heads, head_dim = 3, 4, 8
+    # 100 is longer than one block of 64 keys, float16 accumulates in float32
+    for seq_length, dtype, rtol, atol in [(37, np.float32, 1e-4, 1e-4),
+                                          (37, np.float64, 1e-6, 1e-6),
+                                          (37, np.float16, 1e-2, 1e-2),
+                                          (100, np.float32, 1e-4, 1e-4),
+                                          (100, np.float16, 1e-2, 1e-2)]:
+        qkv = mx.nd.random.normal(shape=(seq_length, batch_size, heads * 3 * head_dim), dtype=dtype)
+        mask = mx.nd.random.normal(shape=(batch_size, seq_length, seq_length), dtype=dtype)
+        valid_length = mx.nd.array([seq_length, 5, seq_length - 17], dtype=np.int32)
+        ograd = mx.nd.random.normal(shape=(seq_length, batch_size, heads * head_dim), dtype=dtype)
+        scale = 1.0 / np.sqrt(head_dim)
+        # the reference for float16 runs in float32, -1e9 would overflow float16
+        ref_dtype = np.float32 if dtype == np.float16 else dtype
+        ref_qkv = qkv.astype(ref_dtype)
+        key_mask = np.where(np.arange(seq_length)[None, None, :] <
+                            valid_length.asnumpy()[:, None, None], 0, -1e9)
+        ref_mask = mask.astype(ref_dtype) + mx.nd.array(key_mask, dtype=ref_dtype)
+
+        qkv.attach_grad()
+        with mx.autograd.record():
+            out = mx.nd.contrib.interleaved_selfatt(qkv, mask, valid_length, heads=heads,
+                                                   use_mask=True, use_valid_length=True)
+        out.backward(ograd)
+        ref_qkv.attach_grad()
+        with mx.autograd.record():
+            ref_out = ref_selfatt(ref_qkv, heads, scale, ref_mask, valid_length)
+        ref_out.backward(ograd.astype(ref_dtype))
+        assert out.dtype == dtype and qkv.grad.dtype == dtype
+        assert_almost_equal(out.asnumpy().astype(ref_dtype), ref_out.asnumpy(), rtol=rtol, atol=atol)
+        assert_almost_equal(qkv.grad.asnumpy().astype(ref_dtype), ref_qkv.grad.asnumpy(),
+                            rtol=rtol, atol=atol)
+
+        # without mask and valid length, and with an explicit scale
+        out = mx.nd.contrib.interleaved_selfatt(qkv, heads=heads, scale=0.5)
+        ref_out = ref_selfatt(ref_qkv, heads, 0.5, mx.nd.zeros_like(ref_mask), valid_length)
+        assert_almost_equal(out.asnumpy().astype(ref_dtype), ref_out.asnumpy(), rtol=rtol, atol=atol)
+
+
 @with_seed()
 def test_reciprocal_op():
     eps = 2**(-11)
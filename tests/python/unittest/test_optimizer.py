@@ -16,6 +16,7 @@
 # under the License.
 
 import itertools
+import os
 import numpy as np
 import itertools
 import mxnet as mx
@@ -1224,6 +1225,114 @@ def test_adadelta():
             compare_optimizer(opt1(**kwarg), opt2(**kwarg), shape, dtype)
 
 
+@with_seed()
+def test_multi_tensor_updates():
+    shapes = [(3, 4), (17,), (2, 5, 3), (1,)]
+    lrs = [0.1, 0.05, 0.2, 0.01]
+    wds = [0.0, 0.01, 0.02, 0.03]
+
+    def check(single_op, multi_op, num_states, kwargs, clip_global_norm=None):
+        weights = [mx.nd.random.uniform(shape=s) for s in shapes]
+        grads = [mx.nd.random.uniform(-1, 1, shape=s) for s in shapes]
+        states = [[mx.nd.random.uniform(shape=s) for _ in range(num_states)] for s in shapes]
+        ref_weights = [w.copy() for w in weights]
+        ref_states = [[x.copy() for x in st] for st in states]
+        ref_grads = grads
+        if clip_global_norm is not None:
+            norm = math.sqrt(sum((kwargs.get('rescale_grad', 1.0) * g).norm().asscalar() ** 2
+                                 for g in grads))
+            scale = min(1.0, clip_global_norm / norm)
+            ref_grads = [g * scale for g in grads]
+        for w, g, st, lr, wd in zip(ref_weights, ref_grads, ref_states, lrs, wds):
+            single_op(w, g, *st, out=w, lr=lr, wd=wd, **kwargs)
+        multi_kwargs = dict(kwargs)
+        if clip_global_norm is not None:
+            multi_kwargs['clip_global_norm'] = clip_global_norm
+        data = [x for w, g, st in zip(weights, grads, states) for x in [w, g] + st]
+        multi_op(*data, out=weights, num_weights=len(weights), lrs=lrs, wds=wds, **multi_kwargs)
+        for w, ref_w in zip(weights, ref_weights):
+            assert_almost_equal(w.asnumpy(), ref_w.asnumpy(), rtol=1e-4, atol=1e-5)
+        for st, ref_st in zip(states, ref_states):
+            for x, ref_x in zip(st, ref_st):
+                assert_almost_equal(x.asnumpy(), ref_x.asnumpy(), rtol=1e-4, atol=1e-5)
+
+    for clip_global_norm in [None, 0.5]:
+        for kwargs in [{}, {'rescale_grad': 0.5, 'clip_gradient': 0.3}]:
+            check(mx.nd.adam_update, mx.nd.multi_adam_update, 2,
+                  dict(kwargs, beta1=0.8, beta2=0.99), clip_global_norm)
+            check(mx.nd.rmsprop_update, mx.nd.multi_rmsprop_update, 1,
+                  dict(kwargs, gamma1=0.9, clip_weights=0.9), clip_global_norm)
+            check(mx.nd.nag_mom_update, mx.nd.multi_nag_mom_update, 1,
+                  dict(kwargs, momentum=0.9), clip_global_norm)
+
+    # multi-precision update keeps the float32 master weights in sync
+    weights32 = [mx.nd.random.uniform(shape=s) for s in shapes]
+    weights = [w.astype('float16') for w in weights32]
+    grads = [mx.nd.random.uniform(-1, 1, shape=s).astype('float16') for s in shapes]
+    means = [mx.nd.zeros(s) for s in shapes]
+    variances = [mx.nd.zeros(s) for s in shapes]
+    ref_weights32 = [w.copy() for w in weights32]
+    for w, g, m, v, lr, wd in zip(ref_weights32, grads, [m.copy() for m in means],
+                                  [v.copy() for v in variances], lrs, wds):
+        mx.nd.adam_update(w, g.astype('float32'), m, v, out=w, lr=lr, wd=wd)
+    data = [x for group in zip(weights, grads, means, variances, weights32) for x in group]
+    mx.nd.multi_mp_adam_update(*data, out=weights, num_weights=len(weights), lrs=lrs, wds=wds)
+    for w, w32, ref_w32 in zip(weights, weights32, ref_weights32):
+        assert_almost_equal(w32.asnumpy(), ref_w32.asnumpy(), rtol=1e-4, atol=1e-5)
+        assert_almost_equal(w.asnumpy(), ref_w32.astype('float16').asnumpy())
+
+
+@with_seed()
+def test_aggregated_updater():
+    shapes = [(3, 4), (17,), (2, 5, 3), (1,), (4, 4), (6,)]
+    lr_mult = {0: 1.0, 1: 0.5, 2: 2.0, 3: 1.0, 4: 0.1, 5: 1.5}
+    wd_mult = {0: 1.0, 1: 0.0, 2: 2.0, 3: 1.0, 4: 0.5, 5: 1.0}
+
+    def create_updater(opt_name, aggregation_size, kwargs):
+        old = os.environ.get('MXNET_OPTIMIZER_AGGREGATION_SIZE')
+        os.environ['MXNET_OPTIMIZER_AGGREGATION_SIZE'] = str(aggregation_size)
+        try:
+            opt = mx.optimizer.create(opt_name, **kwargs)
+        finally:
+            if old is None:
+                del os.environ['MXNET_OPTIMIZER_AGGREGATION_SIZE']
+            else:
+                os.environ['MXNET_OPTIMIZER_AGGREGATION_SIZE'] = old
+        assert opt.aggregate_num == aggregation_size
+        opt.set_lr_mult(lr_mult)
+        opt.set_wd_mult(wd_mult)
+        return mx.optimizer.get_updater(opt)
+
+    def check(opt_name, kwargs, dtype):
+        weights = [mx.nd.random.uniform(shape=s).astype(dtype) for s in shapes]
+        ref_weights = [w.copy() for w in weights]
+        updater = create_updater(opt_name, 4, kwargs)
+        ref_updater = create_updater(opt_name, 0, kwargs)
+        for step in range(5):
+            # a subset of the weights in some steps gives every index its own update
+            # count, which the bias correction of adam depends on
+            indices = list(range(len(shapes))) if step % 2 == 0 else [0, 2, 3, 5]
+            grads = [mx.nd.random.uniform(-1, 1, shape=shapes[i]).astype(dtype)
+                     for i in indices]
+            updater(indices, grads, [weights[i] for i in indices])
+            ref_updater(indices, grads, [ref_weights[i] for i in indices])
+        rtol, atol = (1e-2, 1e-3) if dtype == 'float16' else (1e-4, 1e-5)
+        for w, ref_w in zip(weights, ref_weights):
+            assert_almost_equal(w.asnumpy(), ref_w.asnumpy(), rtol=rtol, atol=atol)
+        if kwargs['multi_precision'] and dtype == 'float16':
+            # the float32 master weights must agree, not just their float16 copies
+            for i in range(len(shapes)):
+                assert_almost_equal(updater.states[i][0].asnumpy(),
+                                    ref_updater.states[i][0].asnumpy(), rtol=1e-4, atol=1e-5)
+
+    for dtype, mp in [('float32', False), ('float16', True)]:
+        for extra in [{}, {'rescale_grad': 0.5, 'clip_gradient': 0.3}]:
+            base = dict(extra, learning_rate=0.1, wd=0.01, multi_precision=mp)
+            check('adam', dict(base, beta1=0.8, beta2=0.99), dtype)
+            check('rmsprop', dict(base, gamma1=0.9, clip_weights=0.9), dtype)
+            check('nag', dict(base, momentum=0.9), dtype)
+
+
 def test_factor_scheduler():
     base_lr = 1
     step = 100
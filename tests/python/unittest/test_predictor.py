@@ -17,9 +17,13 @@
 
 from __future__ import print_function
 import sys, os
+import ctypes
+import threading
+import time
 curr_path = os.path.dirname(os.path.abspath(os.path.expanduser(__file__)))
 sys.path.append(os.path.join(curr_path, "../../../amalgamation/python/"))
 from mxnet_predict import Predictor, load_ndarray_file
+from mxnet_predict import _LIB, _check_call, c_array, c_str, mx_uint, mx_float_p
 
 import numpy as np
 import mxnet as mx
@@ -67,6 +71,183 @@ def test_predictor():
     # destroy the predictor
     del predictor
 
+def _export_dense_model(prefix):
+    block = gluon.nn.HybridSequential()
+    block.add(gluon.nn.Dense(7))
+    block.add(gluon.nn.Dense(3))
+    block.hybridize()
+    block.initialize()
+    block.forward(nd.zeros((1, 3)))
+    block.export(prefix)
+    return (open("%s-symbol.json" % prefix, "r").read(),
+            open("%s-0000.params" % prefix, "rb").read())
+
+def _batcher_forward(batcher, data):
+    data = np.ascontiguousarray(data, dtype=np.float32)
+    out = np.empty((data.shape[0], 3), dtype=np.float32)
+    inputs = (mx_float_p * 1)(data.ctypes.data_as(mx_float_p))
+    outputs = (mx_float_p * 1)(out.ctypes.data_as(mx_float_p))
+    _check_call(_LIB.MXPredBatcherForward(batcher, mx_uint(data.shape[0]),
+                                          inputs, mx_uint(1), outputs))
+    return out
+
+def _create_batcher(predictor, max_batch_size, max_wait_us, num_workers):
+    batcher = ctypes.c_void_p()
+    _check_call(_LIB.MXPredBatcherCreate(predictor.handle, mx_uint(1),
+                                         c_array(ctypes.c_char_p, [c_str('data')]),
+                                         mx_uint(max_batch_size), mx_uint(max_wait_us),
+                                         mx_uint(num_workers), ctypes.byref(batcher)))
+    return batcher
+
+@with_seed()
+def test_predictor_batcher():
+    symbol, params = _export_dense_model('test_predictor_batcher')
+    max_batch_size = 8
+    predictor = Predictor(symbol, params, {'data': (max_batch_size, 3)})
+
+    # plain MXPredForward of every request, with a predictor bound for its batch size
+    requests = [np.random.uniform(size=(np.random.randint(1, max_batch_size + 1), 3))
+                for _ in range(64)]
+    expected = []
+    for data in requests:
+        ref = Predictor(symbol, params, {'data': data.shape})
+        ref.forward(data=data)
+        expected.append(ref.get_output(0))
+
+    batcher = _create_batcher(predictor, max_batch_size, 2000, 2)
+    results = [None] * len(requests)
+    def run(indices):
+        for i in indices:
+            results[i] = _batcher_forward(batcher, requests[i])
+    threads = [threading.Thread(target=run, args=(range(t, len(requests), 8),))
+               for t in range(8)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    for out, ref in zip(results, expected):
+        assert_almost_equal(out, ref, rtol=1e-5, atol=1e-6)
+
+    # a request larger than max_batch_size fails without harming the server
+    try:
+        _batcher_forward(batcher, np.zeros((max_batch_size + 1, 3)))
+        assert False, 'oversized request must fail'
+    except RuntimeError:
+        pass
+    assert_almost_equal(_batcher_forward(batcher, requests[0]), expected[0],
+                        rtol=1e-5, atol=1e-6)
+
+    percentiles = (ctypes.c_float * 2)(50.0, 99.0)
+    latency = (ctypes.c_float * 2)()
+    num_requests = ctypes.c_uint64()
+    counts = ctypes.POINTER(ctypes.c_uint64)()
+    num_counts = mx_uint()
+    _check_call(_LIB.MXPredBatcherGetStats(batcher, mx_uint(2), percentiles, latency,
+                                           ctypes.byref(num_requests), ctypes.byref(counts),
+                                           ctypes.byref(num_counts)))
+    assert num_requests.value == len(requests) + 1
+    assert num_counts.value == max_batch_size + 1
+    total_samples = sum(d.shape[0] for d in requests) + requests[0].shape[0]
+    assert sum(i * counts[i] for i in range(num_counts.value)) == total_samples
+    assert 0 < latency[0] <= latency[1]
+    _check_call(_LIB.MXPredBatcherFree(batcher))
+
+    # freeing the server runs the requests still waiting for a full batch,
+    # three requests of two samples never fill a batch of eight
+    batcher = _create_batcher(predictor, max_batch_size, 10 * 1000 * 1000, 1)
+    results = [None] * 3
+    def run_two(i):
+        results[i] = _batcher_forward(batcher, requests[i][:2])
+    threads = [threading.Thread(target=run_two, args=(i,)) for i in range(3)]
+    for t in threads:
+        t.start()
+    time.sleep(0.5)
+    start = time.time()
+    _check_call(_LIB.MXPredBatcherFree(batcher))
+    for t in threads:
+        t.join()
+    assert time.time() - start < 5
+    for out, ref in zip(results, expected[:3]):
+        assert_almost_equal(out, ref[:2], rtol=1e-5, atol=1e-6)
+    del predictor
+
+@with_seed()
+def test_predictor_bucket():
+    symbol, params = _export_dense_model('test_predictor_bucket')
+    max_shape = (16, 3)
+    predictor = Predictor(symbol, params, {'data': max_shape})
+    keys = c_array(ctypes.c_char_p, [c_str('data')])
+
+    bucket = ctypes.c_void_p()
+    _check_call(_LIB.MXPredBucketCreate(predictor.handle, mx_uint(1), keys,
+                                        c_array(mx_uint, [0, 2]), c_array(mx_uint, max_shape),
+                                        mx_uint(2), ctypes.byref(bucket)))
+
+    def get(shape):
+        handle = ctypes.c_void_p()
+        _check_call(_LIB.MXPredBucketGet(bucket, mx_uint(1), keys,
+                                         c_array(mx_uint, [0, len(shape)]),
+                                         c_array(mx_uint, shape), ctypes.byref(handle)))
+        return handle.value
+
+    def stats():
+        hits, misses, evictions = ctypes.c_uint64(), ctypes.c_uint64(), ctypes.c_uint64()
+        num_cached = mx_uint()
+        _check_call(_LIB.MXPredBucketGetStats(bucket, ctypes.byref(hits), ctypes.byref(misses),
+                                              ctypes.byref(evictions),
+                                              ctypes.byref(num_cached)))
+        return hits.value, misses.value, evictions.value, num_cached.value
+
+    def forward(handle, data):
+        data = np.ascontiguousarray(data, dtype=np.float32)
+        out = np.empty((data.shape[0], 3), dtype=np.float32)
+        _check_call(_LIB.MXPredSetInput(ctypes.c_void_p(handle), c_str('data'),
+                                        data.ctypes.data_as(mx_float_p), mx_uint(data.size)))
+        _check_call(_LIB.MXPredForward(ctypes.c_void_p(handle)))
+        _check_call(_LIB.MXPredGetOutput(ctypes.c_void_p(handle), mx_uint(0),
+                                         out.ctypes.data_as(mx_float_p), mx_uint(out.size)))
+        return out
+
+    # the largest shapes are always served by the predictor bound at creation
+    largest = get(max_shape)
+    assert get(max_shape) == largest
+    assert stats() == (2, 0, 0, 1)
+
+    # a miss binds a predictor, asking again for the same shapes hits it
+    pred4 = get((4, 3))
+    assert get((4, 3)) == pred4
+    assert stats() == (3, 1, 0, 2)
+
+    # with cache_size 2, a third shape evicts the least recently used one
+    get((8, 3))
+    get((2, 3))
+    assert stats() == (3, 3, 1, 3)
+    get((8, 3))
+    assert stats() == (4, 3, 1, 3)
+    get((4, 3))
+    assert stats() == (4, 4, 2, 3)
+
+    # shapes exceeding the largest ones fail before binding
+    for shape in [(17, 3), (4, 4), (4, 3, 1)]:
+        try:
+            get(shape)
+            assert False, 'shape %s must be rejected' % (shape,)
+        except RuntimeError:
+            pass
+    assert stats() == (4, 4, 2, 3)
+
+    # every cached predictor computes what a freshly reshaped predictor does
+    for shape in [max_shape, (4, 3), (8, 3)]:
+        data = np.random.uniform(size=shape)
+        ref = Predictor(symbol, params, {'data': max_shape})
+        ref.reshape({'data': shape})
+        ref.forward(data=data)
+        assert_almost_equal(forward(get(shape), data), ref.get_output(0),
+                            rtol=1e-5, atol=1e-6)
+
+    _check_call(_LIB.MXPredBucketFree(bucket))
+    del predictor
+
 @with_seed()
 def test_load_ndarray():
     nd_file = 'test_predictor_load_ndarray.params'
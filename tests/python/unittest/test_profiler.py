@@ -22,8 +22,9 @@ from mxnet import profiler
 import time
 import os
 import json
+import numpy as np
 from collections import OrderedDict
-from common import run_in_spawned_process
+from common import run_in_spawned_process, TemporaryDirectory
 import unittest
 
 def enable_profiler(profile_filename, run=True, continuous_dump=False, aggregate_stats=False):
@@ -449,6 +450,59 @@ def test_custom_operator_profiling_naive_engine():
             {'MXNET_ENGINE_TYPE' : "NaiveEngine"}, 'symbolic', \
             'test_custom_operator_profiling_multiple_custom_ops_symbolic_naive.json')
 
+def _test_streaming_profiler(seed, file_name):
+    profiler.set_streaming_state('run')
+    inp = mx.nd.zeros(shape=(100, 100))
+    y = mx.nd.sqrt(inp)
+    inp = inp + 1
+    inp = inp + 1
+    mx.nd.waitall()
+    debug_str = profiler.streaming_dumps(reset=True)
+    profiler.set_streaming_state('stop')
+    rows = {line.split()[0]: line.split()[1:] for line in debug_str.splitlines()
+            if line and line.split()[0] in ('sqrt', '_plus_scalar')}
+    assert int(rows['sqrt'][0]) == 1
+    assert int(rows['_plus_scalar'][0]) == 2
+    # the percentiles are ordered
+    p50, p99, p999, max_us = [int(v) for v in rows['_plus_scalar'][2:]]
+    assert p50 <= p99 <= p999 <= max_us
+    assert 'sqrt' not in profiler.streaming_dumps()
+    with open(file_name) as f:
+        names = [line.strip().split(',')[-1] for line in f if not line.startswith('#')]
+    assert names.count('_plus_scalar') == 2
+
+def test_streaming_profiler():
+    with TemporaryDirectory() as tmpdir:
+        file_name = os.path.join(tmpdir, 'test_streaming_profiler.csv')
+        run_in_spawned_process(_test_streaming_profiler,
+                               {'MXNET_PROFILER_STREAM_FILENAME': file_name}, file_name)
+
+def test_dispatch_cache_stats():
+    a = mx.nd.ones((2, 3))
+    b = mx.nd.ones((2, 3), dtype='float16')
+    mx.nd.waitall()
+    profiler.dispatch_cache_stats(reset=True)
+    for _ in range(10):
+        c = mx.nd.broadcast_add(a, a)
+    stats = profiler.dispatch_cache_stats()
+    assert stats['hits'] >= 9
+    assert stats['hit_rate'] > 0.5
+    assert stats['saved_time_us'] >= 0
+    # a hit must not reuse the dispatch of another signature
+    assert mx.nd.broadcast_add(b, b).dtype == np.float16
+    assert mx.nd.broadcast_add(a, a.reshape((2, 1, 3))).shape == (2, 2, 3)
+    assert mx.nd.sum(a, axis=1).shape == (2,)
+    assert mx.nd.sum(a, axis=0).shape == (3,)
+    out = mx.nd.zeros((2, 3))
+    mx.nd.broadcast_add(a, a, out=out)
+    mx.nd.broadcast_add(a, a, out=out)
+    assert (out.asnumpy() == 2).all()
+    assert (c.asnumpy() == 2).all()
+    stats = profiler.dispatch_cache_stats(reset=True)
+    assert stats['misses'] > 0
+    stats = profiler.dispatch_cache_stats()
+    assert stats['hits'] == 0 and stats['misses'] == 0
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()
@@ -364,6 +364,35 @@ def test_subgraph_exe():
 def test_subgraph_v2_exe():
     _test_subgraph_exe('default_v2')
 
+def test_elemwise_fusion():
+    a = mx.sym.var('a')
+    b = mx.sym.var('b')
+    c = mx.sym.var('c')
+    x = mx.sym.elemwise_mul(a, b) + 2.0
+    y = mx.sym.Activation(x, act_type='sigmoid') * 3.0
+    z = mx.sym.relu(mx.sym.elemwise_sub(y, c)) / 4.0
+    w = mx.sym.elemwise_add(mx.sym.sqrt(mx.sym.abs(a) + 1.0), mx.sym.tanh(x))
+    sym = mx.sym.Group([z, w, mx.sym.exp(y)])
+    fused_sym = sym.get_backend_symbol('ELEMWISE_FUSION')
+    assert sym.list_arguments() == fused_sym.list_arguments()
+    assert '_sg_elemwise_fused' in fused_sym.tojson()
+
+    shape = (3, 1000)
+    args = {name: mx.nd.random.uniform(-1, 1, shape=shape) for name in sym.list_arguments()}
+    out_grads = [mx.nd.random.uniform(-1, 1, shape=shape) for _ in sym.list_outputs()]
+    results = []
+    for s in [sym, fused_sym]:
+        args_grad = {name: mx.nd.zeros(shape) for name in sym.list_arguments()}
+        exe = s.bind(mx.cpu(), args=args, args_grad=args_grad)
+        exe.forward(is_train=True)
+        exe.backward(out_grads)
+        results.append(([o.asnumpy() for o in exe.outputs],
+                        [args_grad[name].asnumpy() for name in sym.list_arguments()]))
+    for ref, out in zip(results[0][0], results[1][0]):
+        assert_almost_equal(ref, out, rtol=1e-5, atol=1e-6)
+    for ref, grad in zip(results[0][1], results[1][1]):
+        assert_almost_equal(ref, grad, rtol=1e-5, atol=1e-6)
+
 if __name__ == '__main__':
     import nose
     nose.runmodule()